@@ -21,6 +21,7 @@
 struct iovec;
 class pool_diskmgr_t;
 class printf_buffer_t;
+class uring_diskmgr_t;
 
 /* The pool disk manager uses a thread pool in conjunction with synchronous
 (blocking) IO calls to asynchronously run IO requests. */
@@ -102,6 +103,7 @@ struct pool_diskmgr_action_t
 
 private:
     friend class pool_diskmgr_t;
+    friend class uring_diskmgr_t;
     pool_diskmgr_t *parent;
 
     enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE};
@@ -137,6 +139,9 @@ private:
 void debug_print(printf_buffer_t *buf,
                  const pool_diskmgr_action_t &action);
 
+// The number of requests a disk manager backend keeps in flight at once.
+int blocker_pool_queue_depth(int max_concurrent_io_requests);
+
 class pool_diskmgr_t : private availability_callback_t, public home_thread_mixin_debug_only_t {
 public:
     friend struct pool_diskmgr_action_t;
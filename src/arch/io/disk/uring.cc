@@ -0,0 +1,308 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk/uring.hpp"
+
+#if USE_IO_URING
+
+#include <limits.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "logger.hpp"
+
+// The fallback pool only ever sees resizes and datasync-wrapped writes.
+const int URING_SYNC_BACKEND_CONCURRENCY = 2;
+
+// The kernel refuses rings with more than 32768 entries. We stay well below that,
+// since the memory for the submission and completion queues is locked.
+const int URING_MAX_QUEUE_DEPTH = 4096;
+
+// How long we wait before retrying a submission that the kernel refused for lack of
+// resources, if there are no requests in flight whose completion could trigger it.
+const int64_t URING_SUBMIT_RETRY_MS = 1;
+
+/* glibc provides no wrappers for the io_uring system calls. */
+
+int sys_io_uring_setup(unsigned entries, io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int sys_io_uring_enter(fd_t fd, unsigned to_submit, unsigned min_complete,
+                       unsigned flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                   nullptr, 0);
+}
+
+int sys_io_uring_register(fd_t fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+bool probe_io_uring() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    scoped_fd_t fd(sys_io_uring_setup(1, &params));
+    if (fd.get() == INVALID_FD) {
+        return false;
+    }
+    // We need `IORING_REGISTER_EVENTFD` to hook completions into the event queue.
+    system_event_t event;
+    int notify_fd = event.get_notify_fd();
+    return sys_io_uring_register(fd.get(), IORING_REGISTER_EVENTFD, &notify_fd, 1) == 0;
+}
+
+bool uring_diskmgr_t::is_supported() {
+    static const bool supported = probe_io_uring();
+    return supported;
+}
+
+struct uring_diskmgr_t::request_t {
+    explicit request_t(action_t *_action) : action(_action), bytes_done(0) {
+        action->copy_vectors(&vecs);
+        remaining = vecs.data();
+        remaining_count = vecs.size();
+    }
+
+    action_t *action;
+
+    // A copy of the action's io vectors. `remaining` and `remaining_count` get
+    // advanced past the bytes that the kernel has already transferred when we
+    // have to resubmit after a short read or write.
+    scoped_array_t<iovec> vecs;
+    iovec *remaining;
+    size_t remaining_count;
+    int64_t bytes_done;
+
+    DISABLE_COPYING(request_t);
+};
+
+uring_diskmgr_t::uring_diskmgr_t(linux_event_queue_t *_queue,
+                                 passive_producer_t<action_t *> *_source,
+                                 int max_concurrent_io_requests)
+    : queue_depth(std::min(blocker_pool_queue_depth(max_concurrent_io_requests),
+                           URING_MAX_QUEUE_DEPTH)),
+      source(_source),
+      queue(_queue),
+      n_unsubmitted(0),
+      n_pending(0),
+      reaping(false),
+      retry_timer(nullptr),
+      sync_backend(_queue, &sync_queue, URING_SYNC_BACKEND_CONCURRENCY) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // The kernel rounds the number of entries up to a power of two. The completion
+    // queue gets twice as many entries, so it can't overflow while we never have
+    // more than `queue_depth` requests in flight.
+    ring_fd.reset(sys_io_uring_setup(queue_depth, &params));
+    guarantee_err(ring_fd.get() != INVALID_FD, "Could not set up io_uring");
+    guarantee(params.sq_entries >= static_cast<unsigned>(queue_depth));
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+    }
+
+    sq_ring_ptr = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_SQ_RING);
+    guarantee_err(sq_ring_ptr != MAP_FAILED, "Could not map io_uring submission queue");
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ring_ptr = sq_ring_ptr;
+    } else {
+        cq_ring_ptr = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_CQ_RING);
+        guarantee_err(cq_ring_ptr != MAP_FAILED,
+                      "Could not map io_uring completion queue");
+    }
+
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes_ptr = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_SQES);
+    guarantee_err(sqes_ptr != MAP_FAILED, "Could not map io_uring submission entries");
+    sqes = static_cast<io_uring_sqe *>(sqes_ptr);
+
+    char *sq = static_cast<char *>(sq_ring_ptr);
+    sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    char *cq = static_cast<char *>(cq_ring_ptr);
+    cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    int notify_fd = completion_event.get_notify_fd();
+    int res = sys_io_uring_register(ring_fd.get(), IORING_REGISTER_EVENTFD,
+                                    &notify_fd, 1);
+    guarantee_err(res == 0, "Could not register eventfd with io_uring");
+    queue->watch_event(&completion_event, this);
+
+    sync_backend.done_fun = [this](action_t *a) { done_fun(a); };
+
+    if (source->available->get()) { pump(); }
+    source->available->set_callback(this);
+}
+
+uring_diskmgr_t::~uring_diskmgr_t() {
+    assert_thread();
+    rassert(n_pending == 0);
+    if (retry_timer != nullptr) {
+        cancel_timer(retry_timer);
+    }
+    source->available->unset_callback();
+    queue->forget_event(&completion_event, this);
+
+    munmap(sqes, sqes_size);
+    if (cq_ring_ptr != sq_ring_ptr) {
+        munmap(cq_ring_ptr, cq_ring_size);
+    }
+    munmap(sq_ring_ptr, sq_ring_size);
+}
+
+void uring_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    if (source->available->get()) pump();
+}
+
+void uring_diskmgr_t::pump() {
+    assert_thread();
+    while (source->available->get() && n_pending < queue_depth) {
+        action_t *a = source->pop();
+        if (a->get_is_resize() || a->wrap_in_datasyncs) {
+            sync_queue.push(a);
+            continue;
+        }
+        n_pending++;
+        prepare_sqe(new request_t(a));
+    }
+    flush_submissions();
+}
+
+void uring_diskmgr_t::prepare_sqe(request_t *request) {
+    // We never have more requests in flight than there are submission entries,
+    // so there is always room in the ring.
+    unsigned tail = *sq_tail;
+    rassert(tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) <= sq_mask);
+    unsigned index = tail & sq_mask;
+
+    io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = request->action->get_is_read() ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->fd = request->action->get_fd();
+    sqe->off = request->action->get_offset() + request->bytes_done;
+    sqe->addr = reinterpret_cast<uint64_t>(request->remaining);
+    sqe->len = std::min<size_t>(request->remaining_count, IOV_MAX);
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++n_unsubmitted;
+}
+
+void uring_diskmgr_t::flush_submissions() {
+    if (reaping || n_unsubmitted == 0) {
+        return;
+    }
+    int res;
+    do {
+        res = sys_io_uring_enter(ring_fd.get(), n_unsubmitted, 0, 0);
+    } while (res == -1 && get_errno() == EINTR);
+
+    if (res == -1) {
+        // The kernel is temporarily out of resources. The entries stay in the
+        // submission queue, and we try again once the next completion comes in.
+        // If nothing is in flight, no completion will come, so we use a timer.
+        guarantee_err(get_errno() == EAGAIN || get_errno() == EBUSY,
+                      "io_uring_enter failed");
+        const bool in_flight = n_pending > static_cast<int>(n_unsubmitted);
+        if (!in_flight && retry_timer == nullptr) {
+            retry_timer = fire_timer_once(URING_SUBMIT_RETRY_MS, this);
+        }
+        return;
+    }
+    rassert(static_cast<unsigned>(res) <= n_unsubmitted);
+    n_unsubmitted -= res;
+}
+
+void uring_diskmgr_t::on_timer(ticks_t) {
+    assert_thread();
+    retry_timer = nullptr;
+    flush_submissions();
+}
+
+void uring_diskmgr_t::on_event(DEBUG_VAR int events) {
+    assert_thread();
+    rassert(events == poll_event_in);
+    completion_event.consume_wakey_wakeys();
+
+    reaping = true;
+    reap_completions();
+    reaping = false;
+
+    pump();
+}
+
+void uring_diskmgr_t::reap_completions() {
+    unsigned head = *cq_head;
+    for (;;) {
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            break;
+        }
+        io_uring_cqe *cqe = &cqes[head & cq_mask];
+        request_t *request = reinterpret_cast<request_t *>(cqe->user_data);
+        int32_t res = cqe->res;
+        ++head;
+        // Release the entry before handling it, since `handle_completion` may
+        // call back into code that submits more requests.
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        handle_completion(request, res);
+    }
+}
+
+void uring_diskmgr_t::handle_completion(request_t *request, int32_t res) {
+    action_t *a = request->action;
+    if (res == -EINTR || res == -EAGAIN) {
+        prepare_sqe(request);
+        return;
+    } else if (res < 0) {
+        finish(request, res);
+        return;
+    } else if (res == 0 && a->get_is_write()) {
+        // See the corresponding comment in `pool_diskmgr_t::action_t::perform_read_write`.
+        logERR("Failed I/O: vectored write of %zu bytes stopped after "
+               "%" PRIi64 " bytes. Assuming we ran out of disk space.",
+               a->get_count(), request->bytes_done);
+        finish(request, -ENOSPC);
+        return;
+    } else if (res == 0) {
+        logERR("Failed I/O: we tried to read from behind the end of the file. "
+               "Either the file got truncated, or there is a bug in RethinkDB.");
+        finish(request, -EINVAL);
+        return;
+    }
+
+    request->bytes_done += action_t::advance_vector(&request->remaining,
+                                                    &request->remaining_count, res);
+    if (request->bytes_done < static_cast<int64_t>(a->get_count())) {
+        // A short read or write. Submit the rest.
+        prepare_sqe(request);
+        return;
+    }
+    finish(request, request->bytes_done);
+}
+
+void uring_diskmgr_t::finish(request_t *request, int64_t io_result) {
+    action_t *a = request->action;
+    delete request;
+    a->io_result = io_result;
+    n_pending--;
+    done_fun(a);
+}
+
+#endif  // USE_IO_URING
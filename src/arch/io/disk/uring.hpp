@@ -0,0 +1,124 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_URING_HPP_
+#define ARCH_IO_DISK_URING_HPP_
+
+#if defined(__linux__) && !defined(NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define USE_IO_URING 1
+#endif
+#endif
+
+#ifndef USE_IO_URING
+#define USE_IO_URING 0
+#endif
+
+#if USE_IO_URING
+
+#include <sys/uio.h>
+
+#include <functional>
+
+#include "arch/io/disk/pool.hpp"
+#include "arch/io/io_utils.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "arch/timer.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "concurrency/queue/unlimited_fifo.hpp"
+#include "containers/scoped.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/* The io_uring disk manager hands reads and writes to the kernel through an
+io_uring submission queue instead of running blocking `preadv`/`pwritev` calls
+on a `blocker_pool_t` thread. Requests popped from `source` during one event
+loop turn are submitted with a single `io_uring_enter` call, and completions are
+reaped when the kernel signals the eventfd that we registered with the ring and
+with `linux_event_queue_t`.
+
+Resizes and writes that must be wrapped in datasyncs are rare and are not worth
+chaining in the ring, so they are forwarded to a small `pool_diskmgr_t`.
+
+It consumes the same action type as `pool_diskmgr_t` so that it can be swapped
+in at the bottom of the `linux_disk_manager_t` stack. Use `is_supported()` to
+find out whether the running kernel (or seccomp profile) allows io_uring. */
+
+class uring_diskmgr_t : private availability_callback_t,
+                        private linux_event_callback_t,
+                        private timer_callback_t,
+                        public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_action_t action_t;
+
+    /* Returns true if an io_uring instance with a registered eventfd can be
+    created. The result is computed once and cached. */
+    static bool is_supported();
+
+    /* Like `pool_diskmgr_t`, the `uring_diskmgr_t` draws actions to run from
+    `source` and calls `done_fun` on each one when it's done. */
+    uring_diskmgr_t(linux_event_queue_t *queue, passive_producer_t<action_t *> *source,
+                    int max_concurrent_io_requests);
+    std::function<void(action_t *)> done_fun;
+    ~uring_diskmgr_t();
+
+private:
+    struct request_t;
+
+    void on_source_availability_changed();
+    void on_event(int events);
+    void on_timer(ticks_t ticks);
+
+    void pump();
+    void prepare_sqe(request_t *request);
+    void flush_submissions();
+    void reap_completions();
+    void handle_completion(request_t *request, int32_t res);
+    void finish(request_t *request, int64_t io_result);
+
+    const int queue_depth;
+    passive_producer_t<action_t *> *source;
+    linux_event_queue_t *queue;
+
+    scoped_fd_t ring_fd;
+
+    void *sq_ring_ptr;
+    size_t sq_ring_size;
+    void *cq_ring_ptr;
+    size_t cq_ring_size;
+    io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    io_uring_cqe *cqes;
+
+    // The number of SQEs that we have filled in but not yet passed to
+    // `io_uring_enter`.
+    unsigned n_unsubmitted;
+    // The number of requests that are currently owned by the ring.
+    int n_pending;
+    // Set while we run completions, so that requests which are submitted by
+    // `done_fun` callbacks get batched into one `io_uring_enter` call.
+    bool reaping;
+    // Set while we wait to retry a submission that the kernel refused while no
+    // requests were in flight.
+    timer_token_t *retry_timer;
+
+    system_event_t completion_event;
+
+    // Resizes and datasync-wrapped writes go through here.
+    unlimited_fifo_queue_t<action_t *> sync_queue;
+    pool_diskmgr_t sync_backend;
+
+    DISABLE_COPYING(uring_diskmgr_t);
+};
+
+#endif  // USE_IO_URING
+
+#endif  // ARCH_IO_DISK_URING_HPP_
@@ -227,6 +227,22 @@ size_t artificial_stack_t::free_space_below(const void *addr) const {
     return reinterpret_cast<uintptr_t>(addr) - lowest_valid_address;
 }
 
+size_t artificial_stack_t::max_usage() const {
+#ifdef VALGRIND
+    // Valgrind would complain about us reading the parts that were never written.
+    return 0;
+#else
+    // Skip the protection page. It might be `PROT_NONE` right now.
+    const uintptr_t *pos = reinterpret_cast<const uintptr_t *>(
+        reinterpret_cast<uintptr_t>(get_stack_bound()) + getpagesize());
+    const uintptr_t *end = static_cast<const uintptr_t *>(get_stack_base());
+    while (pos < end && *pos == 0) {
+        ++pos;
+    }
+    return reinterpret_cast<uintptr_t>(end) - reinterpret_cast<uintptr_t>(pos);
+#endif
+}
+
 extern "C" {
 // `lightweight_swapcontext` is defined in assembly further down.  If we didn't add the
 // asm("_lightweight_swapcontext") here, we'd have to conditionally compile the symbol name in the
@@ -92,6 +92,12 @@ public:
     /* Returns how many more bytes below the given address can be used */
     size_t free_space_below(const void *addr) const;
 
+    /* Returns how many bytes of the stack have been written to since it was
+    allocated. Pages that were never touched read as zero, so this scans upwards
+    from the bottom for the first non-zero word. That reads the whole unused part of
+    the stack, so don't call this on a hot path. */
+    size_t max_usage() const;
+
     /* Enables stack-smashing protection for this stack, if not already enabled */
     void enable_overflow_protection();
     /* Disables stack-smashing protection for this stack, if currently enabled */
@@ -213,9 +219,10 @@ public:
     /* Returns how many more bytes below the given address can be used */
     size_t free_space_below(const void *addr) const;
 
-    /* These two are currently not implemented for threaded stacks. */
+    /* These three are currently not implemented for threaded stacks. */
     void enable_overflow_protection() {}
     void disable_overflow_protection() {}
+    size_t max_usage() const { return 0; }
 
 private:
     static void *internal_run(void *p);
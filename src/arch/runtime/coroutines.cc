@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <functional>
 #ifndef NDEBUG
@@ -27,8 +28,23 @@
 size_t coro_stack_size = COROUTINE_STACK_SIZE;
 
 // How many unused coroutine stacks to keep around (at most), before they are
-// freed. This value is per thread.
+// freed. This value is per thread and per stack tier. Small stacks are a quarter of
+// the size of normal ones, so we can afford to keep more of them.
 const size_t COROUTINE_FREE_LIST_SIZE = 64;
+const size_t SMALL_COROUTINE_FREE_LIST_SIZE = 256;
+
+// Measuring how much of a stack has been used is relatively expensive, so we only
+// do it for every `COROUTINE_STACK_USAGE_SAMPLE_INTERVAL`th coroutine that finishes
+// on a given thread.
+const uint64_t COROUTINE_STACK_USAGE_SAMPLE_INTERVAL = 256;
+
+#if !defined(NDEBUG) && !defined(THREADED_COROUTINES)
+// Small stacks don't have a guard page. In debug mode we put this pattern into the
+// bottom of the stack instead, and check that it's still intact whenever the
+// coroutine finishes.
+const uintptr_t SMALL_STACK_CANARY = static_cast<uintptr_t>(0x5ca1ab1ec0ffee42ULL);
+const size_t SMALL_STACK_CANARY_WORDS = 8;
+#endif
 
 // In debug mode, we print a warning if more than this many coroutines have been
 // allocated on one thread.
@@ -67,8 +83,12 @@ struct coro_globals_t {
     /* The previous context. */
     coro_t *prev_coro;
 
-    /* A list of coro_t objects that are not in use. */
-    intrusive_list_t<coro_t> free_coros;
+    /* Lists of coro_t objects that are not in use, one per stack tier. */
+    intrusive_list_t<coro_t> free_coros[NUM_CORO_STACK_TIERS];
+
+    /* How many coroutines have been returned to the free lists on this thread. Used
+    to decide when to sample stack usage. */
+    uint64_t returned_coro_count;
 
     /* A list of coroutines that currently have protected stacks. The least recently
     used protected coroutine is always at the front of the list. */
@@ -102,6 +122,7 @@ struct coro_globals_t {
     coro_globals_t()
         : current_coro(nullptr)
         , prev_coro(nullptr)
+        , returned_coro_count(0)
 #ifndef NDEBUG
         , coro_count(0)
         , printed_high_coro_count_warning(false)
@@ -115,9 +136,11 @@ struct coro_globals_t {
         rassert(!current_coro);
 
         /* Destroy remaining coroutines */
-        while (coro_t *s = free_coros.head()) {
-            free_coros.remove(s);
-            delete s;
+        for (size_t i = 0; i < NUM_CORO_STACK_TIERS; ++i) {
+            while (coro_t *s = free_coros[i].head()) {
+                free_coros[i].remove(s);
+                delete s;
+            }
         }
     }
 
@@ -128,10 +151,16 @@ TLS_with_init(coro_globals_t *, cglobals, nullptr);
 // These must be initialized after TLS_cglobals, because perfmon_multi_membership_t
 // construction depends on coro_t::coroutines_have_been_initialized() which in turn
 // depends on cglobals.
-static perfmon_counter_t pm_active_coroutines, pm_allocated_coroutines;
+static perfmon_counter_t pm_active_coroutines, pm_allocated_coroutines,
+    pm_allocated_small_coroutines;
+static perfmon_high_water_mark_t pm_coroutine_stack_high_water,
+    pm_small_coroutine_stack_high_water;
 static perfmon_multi_membership_t pm_coroutines_membership(&get_global_perfmon_collection(),
     &pm_active_coroutines, "active_coroutines",
-    &pm_allocated_coroutines, "allocated_coroutines");
+    &pm_allocated_coroutines, "allocated_coroutines",
+    &pm_allocated_small_coroutines, "allocated_small_coroutines",
+    &pm_coroutine_stack_high_water, "coroutine_stack_high_water",
+    &pm_small_coroutine_stack_high_water, "small_coroutine_stack_high_water");
 
 coro_runtime_t::coro_runtime_t() {
     rassert(!TLS_get_cglobals(), "coro runtime initialized twice on this thread");
@@ -157,8 +186,17 @@ void coro_runtime_t::get_coroutine_counts(std::map<std::string, size_t> *dest) {
 TLS_with_init(int64_t, coro_selfname_counter, 0);
 #endif
 
-coro_t::coro_t() :
-    stack(&coro_t::run, coro_stack_size),
+static size_t stack_size_for_tier(coro_stack_tier_t tier) {
+    switch (tier) {
+    case coro_stack_tier_t::SMALL: return SMALL_COROUTINE_STACK_SIZE;
+    case coro_stack_tier_t::NORMAL: return coro_stack_size;
+    default: unreachable();
+    }
+}
+
+coro_t::coro_t(coro_stack_tier_t tier) :
+    stack_tier_(tier),
+    stack(&coro_t::run, stack_size_for_tier(tier)),
     current_thread_(linux_thread_pool_t::get_thread_id()),
     notified_(false),
     waiting_(false),
@@ -175,6 +213,16 @@ coro_t::coro_t() :
 #endif
 {
     ++pm_allocated_coroutines;
+    if (stack_tier_ == coro_stack_tier_t::SMALL) {
+        ++pm_allocated_small_coroutines;
+#if !defined(NDEBUG) && !defined(THREADED_COROUTINES)
+        uintptr_t *canary = reinterpret_cast<uintptr_t *>(
+            reinterpret_cast<uintptr_t>(stack.get_stack_bound()) + getpagesize());
+        for (size_t i = 1; i <= SMALL_STACK_CANARY_WORDS; ++i) {
+            canary[-static_cast<ptrdiff_t>(i)] = SMALL_STACK_CANARY;
+        }
+#endif
+    }
 
 #ifndef NDEBUG
     TLS_get_cglobals()->coro_count++;
@@ -189,18 +237,38 @@ coro_t::coro_t() :
 
 void coro_t::return_coro_to_free_list(coro_t *coro) {
     coro_globals_t *cglobals = TLS_get_cglobals();
+
+    ++cglobals->returned_coro_count;
+    if (cglobals->returned_coro_count % COROUTINE_STACK_USAGE_SAMPLE_INTERVAL == 0) {
+        // Stacks are reused without being cleared, so this is the most that this
+        // stack has been used by any coroutine so far.
+        int64_t usage = static_cast<int64_t>(coro->stack.max_usage());
+        if (coro->stack_tier_ == coro_stack_tier_t::SMALL) {
+            pm_small_coroutine_stack_high_water.record(usage);
+        } else {
+            pm_coroutine_stack_high_water.record(usage);
+        }
+    }
+
     // Note that we must guarantee that `coro` is never evicted immediately. We do so
     // by checking the free list size *before* we push `coro` onto it.
     // This is important because when we call `return_coro_to_free_list` in
     // `coro_t::run`, that coroutine is still active and must not be deleted yet.
     static_assert(COROUTINE_FREE_LIST_SIZE > 0, "COROUTINE_FREE_LIST_SIZE cannot be 0");
-    if (cglobals->free_coros.size() >= COROUTINE_FREE_LIST_SIZE) {
-        coro_t *coro_to_delete = cglobals->free_coros.tail();
-        cglobals->free_coros.remove(coro_to_delete);
+    static_assert(SMALL_COROUTINE_FREE_LIST_SIZE > 0,
+                  "SMALL_COROUTINE_FREE_LIST_SIZE cannot be 0");
+    const size_t max_size = coro->stack_tier_ == coro_stack_tier_t::SMALL
+        ? SMALL_COROUTINE_FREE_LIST_SIZE
+        : COROUTINE_FREE_LIST_SIZE;
+    intrusive_list_t<coro_t> *free_coros =
+        &cglobals->free_coros[static_cast<size_t>(coro->stack_tier_)];
+    if (free_coros->size() >= max_size) {
+        coro_t *coro_to_delete = free_coros->tail();
+        free_coros->remove(coro_to_delete);
         delete coro_to_delete;
     }
-    rassert(cglobals->free_coros.size() < COROUTINE_FREE_LIST_SIZE);
-    cglobals->free_coros.push_back(coro);
+    rassert(free_coros->size() < max_size);
+    free_coros->push_back(coro);
 }
 
 coro_t::~coro_t() {
@@ -211,12 +279,22 @@ coro_t::~coro_t() {
     TLS_get_cglobals()->coro_count--;
 #endif
     --pm_allocated_coroutines;
+    if (stack_tier_ == coro_stack_tier_t::SMALL) {
+        --pm_allocated_small_coroutines;
+    }
 }
 
 /* Helper function for switching into a new context and making sure that the new context
 is protected against stack overflows. Might also unprotect old contexts to avoid
 exhausting kernel limits on memory-mapped regions. */
 void coro_t::switch_to_coro_with_protection(coro_context_ref_t *current_context) {
+    /* Small stacks are never protected, so they don't take up any room in the
+    `protected_coros_lru` list either. */
+    if (stack_tier_ == coro_stack_tier_t::SMALL) {
+        context_switch(current_context, &stack.context);
+        return;
+    }
+
     /* Move ourselves to the back of the `protected_coros_lru` list. */
     coro_globals_t *cglobals = TLS_get_cglobals();
     if (protected_stack_lru_entry_.in_a_list()) {
@@ -278,6 +356,19 @@ void coro_t::run() {
 
         rassert(coro->current_thread_ == get_thread_id());
 
+#if !defined(NDEBUG) && !defined(THREADED_COROUTINES)
+        if (coro->stack_tier_ == coro_stack_tier_t::SMALL) {
+            const uintptr_t *canary = reinterpret_cast<const uintptr_t *>(
+                reinterpret_cast<uintptr_t>(coro->stack.get_stack_bound())
+                + getpagesize());
+            for (size_t i = 1; i <= SMALL_STACK_CANARY_WORDS; ++i) {
+                rassert(canary[-static_cast<ptrdiff_t>(i)] == SMALL_STACK_CANARY,
+                        "A coroutine with a small stack overflowed its stack. Spawn "
+                        "it with `coro_stack_tier_t::NORMAL` instead.");
+            }
+        }
+#endif
+
         // Destroy the Callable object which was either allocated within the coro_t or on the heap
         coro->action_wrapper.reset();
 
@@ -504,16 +595,19 @@ bool coroutines_have_been_initialized() {
     return TLS_get_cglobals() != nullptr;
 }
 
-coro_t * coro_t::get_coro() {
+coro_t * coro_t::get_coro(coro_stack_tier_t tier) {
     rassert(coroutines_have_been_initialized());
     coro_t *coro;
 
-    if (TLS_get_cglobals()->free_coros.size() == 0) {
-        coro = new coro_t();
+    intrusive_list_t<coro_t> *free_coros =
+        &TLS_get_cglobals()->free_coros[static_cast<size_t>(tier)];
+    if (free_coros->size() == 0) {
+        coro = new coro_t(tier);
     } else {
-        coro = TLS_get_cglobals()->free_coros.tail();
-        TLS_get_cglobals()->free_coros.remove(coro);
+        coro = free_coros->tail();
+        free_coros->remove(coro);
     }
+    rassert(coro->stack_tier_ == tier);
 
     rassert(!coro->intrusive_list_node_t<coro_t>::in_a_list());
 
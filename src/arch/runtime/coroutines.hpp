@@ -36,6 +36,25 @@ struct coro_profiler_mixin_t {
 #endif
 };
 
+/* Every coroutine is spawned with one of these stack sizes.
+`NORMAL` stacks are `COROUTINE_STACK_SIZE` bytes large (see also
+`coro_t::set_coroutine_stack_size()`) and get an `mprotect`ed guard page while they
+are active.
+`SMALL` stacks are `SMALL_COROUTINE_STACK_SIZE` bytes large and never get a guard
+page, which saves two `mprotect` calls and a memory mapping per stack. An overflow on
+a `SMALL` stack goes undetected in release mode, so they should only be used for leaf
+callbacks whose stack depth is bounded: ones that don't send messages, serialize
+data, take locks with arbitrary waiters, or call back into other components.
+Coroutines that mostly wait but then do arbitrary work, such as the changefeed
+`server_t::add_client_cb()`, need a `NORMAL` stack. Code that needs a lot of stack can
+still use `call_with_enough_stack()`, which spawns a `NORMAL` coroutine if
+necessary. */
+enum class coro_stack_tier_t {
+    SMALL = 0,
+    NORMAL = 1
+};
+const size_t NUM_CORO_STACK_TIERS = 2;
+
 /* The `coro_lru_entry_t` is used to keep track of coroutines that have protected
 stacks and to eventually unprotect them using a least-recently-used strategy. */
 struct coro_lru_entry_t : public intrusive_list_node_t<coro_lru_entry_t> {
@@ -58,14 +77,18 @@ public:
     friend bool has_n_bytes_free_stack_space(size_t);
 
     template<class callable_t>
-    static void spawn_now_dangerously(callable_t &&action) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static void spawn_now_dangerously(
+            callable_t &&action,
+            coro_stack_tier_t tier = coro_stack_tier_t::NORMAL) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), tier);
         coro->notify_now_deprecated();
     }
 
     template<class callable_t>
-    static coro_t *spawn_sometime(callable_t &&action) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static coro_t *spawn_sometime(
+            callable_t &&action,
+            coro_stack_tier_t tier = coro_stack_tier_t::NORMAL) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), tier);
         coro->notify_sometime();
         return coro;
     }
@@ -74,8 +97,11 @@ public:
     It avoids two thread messages, since it doesn't have to run on the original
     thread first, and also doesn't switch back at the end of the coro's lifetime. */
     template<class callable_t>
-    static coro_t *spawn_on_thread(callable_t &&action, threadnum_t thread) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static coro_t *spawn_on_thread(
+            callable_t &&action,
+            threadnum_t thread,
+            coro_stack_tier_t tier = coro_stack_tier_t::NORMAL) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), tier);
         coro->current_thread_ = thread;
         coro->notify_sometime();
         return coro;
@@ -85,8 +111,10 @@ public:
     `spawn_later_ordered()` (or `spawn_ordered()`). `spawn_later_ordered()` does not
     honor scheduler priorities. */
     template<class callable_t>
-    static coro_t *spawn_later_ordered(callable_t &&action) {
-        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action));
+    static coro_t *spawn_later_ordered(
+            callable_t &&action,
+            coro_stack_tier_t tier = coro_stack_tier_t::NORMAL) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), tier);
         coro->notify_later_ordered();
         return coro;
     }
@@ -148,9 +176,12 @@ public:
     const std::string& get_coroutine_type() { return coroutine_type; }
 #endif
 
+    /* Sets the size of `coro_stack_tier_t::NORMAL` stacks that are allocated from
+    now on. */
     static void set_coroutine_stack_size(size_t size);
 
     coro_stack_t *get_stack();
+    coro_stack_tier_t get_stack_tier() const { return stack_tier_; }
 
     void set_priority(int _priority) {
         linux_thread_message_t::set_priority(_priority);
@@ -174,19 +205,20 @@ private:
 
     // Constructor sets up the stack, get_and_init_coro will load a function to be run
     //  at which point the coroutine can be notified
-    coro_t();
+    explicit coro_t(coro_stack_tier_t tier);
 
     // Generates a spawn-time backtrace and stores it into `spawn_backtrace`.
     void grab_spawn_backtrace();
 
     // Performs a context switch from `current_context` to this coroutine.
-    // Also enables stack-overflow protection on this coroutine.
+    // Also enables stack-overflow protection on this coroutine, unless it has a
+    // `SMALL` stack.
     void switch_to_coro_with_protection(coro_context_ref_t *current_context);
 
     // If this function footprint ever changes, you may need to update the parse_coroutine_info function
     template<class callable_t>
-    static coro_t *get_and_init_coro(callable_t &&action) {
-        coro_t *coro = get_coro();
+    static coro_t *get_and_init_coro(callable_t &&action, coro_stack_tier_t tier) {
+        coro_t *coro = get_coro(tier);
 #ifndef NDEBUG
         coro->parse_coroutine_type(CURRENT_FUNCTION_PRETTY);
 #endif
@@ -205,7 +237,7 @@ private:
         return coro;
     }
 
-    static coro_t *get_coro();
+    static coro_t *get_coro(coro_stack_tier_t tier);
 
     static void return_coro_to_free_list(coro_t *coro);
 
@@ -217,6 +249,7 @@ private:
 
     virtual void on_thread_switch();
 
+    coro_stack_tier_t stack_tier_;
     coro_stack_t stack;
 
     threadnum_t current_thread_;
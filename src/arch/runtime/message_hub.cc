@@ -92,15 +92,22 @@ void linux_message_hub_t::store_message_sometime(threadnum_t nthread, linux_thre
 
 
 void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
-    bool do_wake_up;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        do_wake_up = !check_and_set_is_woken_up();
-        incoming_messages_.push_back(msg);
+    msg_list_t msgs;
+    msgs.push_back(msg);
+    deliver_incoming_messages(&msgs);
+}
+
+void linux_message_hub_t::deliver_incoming_messages(msg_list_t *msgs) {
+    // If the queue wasn't empty, whoever pushed onto it first has taken care of the
+    // wakeup.
+    if (incoming_messages_.push_all(msgs)) {
+        wake_up();
     }
+}
 
+void linux_message_hub_t::wake_up() {
     // Wakey wakey eggs and bakey
-    if (do_wake_up) {
+    if (!is_woken_up_.exchange(true)) {
         event_.wakey_wakey();
     }
 }
@@ -176,32 +183,28 @@ void linux_message_hub_t::on_event(int events) {
             // Place wakey_wakey and then yield to the event processing.
             // It will wake us up again immediately, but can handle a few
             // OS events (such as timers, network messages etc.) in the meantime.
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&incoming_messages_lock_);
-                do_wake_up = !check_and_set_is_woken_up();
-            }
-            if (do_wake_up) {
-                event_.wakey_wakey();
-            }
-            break;
+            // `is_woken_up_` is still set, so other threads keep leaving the
+            // wakeup to us.
+            event_.wakey_wakey();
+            return;
         }
     }
+
+    // Other threads didn't wake us up for the messages that arrived while we were
+    // busy, so we have to check for them after we stop suppressing their wakeups.
+    is_woken_up_.store(false);
+    if (!incoming_messages_.empty()) {
+        wake_up();
+    }
 }
 
 void linux_message_hub_t::sort_incoming_messages_by_priority() {
-    // We do this in two steps to release the spinlock faster.
-    // append_and_clear is a very cheap operation, while
-    // assigning each message to a different priority queue
-    // is more expensive.
+    // We do this in two steps so that the messages are taken off the shared queue
+    // with a single atomic operation.
 
     // 1. Pull the messages
     msg_list_t new_messages;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        new_messages.append_and_clear(&incoming_messages_);
-        is_woken_up_ = false;
-    }
+    incoming_messages_.pop_all(&new_messages);
 
     // 2. Sort the messages into their respective priority queues
     while (linux_thread_message_t *m = new_messages.head()) {
@@ -219,12 +222,6 @@ void linux_message_hub_t::sort_incoming_messages_by_priority() {
     }
 }
 
-bool linux_message_hub_t::check_and_set_is_woken_up() {
-    const bool was_woken_up = is_woken_up_;
-    is_woken_up_ = true;
-    return was_woken_up;
-}
-
 // Pushes messages collected locally global lists available to all
 // threads.
 void linux_message_hub_t::push_messages() {
@@ -234,23 +231,8 @@ void linux_message_hub_t::push_messages() {
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
             // Transfer messages to the other core
-
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
-
-                // We only need to do a wake up if we're the first people to do a
-                // wake up.
-                do_wake_up =
-                    !thread_pool_->threads[i]->message_hub.check_and_set_is_woken_up();
-
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
-            }
-
-            // Wakey wakey, perhaps eggs and bakey
-            if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.event_.wakey_wakey();
-            }
+            thread_pool_->threads[i]->message_hub.deliver_incoming_messages(
+                &queue->msg_local_list);
         }
     }
 }
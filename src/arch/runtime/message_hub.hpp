@@ -4,12 +4,14 @@
 
 #include <pthread.h>
 
+#include <atomic>
+
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "arch/runtime/system_event.hpp"
-#include "arch/spinlock.hpp"
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/mpsc_queue.hpp"
 #include "threading.hpp"
 
 
@@ -69,15 +71,25 @@ private:
         //TODO this doesn't need to be a class anymore
 
         /* Messages are cached here before being pushed to the global list so that we don't
-        have to acquire the spinlock as often */
+        have to touch the other thread's queue as often */
         msg_list_t msg_local_list;
     } queues_[MAX_THREADS];
 
-    // Must only be used with acquired incoming_messages_lock_
-    bool check_and_set_is_woken_up();
-    bool is_woken_up_;
-    msg_list_t incoming_messages_;
-    spinlock_t incoming_messages_lock_;
+    // Moves `msgs` onto incoming_messages_ and wakes up the thread if that's necessary.
+    // Can be called from any thread.
+    void deliver_incoming_messages(msg_list_t *msgs);
+
+    // Wakes up the thread unless it's already going to look at incoming_messages_.
+    void wake_up();
+
+    mpsc_queue_t<linux_thread_message_t> incoming_messages_;
+
+    /* True from the time that the thread gets woken up until `on_event()` is done. Other
+    threads don't send another wakeup while it's set, and since `on_event()` checks
+    incoming_messages_ again before it clears it, they don't have to while the thread is
+    busy processing messages. Only the thread that pushes onto an empty
+    incoming_messages_ looks at it at all. */
+    std::atomic<bool> is_woken_up_;
 
     // Use `sort_incoming_messages_by_priority()` to sort incoming_messages_ into
     // these lists.
@@ -7,6 +7,7 @@
 
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/mpsc_queue.hpp"
 
 #ifdef _WIN32
 
@@ -21,7 +22,9 @@ typedef int fd_t;
 #endif
 
 
-class linux_thread_message_t : public intrusive_list_node_t<linux_thread_message_t> {
+class linux_thread_message_t
+    : public intrusive_list_node_t<linux_thread_message_t>,
+      public mpsc_queue_node_t<linux_thread_message_t> {
 public:
     explicit linux_thread_message_t(int _priority)
         : priority(_priority),
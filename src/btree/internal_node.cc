@@ -7,6 +7,18 @@
 
 //In this tree, less than or equal takes the left-hand branch and greater than takes the right hand branch
 
+/* Prefix compression: every key that can end up in a subtree lies inside the key
+range that the parents assign to the subtree's root. If the two keys bounding that
+range share a prefix, then so does every key in between, so an internal node only
+needs to store that prefix once. It goes into the key of the special last pair, which
+older nodes (marked with `internal_node_t::unprefixed_magic`) leave empty. All other
+pairs store their keys with the prefix stripped.
+
+Because a node's prefix is shared by its whole range and not just by the keys it
+currently contains, inserting a key never invalidates it. The prefix is extended when
+a node is split and its parent learns the bounds of both halves, and it is shortened
+when merging or leveling widens a node's range. */
+
 namespace internal_node {
 
 class ibuf_t;
@@ -21,8 +33,26 @@ uint16_t insert_pair(internal_node_t *node, const btree_internal_pair *pair);
 uint16_t insert_pair(internal_node_t *node, block_id_t lnode, const btree_key_t *key);
 void delete_offset(internal_node_t *node, int index);
 void insert_offset(internal_node_t *node, uint16_t offset, int index);
-void make_last_pair_special(internal_node_t *node);
+void make_last_pair_special(internal_node_t *node, const btree_key_t *prefix);
 bool is_equal(const btree_key_t *key1, const btree_key_t *key2);
+
+int compare_to_prefix(const btree_key_t *key, const btree_key_t *prefix);
+int common_prefix_size(const btree_key_t *key1, const btree_key_t *key2);
+void strip_prefix(const internal_node_t *node, const btree_key_t *key, store_key_t *suffix_out);
+void get_key_from_parent(const internal_node_t *parent, const internal_node_t *node,
+                         store_key_t *key_out);
+size_t pairs_size_with_prefix_size(block_size_t block_size, const internal_node_t *node,
+                                   int prefix_size);
+
+// A pair with its full key. The key of the last pair of a node is unused.
+struct entry_t {
+    block_id_t lnode;
+    store_key_t key;
+};
+void read_entries(const internal_node_t *node, std::vector<entry_t> *entries_out);
+size_t entries_size(const entry_t *begin, const entry_t *end, int prefix_size);
+void write_entries(block_size_t block_size, internal_node_t *node,
+                   const entry_t *begin, const entry_t *end, const btree_key_t *prefix);
 }  // namespace impl
 
 void init(block_size_t block_size, internal_node_t *node) {
@@ -33,13 +63,12 @@ void init(block_size_t block_size, internal_node_t *node) {
 
 void init(block_size_t block_size, internal_node_t *node, const internal_node_t *lnode, const uint16_t *offsets, int numpairs) {
     init(block_size, node);
-    rassert(get_pair_by_index(lnode, lnode->npairs-1)->key.size == 0);
     for (int i = 0; i < numpairs; i++) {
         node->pair_offsets[i] = impl::insert_pair(node, get_pair(lnode, offsets[i]));
     }
     node->npairs = numpairs;
     std::sort(node->pair_offsets, node->pair_offsets+node->npairs-1, internal_key_comp(node));
-    rassert(get_pair_by_index(node, node->npairs-1)->key.size == 0);
+    rassert(impl::is_equal(get_prefix(node), get_prefix(lnode)));
 }
 
 block_id_t lookup(const internal_node_t *node, const btree_key_t *key) {
@@ -58,10 +87,13 @@ bool insert(internal_node_t *node, const btree_key_t *key, block_id_t lnode, blo
         impl::insert_offset(node, special_offset, 0);
     }
 
+    store_key_t suffix;
+    impl::strip_prefix(node, key, &suffix);
     int index = get_offset_index(node, key);
-    rassert(!impl::is_equal(&get_pair_by_index(node, index)->key, key),
+    rassert(index == node->npairs - 1
+            || !impl::is_equal(&get_pair_by_index(node, index)->key, suffix.btree_key()),
         "tried to insert duplicate key into internal node!");
-    const uint16_t offset = impl::insert_pair(node, lnode, key);
+    const uint16_t offset = impl::insert_pair(node, lnode, suffix.btree_key());
     impl::insert_offset(node, offset, index);
 
     get_pair_by_index(node, index + 1)->lnode = rnode;
@@ -69,12 +101,13 @@ bool insert(internal_node_t *node, const btree_key_t *key, block_id_t lnode, blo
 }
 
 bool remove(block_size_t block_size, internal_node_t *node, const btree_key_t *key) {
+    const store_key_t prefix(get_prefix(node));
     int index = get_offset_index(node, key);
     impl::delete_pair(node, node->pair_offsets[index]);
     impl::delete_offset(node, index);
 
     if (index == node->npairs) {
-        impl::make_last_pair_special(node);
+        impl::make_last_pair_special(node, prefix.btree_key());
     }
 
     validate(block_size, node);
@@ -92,9 +125,12 @@ void split(block_size_t block_size, internal_node_t *node, internal_node_t *rnod
     int median_index = index;
 
     // Equality takes the left branch, so the median should be from this node.
-    const btree_key_t *median_key = &get_pair_by_index(node, median_index-1)->key;
-    keycpy(median, median_key);
+    store_key_t median_key;
+    get_key_by_index(node, median_index-1, &median_key);
+    keycpy(median, median_key.btree_key());
 
+    // Both halves cover a part of this node's range, so they can keep its prefix.
+    const store_key_t prefix(get_prefix(node));
     init(block_size, rnode, node, node->pair_offsets + median_index, node->npairs - median_index);
 
     // TODO: This is really slow because most pairs will likely be copied
@@ -106,7 +142,7 @@ void split(block_size_t block_size, internal_node_t *node, internal_node_t *rnod
     const uint16_t new_npairs = median_index;
     node->npairs = new_npairs;
     //make last pair special
-    impl::make_last_pair_special(node);
+    impl::make_last_pair_special(node, prefix.btree_key());
 
     validate(block_size, node);
     validate(block_size, rnode);
@@ -116,23 +152,26 @@ void merge(block_size_t block_size, const internal_node_t *node, internal_node_t
     validate(block_size, node);
     validate(block_size, rnode);
     // get the key in parent which points to node
-    const btree_key_t *key_from_parent = &get_pair_by_index(parent, get_offset_index(parent, &get_pair_by_index(node, 0)->key))->key;
-
-    guarantee(sizeof(internal_node_t) + (node->npairs + rnode->npairs)*sizeof(*node->pair_offsets) +
-        (block_size.value() - node->frontmost_offset) + (block_size.value() - rnode->frontmost_offset) + key_from_parent->size < block_size.value(),
+    store_key_t key_from_parent;
+    impl::get_key_from_parent(parent, node, &key_from_parent);
+
+    // The merged node covers the ranges of both nodes, so it can only keep the part
+    // of the prefix that they share.
+    const btree_key_t *lprefix = get_prefix(node);
+    const store_key_t prefix(impl::common_prefix_size(lprefix, get_prefix(rnode)),
+                             lprefix->contents);
+
+    std::vector<impl::entry_t> entries;
+    impl::read_entries(node, &entries);
+    entries.back().key = key_from_parent;
+    impl::read_entries(rnode, &entries);
+
+    const impl::entry_t *begin = entries.data();
+    const impl::entry_t *end = begin + entries.size();
+    guarantee(impl::entries_size(begin, end, prefix.size()) < block_size.value(),
         "internal nodes too full to merge");
 
-    memmove(rnode->pair_offsets + node->npairs, rnode->pair_offsets, rnode->npairs * sizeof(*rnode->pair_offsets));
-
-    for (int i = 0; i < node->npairs-1; i++) { // the last pair is special
-        const uint16_t new_offset = impl::insert_pair(rnode, get_pair_by_index(node, i));
-        rnode->pair_offsets[i] = new_offset;
-    }
-    const uint16_t new_offset = impl::insert_pair(rnode, get_pair_by_index(node, node->npairs-1)->lnode, key_from_parent);
-    rnode->pair_offsets[node->npairs - 1] = new_offset;
-
-    const uint16_t new_npairs = rnode->npairs + node->npairs;
-    rnode->npairs = new_npairs;
+    impl::write_entries(block_size, rnode, begin, end, prefix.btree_key());
 
     validate(block_size, rnode);
 }
@@ -143,96 +182,90 @@ bool level(block_size_t block_size, internal_node_t *node,
            std::vector<block_id_t> *moved_children_out) {
     validate(block_size, node);
     validate(block_size, sibling);
-    if (moved_children_out != nullptr) {
-        moved_children_out->reserve(sibling->npairs);
+
+    const bool node_is_left = nodecmp(node, sibling) < 0;
+    internal_node_t *left = node_is_left ? node : sibling;
+    internal_node_t *right = node_is_left ? sibling : node;
+
+    store_key_t key_from_parent;
+    impl::get_key_from_parent(parent, left, &key_from_parent);
+
+    // Lay out the pairs of both nodes in order. The special pair of `left` gets the
+    // key from the parent, and then we pick a new boundary between the two nodes.
+    std::vector<impl::entry_t> entries;
+    impl::read_entries(left, &entries);
+    entries.back().key = key_from_parent;
+    const int old_boundary = entries.size();
+    impl::read_entries(right, &entries);
+    const int num_entries = entries.size();
+
+    // Balance the nodes by the size of the pairs with their full keys. The actual
+    // sizes depend on the new prefixes, which depend on the boundary.
+    std::vector<size_t> sizes_before(num_entries + 1, 0);
+    for (int i = 0; i < num_entries; ++i) {
+        const int key_size = i == num_entries - 1 ? 0 : entries[i].key.size();
+        sizes_before[i + 1] = sizes_before[i] + sizeof(*node->pair_offsets)
+            + impl::pair_size_with_key_size(key_size);
     }
+    const size_t total_size = sizes_before[num_entries];
 
-    if (nodecmp(node, sibling) < 0) {
-        const btree_key_t *key_from_parent = &get_pair_by_index(parent, get_offset_index(parent, &get_pair_by_index(node, 0)->key))->key;
-        if (sizeof(internal_node_t) + (node->npairs + 1) * sizeof(*node->pair_offsets) + impl::pair_size_with_key(key_from_parent) >= node->frontmost_offset)
+    // Each node has to keep at least two pairs, and the node has to gain at least one.
+    int boundary;
+    if (node_is_left) {
+        boundary = old_boundary + 1;
+        if (boundary > num_entries - 2) {
             return false;
-        uint16_t special_pair_offset = node->pair_offsets[node->npairs-1];
-        block_id_t last_offset = get_pair(node, special_pair_offset)->lnode;
-        uint16_t new_pair_offset = impl::insert_pair(node, last_offset, key_from_parent);
-        node->pair_offsets[node->npairs - 1] = new_pair_offset;
-
-        uint16_t new_npairs = node->npairs;
-        // This loop involves repeated memmoves (resulting in ~(n^2) work where n is
-        // the block size).  There should be a way to drastically reduce the number
-        // and increase efficiency.
-        for (;;) {
-            const btree_internal_pair *pair_to_move = get_pair_by_index(sibling, 0);
-            uint16_t size_change = sizeof(*node->pair_offsets) + pair_size(pair_to_move);
-            if (new_npairs * sizeof(*node->pair_offsets) + (block_size.value() - node->frontmost_offset) + size_change >= sibling->npairs * sizeof(*sibling->pair_offsets) + (block_size.value() - sibling->frontmost_offset) - size_change) {
-                break;
-            }
-
-            const uint16_t new_offset = impl::insert_pair(node, pair_to_move);
-            node->pair_offsets[new_npairs] = new_offset;
-            ++new_npairs;
-            if (moved_children_out != nullptr) {
-                moved_children_out->push_back(pair_to_move->lnode);
-            }
-
-            impl::delete_pair(sibling, sibling->pair_offsets[0]);
-            impl::delete_offset(sibling, 0);
         }
-
-        const btree_internal_pair *pair_for_parent = get_pair_by_index(sibling, 0);
-
-        node->pair_offsets[new_npairs] = special_pair_offset;
-        ++new_npairs;
-
-        node->npairs = new_npairs;
-
-        btree_internal_pair *special_pair = get_pair(node, special_pair_offset);
-        special_pair->lnode = pair_for_parent->lnode;
-
-        keycpy(replacement_key, &pair_for_parent->key);
-
-        if (moved_children_out != nullptr) {
-            moved_children_out->push_back(pair_for_parent->lnode);
+        while (boundary + 1 <= num_entries - 2
+               && sizes_before[boundary + 1] < total_size - sizes_before[boundary + 1]) {
+            ++boundary;
         }
-        impl::delete_pair(sibling, sibling->pair_offsets[0]);
-        impl::delete_offset(sibling, 0);
     } else {
-        uint16_t offset;
-        const btree_key_t *key_from_parent = &get_pair_by_index(parent, get_offset_index(parent, &get_pair_by_index(sibling, 0)->key))->key;
-        if (sizeof(internal_node_t) + (node->npairs + 1) * sizeof(*node->pair_offsets) + impl::pair_size_with_key(key_from_parent) >= node->frontmost_offset)
+        boundary = old_boundary - 1;
+        if (boundary < 2) {
             return false;
-        block_id_t first_child = get_pair_by_index(sibling, sibling->npairs-1)->lnode;
-        offset = impl::insert_pair(node, first_child, key_from_parent);
-        impl::insert_offset(node, offset, 0);
-        if (moved_children_out != nullptr) {
-            moved_children_out->push_back(first_child);
         }
-        impl::delete_pair(sibling, sibling->pair_offsets[sibling->npairs-1]);
-        impl::delete_offset(sibling, sibling->npairs-1);
-
-        // This loop involves repeated memmoves. There should be a way to
-        // drastically reduce the number and increase efficiency.
-        for (;;) {
-            const btree_internal_pair *pair_to_move = get_pair_by_index(sibling, sibling->npairs-1);
-            uint16_t size_change = sizeof(*node->pair_offsets) + pair_size(pair_to_move);
-            if (node->npairs * sizeof(*node->pair_offsets) + (block_size.value() - node->frontmost_offset) + size_change >= sibling->npairs * sizeof(*sibling->pair_offsets) + (block_size.value() - sibling->frontmost_offset) - size_change) {
-                break;
-            }
-
-            offset = impl::insert_pair(node, pair_to_move);
-            impl::insert_offset(node, offset, 0);
-            if (moved_children_out != nullptr) {
-                moved_children_out->push_back(pair_to_move->lnode);
-            }
-
-            impl::delete_pair(sibling, sibling->pair_offsets[sibling->npairs-1]);
-            impl::delete_offset(sibling, sibling->npairs-1);
+        while (boundary - 1 >= 2
+               && total_size - sizes_before[boundary - 1] < sizes_before[boundary - 1]) {
+            --boundary;
         }
+    }
 
-        keycpy(replacement_key, &get_pair_by_index(sibling, sibling->npairs-1)->key);
+    // Both nodes keep the part of their prefix that they share with the new key in
+    // the parent. That's still a prefix of every key in their new ranges.
+    const btree_key_t *new_key = entries[boundary - 1].key.btree_key();
+    const btree_key_t *lprefix = get_prefix(left);
+    const btree_key_t *rprefix = get_prefix(right);
+    const store_key_t new_lprefix(impl::common_prefix_size(lprefix, new_key),
+                                  lprefix->contents);
+    const store_key_t new_rprefix(impl::common_prefix_size(rprefix, new_key),
+                                  rprefix->contents);
+
+    const impl::entry_t *begin = entries.data();
+    const impl::entry_t *mid = begin + boundary;
+    const impl::entry_t *end = begin + num_entries;
+    const size_t new_lsize = impl::entries_size(begin, mid, new_lprefix.size());
+    const size_t new_rsize = impl::entries_size(mid, end, new_rprefix.size());
+    // `node` must be able to take another key afterwards, see `change_unsafe()`.
+    const size_t new_node_size = node_is_left ? new_lsize : new_rsize;
+    if (new_lsize >= block_size.value() || new_rsize >= block_size.value()
+        || new_node_size + MAX_KEY_SIZE >= block_size.value()) {
+        return false;
+    }
 
-        impl::make_last_pair_special(sibling);
+    if (moved_children_out != nullptr) {
+        const int moved_begin = node_is_left ? old_boundary : boundary;
+        const int moved_end = node_is_left ? boundary : old_boundary;
+        moved_children_out->reserve(moved_end - moved_begin);
+        for (int i = moved_begin; i < moved_end; ++i) {
+            moved_children_out->push_back(entries[i].lnode);
+        }
     }
 
+    keycpy(replacement_key, new_key);
+    impl::write_entries(block_size, left, begin, mid, new_lprefix.btree_key());
+    impl::write_entries(block_size, right, mid, end, new_rprefix.btree_key());
+
     validate(block_size, node);
     validate(block_size, sibling);
     guarantee(!change_unsafe(node), "level made internal node dangerously full");
@@ -245,11 +278,11 @@ int sibling(const internal_node_t *node, const btree_key_t *key, block_id_t *sib
     int cmp;
     if (index > 0) {
         sib_pair = get_pair_by_index(node, index-1);
-        key_in_middle_out->assign(&sib_pair->key);
+        get_key_by_index(node, index-1, key_in_middle_out);
         cmp = 1;
     } else {
         sib_pair = get_pair_by_index(node, index+1);
-        key_in_middle_out->assign(&get_pair_by_index(node, index)->key);
+        get_key_by_index(node, index, key_in_middle_out);
         cmp = -1;
     }
 
@@ -274,17 +307,18 @@ void update_key(internal_node_t *node, const btree_key_t *key_to_replace, const
 
     const int index = get_offset_index(node, key_to_replace);
     const block_id_t tmp_lnode = get_pair_by_index(node, index)->lnode;
+    store_key_t suffix;
+    impl::strip_prefix(node, replacement_key, &suffix);
     impl::delete_pair(node, node->pair_offsets[index]);
 
-    guarantee(sizeof(internal_node_t) + (node->npairs) * sizeof(*node->pair_offsets) + impl::pair_size_with_key(replacement_key) < node->frontmost_offset,
+    guarantee(sizeof(internal_node_t) + (node->npairs) * sizeof(*node->pair_offsets) + impl::pair_size_with_key(suffix.btree_key()) < node->frontmost_offset,
         "cannot fit updated key in internal node");
 
-    const uint16_t new_offset = impl::insert_pair(node, tmp_lnode, replacement_key);
+    const uint16_t new_offset = impl::insert_pair(node, tmp_lnode, suffix.btree_key());
     node->pair_offsets[index] = new_offset;
 
     rassert(is_sorted(node->pair_offsets, node->pair_offsets+node->npairs-1, internal_key_comp(node)),
             "Invalid key given to update_key: offsets no longer in sorted order");
-    rassert(get_pair_by_index(node, node->npairs-1)->key.size == 0);
 }
 
 bool is_full(const internal_node_t *node) {
@@ -306,7 +340,15 @@ void validate(DEBUG_VAR block_size_t block_size, DEBUG_VAR const internal_node_t
     }
     rassert(is_sorted(node->pair_offsets, node->pair_offsets+node->npairs-1, internal_key_comp(node)),
         "Offsets no longer in sorted order");
-    rassert(get_pair_by_index(node, node->npairs-1)->key.size == 0);
+    if (node->magic == internal_node_t::unprefixed_magic) {
+        rassert(get_pair_by_index(node, node->npairs-1)->key.size == 0);
+    } else {
+        rassert(node->magic == internal_node_t::expected_magic);
+        for (int i = 0; i < node->npairs - 1; i++) {
+            rassert(get_prefix(node)->size + get_pair_by_index(node, i)->key.size
+                    <= MAX_KEY_SIZE);
+        }
+    }
 #endif
 }
 
@@ -319,16 +361,23 @@ bool is_underfull(block_size_t block_size, const internal_node_t *node) {
 }
 
 bool is_mergable(block_size_t block_size, const internal_node_t *node, const internal_node_t *sibling, const internal_node_t *parent) {
-    const btree_key_t *key_from_parent;
-    if (nodecmp(node, sibling) < 0) {
-        key_from_parent = &get_pair_by_index(parent, get_offset_index(parent, &get_pair_by_index(node, 0)->key))->key;
-    } else {
-        key_from_parent = &get_pair_by_index(parent, get_offset_index(parent, &get_pair_by_index(sibling, 0)->key))->key;
+    const internal_node_t *left = node;
+    const internal_node_t *right = sibling;
+    if (nodecmp(node, sibling) >= 0) {
+        std::swap(left, right);
     }
-    return sizeof(internal_node_t) +
-        (node->npairs + sibling->npairs + 1)*sizeof(*node->pair_offsets) +
-        (block_size.value() - node->frontmost_offset) +
-        (block_size.value() - sibling->frontmost_offset) + key_from_parent->size +
+    store_key_t key_from_parent;
+    impl::get_key_from_parent(parent, left, &key_from_parent);
+
+    // See `merge()` for the prefix of the merged node.
+    const int prefix_size = impl::common_prefix_size(get_prefix(left), get_prefix(right));
+    const size_t merged_size = sizeof(internal_node_t) +
+        (left->npairs + right->npairs) * sizeof(*node->pair_offsets) +
+        impl::pairs_size_with_prefix_size(block_size, left, prefix_size) +
+        impl::pair_size_with_key_size(key_from_parent.size() - prefix_size) +
+        impl::pairs_size_with_prefix_size(block_size, right, prefix_size) +
+        impl::pair_size_with_key_size(prefix_size);
+    return merged_size + sizeof(*node->pair_offsets) +
         impl::pair_size_with_key_size(MAX_KEY_SIZE) +
         INTERNAL_EPSILON < block_size.value(); // must still have enough room for an arbitrary key  // TODO: we can't be tighter?
 }
@@ -356,15 +405,86 @@ btree_internal_pair *get_pair_by_index(internal_node_t *node, int index) {
     return get_pair(node, node->pair_offsets[index]);
 }
 
+const btree_key_t *get_prefix(const internal_node_t *node) {
+    rassert(node->npairs > 0);
+    // Nodes with `unprefixed_magic` always leave this key empty.
+    return &get_pair_by_index(node, node->npairs - 1)->key;
+}
+
+void get_key_by_index(const internal_node_t *node, int index, store_key_t *key_out) {
+    rassert(index < node->npairs - 1, "the last pair has no key");
+    const btree_key_t *prefix = get_prefix(node);
+    const btree_key_t *suffix = &get_pair_by_index(node, index)->key;
+    guarantee(prefix->size + suffix->size <= MAX_KEY_SIZE,
+              "corrupted internal node: key too large");
+    key_out->set_size(prefix->size + suffix->size);
+    memcpy(key_out->contents(), prefix->contents, prefix->size);
+    memcpy(key_out->contents() + prefix->size, suffix->contents, suffix->size);
+}
+
+void get_child_prefix(const internal_node_t *node, int index, store_key_t *prefix_out) {
+    rassert(index >= 0 && index < node->npairs);
+    if (index > 0 && index < node->npairs - 1) {
+        store_key_t left_bound, right_bound;
+        get_key_by_index(node, index - 1, &left_bound);
+        get_key_by_index(node, index, &right_bound);
+        prefix_out->assign(
+            impl::common_prefix_size(left_bound.btree_key(), right_bound.btree_key()),
+            left_bound.contents());
+    } else {
+        // One of the child's bounds is also a bound of `node`.
+        prefix_out->assign(get_prefix(node));
+    }
+}
+
+void extend_prefix(block_size_t block_size, internal_node_t *node, const btree_key_t *prefix) {
+    const btree_key_t *old_prefix = get_prefix(node);
+    if (prefix->size <= old_prefix->size
+        || impl::common_prefix_size(prefix, old_prefix) != old_prefix->size) {
+        return;
+    }
+
+    std::vector<impl::entry_t> entries;
+    impl::read_entries(node, &entries);
+    for (size_t i = 0; i + 1 < entries.size(); ++i) {
+        if (impl::compare_to_prefix(entries[i].key.btree_key(), prefix) != 0) {
+            // The prefix isn't shared by the node's whole range after all.
+            rassert(false, "tried to extend an internal node's prefix past its range");
+            return;
+        }
+    }
+
+    // Every key gets shorter, so the node still fits.
+    impl::write_entries(block_size, node, entries.data(),
+                        entries.data() + entries.size(), prefix);
+    validate(block_size, node);
+}
+
 int get_offset_index(const internal_node_t *node, const btree_key_t *key) {
-    return std::lower_bound(node->pair_offsets, node->pair_offsets+node->npairs-1, (uint16_t) internal_key_comp::faux_offset, internal_key_comp(node, key)) - node->pair_offsets;
+    const btree_key_t *prefix = get_prefix(node);
+    if (prefix->size == 0) {
+        return std::lower_bound(node->pair_offsets, node->pair_offsets+node->npairs-1, (uint16_t) internal_key_comp::faux_offset, internal_key_comp(node, key)) - node->pair_offsets;
+    }
+
+    // Keys outside of the prefix go to the first or the last child. This only
+    // happens for keys that lie outside of the node's range, for example the
+    // boundaries of a range traversal.
+    const int cmp = impl::compare_to_prefix(key, prefix);
+    if (cmp < 0) {
+        return 0;
+    } else if (cmp > 0) {
+        return node->npairs - 1;
+    }
+    const store_key_t suffix(key->size - prefix->size, key->contents + prefix->size);
+    return std::lower_bound(node->pair_offsets, node->pair_offsets+node->npairs-1, (uint16_t) internal_key_comp::faux_offset, internal_key_comp(node, suffix.btree_key())) - node->pair_offsets;
 }
 
 int nodecmp(const internal_node_t *node1, const internal_node_t *node2) {
-    const btree_key_t *key1 = &get_pair_by_index(node1, 0)->key;
-    const btree_key_t *key2 = &get_pair_by_index(node2, 0)->key;
+    store_key_t key1, key2;
+    get_key_by_index(node1, 0, &key1);
+    get_key_by_index(node2, 0, &key2);
 
-    return btree_key_cmp(key1, key2);
+    return btree_key_cmp(key1.btree_key(), key2.btree_key());
 }
 
 namespace impl {
@@ -383,9 +503,9 @@ void delete_pair(internal_node_t *node, uint16_t offset) {
     const size_t shift = pair_size(pair_to_delete);
     const size_t size = offset - node->frontmost_offset;
 
-    rassert(node->magic == internal_node_t::expected_magic);
+    rassert(node::is_internal(reinterpret_cast<const node_t *>(node)));
     memmove(reinterpret_cast<char *>(front_pair) + shift, front_pair, size);
-    rassert(node->magic == internal_node_t::expected_magic);
+    rassert(node::is_internal(reinterpret_cast<const node_t *>(node)));
 
 
     node->frontmost_offset = node->frontmost_offset + shift;
@@ -445,12 +565,11 @@ void insert_offset(internal_node_t *node, uint16_t offset, int index) {
     node->npairs += 1;
 }
 
-void make_last_pair_special(internal_node_t *node) {
+void make_last_pair_special(internal_node_t *node, const btree_key_t *prefix) {
+    rassert(node->magic == internal_node_t::expected_magic || prefix->size == 0);
     const int index = node->npairs - 1;
     const uint16_t old_offset = node->pair_offsets[index];
-    btree_key_t tmp;
-    tmp.size = 0;
-    const uint16_t new_offset = insert_pair(node, get_pair(node, old_offset)->lnode, &tmp);
+    const uint16_t new_offset = insert_pair(node, get_pair(node, old_offset)->lnode, prefix);
     node->pair_offsets[index] = new_offset;
     delete_pair(node, old_offset);
 }
@@ -460,7 +579,86 @@ bool is_equal(const btree_key_t *key1, const btree_key_t *key2) {
     return btree_key_cmp(key1, key2) == 0;
 }
 
+// Returns zero if `key` starts with `prefix`, and otherwise how `key` compares to
+// all keys that do.
+int compare_to_prefix(const btree_key_t *key, const btree_key_t *prefix) {
+    const int res = memcmp(key->contents, prefix->contents,
+                           std::min(key->size, prefix->size));
+    if (res != 0) {
+        return res;
+    }
+    return key->size < prefix->size ? -1 : 0;
+}
+
+int common_prefix_size(const btree_key_t *key1, const btree_key_t *key2) {
+    const int max_size = std::min(key1->size, key2->size);
+    int size = 0;
+    while (size < max_size && key1->contents[size] == key2->contents[size]) {
+        ++size;
+    }
+    return size;
+}
+
+void strip_prefix(const internal_node_t *node, const btree_key_t *key, store_key_t *suffix_out) {
+    const btree_key_t *prefix = get_prefix(node);
+    guarantee(compare_to_prefix(key, prefix) == 0,
+              "key outside of the range of an internal node");
+    suffix_out->assign(key->size - prefix->size, key->contents + prefix->size);
+}
+
+void get_key_from_parent(const internal_node_t *parent, const internal_node_t *node,
+                         store_key_t *key_out) {
+    store_key_t first_key;
+    get_key_by_index(node, 0, &first_key);
+    get_key_by_index(parent, get_offset_index(parent, first_key.btree_key()), key_out);
+}
+
+// The size of all but the last pair of `node` if its prefix had `prefix_size` bytes.
+size_t pairs_size_with_prefix_size(block_size_t block_size, const internal_node_t *node,
+                                   int prefix_size) {
+    const int old_prefix_size = get_prefix(node)->size;
+    rassert(prefix_size <= old_prefix_size);
+    return (block_size.value() - node->frontmost_offset)
+        - pair_size(get_pair_by_index(node, node->npairs - 1))
+        + (node->npairs - 1) * (old_prefix_size - prefix_size);
+}
+
+void read_entries(const internal_node_t *node, std::vector<entry_t> *entries_out) {
+    const size_t first = entries_out->size();
+    entries_out->resize(first + node->npairs);
+    for (int i = 0; i < node->npairs; ++i) {
+        entry_t *entry = &(*entries_out)[first + i];
+        entry->lnode = get_pair_by_index(node, i)->lnode;
+        if (i < node->npairs - 1) {
+            get_key_by_index(node, i, &entry->key);
+        }
+    }
+}
+
+size_t entries_size(const entry_t *begin, const entry_t *end, int prefix_size) {
+    rassert(begin < end);
+    size_t size = sizeof(internal_node_t) + (end - begin) * sizeof(uint16_t)
+        + pair_size_with_key_size(prefix_size);
+    for (const entry_t *it = begin; it + 1 < end; ++it) {
+        size += pair_size_with_key_size(it->key.size() - prefix_size);
+    }
+    return size;
+}
+
+void write_entries(block_size_t block_size, internal_node_t *node,
+                   const entry_t *begin, const entry_t *end, const btree_key_t *prefix) {
+    guarantee(entries_size(begin, end, prefix->size) <= block_size.value());
+    init(block_size, node);
+    for (const entry_t *it = begin; it + 1 < end; ++it) {
+        rassert(compare_to_prefix(it->key.btree_key(), prefix) == 0);
+        const store_key_t suffix(it->key.size() - prefix->size,
+                                 it->key.contents() + prefix->size);
+        node->pair_offsets[it - begin] = insert_pair(node, it->lnode, suffix.btree_key());
+    }
+    node->pair_offsets[end - begin - 1] = insert_pair(node, (end - 1)->lnode, prefix);
+    node->npairs = end - begin;
+}
+
 }  // namespace impl
 
 }  // namespace internal_node
-
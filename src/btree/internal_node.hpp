@@ -59,6 +59,16 @@ btree_internal_pair *get_pair_by_index(internal_node_t *node, int index);
 
 int get_offset_index(const internal_node_t *node, const btree_key_t *key);
 
+// The prefix that all keys in the node share. The keys of the pairs don't include
+// it, so use `get_key_by_index()` to get the full key of a pair.
+const btree_key_t *get_prefix(const internal_node_t *node);
+void get_key_by_index(const internal_node_t *node, int index, store_key_t *key_out);
+
+// Computes the longest prefix shared by all keys in the range of the child at
+// `index`, and makes `node` store that prefix once if it's longer than its own.
+void get_child_prefix(const internal_node_t *node, int index, store_key_t *prefix_out);
+void extend_prefix(block_size_t block_size, internal_node_t *node, const btree_key_t *prefix);
+
 }  // namespace internal_node
 
 class internal_key_comp {
@@ -1,6 +1,10 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "btree/keys.hpp"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "debug.hpp"
 #include "utils.hpp"
 
@@ -20,6 +24,42 @@ int sized_strcmp(const uint8_t *str1, int len1, const uint8_t *str2, int len2) {
     return res;
 }
 
+int sized_strcmp_with_prefix(const uint8_t *str1, int len1, const uint8_t *str2, int len2,
+                             int known_prefix, int *common_prefix_out) {
+    const int min_len = std::min(len1, len2);
+    rassert(known_prefix <= min_len);
+    int i = known_prefix;
+#if defined(__SSE2__)
+    // Find the first differing byte sixteen bytes at a time.
+    for (; i + 16 <= min_len; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str1 + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str2 + i));
+        const int equal_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+        if (equal_mask != 0xffff) {
+            i += __builtin_ctz(~equal_mask);
+            *common_prefix_out = i;
+            return static_cast<int>(str1[i]) - static_cast<int>(str2[i]);
+        }
+    }
+#endif
+    for (; i + 8 <= min_len; i += 8) {
+        uint64_t a, b;
+        memcpy(&a, str1 + i, sizeof(a));
+        memcpy(&b, str2 + i, sizeof(b));
+        if (a != b) {
+            break;
+        }
+    }
+    for (; i < min_len; ++i) {
+        if (str1[i] != str2[i]) {
+            *common_prefix_out = i;
+            return static_cast<int>(str1[i]) - static_cast<int>(str2[i]);
+        }
+    }
+    *common_prefix_out = min_len;
+    return len1 - len2;
+}
+
 bool unescaped_str_to_key(const char *str, int len, store_key_t *buf) {
     if (len <= MAX_KEY_SIZE) {
         memcpy(buf->contents(), str, len);
@@ -38,6 +38,13 @@ bool is_better(const T &a, const T &b, sorting_t sorting) {
 // Fast string compare
 int sized_strcmp(const uint8_t *str1, int len1, const uint8_t *str2, int len2);
 
+// Like `sized_strcmp()`, but skips the first `known_prefix` bytes, which the caller
+// knows the strings to share, and stores the length of their longest common prefix
+// in `*common_prefix_out`. Searches over sorted keys use this to avoid comparing
+// the same leading bytes again and again.
+int sized_strcmp_with_prefix(const uint8_t *str1, int len1, const uint8_t *str2, int len2,
+                             int known_prefix, int *common_prefix_out);
+
 // Note: Changing this struct changes the format of the data stored on disk.
 // If you change this struct, previous stored data will be misinterpreted.
 ATTR_PACKED(struct btree_key_t {
@@ -1190,20 +1190,38 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
     // beg == 0 or key > *(beg - 1).
     // end == num_pairs or key < *end.
 
+    // The lengths of the common prefixes of key and *(beg - 1), and of key and
+    // *end. Every entry in between shares at least the shorter one with key, so
+    // comparisons can skip it. Secondary index keys tend to share long prefixes.
+    int beg_common_prefix = 0;
+    int end_common_prefix = 0;
+
     while (beg < end) {
         // when (end - beg) > 0, (end - beg) / 2 is always less than (end - beg).  So beg <= test_point < end.
         int test_point = beg + (end - beg) / 2;
 
+        // Whichever way this comparison goes, one of these is probed next. Fetching
+        // both now overlaps their cache misses with the comparison.
+        if (end - beg > 2) {
+            __builtin_prefetch(get_entry(node, node->pair_offsets[beg + (test_point - beg) / 2]));
+            __builtin_prefetch(get_entry(node, node->pair_offsets[test_point + 1 + (end - test_point - 1) / 2]));
+        }
+
         const btree_key_t *ek = entry_key(get_entry(node, node->pair_offsets[test_point]));
 
-        int res = btree_key_cmp(key, ek);
+        int common_prefix;
+        int res = sized_strcmp_with_prefix(key->contents, key->size, ek->contents, ek->size,
+                                           std::min(beg_common_prefix, end_common_prefix),
+                                           &common_prefix);
 
         if (res < 0) {
             // key < *test_point.
             end = test_point;
+            end_common_prefix = common_prefix;
         } else if (res > 0) {
             // key > *test_point.  Since test_point < end, we have test_point + 1 <= end.
             beg = test_point + 1;
+            beg_common_prefix = common_prefix;
         } else {
             // We found the key!
             *index_out = test_point;
@@ -4,7 +4,8 @@
 #include "btree/leaf_node.hpp"
 #include "btree/internal_node.hpp"
 
-const block_magic_t internal_node_t::expected_magic = { { 'i', 'n', 't', 'e' } };
+const block_magic_t internal_node_t::expected_magic = { { 'i', 'n', 't', 'p' } };
+const block_magic_t internal_node_t::unprefixed_magic = { { 'i', 'n', 't', 'e' } };
 
 namespace node {
 
@@ -49,7 +50,7 @@ void validate(DEBUG_VAR value_sizer_t *sizer, DEBUG_VAR const node_t *node) {
 #ifndef NDEBUG
     if (node->magic == sizer->btree_leaf_magic()) {
         leaf::validate(sizer, reinterpret_cast<const leaf_node_t *>(node));
-    } else if (node->magic == internal_node_t::expected_magic) {
+    } else if (is_internal(node)) {
         internal_node::validate(sizer->block_size(), reinterpret_cast<const internal_node_t *>(node));
     } else {
         unreachable("Invalid leaf node type.");
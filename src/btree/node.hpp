@@ -49,7 +49,14 @@ ATTR_PACKED(struct internal_node_t {
     uint16_t frontmost_offset;
     uint16_t pair_offsets[0];
 
+    // Nodes with `expected_magic` store their keys without a shared prefix, which
+    // goes into the key of the last pair instead. Nodes written by older versions
+    // have `unprefixed_magic` and an empty last key, so they read the same way. Older
+    // versions take nodes with `expected_magic` for leaves, so files move to
+    // serializer version 2.4 before the first one gets written (see
+    // `check_and_handle_split()`).
     static const block_magic_t expected_magic;
+    static const block_magic_t unprefixed_magic;
 });
 
 // A node_t is either a btree_internal_node or a btree_leaf_node.
@@ -60,7 +67,8 @@ ATTR_PACKED(struct node_t {
 namespace node {
 
 inline bool is_internal(const node_t *node) {
-    if (node->magic == internal_node_t::expected_magic) {
+    if (node->magic == internal_node_t::expected_magic
+        || node->magic == internal_node_t::unprefixed_magic) {
         return true;
     }
     return false;
@@ -73,12 +73,14 @@ void check_and_handle_split(value_sizer_t *sizer,
                             superblock_t *sb,
                             const btree_key_t *key, void *new_value,
                             const value_deleter_t *detacher) {
+    bool is_internal;
     {
         buf_read_t buf_read(buf);
         const node_t *node = static_cast<const node_t *>(buf_read.get_data_read());
+        is_internal = node::is_internal(node);
 
         // If the node isn't full, we don't need to split, so we're done.
-        if (!node::is_internal(node)) { // This should only be called when update_needed.
+        if (!is_internal) { // This should only be called when update_needed.
             rassert(new_value);
             if (!leaf::is_full(sizer, reinterpret_cast<const leaf_node_t *>(node),
                                key, new_value)) {
@@ -92,6 +94,13 @@ void check_and_handle_split(value_sizer_t *sizer,
         }
     }
 
+    // Splitting an internal node or the root writes internal nodes with prefixed
+    // keys, which older versions read as leaves. They refuse to open files of the
+    // current serializer format, so the file has to move to it first.
+    if (is_internal || last_buf->empty()) {
+        buf->cache()->require_current_serializer_format();
+    }
+
     // If we are splitting the root, we must detach it from sb first.
     // It will later be attached to a newly created root, together with its
     // newly created sibling.
@@ -152,6 +161,32 @@ void check_and_handle_split(value_sizer_t *sizer,
         rassert(success, "could not insert internal btree node");
     }
 
+    // Now that the parent bounds both halves more tightly, internal nodes can strip
+    // a longer prefix off their keys.
+    if (is_internal) {
+        store_key_t lprefix, rprefix;
+        {
+            buf_read_t last_read(last_buf);
+            const internal_node_t *parent
+                = static_cast<const internal_node_t *>(last_read.get_data_read());
+            const int index = internal_node::get_offset_index(parent, median);
+            internal_node::get_child_prefix(parent, index, &lprefix);
+            internal_node::get_child_prefix(parent, index + 1, &rprefix);
+        }
+        {
+            buf_write_t buf_write(buf);
+            internal_node::extend_prefix(sizer->block_size(),
+                static_cast<internal_node_t *>(buf_write.get_data_write()),
+                lprefix.btree_key());
+        }
+        {
+            buf_write_t rbuf_write(&rbuf);
+            internal_node::extend_prefix(sizer->block_size(),
+                static_cast<internal_node_t *>(rbuf_write.get_data_write()),
+                rprefix.btree_key());
+        }
+    }
+
     // We've split the node; now figure out where the key goes and release the other buf (since we're done with it).
     if (0 >= btree_key_cmp(key, median)) {
         // The key goes in the old buf (the left one).
@@ -174,6 +209,7 @@ void check_and_handle_underfull(value_sizer_t *sizer,
                                 const btree_key_t *key,
                                 const value_deleter_t *detacher) {
     bool node_is_underfull;
+    bool node_is_internal = false;
     {
         if (last_buf->empty()) {
             // The root node is never underfull.
@@ -182,9 +218,16 @@ void check_and_handle_underfull(value_sizer_t *sizer,
             buf_read_t buf_read(buf);
             const node_t *const node = static_cast<const node_t *>(buf_read.get_data_read());
             node_is_underfull = node::is_underfull(sizer, node);
+            node_is_internal = node::is_internal(node);
         }
     }
     if (node_is_underfull) {
+        // Merging or leveling internal nodes rewrites them with prefixed keys (see
+        // `check_and_handle_split()`).
+        if (node_is_internal) {
+            buf->cache()->require_current_serializer_format();
+        }
+
         // Acquire a sibling to merge or level with.
         store_key_t key_in_middle;
         block_id_t sib_node_id;
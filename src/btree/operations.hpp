@@ -67,7 +67,8 @@ public:
               &pm_keys_read, "keys_read",
               &pm_total_keys_read, "total_keys_read",
               &pm_keys_set, "keys_set",
-              &pm_total_keys_set, "total_keys_set") {
+              &pm_total_keys_set, "total_keys_set",
+              &pm_total_sorted_inserts, "total_sorted_inserts") {
         if (parent != nullptr) {
             rename(parent, identifier);
         }
@@ -94,6 +95,8 @@ public:
     perfmon_counter_t
         pm_total_keys_read,
         pm_total_keys_set;
+    // Batches that `rdb_batched_insert_into_empty_range()` inserted in key order.
+    perfmon_counter_t pm_total_sorted_inserts;
     perfmon_multi_membership_t pm_keys_membership;
 };
 
@@ -426,7 +426,7 @@ struct do_a_subtree_traversal_fsm_t : public node_ready_callback_t {
         rassert(coro_t::self());
         bool is_leaf;
         {
-            buf_read_t read(&buf);
+            buf_read_t read(&buf, page_reuse_t::LOW);
             const node_t *node = static_cast<const node_t *>(read.get_data_read());
             is_leaf = node::is_leaf(node);
         }
@@ -490,7 +490,7 @@ void process_a_internal_node(traversal_state_t *state,
                              const btree_key_t *right_inclusive_or_null) {
     counted_t<ranged_block_ids_t> ids_source;
     {
-        buf_read_t read(&buf);
+        buf_read_t read(&buf, page_reuse_t::LOW);
         const internal_node_t *node
             = static_cast<const internal_node_t *>(read.get_data_read());
 
@@ -591,6 +591,21 @@ int ranged_block_ids_t::num_block_ids() const {
     }
 }
 
+ranged_block_ids_t::ranged_block_ids_t(block_size_t bs, const internal_node_t *node,
+                                       const btree_key_t *left_exclusive_or_null,
+                                       const btree_key_t *right_inclusive_or_null,
+                                       int _level)
+    : node_(bs.value()),
+      keys_(node->npairs - 1),
+      left_exclusive_or_null_(left_exclusive_or_null),
+      right_inclusive_or_null_(right_inclusive_or_null),
+      level(_level) {
+    memcpy(node_.get(), node, bs.value());
+    for (int i = 0; i < node->npairs - 1; ++i) {
+        internal_node::get_key_by_index(node, i, &keys_[i]);
+    }
+}
+
 void ranged_block_ids_t::get_block_id_and_bounding_interval(int index,
                                                             block_id_t *block_id_out,
                                                             const btree_key_t **left_excl_bound_out,
@@ -601,13 +616,12 @@ void ranged_block_ids_t::get_block_id_and_bounding_interval(int index,
 
         const btree_internal_pair *pair = internal_node::get_pair_by_index(node_.get(), index);
         *block_id_out = pair->lnode;
-        *right_incl_bound_out = (index == node_->npairs - 1 ? right_inclusive_or_null_ : &pair->key);
+        *right_incl_bound_out = (index == node_->npairs - 1 ? right_inclusive_or_null_ : keys_[index].btree_key());
 
         if (index == 0) {
             *left_excl_bound_out = left_exclusive_or_null_;
         } else {
-            const btree_internal_pair *left_neighbor = internal_node::get_pair_by_index(node_.get(), index - 1);
-            *left_excl_bound_out = &left_neighbor->key;
+            *left_excl_bound_out = keys_[index - 1].btree_key();
         }
     } else {
         *block_id_out = forced_block_id_;
@@ -181,6 +181,8 @@ btree_slice_t::btree_slice_t(cache_t *c, perfmon_collection_t *parent,
                              index_type_t index_type)
     : stats(parent,
             (index_type == index_type_t::SECONDARY ? "index-" : "") + identifier),
+      field_dictionary(nullptr),
+      key_filter(nullptr),
       cache_(c),
       backfill_account_(cache()->create_cache_account(BACKFILL_CACHE_PRIORITY)) { }
 
@@ -15,6 +15,8 @@ metainfo, which are unrelated to the B-tree but stored on the ReQL primary super
 They should probably be moved out of the `btree/` directory. */
 
 class binary_blob_t;
+class field_dictionary_manager_t;
+class key_filter_t;
 
 /* `real_superblock_t` represents the superblock for the primary B-tree of a table. */
 class real_superblock_t : public superblock_t {
@@ -100,6 +102,15 @@ public:
 
     btree_stats_t stats;
 
+    /* The field dictionary that the table's rows are serialized against. It's shared by
+    the primary and all sindex slices of a `store_t`, and NULL for slices that don't
+    belong to one. */
+    field_dictionary_manager_t *field_dictionary;
+
+    /* The filter of the keys in the B-tree, which only the primary slice of a `store_t`
+    has. NULL for other slices. */
+    key_filter_t *key_filter;
+
 private:
     cache_t *cache_;
 
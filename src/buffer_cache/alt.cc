@@ -6,6 +6,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "buffer_cache/stats.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "serializer/serializer.hpp"
 #include "utils.hpp"
 
 #define ALT_DEBUG 0
@@ -141,10 +142,42 @@ void cache_t::configure_flush_interval(flush_interval_t interval) {
         clamp_ring_length(which_cpu_shard_, interval.millis));
 }
 
+void cache_t::configure_block_compression(block_compression_t compression) {
+    page_cache_.set_block_compression(compression);
+}
+
+void cache_t::configure_eviction_policy(eviction_policy_t policy) {
+    page_cache_.evicter().set_eviction_policy(policy);
+}
+
+void cache_t::configure_cache_quota(cache_quota_t quota) {
+    page_cache_.evicter().set_cache_quota(quota);
+}
+
+void cache_t::set_external_memory_size(uint64_t bytes) {
+    page_cache_.evicter().set_external_size(bytes);
+}
+
+void cache_t::require_current_serializer_format() {
+    page_cache_.serializer()->require_current_format();
+}
+
 cache_account_t cache_t::create_cache_account(int priority) {
     return page_cache_.create_cache_account(priority);
 }
 
+std::vector<block_id_t> cache_t::hot_block_ids(size_t max_count) const {
+    return page_cache_.hot_block_ids(max_count);
+}
+
+void cache_t::warm_up(const std::vector<block_id_t> &block_ids,
+                      signal_t *interruptor) {
+    cache_account_t account = create_cache_account(CACHE_WARMUP_CACHE_PRIORITY);
+    for (block_id_t block_id : block_ids) {
+        page_cache_.warm_up_block(block_id, &account, interruptor);
+    }
+}
+
 alt_snapshot_node_t *
 cache_t::matching_snapshot_node_or_null(block_id_t block_id,
                                         block_version_t block_version) {
@@ -801,7 +834,13 @@ page_t *buf_lock_t::get_held_page_for_write() {
 }
 
 buf_read_t::buf_read_t(buf_lock_t *lock)
-    : lock_(lock) {
+    : lock_(lock), reuse_(page_reuse_t::NORMAL) {
+    guarantee(!lock_->empty());
+    lock_->access_ref_count_++;
+}
+
+buf_read_t::buf_read_t(buf_lock_t *lock, page_reuse_t reuse)
+    : lock_(lock), reuse_(reuse) {
     guarantee(!lock_->empty());
     lock_->access_ref_count_++;
 }
@@ -819,7 +858,7 @@ const void *buf_read_t::get_data_read(uint32_t *block_size_out) {
     }
     page_acq_.buf_ready_signal()->wait();
     *block_size_out = page_acq_.get_buf_size().value();
-    return page_acq_.get_buf_read();
+    return page_acq_.get_buf_read(reuse_);
 }
 
 buf_write_t::buf_write_t(buf_lock_t *lock)
@@ -63,6 +63,23 @@ public:
     cache_account_t create_cache_account(int priority);
 
     void configure_flush_interval(flush_interval_t interval);
+    void configure_block_compression(block_compression_t compression);
+    void configure_eviction_policy(eviction_policy_t policy);
+    void configure_cache_quota(cache_quota_t quota);
+
+    // Accounts memory that belongs to the cache's owner, such as the key filter of a
+    // store, to the cache (see `evicter_t::set_external_size()`).
+    void set_external_memory_size(uint64_t bytes);
+
+    // Must be called before writing blocks that only the current serializer format
+    // can describe (see `serializer_t::require_current_format()`).
+    void require_current_serializer_format();
+
+    // Returns up to `max_count` ids of blocks that are loaded, hottest first.
+    std::vector<block_id_t> hot_block_ids(size_t max_count) const;
+    // Loads the given blocks into the cache at a low priority.  This is for warming
+    // up the cache with the `hot_block_ids` from before a restart.
+    void warm_up(const std::vector<block_id_t> &block_ids, signal_t *interruptor);
 
 private:
     friend class txn_t;
@@ -320,6 +337,9 @@ private:
 class buf_read_t {
 public:
     explicit buf_read_t(buf_lock_t *lock);
+    // Traversals that visit every block once pass `page_reuse_t::LOW`, so that the
+    // page cache doesn't hold on to the blocks at the expense of hotter ones.
+    buf_read_t(buf_lock_t *lock, page_reuse_t reuse);
     ~buf_read_t();
 
     const void *get_data_read(uint32_t *block_size_out);
@@ -332,6 +352,7 @@ public:
 
 private:
     buf_lock_t *lock_;
+    page_reuse_t reuse_;
     alt::page_acq_t page_acq_;
 
     DISABLE_COPYING(buf_read_t);
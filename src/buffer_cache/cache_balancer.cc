@@ -1,5 +1,6 @@
 #include "buffer_cache/cache_balancer.hpp"
 
+#include <algorithm>
 #include <limits>
 
 #include "buffer_cache/evicter.hpp"
@@ -16,11 +17,77 @@ alt_cache_balancer_t::cache_data_t::cache_data_t(alt::evicter_t *_evicter) :
     evicter(_evicter),
     new_size(0),
     old_size(evicter->memory_limit()),
-    unevictable_size(evicter->unevictable_size()),
+    unevictable_size(evicter->unevictable_size() + evicter->external_size()),
     evictable_disk_backed_size(evicter->evictable_disk_backed_size()),
     evictable_unbacked_size(evicter->evictable_unbacked_size()),
     bytes_loaded(evicter->get_bytes_loaded()),
-    access_count(evicter->access_count()) { }
+    access_count(evicter->access_count()),
+    quota(evicter->cache_quota()) { }
+
+void fit_cache_sizes_to_quotas(uint64_t total_size,
+                               const std::vector<cache_quota_t> &quotas,
+                               std::vector<uint64_t> *sizes) {
+    const size_t n = quotas.size();
+    guarantee(sizes->size() == n);
+
+    uint64_t total_min = 0;
+    for (const cache_quota_t &quota : quotas) {
+        total_min += quota.min_bytes;
+    }
+    const double min_scale = total_min > total_size
+        ? static_cast<double>(total_size) / static_cast<double>(total_min)
+        : 1.0;
+
+    std::vector<uint64_t> lower(n), upper(n);
+    // The number of bytes that clamping freed up (if positive) or took up (if
+    // negative), which we take from or give to the caches that aren't at the
+    // corresponding bound.
+    int64_t surplus = 0;
+    for (size_t i = 0; i < n; ++i) {
+        lower[i] = static_cast<uint64_t>(quotas[i].min_bytes * min_scale);
+        upper[i] = std::max(lower[i], quotas[i].max_bytes);
+        uint64_t *size = &(*sizes)[i];
+        if (*size < lower[i]) {
+            surplus -= lower[i] - *size;
+            *size = lower[i];
+        } else if (*size > upper[i]) {
+            surplus += *size - upper[i];
+            *size = upper[i];
+        }
+    }
+
+    // Every round either settles the surplus or moves a cache to its bound.
+    while (surplus != 0) {
+        std::vector<size_t> adjustable;
+        for (size_t i = 0; i < n; ++i) {
+            if (surplus > 0 ? (*sizes)[i] < upper[i] : (*sizes)[i] > lower[i]) {
+                adjustable.push_back(i);
+            }
+        }
+        if (adjustable.empty()) {
+            break;
+        }
+        const uint64_t magnitude = surplus > 0 ? surplus : -surplus;
+        const uint64_t share = std::max<uint64_t>(1, magnitude / adjustable.size());
+        for (size_t i : adjustable) {
+            if (surplus == 0) {
+                break;
+            }
+            uint64_t *size = &(*sizes)[i];
+            if (surplus > 0) {
+                uint64_t delta = std::min<uint64_t>(
+                    {share, upper[i] - *size, static_cast<uint64_t>(surplus)});
+                *size += delta;
+                surplus -= delta;
+            } else {
+                uint64_t delta = std::min<uint64_t>(
+                    {share, *size - lower[i], static_cast<uint64_t>(-surplus)});
+                *size -= delta;
+                surplus += delta;
+            }
+        }
+    }
+}
 
 alt_cache_balancer_t::alt_cache_balancer_t(
         clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable) :
@@ -243,6 +310,8 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
 
         }
 
+        apply_cache_quotas(total_cache_size, &cache_data);
+
         // Send new cache sizes to each thread
         pmap(num_threads,
              std::bind(&alt_cache_balancer_t::apply_rebalance_to_thread,
@@ -261,6 +330,33 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
     }
 }
 
+void alt_cache_balancer_t::apply_cache_quotas(
+        uint64_t total_cache_size,
+        scoped_array_t<std::vector<cache_data_t> > *cache_data) {
+    std::vector<cache_quota_t> quotas;
+    std::vector<uint64_t> sizes;
+    bool has_quotas = false;
+    for (size_t i = 0; i < cache_data->size(); ++i) {
+        for (const cache_data_t &data : (*cache_data)[i]) {
+            quotas.push_back(data.quota);
+            sizes.push_back(data.new_size);
+            has_quotas |= data.quota.min_bytes != 0 || data.quota.max_bytes != UINT64_MAX;
+        }
+    }
+    if (!has_quotas) {
+        return;
+    }
+
+    fit_cache_sizes_to_quotas(total_cache_size, quotas, &sizes);
+
+    size_t k = 0;
+    for (size_t i = 0; i < cache_data->size(); ++i) {
+        for (cache_data_t &data : (*cache_data)[i]) {
+            data.new_size = sizes[k++];
+        }
+    }
+}
+
 void alt_cache_balancer_t::collect_stats_from_thread(
         int index,
         scoped_array_t<std::vector<cache_data_t> > *data_out,
@@ -10,6 +10,7 @@
 
 #include "threading.hpp"
 #include "arch/timing.hpp"
+#include "buffer_cache/types.hpp"
 #include "concurrency/pump_coro.hpp"
 #include "concurrency/watchable.hpp"
 #include "containers/scoped.hpp"
@@ -18,6 +19,14 @@ namespace alt {
 class evicter_t;
 }
 
+// Moves memory between the caches so that each one's size lies within its quota,
+// while keeping the total unchanged where the quotas allow it.  Minimums that don't
+// fit into `total_size` get scaled down.  If all the caches hit their maximum, the
+// rest of the memory stays unused.
+void fit_cache_sizes_to_quotas(uint64_t total_size,
+                               const std::vector<cache_quota_t> &quotas,
+                               std::vector<uint64_t> *sizes);
+
 // Base class so we can have a dummy implementation for tests
 class cache_balancer_t : public home_thread_mixin_t {
 public:
@@ -133,6 +142,12 @@ private:
     // Callback that handles rebalancing in a coroutine. Called by `rebalance_pumper`.
     void rebalance_blocking(UNUSED signal_t *interruptor);
 
+    struct cache_data_t;
+
+    // Adjusts the new sizes of the caches to respect their quotas.
+    static void apply_cache_quotas(uint64_t total_cache_size,
+                                   scoped_array_t<std::vector<cache_data_t> > *cache_data);
+
     // Used when calculating new cache sizes
     struct cache_data_t {
         explicit cache_data_t(alt::evicter_t *_evicter);
@@ -142,13 +157,16 @@ private:
         uint64_t new_size;
         uint64_t old_size;
 
-        // The three components of actual memory usage by the cache
+        // The three components of actual memory usage by the cache. The memory that
+        // the cache's owner accounts to it counts as unevictable.
         uint64_t unevictable_size;
         uint64_t evictable_disk_backed_size;
         uint64_t evictable_unbacked_size;
 
         int64_t bytes_loaded;
         uint64_t access_count;
+
+        cache_quota_t quota;
     };
 
     // Helper function to collect stats from each thread so we don't need
@@ -1,5 +1,7 @@
 #include "buffer_cache/evicter.hpp"
 
+#include <utility>
+
 #include "arch/runtime/coroutines.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/page.hpp"
@@ -8,12 +10,21 @@
 
 namespace alt {
 
+// With the TWO_QUEUE policy, probationary pages get evicted first as long as they
+// take up more than this fraction of the memory limit.
+const double TWO_QUEUE_PROBATIONARY_FRACTION = 0.25;
+
 evicter_t::evicter_t()
     : initialized_(false),
       page_cache_(nullptr),
       balancer_(nullptr),
       balancer_notify_activity_boolean_(nullptr),
       throttler_(nullptr),
+      external_size_(0),
+      eviction_policy_(eviction_policy_t::SAMPLED_LRU),
+      pm_hits_(make_scoped<perfmon_rate_monitor_t>(secs_to_ticks(1))),
+      pm_misses_(make_scoped<perfmon_rate_monitor_t>(secs_to_ticks(1))),
+      pm_evictions_(make_scoped<perfmon_rate_monitor_t>(secs_to_ticks(1))),
       bytes_loaded_counter_(0),
       access_count_counter_(0),
       access_time_counter_(INITIAL_ACCESS_TIME),
@@ -66,6 +77,45 @@ void evicter_t::update_memory_limit(uint64_t new_memory_limit,
                                            page_cache_->max_block_size());
 }
 
+void evicter_t::set_external_size(uint64_t new_external_size) {
+    guarantee_initialized();
+    const int64_t change = static_cast<int64_t>(new_external_size)
+        - static_cast<int64_t>(external_size_);
+    external_size_ = new_external_size;
+    evict_if_necessary();
+    // The balancer treats the memory like loaded pages, so the cache's share grows to
+    // make room for it.
+    notify_bytes_loading(change);
+}
+
+void evicter_t::set_eviction_policy(eviction_policy_t policy) {
+    guarantee_initialized();
+    if (policy == eviction_policy_) {
+        return;
+    }
+    eviction_policy_ = policy;
+
+    eviction_bag_t *from;
+    eviction_bag_t *to;
+    if (policy == eviction_policy_t::TWO_QUEUE) {
+        from = &evictable_disk_backed_;
+        to = &evictable_probationary_;
+    } else {
+        from = &evictable_probationary_;
+        to = &evictable_disk_backed_;
+    }
+    // Removing a page moves the last page of the bag into its slot, so we walk
+    // the bag backwards.
+    for (size_t i = from->page_count(); i-- > 0;) {
+        page_t *page = from->page_at(i);
+        if (correct_eviction_category(page) == to) {
+            uint32_t mem_usage = page->hypothetical_memory_usage(page_cache_);
+            from->remove(page, mem_usage);
+            to->add(page, mem_usage);
+        }
+    }
+}
+
 void wake_up_balancer(cache_balancer_t *balancer,
                       UNUSED auto_drainer_t::lock_t drainer_lock) {
     on_thread_t th(balancer->home_thread());
@@ -127,7 +177,11 @@ void evicter_t::add_to_evictable_unbacked(page_t *page) {
 
 void evicter_t::add_to_evictable_disk_backed(page_t *page) {
     guarantee_initialized();
-    evictable_disk_backed_.add(page, page->hypothetical_memory_usage(page_cache_));
+    // With the TWO_QUEUE policy, read-ahead pages start out on probation.
+    eviction_bag_t *new_bag = correct_eviction_category(page);
+    rassert(new_bag == &evictable_disk_backed_
+            || new_bag == &evictable_probationary_);
+    new_bag->add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
@@ -138,6 +192,7 @@ void evicter_t::move_unevictable_to_evictable(page_t *page) {
     unevictable_.remove(page, page->hypothetical_memory_usage(page_cache_));
     eviction_bag_t *new_bag = correct_eviction_category(page);
     rassert(new_bag == &evictable_disk_backed_
+            || new_bag == &evictable_probationary_
             || new_bag == &evictable_unbacked_);
     new_bag->add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
@@ -160,6 +215,9 @@ eviction_bag_t *evicter_t::correct_eviction_category(page_t *page) {
     } else if (!page->is_loaded()) {
         return &evicted_;
     } else if (page->is_disk_backed()) {
+        if (eviction_policy_ == eviction_policy_t::TWO_QUEUE && !page->is_protected()) {
+            return &evictable_probationary_;
+        }
         return &evictable_disk_backed_;
     } else {
         return &evictable_unbacked_;
@@ -176,10 +234,31 @@ void evicter_t::remove_page(page_t *page) {
 uint64_t evicter_t::in_memory_size() const {
     guarantee_initialized();
     return unevictable_.size()
+        + external_size_
         + evictable_disk_backed_.size()
+        + evictable_probationary_.size()
         + evictable_unbacked_.size();
 }
 
+bool evicter_t::select_page_to_evict(page_t **page_out, eviction_bag_t **bag_out) {
+    // The probationary bag is always empty with the SAMPLED_LRU policy.
+    eviction_bag_t *first = &evictable_disk_backed_;
+    eviction_bag_t *second = &evictable_probationary_;
+    if (evictable_probationary_.size()
+        > memory_limit_ * TWO_QUEUE_PROBATIONARY_FRACTION) {
+        std::swap(first, second);
+    }
+    if (eviction_bag_t::select_oldish(first, access_time_counter_, page_out)) {
+        *bag_out = first;
+        return true;
+    }
+    if (eviction_bag_t::select_oldish(second, access_time_counter_, page_out)) {
+        *bag_out = second;
+        return true;
+    }
+    return false;
+}
+
 void evicter_t::evict_if_necessary() THROWS_NOTHING {
     guarantee_initialized();
     if (evict_if_necessary_active_) {
@@ -196,13 +275,14 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
 
     evict_if_necessary_active_ = true;
     page_t *page;
+    eviction_bag_t *bag;
     while (in_memory_size() > memory_limit_
-           && eviction_bag_t::select_oldish(
-                &evictable_disk_backed_, access_time_counter_, &page)) {
+           && select_page_to_evict(&page, &bag)) {
         uint32_t mem_usage = page->hypothetical_memory_usage(page_cache_);
-        evictable_disk_backed_.remove(page, mem_usage);
+        bag->remove(page, mem_usage);
         evicted_.add(page, mem_usage);
         page->evict_self(page_cache_);
+        pm_evictions_->record();
         page_cache_->consider_evicting_current_page(page->block_id());
     }
 
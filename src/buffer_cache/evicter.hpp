@@ -6,9 +6,12 @@
 #include <functional>
 
 #include "buffer_cache/eviction_bag.hpp"
+#include "buffer_cache/types.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cache_line_padded.hpp"
 #include "concurrency/pubsub.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
 #include "threading.hpp"
 #include "time.hpp"
 
@@ -47,6 +50,28 @@ public:
                              uint64_t access_count_accounted_for,
                              bool read_ahead_ok);
 
+    // Moves the evictable pages into the bags that the new policy puts them in.
+    void set_eviction_policy(eviction_policy_t policy);
+    eviction_policy_t eviction_policy() const {
+        guarantee_initialized();
+        return eviction_policy_;
+    }
+
+    // The balancer keeps the memory limit within the quota.
+    void set_cache_quota(cache_quota_t quota) {
+        guarantee_initialized();
+        cache_quota_ = quota;
+    }
+    cache_quota_t cache_quota() const {
+        guarantee_initialized();
+        return cache_quota_;
+    }
+
+    // Counts a page acquisition, which is a hit if the page was already in memory.
+    void record_acquisition(bool hit) {
+        (hit ? pm_hits_ : pm_misses_)->record();
+    }
+
     uint64_t next_access_time() {
         guarantee_initialized();
         return ++access_time_counter_;
@@ -66,18 +91,31 @@ public:
     }
     uint64_t evictable_disk_backed_size() const {
         guarantee_initialized();
-        return evictable_disk_backed_.size();
+        return evictable_disk_backed_.size() + evictable_probationary_.size();
     }
     uint64_t evictable_unbacked_size() const {
         guarantee_initialized();
         return evictable_unbacked_.size();
     }
 
+    // Memory that the owner of the cache uses outside of the pages, which counts
+    // against the memory limit. Pages get evicted to make room for it.
+    void set_external_size(uint64_t new_external_size);
+    uint64_t external_size() const {
+        guarantee_initialized();
+        return external_size_;
+    }
+
     int64_t get_bytes_loaded() const {
         guarantee_initialized();
         return bytes_loaded_counter_;
     }
 
+    // Reported by `alt_cache_stats_t`.
+    perfmon_rate_monitor_t *hits_per_sec() { return pm_hits_.get(); }
+    perfmon_rate_monitor_t *misses_per_sec() { return pm_misses_.get(); }
+    perfmon_rate_monitor_t *evictions_per_sec() { return pm_evictions_.get(); }
+
 
     uint64_t in_memory_size() const;
 
@@ -99,6 +137,9 @@ private:
     // Evicts any evictable pages until under the memory limit
     void evict_if_necessary() THROWS_NOTHING;
 
+    // Picks the next page to evict and the bag it is in.
+    bool select_page_to_evict(page_t **page_out, eviction_bag_t **bag_out);
+
     bool initialized_;
     page_cache_t *page_cache_;
     cache_balancer_t *balancer_;
@@ -108,6 +149,18 @@ private:
 
     uint64_t memory_limit_;
 
+    uint64_t external_size_;
+
+    eviction_policy_t eviction_policy_;
+
+    cache_quota_t cache_quota_;
+
+    // A perfmon_rate_monitor_t has room for every thread, which makes it too big to
+    // embed.
+    scoped_ptr_t<perfmon_rate_monitor_t> pm_hits_;
+    scoped_ptr_t<perfmon_rate_monitor_t> pm_misses_;
+    scoped_ptr_t<perfmon_rate_monitor_t> pm_evictions_;
+
     // These are updated every time a page is loaded, created, or destroyed, and
     // cleared when cache memory limits are re-evaluated.  This value can go
     // negative, if you keep deleting blocks or suddenly drop a snapshot.
@@ -121,9 +174,12 @@ private:
     // It avoids reentrant calls to that function.
     bool evict_if_necessary_active_;
 
-    // These track every page's eviction status.
+    // These track every page's eviction status.  With the TWO_QUEUE policy,
+    // evictable disk backed pages that aren't protected yet go into
+    // evictable_probationary_ instead of evictable_disk_backed_.
     eviction_bag_t unevictable_;
     eviction_bag_t evictable_disk_backed_;
+    eviction_bag_t evictable_probationary_;
     eviction_bag_t evictable_unbacked_;
     eviction_bag_t evicted_;
 
@@ -30,6 +30,11 @@ public:
 
     uint64_t size() const { return size_; }
 
+    // For walking over the pages in the bag.  Removing the page at some index moves
+    // the last page of the bag into that index.
+    size_t page_count() const { return bag_.size(); }
+    page_t *page_at(size_t index) const { return bag_.access_random(index); }
+
     static bool select_oldish(
         eviction_bag_t *eb, uint64_t access_time_offset,
         page_t **page_out);
@@ -56,6 +56,8 @@ page_t::page_t(block_id_t block_id, page_cache_t *page_cache)
     : block_id_(block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      is_referenced_(false),
+      is_protected_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_deferred_loaded(this);
 
@@ -70,6 +72,8 @@ page_t::page_t(block_id_t block_id, page_cache_t *page_cache,
     : block_id_(block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      is_referenced_(false),
+      is_protected_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
 
@@ -86,6 +90,8 @@ page_t::page_t(block_id_t block_id, buf_ptr_t buf,
       loader_(nullptr),
       buf_(std::move(buf)),
       access_time_(page_cache->evicter().next_access_time()),
+      is_referenced_(false),
+      is_protected_(false),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_unbacked(this);
@@ -100,6 +106,8 @@ page_t::page_t(block_id_t block_id,
       buf_(std::move(buf)),
       block_token_(block_token),
       access_time_(READ_AHEAD_ACCESS_TIME),
+      is_referenced_(false),
+      is_protected_(false),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
@@ -109,6 +117,8 @@ page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *accoun
     : block_id_(copyee->block_id_),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      is_referenced_(false),
+      is_protected_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
@@ -415,6 +425,7 @@ void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
         = acq->page_cache()->evicter().correct_eviction_category(this);
     waiters_.push_front(acq);
     acq->page_cache()->evicter().change_to_correct_eviction_bag(old_bag, this);
+    acq->page_cache()->evicter().record_acquisition(buf_.has());
     if (buf_.has()) {
         acq->buf_ready_signal_.pulse();
     } else if (loader_ != nullptr) {
@@ -515,9 +526,16 @@ uint32_t page_t::hypothetical_memory_usage(page_cache_t *page_cache) const {
     }
 }
 
-void *page_t::get_page_buf(page_cache_t *page_cache) {
+void *page_t::get_page_buf(page_cache_t *page_cache, page_reuse_t reuse) {
     rassert(buf_.has());
+    // The page has waiters, so it is in the unevictable bag and changing
+    // is_protected_ can't put it into the wrong eviction bag.
+    rassert(!waiters_.empty());
     access_time_ = page_cache->evicter().next_access_time();
+    if (reuse == page_reuse_t::NORMAL) {
+        is_protected_ = is_referenced_;
+        is_referenced_ = true;
+    }
     return buf_.cache_data();
 }
 
@@ -621,12 +639,12 @@ void *page_acq_t::get_buf_write(block_size_t block_size) {
     buf_ready_signal_.wait();
     page_->reset_block_token(page_cache_);
     page_->set_page_buf_size(block_size, page_cache_);
-    return page_->get_page_buf(page_cache_);
+    return page_->get_page_buf(page_cache_, page_reuse_t::NORMAL);
 }
 
-const void *page_acq_t::get_buf_read() {
+const void *page_acq_t::get_buf_read(page_reuse_t reuse) {
     buf_ready_signal_.wait();
-    return page_->get_page_buf(page_cache_);
+    return page_->get_page_buf(page_cache_, reuse);
 }
 
 void page_ptr_t::init(page_t *page) {
@@ -1,6 +1,7 @@
 #ifndef BUFFER_CACHE_PAGE_HPP_
 #define BUFFER_CACHE_PAGE_HPP_
 
+#include "buffer_cache/types.hpp"
 #include "concurrency/cond_var.hpp"
 #include "containers/backindex_bag.hpp"
 #include "containers/half_intrusive_list.hpp"
@@ -43,7 +44,7 @@ public:
     void remove_waiter(page_acq_t *acq);
 
     // These may not be called until the page_acq_t's buf_ready_signal is pulsed.
-    void *get_page_buf(page_cache_t *page_cache);
+    void *get_page_buf(page_cache_t *page_cache, page_reuse_t reuse);
     void reset_block_token(page_cache_t *page_cache);
     void set_page_buf_size(block_size_t block_size, page_cache_t *page_cache);
 
@@ -55,6 +56,9 @@ public:
 
     uint32_t hypothetical_memory_usage(page_cache_t *page_cache) const;
     uint64_t access_time() const { return access_time_; }
+    // Whether the page has been reused, which keeps it out of the probationary bag
+    // with the TWO_QUEUE eviction policy.
+    bool is_protected() const { return is_protected_; }
 
     bool is_loading() const {
         return loader_ != nullptr && page_t::loader_is_loading(loader_);
@@ -132,6 +136,12 @@ private:
 
     uint64_t access_time_;
 
+    // Set by the first access that isn't marked as low-reuse.  The second such
+    // access sets is_protected_.  Neither gets reset on eviction, so a page that
+    // gets reloaded and used again becomes protected right away.
+    bool is_referenced_;
+    bool is_protected_;
+
     // How many page_ptr_t's point at this page, expecting nothing to modify it,
     // other than themselves.
     size_t snapshot_refcount_;
@@ -275,7 +285,7 @@ public:
     // These block, uninterruptibly waiting for buf_ready_signal() to be pulsed.
     block_size_t get_buf_size();
     void *get_buf_write(block_size_t block_size);
-    const void *get_buf_read();
+    const void *get_buf_read(page_reuse_t reuse = page_reuse_t::NORMAL);
 
 private:
     friend class page_t;
@@ -9,6 +9,7 @@
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/interruptor.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "buffer_cache/cache_balancer.hpp"
 #include "do_on_thread.hpp"
@@ -243,6 +244,7 @@ page_cache_t::page_cache_t(serializer_t *serializer,
                            cache_balancer_t *balancer,
                            alt_txn_throttler_t *throttler)
     : max_block_size_(serializer->max_block_size()),
+      block_compression_(block_compression_t::NONE),
       serializer_(serializer),
       // Start the counter at 1 so we can distinguish empty values.
       next_block_version_(block_version_t().subsequent()),
@@ -457,6 +459,50 @@ cache_account_t page_cache_t::create_cache_account(int priority) {
     return cache_account_t(serializer_->home_thread(), io_account);
 }
 
+std::vector<block_id_t> page_cache_t::hot_block_ids(size_t max_count) const {
+    assert_thread();
+    ASSERT_NO_CORO_WAITING;
+    std::vector<std::pair<uint64_t, block_id_t> > loaded;
+    for (const auto &pair : current_pages_) {
+        const current_page_t *cp = pair.second;
+        if (is_aux_block_id(pair.first) || cp->is_deleted() || !cp->page_.has()) {
+            continue;
+        }
+        const page_t *page = cp->page_.get_page_for_read();
+        if (page->is_loaded()) {
+            loaded.push_back(std::make_pair(page->access_time(), pair.first));
+        }
+    }
+
+    const size_t count = std::min(max_count, loaded.size());
+    std::partial_sort(loaded.begin(), loaded.begin() + count, loaded.end(),
+                      std::greater<std::pair<uint64_t, block_id_t> >());
+    std::vector<block_id_t> ret;
+    ret.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        ret.push_back(loaded[i].second);
+    }
+    return ret;
+}
+
+void page_cache_t::warm_up_block(block_id_t block_id, cache_account_t *account,
+                                 signal_t *interruptor) {
+    assert_thread();
+    // If there is a current_page_t, somebody else has already gotten to the block.
+    // (Whatever they did with it, it's not our business to reload it.)  Blocks that
+    // were deleted since their id was recorded have an invalid recency.
+    if (is_aux_block_id(block_id)
+        || current_pages_.count(block_id) > 0
+        || recency_for_block_id(block_id) == repli_timestamp_t::invalid) {
+        return;
+    }
+
+    current_page_acq_t acq(this, block_id, read_access_t::read);
+    page_acq_t page_acq;
+    page_acq.init(acq.current_page_for_read(account), this, account);
+    wait_interruptible(page_acq.buf_ready_signal(), interruptor);
+}
+
 
 current_page_acq_t::current_page_acq_t()
     : page_cache_(nullptr), the_txn_(nullptr) { }
@@ -1540,7 +1586,8 @@ flush_prep_t page_cache_t::prep_flush_changes(
                     prep.write_infos.emplace_back(
                         page->get_loaded_ser_buffer(),
                         page->get_page_buf_size(),
-                        it->first);
+                        it->first,
+                        page_cache->block_compression_);
                     prep.ancillary_infos.emplace_back(it->second.tstamp);
                     // The account doesn't matter because the page is already
                     // loaded.
@@ -461,8 +461,25 @@ public:
 
     max_block_size_t max_block_size() const { return max_block_size_; }
 
+    // Sets how blocks that get flushed from now on are encoded on disk.  Blocks
+    // that are already on disk keep their encoding until they get rewritten.
+    void set_block_compression(block_compression_t compression) {
+        assert_thread();
+        block_compression_ = compression;
+    }
+
     cache_account_t create_cache_account(int priority);
 
+    // Returns the ids of up to `max_count` blocks that are loaded in the cache, most
+    // recently accessed first.  Aux blocks are left out.
+    std::vector<block_id_t> hot_block_ids(size_t max_count) const;
+
+    // Loads the block into the cache using `account`, unless there already is a
+    // current_page_t for it or it has been deleted.  This is how the cache gets
+    // warmed up after a restart.
+    void warm_up_block(block_id_t block_id, cache_account_t *account,
+                       signal_t *interruptor);
+
     cache_account_t *default_reads_account() {
         return &default_reads_account_;
     }
@@ -590,6 +607,8 @@ private:
 
     const max_block_size_t max_block_size_;
 
+    block_compression_t block_compression_;
+
     // We use a separate I/O account for reads in each page cache.
     // Note that block writes use a shared I/O account that sits in the
     // merger_serializer_t (as long as you use one, otherwise they use the
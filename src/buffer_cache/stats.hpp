@@ -17,16 +17,24 @@ public:
 
     class perfmon_value_t : public perfmon_t {
     public:
-        explicit perfmon_value_t(alt_cache_stats_t *_parent);
+        perfmon_value_t(alt_cache_stats_t *_parent,
+                        uint64_t (alt::evicter_t::*_getter)() const);
         void *begin_stats();
         void visit_stats(void *);
         ql::datum_t end_stats(void *);
     private:
         alt_cache_stats_t *parent;
+        uint64_t (alt::evicter_t::*getter)() const;
         DISABLE_COPYING(perfmon_value_t);
     };
     perfmon_value_t in_use_bytes;
     perfmon_membership_t in_use_bytes_membership;
+    perfmon_value_t limit_bytes;
+    perfmon_membership_t limit_bytes_membership;
+
+    perfmon_membership_t hits_per_sec_membership;
+    perfmon_membership_t misses_per_sec_membership;
+    perfmon_membership_t evictions_per_sec_membership;
 
 
     perfmon_multi_membership_t cache_collection_membership;
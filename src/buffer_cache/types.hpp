@@ -22,6 +22,28 @@ struct flush_interval_t {
     int64_t millis;
 };
 
+// How the page cache picks pages to evict.  SAMPLED_LRU evicts the least recently
+// used of a few randomly sampled pages.  TWO_QUEUE keeps pages that haven't been
+// reused yet in a probationary queue, which gets evicted first once it holds more
+// than a quarter of the cache, so that a single scan can't push out the pages
+// that get used again and again.
+enum class eviction_policy_t { SAMPLED_LRU, TWO_QUEUE };
+
+// Bounds on the memory limit that the cache balancer gives a cache.  The balancer
+// scales the minimums down if they add up to more than the total cache size.
+struct cache_quota_t {
+    cache_quota_t() : min_bytes(0), max_bytes(UINT64_MAX) { }
+    cache_quota_t(uint64_t _min_bytes, uint64_t _max_bytes)
+        : min_bytes(_min_bytes), max_bytes(_max_bytes) { }
+
+    uint64_t min_bytes;
+    uint64_t max_bytes;
+};
+
+// Tells the page cache whether a read is likely to be followed by more reads of the
+// same page.  Scans pass LOW, so that the pages they touch don't count as reused.
+enum class page_reuse_t { NORMAL, LOW };
+
 typedef uint32_t block_magic_comparison_t;
 
 struct block_magic_t {
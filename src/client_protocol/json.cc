@@ -196,19 +196,18 @@ void json_protocol_t::write_response_to_buffer(ql::response_t *response,
 #endif
 }
 
-void json_protocol_t::send_response(ql::response_t *response,
-                                    int64_t token,
-                                    tcp_conn_t *conn,
-                                    signal_t *interruptor) {
+void json_protocol_t::write_response_with_header(ql::response_t *response,
+                                                 int64_t token,
+                                                 rapidjson::StringBuffer *buffer_out) {
     uint32_t data_size; // filled in below
     const size_t prefix_size = sizeof(token) + sizeof(data_size);
 
     // Reserve space for the token and the size
-    rapidjson::StringBuffer buffer;
-    buffer.Push(prefix_size);
+    size_t start_offset = buffer_out->GetSize();
+    buffer_out->Push(prefix_size);
 
-    write_response_to_buffer(response, &buffer);
-    int64_t payload_size = buffer.GetSize() - prefix_size;
+    write_response_to_buffer(response, buffer_out);
+    int64_t payload_size = buffer_out->GetSize() - start_offset - prefix_size;
     guarantee(payload_size > 0);
 
     static_assert(std::is_same<decltype(wire_protocol_t::TOO_LARGE_RESPONSE_SIZE),
@@ -216,16 +215,17 @@ void json_protocol_t::send_response(ql::response_t *response,
                   "The largest response must fit in 32 bits.");
 
     if (payload_size >= wire_protocol_t::TOO_LARGE_RESPONSE_SIZE) {
+        buffer_out->Pop(buffer_out->GetSize() - start_offset);
         response->fill_error(Response::RUNTIME_ERROR,
                              Response::RESOURCE_LIMIT,
                              wire_protocol_t::too_large_response_message(payload_size),
                              ql::backtrace_registry_t::EMPTY_BACKTRACE);
-        send_response(response, token, conn, interruptor);
+        write_response_with_header(response, token, buffer_out);
         return;
     }
 
     // Fill in the token and size
-    char *mutable_buffer = buffer.GetMutableBuffer();
+    char *mutable_buffer = buffer_out->GetMutableBuffer() + start_offset;
     for (size_t i = 0; i < sizeof(token); ++i) {
         mutable_buffer[i] = reinterpret_cast<const char *>(&token)[i];
     }
@@ -235,7 +235,13 @@ void json_protocol_t::send_response(ql::response_t *response,
         mutable_buffer[i + sizeof(token)] =
             reinterpret_cast<const char *>(&data_size)[i];
     }
+}
 
+void json_protocol_t::send_response(ql::response_t *response,
+                                    int64_t token,
+                                    tcp_conn_t *conn,
+                                    signal_t *interruptor) {
+    rapidjson::StringBuffer buffer;
+    write_response_with_header(response, token, &buffer);
     conn->write(buffer.GetString(), buffer.GetSize(), interruptor);
 }
-
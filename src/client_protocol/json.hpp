@@ -33,6 +33,12 @@ public:
     static void write_response_to_buffer(ql::response_t *response,
                                          rapidjson::StringBuffer *buffer_out);
 
+    // Writes the token, the size and the serialized response into `buffer_out`, in the
+    // format in which they are sent to the client.
+    static void write_response_with_header(ql::response_t *response,
+                                           int64_t token,
+                                           rapidjson::StringBuffer *buffer_out);
+
     static void send_response(ql::response_t *response,
                               int64_t token,
                               tcp_conn_t *conn,
@@ -549,6 +549,81 @@ void save_exception(std::exception_ptr *err,
     }
 }
 
+/* Clients often pipeline many small queries on one connection. Writing each
+response separately costs a system call and usually a TCP packet per response, so
+`response_batcher_t` collects the responses that become ready in the same turn of the
+event loop, or while the previous batch is still being written, and sends them with a
+single `write()`. */
+class response_batcher_t {
+public:
+    explicit response_batcher_t(tcp_conn_t *_conn) : conn(_conn) { }
+
+    /* Returns once `data` has been written to the connection, together with whatever
+    other responses ended up in the same batch. If writing the batch fails, every
+    sender in it gets the exception. */
+    void send(const char *data, size_t size, signal_t *interruptor) {
+        // Copying a large response into the batch would cost more than the extra
+        // `write()` call saves.
+        if (size >= MAX_BATCHED_RESPONSE_SIZE) {
+            new_mutex_acq_t write_lock(&write_mutex, interruptor);
+            conn->write(data, size, interruptor);
+            return;
+        }
+
+        if (open_batch.has()) {
+            // Someone else is going to write this batch. We don't wait interruptibly,
+            // because our response is already part of the batch and we must not send
+            // a second response for the same token.
+            counted_t<batch_t> batch = open_batch;
+            batch->data.append(data, size);
+            batch->done.wait_lazily_unordered();
+            if (batch->error) {
+                std::rethrow_exception(batch->error);
+            }
+            return;
+        }
+
+        counted_t<batch_t> batch = make_counted<batch_t>();
+        batch->data.append(data, size);
+        open_batch = batch;
+        try {
+            // Give the other queries that finish in this turn of the event loop a
+            // chance to add their responses.
+            coro_t::yield();
+            new_mutex_acq_t write_lock(&write_mutex, interruptor);
+            // The batch is closed once we start writing it.
+            open_batch.reset();
+            conn->write(batch->data.data(), batch->data.size(), interruptor);
+        } catch (...) {
+            if (open_batch.get() == batch.get()) {
+                open_batch.reset();
+            }
+            batch->error = std::current_exception();
+            batch->done.pulse();
+            throw;
+        }
+        batch->done.pulse();
+    }
+
+private:
+    static const size_t MAX_BATCHED_RESPONSE_SIZE = 64 * KILOBYTE;
+
+    struct batch_t : public single_threaded_countable_t<batch_t> {
+        std::string data;
+        cond_t done;
+        std::exception_ptr error;
+    };
+
+    tcp_conn_t *conn;
+    // Held while a batch (or a large response) is being written.
+    new_mutex_t write_mutex;
+    // The batch that new responses are added to. Empty if there is no batch that
+    // hasn't started writing yet.
+    counted_t<batch_t> open_batch;
+
+    DISABLE_COPYING(response_batcher_t);
+};
+
 template <class protocol_t>
 void query_server_t::connection_loop(tcp_conn_t *conn,
                                      size_t max_concurrent_queries,
@@ -557,7 +632,7 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
     std::exception_ptr err;
     std::string err_str;
     cond_t abort;
-    new_mutex_t send_mutex;
+    response_batcher_t response_batcher(conn);
     scoped_perfmon_counter_t connection_counter(&rdb_ctx->stats.client_connections);
 
 #ifdef __linux
@@ -590,19 +665,23 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
                 save_exception(&err, &err_str, &abort, [&]() {
                     handler->run_query(query.get(), &response, &cb_interruptor);
                     if (!query->noreply) {
-                        new_mutex_acq_t send_lock(&send_mutex, &cb_interruptor);
-                        protocol_t::send_response(&response, query->token,
-                                                  conn, &cb_interruptor);
+                        rapidjson::StringBuffer buffer;
+                        protocol_t::write_response_with_header(
+                            &response, query->token, &buffer);
                         replied = true;
+                        response_batcher.send(
+                            buffer.GetString(), buffer.GetSize(), &cb_interruptor);
                     }
                 });
                 save_exception(&err, &err_str, &abort, [&]() {
                     if (!replied && !query->noreply) {
                         make_error_response(drain_signal->is_pulsed(), *conn,
                                             err_str, &response);
-                        new_mutex_acq_t send_lock(&send_mutex, drain_signal);
-                        protocol_t::send_response(&response, query->token,
-                                                  conn, &cb_interruptor);
+                        rapidjson::StringBuffer buffer;
+                        protocol_t::write_response_with_header(
+                            &response, query->token, &buffer);
+                        response_batcher.send(
+                            buffer.GetString(), buffer.GetSize(), &cb_interruptor);
                     }
                 });
             });
@@ -20,6 +20,9 @@ const uuid_u jobs_manager_t::base_disk_compaction_id =
 const uuid_u jobs_manager_t::base_backfill_id =
     str_to_uuid("a5e1b38d-c712-42d7-ab4c-f177a3fb0d20");
 
+const uuid_u jobs_manager_t::base_cache_warmup_id =
+    str_to_uuid("3f1c5e0a-9d27-4b8e-a6f4-58c2d0e7b193");
+
 jobs_manager_t::jobs_manager_t(mailbox_manager_t *_mailbox_manager,
                                server_id_t const &_server_id,
                                rdb_context_t *_rdb_context,
@@ -53,6 +56,7 @@ void jobs_manager_t::on_get_job_reports(
     std::vector<disk_compaction_job_report_t> disk_compaction_job_reports;
     std::vector<index_construction_job_report_t> index_construction_job_reports;
     std::vector<backfill_job_report_t> backfill_job_reports;
+    std::vector<cache_warmup_job_report_t> cache_warmup_job_reports;
 
     if (drainer.is_draining()) {
         // We're shutting down, send an empty reponse since we can't acquire a `drainer`
@@ -63,7 +67,11 @@ void jobs_manager_t::on_get_job_reports(
              query_job_reports,
              disk_compaction_job_reports,
              index_construction_job_reports,
-             backfill_job_reports);
+             backfill_job_reports,
+             job_reports_extension_t(
+                 index_construction_job_reports,
+                 backfill_job_reports,
+                 std::move(cache_warmup_job_reports)));
         return;
     }
 
@@ -88,7 +96,7 @@ void jobs_manager_t::on_get_job_reports(
                     }
 
                     auto render = pprint::render_as_javascript(
-                        pair.second->term_storage->root_term());
+                        pair.second->root_term());
 
                     query_job_reports_inner.emplace_back(
                         pair.second->job_id,
@@ -114,6 +122,21 @@ void jobs_manager_t::on_get_job_reports(
             server_id);
     }
 
+    if (table_persistence_interface != nullptr) {
+        std::string base_str = uuid_to_str(server_id.get_uuid());
+        for (const auto &warmup : table_persistence_interface->get_cache_warmups()) {
+            cache_warmup_job_reports.emplace_back(
+                uuid_u::from_hash(base_cache_warmup_id,
+                                  base_str + uuid_to_str(warmup.first)),
+                time - std::min<double>(warmup.second.start_time, time),
+                server_id,
+                warmup.first,
+                warmup.second.is_ready,
+                warmup.second.blocks_done,
+                warmup.second.blocks_total);
+        }
+    }
+
     try {
         multi_table_manager->visit_tables(interruptor, access_t::read,
         [&](const namespace_id_t &table_id,
@@ -139,7 +162,8 @@ void jobs_manager_t::on_get_job_reports(
                     status.first,
                     status.second.second.ready,
                     status.second.second.progress_numerator,
-                    status.second.second.progress_denominator);
+                    status.second.second.progress_denominator,
+                    status.second.second.rows_per_second);
             }
 
             std::map<region_t, backfill_progress_tracker_t::progress_tracker_t> backfills =
@@ -164,7 +188,9 @@ void jobs_manager_t::on_get_job_reports(
                     backfill.second.is_ready,
                     backfill.second.progress,
                     backfill.second.source_server_id,
-                    server_id);
+                    server_id,
+                    backfill.second.bytes_transferred,
+                    backfill.second.bytes_uncompressed);
             }
         });
 
@@ -173,7 +199,11 @@ void jobs_manager_t::on_get_job_reports(
              query_job_reports,
              disk_compaction_job_reports,
              index_construction_job_reports,
-             backfill_job_reports);
+             backfill_job_reports,
+             job_reports_extension_t(
+                 index_construction_job_reports,
+                 backfill_job_reports,
+                 std::move(cache_warmup_job_reports)));
     } catch (const interrupted_exc_t &) {
         // Do nothing
     }
@@ -20,6 +20,76 @@ ql::datum_t convert_job_type_and_id_to_datum(std::string const &type, uuid_u con
     return std::move(primary_key_builder).to_datum();
 }
 
+cache_warmup_job_report_t::cache_warmup_job_report_t()
+    : job_report_base_t<cache_warmup_job_report_t>() { }
+
+cache_warmup_job_report_t::cache_warmup_job_report_t(
+        uuid_u const &_id,
+        double _duration,
+        server_id_t const &_server_id,
+        namespace_id_t const &_table,
+        bool _is_ready,
+        double _progress_numerator,
+        double _progress_denominator)
+    : job_report_base_t<cache_warmup_job_report_t>(
+        "cache_warmup", _id, _duration, _server_id),
+      table(_table),
+      is_ready(_is_ready),
+      progress_numerator(_progress_numerator),
+      progress_denominator(_progress_denominator) { }
+
+void cache_warmup_job_report_t::merge_derived(
+        cache_warmup_job_report_t const &job_report) {
+    is_ready &= job_report.is_ready;
+    progress_numerator += job_report.progress_numerator;
+    progress_denominator += job_report.progress_denominator;
+}
+
+bool cache_warmup_job_report_t::info_derived(
+        admin_identifier_format_t identifier_format,
+        UNUSED server_config_client_t *server_config_client,
+        table_meta_client_t *table_meta_client,
+        cluster_semilattice_metadata_t const &metadata,
+        ql::datum_object_builder_t *info_builder_out) const {
+    if (is_ready) {
+        return false;
+    }
+
+    ql::datum_t table_name_or_uuid;
+    ql::datum_t db_name_or_uuid;
+    if (!convert_table_id_to_datums(
+            table,
+            identifier_format,
+            metadata,
+            table_meta_client,
+            &table_name_or_uuid,
+            nullptr,
+            &db_name_or_uuid,
+            nullptr)) {
+        return false;
+    }
+    info_builder_out->overwrite("table", table_name_or_uuid);
+    info_builder_out->overwrite("db", db_name_or_uuid);
+
+    info_builder_out->overwrite("progress",
+        ql::datum_t(progress_denominator == 0
+            ? 0
+            : progress_numerator / progress_denominator));
+
+    return true;
+}
+
+RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
+    cache_warmup_job_report_t,
+    type,
+    id,
+    duration,
+    servers,
+    table,
+    is_ready,
+    progress_numerator,
+    progress_denominator);
+
 disk_compaction_job_report_t::disk_compaction_job_report_t()
     : job_report_base_t<disk_compaction_job_report_t>() { }
 
@@ -46,7 +116,9 @@ RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(
     disk_compaction_job_report_t, type, id, duration, servers);
 
 backfill_job_report_t::backfill_job_report_t()
-    : job_report_base_t<backfill_job_report_t>() { }
+    : job_report_base_t<backfill_job_report_t>(),
+      bytes_transferred(0),
+      bytes_uncompressed(0) { }
 
 backfill_job_report_t::backfill_job_report_t(
         uuid_u const &_id,
@@ -56,14 +128,18 @@ backfill_job_report_t::backfill_job_report_t(
         bool _is_ready,
         double _progress,
         server_id_t const &_source_server,
-        server_id_t const &_destination_server)
+        server_id_t const &_destination_server,
+        uint64_t _bytes_transferred,
+        uint64_t _bytes_uncompressed)
     : job_report_base_t<backfill_job_report_t>("backfill", _id, _duration, _server_id),
       table(_table),
       is_ready(_is_ready),
       progress_numerator(_progress),
       progress_denominator(1.0),
       source_server(_source_server),
-      destination_server(_destination_server) {
+      destination_server(_destination_server),
+      bytes_transferred(_bytes_transferred),
+      bytes_uncompressed(_bytes_uncompressed) {
     servers.insert({source_server, destination_server});
 }
 
@@ -72,6 +148,8 @@ void backfill_job_report_t::merge_derived(
     is_ready &= job_report.is_ready;
     progress_numerator += job_report.progress_numerator;
     progress_denominator += job_report.progress_denominator;
+    bytes_transferred += job_report.bytes_transferred;
+    bytes_uncompressed += job_report.bytes_uncompressed;
 }
 
 bool backfill_job_report_t::info_derived(
@@ -127,6 +205,10 @@ bool backfill_job_report_t::info_derived(
 
     info_builder_out->overwrite("progress",
         ql::datum_t(progress_numerator / progress_denominator));
+    info_builder_out->overwrite("bytes_transferred",
+        ql::datum_t(static_cast<double>(bytes_transferred)));
+    info_builder_out->overwrite("bytes_uncompressed",
+        ql::datum_t(static_cast<double>(bytes_uncompressed)));
 
     return true;
 }
@@ -145,7 +227,8 @@ RDB_IMPL_SERIALIZABLE_10_FOR_CLUSTER(
     destination_server);
 
 index_construction_job_report_t::index_construction_job_report_t()
-    : job_report_base_t<index_construction_job_report_t>() { }
+    : job_report_base_t<index_construction_job_report_t>(),
+      rows_per_second(0) { }
 
 index_construction_job_report_t::index_construction_job_report_t(
         uuid_u const &_id,
@@ -155,20 +238,24 @@ index_construction_job_report_t::index_construction_job_report_t(
         std::string const &_index,
         bool _is_ready,
         double _progress_numerator,
-        double _progress_denominator)
+        double _progress_denominator,
+        double _rows_per_second)
     : job_report_base_t<index_construction_job_report_t>(
         "index_construction", _id, _duration, _server_id),
       table(_table),
       index(_index),
       is_ready(_is_ready),
       progress_numerator(_progress_numerator),
-      progress_denominator(_progress_denominator) { }
+      progress_denominator(_progress_denominator),
+      rows_per_second(_rows_per_second) { }
 
 void index_construction_job_report_t::merge_derived(
        index_construction_job_report_t const &job_report) {
     is_ready &= job_report.is_ready;
     progress_numerator += job_report.progress_numerator;
     progress_denominator += job_report.progress_denominator;
+    // The shards are constructed in parallel, so their throughputs add up.
+    rows_per_second += job_report.rows_per_second;
 }
 
 bool index_construction_job_report_t::info_derived(
@@ -202,6 +289,7 @@ bool index_construction_job_report_t::info_derived(
         ql::datum_t(progress_denominator == 0
             ? 0
             : progress_numerator / progress_denominator));
+    info_builder_out->overwrite("rows_per_second", ql::datum_t(rows_per_second));
 
     return true;
 }
@@ -251,6 +339,68 @@ bool query_job_report_t::info_derived(
 RDB_IMPL_SERIALIZABLE_6_FOR_CLUSTER(
     query_job_report_t, type, id, duration, servers, client_addr_port, query);
 
+job_reports_extension_t::job_reports_extension_t(
+        std::vector<index_construction_job_report_t> const &index_construction_jobs,
+        std::vector<backfill_job_report_t> const &backfill_jobs,
+        std::vector<cache_warmup_job_report_t> &&_cache_warmup_jobs)
+    : cache_warmup_jobs(std::move(_cache_warmup_jobs)) {
+    index_construction_rows_per_second.reserve(index_construction_jobs.size());
+    for (auto const &index_construction_job : index_construction_jobs) {
+        index_construction_rows_per_second.push_back(
+            index_construction_job.rows_per_second);
+    }
+    backfill_bytes_transferred.reserve(backfill_jobs.size());
+    backfill_bytes_uncompressed.reserve(backfill_jobs.size());
+    for (auto const &backfill_job : backfill_jobs) {
+        backfill_bytes_transferred.push_back(backfill_job.bytes_transferred);
+        backfill_bytes_uncompressed.push_back(backfill_job.bytes_uncompressed);
+    }
+}
+
+void job_reports_extension_t::apply(
+        std::vector<index_construction_job_report_t> *index_construction_jobs,
+        std::vector<backfill_job_report_t> *backfill_jobs) const {
+    if (index_construction_rows_per_second.size() == index_construction_jobs->size()) {
+        for (size_t i = 0; i < index_construction_jobs->size(); ++i) {
+            (*index_construction_jobs)[i].rows_per_second =
+                index_construction_rows_per_second[i];
+        }
+    }
+    if (backfill_bytes_transferred.size() == backfill_jobs->size() &&
+            backfill_bytes_uncompressed.size() == backfill_jobs->size()) {
+        for (size_t i = 0; i < backfill_jobs->size(); ++i) {
+            (*backfill_jobs)[i].bytes_transferred = backfill_bytes_transferred[i];
+            (*backfill_jobs)[i].bytes_uncompressed = backfill_bytes_uncompressed[i];
+        }
+    }
+}
+
+template <cluster_version_t W>
+void serialize(write_message_t *wm, const job_reports_extension_t &extension) {
+    serialize<W>(wm, extension.cache_warmup_jobs);
+    serialize<W>(wm, extension.backfill_bytes_transferred);
+    serialize<W>(wm, extension.backfill_bytes_uncompressed);
+    serialize<W>(wm, extension.index_construction_rows_per_second);
+}
+
+template <cluster_version_t W>
+archive_result_t deserialize(read_stream_t *s, job_reports_extension_t *extension) {
+    /* A server running a previous version ends its message here. */
+    archive_result_t res = deserialize<W>(s, &extension->cache_warmup_jobs);
+    if (res == archive_result_t::SOCK_EOF) {
+        *extension = job_reports_extension_t();
+        return archive_result_t::SUCCESS;
+    }
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &extension->backfill_bytes_transferred);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &extension->backfill_bytes_uncompressed);
+    if (bad(res)) { return res; }
+    return deserialize<W>(s, &extension->index_construction_rows_per_second);
+}
+
+INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(job_reports_extension_t);
+
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(jobs_manager_business_card_t,
                                     get_job_reports_mailbox_address,
                                     job_interrupt_mailbox_address);
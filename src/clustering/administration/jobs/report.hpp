@@ -59,7 +59,9 @@ public:
             bool is_ready,
             double progress,
             server_id_t const &source_server,
-            server_id_t const &destination_server);
+            server_id_t const &destination_server,
+            uint64_t bytes_transferred,
+            uint64_t bytes_uncompressed);
 
     void merge_derived(backfill_job_report_t const &job_report);
 
@@ -76,9 +78,41 @@ public:
     double progress_denominator;
     server_id_t source_server;
     server_id_t destination_server;
+    // These two aren't serialized with the report, see `job_reports_extension_t`.
+    uint64_t bytes_transferred;
+    uint64_t bytes_uncompressed;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(backfill_job_report_t);
 
+class cache_warmup_job_report_t
+    : public job_report_base_t<cache_warmup_job_report_t> {
+public:
+    cache_warmup_job_report_t();
+    cache_warmup_job_report_t(
+            uuid_u const &id,
+            double duration,
+            server_id_t const &server_id,
+            namespace_id_t const &table,
+            bool is_ready,
+            double progress_numerator,
+            double progress_denominator);
+
+    void merge_derived(cache_warmup_job_report_t const &job_report);
+
+    bool info_derived(
+            admin_identifier_format_t identifier_format,
+            server_config_client_t *server_config_client,
+            table_meta_client_t *table_meta_client,
+            cluster_semilattice_metadata_t const &metadata,
+            ql::datum_object_builder_t *info_builder_out) const;
+
+    namespace_id_t table;
+    bool is_ready;
+    double progress_numerator;
+    double progress_denominator;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(cache_warmup_job_report_t);
+
 class disk_compaction_job_report_t
     : public job_report_base_t<disk_compaction_job_report_t> {
 public:
@@ -111,7 +145,8 @@ public:
             std::string const &index,
             bool is_ready,
             double progress_numerator,
-            double progress_denominator);
+            double progress_denominator,
+            double rows_per_second);
 
     void merge_derived(index_construction_job_report_t const &job_report);
 
@@ -127,6 +162,8 @@ public:
     bool is_ready;
     double progress_numerator;
     double progress_denominator;
+    // This isn't serialized with the report, see `job_reports_extension_t`.
+    double rows_per_second;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(index_construction_job_report_t);
 
@@ -154,12 +191,37 @@ public:
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(query_job_report_t);
 
+/* The job report data that servers running a previous version neither send nor expect.
+It's the last argument of `return_mailbox_t`, which those servers don't read, and it's
+left empty when they reply. The index construction and backfill vectors have an entry
+for each report in the corresponding argument of the same message. */
+class job_reports_extension_t {
+public:
+    job_reports_extension_t() { }
+    job_reports_extension_t(
+            std::vector<index_construction_job_report_t> const &index_construction_jobs,
+            std::vector<backfill_job_report_t> const &backfill_jobs,
+            std::vector<cache_warmup_job_report_t> &&_cache_warmup_jobs);
+
+    // Copies the fields into the reports, unless the reply didn't include them.
+    void apply(
+            std::vector<index_construction_job_report_t> *index_construction_jobs,
+            std::vector<backfill_job_report_t> *backfill_jobs) const;
+
+    std::vector<cache_warmup_job_report_t> cache_warmup_jobs;
+    std::vector<uint64_t> backfill_bytes_transferred;
+    std::vector<uint64_t> backfill_bytes_uncompressed;
+    std::vector<double> index_construction_rows_per_second;
+};
+RDB_DECLARE_SERIALIZABLE(job_reports_extension_t);
+
 class jobs_manager_business_card_t {
 public:
     typedef mailbox_t<void(std::vector<query_job_report_t>,
                            std::vector<disk_compaction_job_report_t>,
                            std::vector<index_construction_job_report_t>,
-                           std::vector<backfill_job_report_t>)> return_mailbox_t;
+                           std::vector<backfill_job_report_t>,
+                           job_reports_extension_t)> return_mailbox_t;
     typedef mailbox_t<void(return_mailbox_t::address_t)> get_job_reports_mailbox_t;
     typedef mailbox_t<void(uuid_u)> job_interrupt_mailbox_t;
 
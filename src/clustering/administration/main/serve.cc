@@ -280,7 +280,9 @@ bool do_serve(io_backender_t *io_backender,
                               nullptr,   /* we'll fill this in later */
                               semilattice_manager_auth.get_root_view(),
                               &get_global_perfmon_collection(),
-                              serve_info.reql_http_proxy);
+                              serve_info.reql_http_proxy,
+                              i_am_a_server ? io_backender : nullptr,
+                              base_path);
         {
             /* Extract a subview of the directory with all the table meta manager
             business cards. */
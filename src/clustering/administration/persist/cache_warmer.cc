@@ -0,0 +1,128 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/persist/cache_warmer.hpp"
+
+#include <algorithm>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "clustering/administration/persist/file_keys.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "rdb_protocol/store.hpp"
+
+// How often the hot blocks get recorded.
+const int64_t CACHE_WARMER_RECORD_INTERVAL_MS = 10 * 60 * 1000;
+
+// How many block ids get recorded per CPU shard at most. With the default block size,
+// that's 128 MB of cache per shard.
+const size_t CACHE_WARMER_MAX_BLOCKS_PER_SHARD = 32768;
+
+// How many blocks get warmed up at a time, between progress updates.
+const size_t CACHE_WARMER_BATCH_SIZE = 64;
+
+RDB_IMPL_SERIALIZABLE_1_SINCE_v2_3(table_hot_blocks_t, shards);
+
+void cache_warmer_t::erase(
+        metadata_file_t::write_txn_t *write_txn,
+        const namespace_id_t &table_id) {
+    cond_t non_interruptor;
+    write_txn->erase(
+        mdprefix_table_hot_blocks().suffix(uuid_to_str(table_id)),
+        &non_interruptor);
+}
+
+cache_warmer_t::cache_warmer_t(
+        const namespace_id_t &_table_id,
+        metadata_file_t *_metadata_file,
+        metadata_file_t::read_txn_t *metadata_read_txn,
+        signal_t *interruptor) :
+    table_id(_table_id), metadata_file(_metadata_file) {
+    metadata_read_txn->read_maybe(
+        mdprefix_table_hot_blocks().suffix(uuid_to_str(table_id)),
+        &hot_blocks,
+        interruptor);
+    progress.is_ready = false;
+    progress.start_time = current_microtime();
+    progress.blocks_done = 0;
+    progress.blocks_total = 0;
+    for (const auto &shard : hot_blocks.shards) {
+        progress.blocks_total += shard.size();
+    }
+}
+
+void cache_warmer_t::start(const std::vector<store_t *> &_stores) {
+    assert_thread();
+    guarantee(stores.empty());
+    stores = _stores;
+    progress.start_time = current_microtime();
+    coro_t::spawn_sometime(std::bind(&cache_warmer_t::run, this, drainer.lock()));
+}
+
+cache_warmer_t::progress_t cache_warmer_t::get_progress() const {
+    assert_thread();
+    return progress;
+}
+
+void cache_warmer_t::run(auto_drainer_t::lock_t keepalive) {
+    signal_t *interruptor = keepalive.get_drain_signal();
+    pmap(stores.size(), [&](int64_t shard) {
+        warm_up_shard(shard, interruptor);
+    });
+    if (interruptor->is_pulsed()) {
+        return;
+    }
+    progress.is_ready = true;
+    hot_blocks = table_hot_blocks_t();
+
+    try {
+        for (;;) {
+            nap(CACHE_WARMER_RECORD_INTERVAL_MS, interruptor);
+            record_hot_blocks();
+        }
+    } catch (const interrupted_exc_t &) {
+        // We're shutting down.
+    }
+}
+
+void cache_warmer_t::warm_up_shard(size_t shard, signal_t *interruptor) {
+    if (shard >= hot_blocks.shards.size()) {
+        // The number of CPU shards never changes, but there might be no record at all.
+        return;
+    }
+    const std::vector<block_id_t> &block_ids = hot_blocks.shards[shard];
+    store_t *store = stores[shard];
+    try {
+        for (size_t i = 0; i < block_ids.size(); i += CACHE_WARMER_BATCH_SIZE) {
+            std::vector<block_id_t> batch(
+                block_ids.begin() + i,
+                block_ids.begin() + std::min(i + CACHE_WARMER_BATCH_SIZE,
+                                             block_ids.size()));
+            {
+                cross_thread_signal_t ct_interruptor(interruptor, store->home_thread());
+                on_thread_t thread_switcher(store->home_thread());
+                store->warm_up_cache(batch, &ct_interruptor);
+            }
+            progress.blocks_done += batch.size();
+        }
+    } catch (const interrupted_exc_t &) {
+        // `run()` notices the interruption.
+    }
+}
+
+void cache_warmer_t::record_hot_blocks() {
+    table_hot_blocks_t recorded;
+    recorded.shards.resize(stores.size());
+    pmap(stores.size(), [&](int64_t shard) {
+        on_thread_t thread_switcher(stores[shard]->home_thread());
+        recorded.shards[shard] =
+            stores[shard]->hot_block_ids(CACHE_WARMER_MAX_BLOCKS_PER_SHARD);
+    });
+
+    cond_t non_interruptor;
+    metadata_file_t::write_txn_t write_txn(metadata_file, &non_interruptor);
+    write_txn.write(
+        mdprefix_table_hot_blocks().suffix(uuid_to_str(table_id)),
+        recorded,
+        &non_interruptor);
+}
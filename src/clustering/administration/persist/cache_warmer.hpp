@@ -0,0 +1,73 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_PERSIST_CACHE_WARMER_HPP_
+#define CLUSTERING_ADMINISTRATION_PERSIST_CACHE_WARMER_HPP_
+
+#include <vector>
+
+#include "clustering/administration/persist/file.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "containers/uuid.hpp"
+#include "rpc/serialize_macros.hpp"
+#include "serializer/types.hpp"
+#include "time.hpp"
+
+class store_t;
+
+/* The ids of the blocks that were loaded in the cache of each of a table's CPU shards,
+hottest first. */
+class table_hot_blocks_t {
+public:
+    std::vector<std::vector<block_id_t> > shards;
+};
+RDB_DECLARE_SERIALIZABLE(table_hot_blocks_t);
+
+/* `cache_warmer_t` keeps a table's caches from starting out cold after a restart. It
+periodically records which blocks are loaded in the cache of each CPU shard in the
+metadata file. When the table's stores get loaded again, it reads those blocks back in
+the background at a low priority, before it starts recording again. */
+class cache_warmer_t : public home_thread_mixin_t {
+public:
+    class progress_t {
+    public:
+        bool is_ready;
+        microtime_t start_time;
+        uint64_t blocks_done;
+        uint64_t blocks_total;
+    };
+
+    static void erase(
+        metadata_file_t::write_txn_t *write_txn,
+        const namespace_id_t &table_id);
+
+    cache_warmer_t(
+        const namespace_id_t &table_id,
+        metadata_file_t *metadata_file,
+        metadata_file_t::read_txn_t *metadata_read_txn,
+        signal_t *interruptor);
+
+    /* Starts warming up the stores, one per CPU shard. They must stay alive until the
+    `cache_warmer_t` is destroyed. */
+    void start(const std::vector<store_t *> &stores);
+
+    progress_t get_progress() const;
+
+private:
+    void run(auto_drainer_t::lock_t keepalive);
+    void warm_up_shard(size_t shard, signal_t *interruptor);
+    void record_hot_blocks();
+
+    namespace_id_t const table_id;
+    metadata_file_t * const metadata_file;
+
+    /* What was recorded before the restart. It's dropped once the warm-up is done. */
+    table_hot_blocks_t hot_blocks;
+
+    std::vector<store_t *> stores;
+    progress_t progress;
+
+    auto_drainer_t drainer;
+
+    DISABLE_COPYING(cache_warmer_t);
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_PERSIST_CACHE_WARMER_HPP_ */
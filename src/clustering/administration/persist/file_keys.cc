@@ -52,6 +52,10 @@ metadata_file_t::key_t<table_raft_versioned_user_value_t>
         mdprefix_table_raft_snapshot_extension() {
     return metadata_file_t::key_t<table_raft_versioned_user_value_t>("table.snapshot_extension/");
 }
+metadata_file_t::key_t<table_hot_blocks_t>
+        mdprefix_table_hot_blocks() {
+    return metadata_file_t::key_t<table_hot_blocks_t>("table.hot_blocks/");
+}
 
 
 metadata_file_t::key_t<raft_log_entry_t<table_raft_state_t> >
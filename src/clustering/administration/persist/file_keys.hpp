@@ -13,6 +13,7 @@ template<class state_t> class raft_log_entry_t;
 class server_config_versioned_t;
 class server_id_t;
 class table_active_persistent_state_t;
+class table_hot_blocks_t;
 class table_inactive_persistent_state_t;
 class table_raft_state_t;
 class table_raft_stored_header_t;
@@ -50,6 +51,9 @@ metadata_file_t::key_t<table_raft_stored_snapshot_t>
 // that go v2_3_ext -> v2_3 -> v2_3_ext don't pick up some old user value.
 metadata_file_t::key_t<table_raft_versioned_user_value_t>
     mdprefix_table_raft_snapshot_extension();
+// The blocks that `cache_warmer_t` loads back into the cache after a restart.
+metadata_file_t::key_t<table_hot_blocks_t>
+    mdprefix_table_hot_blocks();
 
 /* This prefix should be followed by a string of the form `TABLE/LOG_INDEX`, where
 `TABLE` is a UUID as before, and `LOG_INDEX` is a 16-digit hexadecimal. */
@@ -5,6 +5,7 @@
 #include <array>
 
 #include "clustering/administration/persist/branch_history_manager.hpp"
+#include "clustering/administration/persist/cache_warmer.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/administration/perfmon_collection_repo.hpp"
@@ -21,6 +22,7 @@ public:
             const namespace_id_t &table_id,
             const serializer_filepath_t &path,
             scoped_ptr_t<real_branch_history_manager_t> &&bhm,
+            scoped_ptr_t<cache_warmer_t> &&warmer,
             const base_path_t &base_path,
             io_backender_t *io_backender,
             cache_balancer_t *cache_balancer,
@@ -32,6 +34,7 @@ public:
                 namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
             > *real_multistores) :
         branch_history_manager(std::move(bhm)),
+        cache_warmer(std::move(warmer)),
         serializer_thread_allocation(std::move(serializer_thread)),
         store_thread_allocations(std::move(store_threads)),
         map_insertion_sentry(
@@ -120,6 +123,7 @@ public:
     }
 
     ~real_multistore_ptr_t() {
+        cache_warmer.reset();
         serializer_thread_allocation.reset();
         store_thread_allocations.clear();
         map_insertion_sentry.reset();
@@ -147,6 +151,10 @@ public:
         return serializer.get_or_null();
     }
 
+    cache_warmer_t *get_cache_warmer() {
+        return cache_warmer.get();
+    }
+
     store_view_t *get_cpu_sharded_store(size_t i) {
         return stores[i].get();
     }
@@ -166,6 +174,7 @@ public:
 
 private:
     scoped_ptr_t<real_branch_history_manager_t> branch_history_manager;
+    scoped_ptr_t<cache_warmer_t> cache_warmer;
     scoped_ptr_t<serializer_t> serializer;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
     scoped_ptr_t<store_t> stores[CPU_SHARDING_FACTOR];
@@ -253,6 +262,7 @@ void real_table_persistence_interface_t::write_metadata_inactive(
         &non_interruptor);
     table_raft_storage_interface_t::erase(&write_txn, table_id);
     real_branch_history_manager_t::erase(&write_txn, table_id);
+    cache_warmer_t::erase(&write_txn, table_id);
 }
 
 void real_table_persistence_interface_t::delete_metadata(
@@ -268,6 +278,7 @@ void real_table_persistence_interface_t::delete_metadata(
         &non_interruptor);
     table_raft_storage_interface_t::erase(&write_txn, table_id);
     real_branch_history_manager_t::erase(&write_txn, table_id);
+    cache_warmer_t::erase(&write_txn, table_id);
 }
 
 void real_table_persistence_interface_t::load_multistore(
@@ -279,6 +290,9 @@ void real_table_persistence_interface_t::load_multistore(
     scoped_ptr_t<real_branch_history_manager_t> bhm(
         new real_branch_history_manager_t(
             table_id, metadata_file, metadata_read_txn, interruptor));
+    scoped_ptr_t<cache_warmer_t> warmer(
+        new cache_warmer_t(table_id, metadata_file, metadata_read_txn, interruptor));
+    cache_warmer_t *warmer_ptr = warmer.get();
 
     scoped_ptr_t<thread_allocation_t> serializer_thread(
         new thread_allocation_t(&thread_allocator));
@@ -291,6 +305,7 @@ void real_table_persistence_interface_t::load_multistore(
         table_id,
         file_name_for(table_id),
         std::move(bhm),
+        std::move(warmer),
         base_path,
         io_backender,
         cache_balancer,
@@ -299,6 +314,14 @@ void real_table_persistence_interface_t::load_multistore(
         std::move(serializer_thread),
         std::move(store_threads),
         &real_multistores));
+
+    /* The `real_multistore_ptr_t` constructor runs on the serializer thread, so the
+    warm-up can only start now. */
+    std::vector<store_t *> stores;
+    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        stores.push_back((*multistore_ptr_out)->get_underlying_store(i));
+    }
+    warmer_ptr->start(stores);
 }
 
 void real_table_persistence_interface_t::create_multistore(
@@ -318,6 +341,13 @@ void real_table_persistence_interface_t::destroy_multistore(
     guarantee(multistore_ptr_in->has());
     multistore_ptr_in->reset();
 
+    {
+        /* The recorded hot blocks refer to the file we're about to remove. */
+        cond_t non_interruptor;
+        metadata_file_t::write_txn_t write_txn(metadata_file, &non_interruptor);
+        cache_warmer_t::erase(&write_txn, table_id);
+    }
+
     std::string filepath = file_name_for(table_id).permanent_path();
     logNTC("Removing file %s\n", filepath.c_str());
     const int res = ::unlink(filepath.c_str());
@@ -330,6 +360,19 @@ serializer_filepath_t real_table_persistence_interface_t::file_name_for(
     return serializer_filepath_t(base_path, uuid_to_str(table_id));
 }
 
+std::map<namespace_id_t, cache_warmer_t::progress_t>
+        real_table_persistence_interface_t::get_cache_warmups() const {
+    std::map<namespace_id_t, cache_warmer_t::progress_t> warmups;
+    for (const auto &real_multistore : real_multistores) {
+        cache_warmer_t::progress_t progress =
+            real_multistore.second.first->get_cache_warmer()->get_progress();
+        if (!progress.is_ready && progress.blocks_total != 0) {
+            warmups.insert(std::make_pair(real_multistore.first, progress));
+        }
+    }
+    return warmups;
+}
+
 bool real_table_persistence_interface_t::is_gc_active() const {
     for (int thread = 0; thread < get_num_db_threads(); ++thread) {
         std::map<serializer_t *, auto_drainer_t::lock_t> serializers_copy;
@@ -3,6 +3,7 @@
 #define CLUSTERING_ADMINISTRATION_PERSIST_TABLE_INTERFACE_HPP_
 
 #include "clustering/administration/perfmon_collection_repo.hpp"
+#include "clustering/administration/persist/cache_warmer.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/table_manager/table_metadata.hpp"
 
@@ -72,6 +73,9 @@ public:
 
     bool is_gc_active() const;
 
+    /* Returns the progress of the cache warm-ups that are still running, by table. */
+    std::map<namespace_id_t, cache_warmer_t::progress_t> get_cache_warmups() const;
+
 private:
     serializer_filepath_t file_name_for(const namespace_id_t &table_id);
     threadnum_t pick_thread();
@@ -39,7 +39,9 @@ parsed_stats_t::server_stats_t::server_stats_t() :
 parsed_stats_t::table_stats_t::table_stats_t() :
     read_docs_per_sec(0), read_docs_total(0),
     written_docs_per_sec(0), written_docs_total(0),
-    in_use_bytes(0), metadata_bytes(0), data_bytes(0),
+    in_use_bytes(0), limit_bytes(0),
+    hits_per_sec(0), misses_per_sec(0), evictions_per_sec(0),
+    metadata_bytes(0), data_bytes(0),
     garbage_bytes(0), preallocated_bytes(0),
     read_bytes_per_sec(0), read_bytes_total(0),
     written_bytes_per_sec(0), written_bytes_total(0) { }
@@ -125,6 +127,14 @@ void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                 } else if (key == "cache") {
                     add_perfmon_value(sub_pair.second, "in_use_bytes",
                                       &stats_out->in_use_bytes);
+                    add_perfmon_value(sub_pair.second, "limit_bytes",
+                                      &stats_out->limit_bytes);
+                    add_perfmon_value(sub_pair.second, "hits_per_sec",
+                                      &stats_out->hits_per_sec);
+                    add_perfmon_value(sub_pair.second, "misses_per_sec",
+                                      &stats_out->misses_per_sec);
+                    add_perfmon_value(sub_pair.second, "evictions_per_sec",
+                                      &stats_out->evictions_per_sec);
                 }
             }
         }
@@ -552,6 +562,17 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
 
         ql::datum_object_builder_t se_cache_builder;
         ADD_STAT(se_cache_builder, table_stats, in_use_bytes);
+        ADD_STAT(se_cache_builder, table_stats, limit_bytes);
+        ADD_STAT(se_cache_builder, table_stats, hits_per_sec);
+        ADD_STAT(se_cache_builder, table_stats, misses_per_sec);
+        ADD_STAT(se_cache_builder, table_stats, evictions_per_sec);
+        // The fraction of page acquisitions that found the page in memory, or null
+        // if there weren't any.
+        const double acquisitions_per_sec =
+            table_stats.hits_per_sec + table_stats.misses_per_sec;
+        se_cache_builder.overwrite("hit_ratio", acquisitions_per_sec > 0
+            ? ql::datum_t(table_stats.hits_per_sec / acquisitions_per_sec)
+            : ql::datum_t::null());
 
         ql::datum_object_builder_t se_disk_space_builder;
         ADD_STAT(se_disk_space_builder, table_stats, metadata_bytes);
@@ -28,6 +28,10 @@ public:
         double written_docs_per_sec;
         double written_docs_total;
         double in_use_bytes;
+        double limit_bytes;
+        double hits_per_sec;
+        double misses_per_sec;
+        double evictions_per_sec;
         double metadata_bytes;
         double data_bytes;
         double garbage_bytes;
@@ -4,6 +4,7 @@
 #include "clustering/administration/tables/database_metadata.hpp"
 #include "containers/archive/archive.hpp"
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/shared_buf_stream.hpp"
 #include "containers/archive/stl_types.hpp"
 #include "containers/archive/versioned.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -46,7 +47,20 @@ INSTANTIATE_SERIALIZABLE_FOR_VERSION(user_value_t, cluster_version_t::v2_2);
 INSTANTIATE_SERIALIZABLE_FOR_VERSION(user_value_t, cluster_version_t::v2_3);
 
 // Implement actual serialization for clustering.
-RDB_MAKE_SERIALIZABLE_1_FOR_CLUSTER(user_value_t, datum);
+template <>
+void serialize<cluster_version_t::CLUSTER>(
+        write_message_t *wm, const user_value_t &thing) {
+    serialize<cluster_version_t::CLUSTER>(wm, thing.datum);
+}
+
+template <>
+archive_result_t deserialize<cluster_version_t::CLUSTER>(
+        read_stream_t *s, user_value_t *thing) {
+    // The user value stays in the table's metadata for a long time, so it shouldn't
+    // keep the buffer of the message it came in alive.
+    shared_buf_read_stream_t::no_slices_t no_slices(s);
+    return deserialize<cluster_version_t::CLUSTER>(s, &thing->datum);
+}
 
 RDB_IMPL_EQUALITY_COMPARABLE_1(user_value_t, datum);
 
@@ -121,3 +135,66 @@ flush_interval_t get_flush_interval(const table_config_t &config) {
 
     return flush_interval_t{DEFAULT_FLUSH_INTERVAL};
 }
+
+block_compression_t get_block_compression(const table_config_t &config) {
+    ql::datum_t field = config.user_value.datum.get_field("srh/block_compression",
+                                                          ql::NOTHROW);
+
+    if (field.has() && field.get_type() == ql::datum_t::R_STR
+        && field.as_str() == "lz4") {
+        return block_compression_t::LZ4;
+    }
+
+    return block_compression_t::NONE;
+}
+
+eviction_policy_t get_eviction_policy(const table_config_t &config) {
+    ql::datum_t field = config.user_value.datum.get_field("srh/eviction_policy",
+                                                          ql::NOTHROW);
+
+    if (field.has() && field.get_type() == ql::datum_t::R_STR
+        && field.as_str() == "2q") {
+        return eviction_policy_t::TWO_QUEUE;
+    }
+
+    return eviction_policy_t::SAMPLED_LRU;
+}
+
+// Reads a non-negative size in megabytes from the user value, if it's there.
+bool get_user_value_mb(const table_config_t &config, const char *key,
+                       uint64_t *bytes_out) {
+    ql::datum_t field = config.user_value.datum.get_field(key, ql::NOTHROW);
+
+    if (!field.has() || field.get_type() != ql::datum_t::R_NUM
+        || field.as_num() < 0) {
+        return false;
+    }
+
+    // Sizes that don't fit into 64 bits saturate.
+    double bytes = field.as_num() * MEGABYTE;
+    *bytes_out = bytes >= static_cast<double>(UINT64_MAX)
+        ? UINT64_MAX
+        : static_cast<uint64_t>(bytes);
+    return true;
+}
+
+cache_quota_t get_cache_quota(const table_config_t &config) {
+    cache_quota_t quota;
+    get_user_value_mb(config, "srh/cache_min_mb", &quota.min_bytes);
+    get_user_value_mb(config, "srh/cache_max_mb", &quota.max_bytes);
+    return quota;
+}
+
+bool get_field_dictionary_enabled(const table_config_t &config) {
+    ql::datum_t field = config.user_value.datum.get_field("srh/field_dictionary",
+                                                          ql::NOTHROW);
+
+    return field.has() && field.get_type() == ql::datum_t::R_BOOL && field.as_bool();
+}
+
+bool get_key_filter_enabled(const table_config_t &config) {
+    ql::datum_t field = config.user_value.datum.get_field("srh/key_filter",
+                                                          ql::NOTHROW);
+
+    return field.has() && field.get_type() == ql::datum_t::R_BOOL && field.as_bool();
+}
@@ -91,6 +91,11 @@ RDB_DECLARE_SERIALIZABLE(table_config_t);
 RDB_DECLARE_EQUALITY_COMPARABLE(table_config_t);
 
 flush_interval_t get_flush_interval(const table_config_t &);
+block_compression_t get_block_compression(const table_config_t &);
+eviction_policy_t get_eviction_policy(const table_config_t &);
+cache_quota_t get_cache_quota(const table_config_t &);
+bool get_field_dictionary_enabled(const table_config_t &);
+bool get_key_filter_enabled(const table_config_t &);
 
 class table_shard_scheme_t {
 public:
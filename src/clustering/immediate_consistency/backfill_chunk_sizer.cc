@@ -0,0 +1,67 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/immediate_consistency/backfill_chunk_sizer.hpp"
+
+#include <algorithm>
+
+/* How many chunks should be in flight per round trip. More chunks keep the backfillee
+busier while it waits for the next one, but cost more messages. */
+static const double CHUNKS_PER_ROUND_TRIP = 4.0;
+
+/* How much weight the latest measurement gets in the moving averages. */
+static const double MEASUREMENT_SMOOTHING = 0.25;
+
+static void update_average(double sample, double *average) {
+    if (*average == 0) {
+        *average = sample;
+    } else {
+        *average += MEASUREMENT_SMOOTHING * (sample - *average);
+    }
+}
+
+backfill_chunk_sizer_t::backfill_chunk_sizer_t(
+        size_t initial_chunk_size, size_t queue_size) :
+    min_chunk_size(std::max<size_t>(1, initial_chunk_size / 4)),
+    max_chunk_size(std::max<size_t>(initial_chunk_size, queue_size / 4)),
+    chunk_size(initial_chunk_size),
+    bytes_sent(0),
+    bytes_acked(0),
+    round_trip_secs(0),
+    bytes_per_sec(0),
+    last_ack_time(0) { }
+
+void backfill_chunk_sizer_t::on_chunk_sent(size_t mem_size, ticks_t now) {
+    unacked_chunk_t chunk;
+    chunk.measure_round_trip = bytes_sent == bytes_acked;
+    bytes_sent += mem_size;
+    chunk.end = bytes_sent;
+    chunk.sent_time = now;
+    unacked_chunks.push_back(chunk);
+}
+
+void backfill_chunk_sizer_t::on_items_acked(size_t mem_size, ticks_t now) {
+    bytes_acked += mem_size;
+    /* Only the first unacknowledged chunk can have been sent while nothing else was in
+    flight, and this is the first acknowledgement for it. */
+    if (!unacked_chunks.empty() && unacked_chunks.front().measure_round_trip) {
+        update_average(ticks_to_secs(now - unacked_chunks.front().sent_time),
+                       &round_trip_secs);
+        unacked_chunks.front().measure_round_trip = false;
+    }
+    while (!unacked_chunks.empty() && unacked_chunks.front().end <= bytes_acked) {
+        unacked_chunks.pop_front();
+    }
+    if (last_ack_time != 0 && now > last_ack_time) {
+        update_average(mem_size / ticks_to_secs(now - last_ack_time), &bytes_per_sec);
+    }
+    last_ack_time = now;
+    update_chunk_size();
+}
+
+void backfill_chunk_sizer_t::update_chunk_size() {
+    if (round_trip_secs == 0 || bytes_per_sec == 0) {
+        return;
+    }
+    double target = bytes_per_sec * round_trip_secs / CHUNKS_PER_ROUND_TRIP;
+    chunk_size = std::min<double>(std::max<double>(target, min_chunk_size),
+                                  max_chunk_size);
+}
@@ -0,0 +1,66 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILL_CHUNK_SIZER_HPP_
+#define CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILL_CHUNK_SIZER_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+
+#include "errors.hpp"
+#include "time.hpp"
+
+/* `backfill_chunk_sizer_t` picks the mem size of the item chunks that the backfiller
+sends to the backfillee. It measures the round trip time of the link and the rate at
+which the backfillee acknowledges items. Their product is how many bytes of items need
+to be in flight to keep the backfillee busy, and chunks are sized so that several of
+them make up that amount. So fast, short links get fewer messages, and slow links get
+smaller chunks that don't sit in the queue for long.
+
+The round trip time is only measured on chunks that were sent while nothing else was
+in flight, from sending the chunk until the first of its items gets acknowledged. The
+backfiller keeps the item queue full whenever it can, so the time until the last item
+of a chunk gets acknowledged is mostly the time the chunk spends queued behind the
+others, which says more about the queue size than about the link.
+
+Until there are measurements, and within bounds, chunks have the configured size. They
+never get smaller than a quarter of it, and never bigger than a quarter of the item
+queue, so that several chunks fit into the queue. The times are passed in so that the
+unit tests can simulate links. */
+class backfill_chunk_sizer_t {
+public:
+    backfill_chunk_sizer_t(size_t initial_chunk_size, size_t queue_size);
+
+    size_t get_chunk_size() const { return chunk_size; }
+
+    void on_chunk_sent(size_t mem_size, ticks_t now);
+    void on_items_acked(size_t mem_size, ticks_t now);
+
+private:
+    void update_chunk_size();
+
+    struct unacked_chunk_t {
+        /* The total mem size of the items sent up to the end of the chunk. */
+        uint64_t end;
+        ticks_t sent_time;
+        /* Whether the chunk was sent while nothing else was in flight, and its round
+        trip hasn't been measured yet. */
+        bool measure_round_trip;
+    };
+
+    const size_t min_chunk_size, max_chunk_size;
+    size_t chunk_size;
+
+    /* The chunks that haven't been acknowledged completely yet. */
+    std::deque<unacked_chunk_t> unacked_chunks;
+    uint64_t bytes_sent, bytes_acked;
+
+    /* Moving averages; zero until the first measurement. */
+    double round_trip_secs;
+    double bytes_per_sec;
+    ticks_t last_ack_time;
+
+    DISABLE_COPYING(backfill_chunk_sizer_t);
+};
+
+#endif /* CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILL_CHUNK_SIZER_HPP_ */
@@ -0,0 +1,55 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/immediate_consistency/backfill_item_chunk.hpp"
+
+#include "containers/archive/string_stream.hpp"
+#include "containers/archive/versioned.hpp"
+#include "containers/lz4_block.hpp"
+
+backfill_item_chunk_t::backfill_item_chunk_t() :
+    raw_size(0), is_compressed(false) { }
+
+backfill_item_chunk_t::backfill_item_chunk_t(
+        const backfill_item_seq_t<backfill_item_t> &items, bool compress) :
+    raw_size(0), is_compressed(false) {
+    write_message_t wm;
+    serialize<cluster_version_t::CLUSTER>(&wm, items);
+    string_stream_t stream;
+    int write_res = send_write_message(&stream, &wm);
+    guarantee(write_res == 0);
+    data = std::move(stream.str());
+    raw_size = data.size();
+
+    if (compress && !data.empty()) {
+        /* Only keep the compressed data if it saves at least an eighth of the size;
+        below that it isn't worth the time the backfillee spends decompressing. */
+        std::string compressed(data.size() - data.size() / 8, '\0');
+        size_t compressed_size = lz4_compress_block(
+            data.data(), data.size(), &compressed[0], compressed.size());
+        if (compressed_size != 0) {
+            compressed.resize(compressed_size);
+            data = std::move(compressed);
+            is_compressed = true;
+        }
+    }
+}
+
+backfill_item_seq_t<backfill_item_t> backfill_item_chunk_t::decode() const {
+    std::string serialized;
+    if (is_compressed) {
+        serialized.resize(raw_size);
+        bool ok = lz4_decompress_block(
+            data.data(), data.size(), &serialized[0], serialized.size());
+        guarantee(ok, "Compressed backfill item chunk is corrupt.");
+    } else {
+        guarantee(data.size() == raw_size);
+        serialized = data;
+    }
+    string_read_stream_t stream(std::move(serialized), 0);
+    backfill_item_seq_t<backfill_item_t> items;
+    archive_result_t res = deserialize<cluster_version_t::CLUSTER>(&stream, &items);
+    guarantee_deserialization(res, "backfill item chunk");
+    return items;
+}
+
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(backfill_item_chunk_t,
+    raw_size, is_compressed, data);
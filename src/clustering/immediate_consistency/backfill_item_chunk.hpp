@@ -0,0 +1,36 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILL_ITEM_CHUNK_HPP_
+#define CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILL_ITEM_CHUNK_HPP_
+
+#include <string>
+
+#include "btree/backfill.hpp"
+#include "clustering/immediate_consistency/backfill_item_seq.hpp"
+#include "rpc/serialize_macros.hpp"
+
+/* `backfill_item_chunk_t` is the form in which a chunk of backfill items travels from
+the backfiller to the backfillee. The backfiller serializes the items up front, and if
+LZ4 makes them smaller by at least an eighth, it sends them compressed. Backfill items
+mostly consist of documents, which usually compress well; if they don't, the cost is
+a failed compression attempt, which gives up early. */
+class backfill_item_chunk_t {
+public:
+    backfill_item_chunk_t();
+    backfill_item_chunk_t(
+        const backfill_item_seq_t<backfill_item_t> &items, bool compress);
+
+    /* Restores the items. Crashes if the data is corrupt. */
+    backfill_item_seq_t<backfill_item_t> decode() const;
+
+    /* The number of bytes of the serialized items, before compression. */
+    uint64_t raw_size;
+
+    bool is_compressed;
+
+    /* The serialized items, compressed if `is_compressed` is `true`. */
+    std::string data;
+};
+
+RDB_DECLARE_SERIALIZABLE(backfill_item_chunk_t);
+
+#endif /* CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILL_ITEM_CHUNK_HPP_ */
@@ -5,9 +5,11 @@ backfill_config_t::backfill_config_t() :
     item_queue_mem_size(4 * MEGABYTE),
     item_chunk_mem_size(100 * KILOBYTE),
     pre_item_queue_mem_size(4 * MEGABYTE),
-    pre_item_chunk_mem_size(100 * KILOBYTE)
+    pre_item_chunk_mem_size(100 * KILOBYTE),
+    compress_items(true)
     { }
 
+// `compress_items` is serialized as part of the `intro_1_t`.
 RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(backfill_config_t,
     item_queue_mem_size, item_chunk_mem_size, pre_item_queue_mem_size,
     pre_item_chunk_mem_size);
@@ -16,9 +18,49 @@ RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(backfiller_bcard_t::intro_2_t,
     common_version, final_version_history, pre_items_mailbox, begin_session_mailbox,
     end_session_mailbox, ack_items_mailbox, num_changes_estimate, progress_estimator);
 
-RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(backfiller_bcard_t::intro_1_t,
-    config, initial_version, initial_version_history, intro_mailbox, items_mailbox,
-    ack_end_session_mailbox, ack_pre_items_mailbox);
+template <cluster_version_t W>
+void serialize(write_message_t *wm, const backfiller_bcard_t::intro_1_t &intro) {
+    serialize<W>(wm, intro.config);
+    serialize<W>(wm, intro.initial_version);
+    serialize<W>(wm, intro.initial_version_history);
+    serialize<W>(wm, intro.intro_mailbox);
+    serialize<W>(wm, intro.items_mailbox);
+    serialize<W>(wm, intro.ack_end_session_mailbox);
+    serialize<W>(wm, intro.ack_pre_items_mailbox);
+    serialize<W>(wm, intro.item_chunks_mailbox);
+    serialize<W>(wm, intro.config.compress_items);
+}
+
+template <cluster_version_t W>
+archive_result_t deserialize(read_stream_t *s, backfiller_bcard_t::intro_1_t *intro) {
+    archive_result_t res = deserialize<W>(s, &intro->config);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &intro->initial_version);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &intro->initial_version_history);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &intro->intro_mailbox);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &intro->items_mailbox);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &intro->ack_end_session_mailbox);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &intro->ack_pre_items_mailbox);
+    if (bad(res)) { return res; }
+
+    /* A backfillee running a previous version ends its message here. */
+    res = deserialize<W>(s, &intro->item_chunks_mailbox);
+    if (res == archive_result_t::SOCK_EOF) {
+        intro->item_chunks_mailbox =
+            backfiller_bcard_t::item_chunks_mailbox_t::address_t();
+        intro->config.compress_items = false;
+        return archive_result_t::SUCCESS;
+    }
+    if (bad(res)) { return res; }
+    return deserialize<W>(s, &intro->config.compress_items);
+}
+
+INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(backfiller_bcard_t::intro_1_t);
 
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(backfiller_bcard_t, region, registrar);
 RDB_IMPL_EQUALITY_COMPARABLE_2(backfiller_bcard_t, region, registrar);
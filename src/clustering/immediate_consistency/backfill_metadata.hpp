@@ -4,6 +4,7 @@
 
 #include "btree/backfill.hpp"
 #include "clustering/generic/registration_metadata.hpp"
+#include "clustering/immediate_consistency/backfill_item_chunk.hpp"
 #include "clustering/immediate_consistency/backfill_item_seq.hpp"
 #include "clustering/immediate_consistency/history.hpp"
 #include "rdb_protocol/distribution_progress.hpp"
@@ -23,8 +24,9 @@ public:
     backfillee. */
     size_t item_queue_mem_size;
 
-    /* The maximum size, in bytes, of a chunk of items sent over the network from the
-    backfiller to the backfillee. */
+    /* The size, in bytes, of the first chunks of items sent over the network from the
+    backfiller to the backfillee. Later chunks are sized by `backfill_chunk_sizer_t`
+    according to how fast the backfillee acknowledges them. */
     size_t item_chunk_mem_size;
 
     /* The maximum amount of RAM that can be used for the pre-items queued in memory on
@@ -34,6 +36,12 @@ public:
     /* The maximum size, in bytes, of a chunk of pre-items sent over the network from the
     backfillee to the backfiller. */
     size_t pre_item_chunk_mem_size;
+
+    /* Whether the backfiller compresses the chunks of items it sends to the
+    backfillee. See `backfill_item_chunk_t`. Previous versions don't know about this
+    field, so it isn't serialized as part of the config; it travels at the end of the
+    `intro_1_t` instead. */
+    bool compress_items;
 };
 
 RDB_DECLARE_SERIALIZABLE(backfill_config_t);
@@ -78,9 +86,12 @@ anywhere between the left-hand side of the range and the furthest point where an
 has ended.
 
 2. The backfiller starts traversing the B-tree; as it does so, it sends messages to the
-`items_mailbox_t` on the backfillee. These messages form a contiguous series of
-`backfill_item_seq_t`s in lexicographical order. Each message includes the corresponding
-metainfo. The backfillee applies the items to its B-tree.
+`item_chunks_mailbox_t` on the backfillee. These messages form a contiguous series of
+`backfill_item_seq_t`s in lexicographical order, each one packed into a
+`backfill_item_chunk_t`. Each message includes the corresponding metainfo. The
+backfillee applies the items to its B-tree. Backfillees running previous versions don't
+have an `item_chunks_mailbox_t`; the backfiller sends them the plain
+`backfill_item_seq_t`s through their `items_mailbox_t` instead.
 
 3. As the backfillee applies each item, it sends messages to the `ack_items_mailbox_t` on
 the backfiller. The backfiller uses this as flow control; it limits the total mem size of
@@ -172,6 +183,14 @@ public:
         backfill_item_seq_t<backfill_item_t>
         )> items_mailbox_t;
 
+    typedef mailbox_t<void(
+        fifo_enforcer_write_token_t,
+        /* The `region_map_t` and the `backfill_item_seq_t` in the
+        `backfill_item_chunk_t` have the same region. */
+        region_map_t<version_t>,
+        backfill_item_chunk_t
+        )> item_chunks_mailbox_t;
+
     typedef mailbox_t<void(
         fifo_enforcer_write_token_t
         )> ack_end_session_mailbox_t;
@@ -192,6 +211,13 @@ public:
         items_mailbox_t::address_t items_mailbox;
         ack_end_session_mailbox_t::address_t ack_end_session_mailbox;
         ack_pre_items_mailbox_t::address_t ack_pre_items_mailbox;
+
+        /* Backfillees running previous versions neither send nor expect this, which
+        is why it's serialized after all of the other fields, together with
+        `config.compress_items`. Previous versions ignore the end of a message that
+        they don't understand, and we leave it nil if a message ends before it. This
+        only works because the `intro_1_t` is always the last part of its message. */
+        item_chunks_mailbox_t::address_t item_chunks_mailbox;
     };
 
     /* This `region_t` describes the region that the backfiller applies to. Backfill
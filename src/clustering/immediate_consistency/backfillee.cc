@@ -333,6 +333,9 @@ backfillee_t::backfillee_t(
     session_interrupted(false),
     items_mailbox(mailbox_manager,
         std::bind(&backfillee_t::on_items, this, ph::_1, ph::_2, ph::_3, ph::_4)),
+    item_chunks_mailbox(mailbox_manager,
+        std::bind(&backfillee_t::on_item_chunk,
+            this, ph::_1, ph::_2, ph::_3, ph::_4)),
     ack_end_session_mailbox(mailbox_manager,
         std::bind(&backfillee_t::on_ack_end_session, this, ph::_1, ph::_2)),
     ack_pre_items_mailbox(mailbox_manager,
@@ -346,6 +349,7 @@ backfillee_t::backfillee_t(
     our_intro.config = backfill_config;
     our_intro.ack_pre_items_mailbox = ack_pre_items_mailbox.get_address();
     our_intro.items_mailbox = items_mailbox.get_address();
+    our_intro.item_chunks_mailbox = item_chunks_mailbox.get_address();
     our_intro.ack_end_session_mailbox = ack_end_session_mailbox.get_address();
 
     /* Fetch the `initial_version` and `initial_version_history` fields for the
@@ -430,9 +434,29 @@ void backfillee_t::on_items(
         return;
     }
     guarantee(current_session != nullptr);
+    /* A backfiller running a previous version sends the items uncompressed, and we
+    don't have their serialized size, so we go by the size estimate. */
+    progress_tracker->bytes_transferred += chunk.get_mem_size();
+    progress_tracker->bytes_uncompressed += chunk.get_mem_size();
     current_session->on_items(std::move(version), std::move(chunk));
 }
 
+void backfillee_t::on_item_chunk(
+        signal_t *interruptor,
+        const fifo_enforcer_write_token_t &fifo_token,
+        region_map_t<version_t> &&version,
+        backfill_item_chunk_t &&chunk) {
+    fifo_enforcer_sink_t::exit_write_t exit_write(&fifo_sink, fifo_token);
+    wait_interruptible(&exit_write, interruptor);
+    if (session_interrupted) {
+        return;
+    }
+    guarantee(current_session != nullptr);
+    progress_tracker->bytes_transferred += chunk.data.size();
+    progress_tracker->bytes_uncompressed += chunk.raw_size;
+    current_session->on_items(std::move(version), chunk.decode());
+}
+
 void backfillee_t::on_ack_end_session(
         signal_t *interruptor,
         const fifo_enforcer_write_token_t &fifo_token) {
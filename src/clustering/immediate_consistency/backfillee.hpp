@@ -90,8 +90,9 @@ public:
         signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
 
 private:
-    /* `on_items()`, `on_ack_end_session()`, and `on_ack_pre_items()` are mailbox
-    callbacks. */
+    /* `on_items()`, `on_item_chunk()`, `on_ack_end_session()`, and
+    `on_ack_pre_items()` are mailbox callbacks. Backfillers running previous versions
+    send their items to `on_items()`, and all others to `on_item_chunk()`. */
 
     void on_items(
         signal_t *interruptor,
@@ -99,6 +100,12 @@ private:
         region_map_t<version_t> &&version,
         backfill_item_seq_t<backfill_item_t> &&chunk);
 
+    void on_item_chunk(
+        signal_t *interruptor,
+        const fifo_enforcer_write_token_t &fifo_token,
+        region_map_t<version_t> &&version,
+        backfill_item_chunk_t &&chunk);
+
     void on_ack_end_session(
         signal_t *interruptor,
         const fifo_enforcer_write_token_t &fifo_token);
@@ -149,6 +156,7 @@ private:
     sending messages to the mailboxes as they're being destroyed. */
     auto_drainer_t drainer;
     backfiller_bcard_t::items_mailbox_t items_mailbox;
+    backfiller_bcard_t::item_chunks_mailbox_t item_chunks_mailbox;
     backfiller_bcard_t::ack_end_session_mailbox_t ack_end_session_mailbox;
     backfiller_bcard_t::ack_pre_items_mailbox_t ack_pre_items_mailbox;
     scoped_ptr_t<registrant_t<backfiller_bcard_t::intro_1_t> > registrant;
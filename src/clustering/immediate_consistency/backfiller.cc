@@ -27,6 +27,7 @@ backfiller_t::client_t::client_t(
         key_range_t::right_bound_t(full_region.inner.left)),
     item_throttler(intro.config.item_queue_mem_size),
     item_throttler_acq(&item_throttler, 0),
+    chunk_sizer(intro.config.item_chunk_mem_size, intro.config.item_queue_mem_size),
     pre_items_mailbox(parent->mailbox_manager,
         std::bind(&client_t::on_pre_items, this, ph::_1, ph::_2, ph::_3)),
     begin_session_mailbox(parent->mailbox_manager,
@@ -242,13 +243,14 @@ private:
         with_priority_t p(CORO_PRIORITY_BACKFILL_SENDER);
         try {
             while (threshold != parent->full_region.inner.right) {
+                size_t chunk_mem_size = parent->chunk_sizer.get_chunk_size();
+
                 /* Wait until there's room in the semaphore for the chunk we're about to
                 process.
                 We acquire the maximum size that we want to put in this chunk first,
                 and then adjust the semaphore acquisition to the actual size of the
                 chunk later. */
-                new_semaphore_in_line_t sem_acq(
-                    &parent->item_throttler, parent->intro.config.item_chunk_mem_size);
+                new_semaphore_in_line_t sem_acq(&parent->item_throttler, chunk_mem_size);
                 wait_interruptible(
                     sem_acq.acquisition_signal(), keepalive.get_drain_signal());
 
@@ -267,7 +269,7 @@ private:
                 subregion.inner.left = threshold.key();
 
                 /* Copy items from the store into `chunk` until the total size hits
-                `item_chunk_mem_size`; we finish the backfill range; or we run out of
+                `chunk_mem_size`; we finish the backfill range; or we run out of
                 pre-items. */
 
                 backfill_item_seq_t<backfill_item_t> chunk(
@@ -340,8 +342,7 @@ private:
                         region_map_t<version_t> *const metainfo;
                     } consumer(&chunk, &metainfo);
 
-                    backfill_item_memory_tracker_t memory_tracker(
-                        parent->intro.config.item_chunk_mem_size);
+                    backfill_item_memory_tracker_t memory_tracker(chunk_mem_size);
 
                     parent->parent->store->send_backfill(
                         parent->common_version.mask(subregion),
@@ -359,7 +360,7 @@ private:
                 information for the backfillee to have. */
                 if (!chunk.empty_domain()) {
                     /* Adjust for the fact that `chunk.get_mem_size()` isn't precisely
-                    equal to `item_chunk_mem_size`, and then transfer the semaphore
+                    equal to `chunk_mem_size`, and then transfer the semaphore
                     ownership. */
                     sem_acq.change_count(chunk.get_mem_size());
                     parent->item_throttler_acq.transfer_in(std::move(sem_acq));
@@ -376,9 +377,21 @@ private:
                     we've sent. */
                     try {
                         /* Send the chunk over the network */
-                        send(parent->parent->mailbox_manager,
-                            parent->intro.items_mailbox,
-                            parent->fifo_source.enter_write(), metainfo, chunk);
+                        parent->chunk_sizer.on_chunk_sent(
+                            chunk.get_mem_size(), get_ticks());
+                        if (!parent->intro.item_chunks_mailbox.is_nil()) {
+                            send(parent->parent->mailbox_manager,
+                                parent->intro.item_chunks_mailbox,
+                                parent->fifo_source.enter_write(), metainfo,
+                                backfill_item_chunk_t(
+                                    chunk, parent->intro.config.compress_items));
+                        } else {
+                            /* The backfillee runs a previous version, which doesn't
+                            understand `backfill_item_chunk_t`. */
+                            send(parent->parent->mailbox_manager,
+                                parent->intro.items_mailbox,
+                                parent->fifo_source.enter_write(), metainfo, chunk);
+                        }
 
                         /* Update `common_version` to reflect the changes that will
                         happen on the backfillee in response to the chunk */
@@ -482,6 +495,7 @@ void backfiller_t::client_t::on_ack_items(
 
     guarantee(static_cast<int64_t>(mem_size) <= item_throttler_acq.count());
     item_throttler_acq.change_count(item_throttler_acq.count() - mem_size);
+    chunk_sizer.on_items_acked(mem_size, get_ticks());
 }
 
 void backfiller_t::client_t::on_pre_items(
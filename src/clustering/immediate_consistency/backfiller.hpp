@@ -7,6 +7,7 @@
 
 #include "clustering/generic/registrar.hpp"
 #include "clustering/immediate_consistency/history.hpp"
+#include "clustering/immediate_consistency/backfill_chunk_sizer.hpp"
 #include "clustering/immediate_consistency/backfill_metadata.hpp"
 #include "store_view.hpp"
 
@@ -100,6 +101,10 @@ private:
         new_semaphore_t item_throttler;
         new_semaphore_in_line_t item_throttler_acq;
 
+        /* `chunk_sizer` picks how much of the `item_throttler` each chunk of items
+        takes up. */
+        backfill_chunk_sizer_t chunk_sizer;
+
         scoped_ptr_t<session_t> current_session;
 
         backfiller_bcard_t::pre_items_mailbox_t pre_items_mailbox;
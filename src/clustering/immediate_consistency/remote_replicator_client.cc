@@ -184,6 +184,8 @@ remote_replicator_client_t::remote_replicator_client_t(
     progress_tracker->start_time = current_microtime();
     progress_tracker->source_server_id = primary_server_id;
     progress_tracker->progress = 0.0;
+    progress_tracker->bytes_transferred = 0;
+    progress_tracker->bytes_uncompressed = 0;
 
     /* If the store is currently constructing a secondary index, wait until it finishes
     before we start the backfill. We'll also check again periodically during the
@@ -18,6 +18,11 @@ public:
         microtime_t start_time;
         server_id_t source_server_id;
         double progress;
+        /* The size of the chunks of backfill items that arrived, as they were sent
+        over the network and before they were compressed. For items that arrived
+        without being put into chunks, both are the items' estimated size. */
+        uint64_t bytes_transferred;
+        uint64_t bytes_uncompressed;
     };
 
     progress_tracker_t * insert_progress_tracker(const region_t &region);
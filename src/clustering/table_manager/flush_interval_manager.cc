@@ -21,16 +21,39 @@ flush_interval_manager_t::flush_interval_manager_t(
 
 void flush_interval_manager_t::update_blocking(signal_t *interruptor) {
     flush_interval_t flush_interval;
+    block_compression_t block_compression;
+    eviction_policy_t eviction_policy;
+    cache_quota_t cache_quota;
+    bool field_dictionary_enabled;
+    bool key_filter_enabled;
     table_config->apply_read([&](const table_config_t *config) {
         flush_interval = get_flush_interval(*config);
+        block_compression = get_block_compression(*config);
+        eviction_policy = get_eviction_policy(*config);
+        cache_quota = get_cache_quota(*config);
+        field_dictionary_enabled = get_field_dictionary_enabled(*config);
+        key_filter_enabled = get_key_filter_enabled(*config);
     });
 
+    // The quota is for the whole table on this server, which is split evenly across
+    // the CPU shards.
+    cache_quota_t shard_cache_quota(
+        cache_quota.min_bytes / CPU_SHARDING_FACTOR,
+        cache_quota.max_bytes == UINT64_MAX
+            ? UINT64_MAX
+            : cache_quota.max_bytes / CPU_SHARDING_FACTOR);
+
     for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
         store_t *store = multistore->get_underlying_store(i);
         cross_thread_signal_t ct_interruptor(interruptor, store->home_thread());
         on_thread_t thread_switcher(store->home_thread());
 
         store->configure_flush_interval(flush_interval);
+        store->configure_block_compression(block_compression);
+        store->configure_eviction_policy(eviction_policy);
+        store->configure_cache_quota(shard_cache_quota);
+        store->configure_field_dictionary(field_dictionary_enabled);
+        store->configure_key_filter(key_filter_enabled);
     }
 }
 
@@ -7,8 +7,9 @@
 #include "concurrency/pump_coro.hpp"
 #include "concurrency/watchable.hpp"
 
-/* The `flush_interval_manager_t` is responsible for reading the flush interval
-description from the `table_config_t` updating the flush interval on the `store_t`. */
+/* The `flush_interval_manager_t` is responsible for reading the flush interval, block
+compression, eviction policy, cache quota, field dictionary and key filter settings from
+the `table_config_t` and applying them to the `store_t`. */
 
 class flush_interval_manager_t {
 public:
@@ -0,0 +1,111 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "concurrency/work_stealing.hpp"
+
+#include <atomic>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/interruptor.hpp"
+#include "containers/counted.hpp"
+#include "threading.hpp"
+#include "utils.hpp"
+
+/* The tasks of one `work_stealing_pmap()` call. The helper coroutines keep it alive,
+since they might only get to run after the call has returned. */
+class work_stealing_tasks_t : public slow_atomic_countable_t<work_stealing_tasks_t> {
+public:
+    work_stealing_tasks_t(size_t _num_tasks,
+                          const std::function<void(size_t)> *_fn,
+                          cond_t *_done)
+        : num_tasks(_num_tasks),
+          fn(_fn),
+          done(_done),
+          home_thread(get_thread_id()),
+          next_task(0),
+          tasks_finished(0),
+          cancelled(false) { }
+
+    /* Runs tasks until there are none left to take. Returns true if it finished the
+    last of them. */
+    bool run_tasks(signal_t *interruptor) {
+        bool finished_last = false;
+        for (;;) {
+            size_t task = next_task.fetch_add(1);
+            if (task >= num_tasks) {
+                break;
+            }
+            if (interruptor != nullptr && interruptor->is_pulsed()) {
+                cancelled.store(true);
+            }
+            if (!cancelled.load()) {
+                (*fn)(task);
+            }
+            if (tasks_finished.fetch_add(1) + 1 == num_tasks) {
+                finished_last = true;
+            }
+        }
+        return finished_last;
+    }
+
+    /* `fn` and `done` are only valid until all tasks are finished. `done` is pulsed
+    on `home_thread` by the helper that finishes the last task, if any. Helpers that
+    don't get a task never touch either of them. */
+    size_t const num_tasks;
+    const std::function<void(size_t)> *const fn;
+    cond_t *const done;
+    threadnum_t const home_thread;
+
+    std::atomic<size_t> next_task;
+    std::atomic<size_t> tasks_finished;
+    std::atomic<bool> cancelled;
+
+private:
+    DISABLE_COPYING(work_stealing_tasks_t);
+};
+
+void steal_tasks(const counted_t<work_stealing_tasks_t> &tasks) {
+    if (tasks->run_tasks(nullptr)) {
+        on_thread_t rethreader(tasks->home_thread);
+        tasks->done->pulse();
+    }
+}
+
+void work_stealing_pmap(size_t num_tasks,
+                        const std::function<void(size_t)> &fn,
+                        signal_t *interruptor) {
+    if (num_tasks == 0) {
+        return;
+    }
+    if (interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+    cond_t done;
+    counted_t<work_stealing_tasks_t> tasks =
+        make_counted<work_stealing_tasks_t>(num_tasks, &fn, &done);
+
+    {
+        // The helpers inherit our priority.
+        with_priority_t p(MESSAGE_SCHEDULER_MIN_PRIORITY);
+        size_t num_helpers = 0;
+        for (int i = 0; i < get_num_db_threads() && num_helpers + 1 < num_tasks; ++i) {
+            threadnum_t thread(i);
+            if (thread == get_thread_id()) {
+                continue;
+            }
+            coro_t::spawn_on_thread([tasks]() { steal_tasks(tasks); }, thread);
+            ++num_helpers;
+        }
+    }
+
+    // We only wait for the helpers that took a task, and only if one of them is still
+    // running when we run out of tasks. The others drop their reference whenever they
+    // get to run, without touching anything that lives on our stack.
+    if (!tasks->run_tasks(interruptor)) {
+        // The helpers might refer to data we were given, so this isn't interruptible.
+        done.wait_lazily_unordered();
+    }
+    if (tasks->cancelled.load()) {
+        throw interrupted_exc_t();
+    }
+}
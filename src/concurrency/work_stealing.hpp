@@ -0,0 +1,30 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_WORK_STEALING_HPP_
+#define CONCURRENCY_WORK_STEALING_HPP_
+
+#include <stddef.h>
+
+#include <functional>
+
+class signal_t;
+
+/* `work_stealing_pmap()` calls `fn(i)` for every `i` in `[0, num_tasks)` and returns
+once all of the calls are done, like `pmap()`. Unlike `pmap()`, it spreads the calls
+over the thread pool instead of keeping them on the current thread.
+
+The current thread works through the tasks in order. Every other thread gets a helper
+coroutine with the lowest scheduler priority, which takes tasks from the same counter
+once it gets to run. A busy thread gets to its helper late, usually after the current
+thread has taken all of the tasks, so it's mostly idle threads that take over work.
+The call only waits for helpers that are still running a task once it runs out of
+tasks itself; helpers that get to run later find nothing left to do and exit.
+
+`fn` is called on arbitrary threads, possibly concurrently, so it must only touch data
+that's safe to use from any thread. It must not throw. If `interruptor` gets pulsed,
+the tasks that haven't started yet are skipped and `interrupted_exc_t` is thrown once
+the running ones are done. */
+void work_stealing_pmap(size_t num_tasks,
+                        const std::function<void(size_t)> &fn,
+                        signal_t *interruptor);
+
+#endif  // CONCURRENCY_WORK_STEALING_HPP_
@@ -66,6 +66,27 @@
 // 0 = minimal priority
 #define SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY   5
 
+// Secondary index construction slows down while the average latency of the writes to
+// the table is above this (see `sindex_construction_pacer_t`)
+#define SINDEX_CONSTRUCTION_TARGET_WRITE_LATENCY_MS  50
+
+// The longest that secondary index construction pauses between two chunks of work
+#define SINDEX_CONSTRUCTION_MAX_PAUSE_MS          1000
+
+// The cache priority to use for warming up the cache after a restart
+#define CACHE_WARMUP_CACHE_PRIORITY               5
+
+// The cache priority to use for rebuilding the key filter of a table
+#define KEY_FILTER_REBUILD_CACHE_PRIORITY         5
+
+// The number of bits per key in the key filter of a table, which gets rebuilt with
+// twice the capacity it needs. A filter at its capacity has a false positive rate of
+// about 1%.
+#define KEY_FILTER_BITS_PER_KEY                   10
+
+// The smallest number of keys that a key filter is sized for
+#define KEY_FILTER_MIN_CAPACITY                   4096
+
 // Size of the buffer used to perform IO operations (in bytes).
 #define IO_BUFFER_SIZE                            (4 * KILOBYTE)
 
@@ -150,6 +171,10 @@
 
 #define COROUTINE_STACK_SIZE                      131072
 
+// Stack size of coroutines that are spawned with `coro_stack_tier_t::SMALL`. These
+// don't get a guard page, so only use them for coroutines with a shallow call graph.
+#define SMALL_COROUTINE_STACK_SIZE                32768
+
 
 /**
  * Message scheduler configuration
@@ -0,0 +1,79 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_ARCHIVE_SHARED_BUF_STREAM_HPP_
+#define CONTAINERS_ARCHIVE_SHARED_BUF_STREAM_HPP_
+
+#include <string.h>
+
+#include "containers/archive/archive.hpp"
+#include "containers/shared_buffer.hpp"
+
+/* Reads from a `shared_buf_t`. Deserializers that know about this stream can refer to
+parts of the buffer instead of copying them out of it (see `datum_deserialize()`). Note
+that anything that does so keeps the whole buffer alive. */
+class shared_buf_read_stream_t : public read_stream_t {
+public:
+    explicit shared_buf_read_stream_t(counted_t<const shared_buf_t> &&buf,
+                                      size_t offset = 0)
+        : pos_(offset), buf_(std::move(buf)), no_slices_depth_(0) {
+        guarantee(buf_.has());
+        guarantee(pos_ <= buf_->size());
+    }
+    virtual ~shared_buf_read_stream_t() { }
+
+    virtual MUST_USE int64_t read(void *p, int64_t n) {
+        size_t num_left = buf_->size() - pos_;
+        size_t num_to_read = static_cast<uint64_t>(n) < num_left ? n : num_left;
+
+        memcpy(p, buf_->data(pos_), num_to_read);
+
+        pos_ += num_to_read;
+
+        return num_to_read;
+    }
+
+    // Skips `n` bytes. Returns false and skips nothing if there are fewer left.
+    MUST_USE bool skip(uint64_t n) {
+        if (n > buf_->size() - pos_) {
+            return false;
+        }
+        pos_ += n;
+        return true;
+    }
+
+    size_t tell() const { return pos_; }
+    const counted_t<const shared_buf_t> &get_buf() const { return buf_; }
+
+    // Whether deserializers may refer into the buffer (see `no_slices_t`).
+    bool allows_slices() const { return no_slices_depth_ == 0; }
+
+    /* Values that outlive the message they were read from, such as cluster metadata,
+    shouldn't keep the message buffer alive. Their deserializers create a `no_slices_t`
+    for `s`, which makes everything they read from it get copied if `s` is a
+    `shared_buf_read_stream_t`. */
+    class no_slices_t {
+    public:
+        explicit no_slices_t(read_stream_t *s)
+            : stream_(dynamic_cast<shared_buf_read_stream_t *>(s)) {
+            if (stream_ != nullptr) {
+                ++stream_->no_slices_depth_;
+            }
+        }
+        ~no_slices_t() {
+            if (stream_ != nullptr) {
+                --stream_->no_slices_depth_;
+            }
+        }
+    private:
+        shared_buf_read_stream_t *stream_;
+        DISABLE_COPYING(no_slices_t);
+    };
+
+private:
+    size_t pos_;
+    counted_t<const shared_buf_t> buf_;
+    int no_slices_depth_;
+
+    DISABLE_COPYING(shared_buf_read_stream_t);
+};
+
+#endif  // CONTAINERS_ARCHIVE_SHARED_BUF_STREAM_HPP_
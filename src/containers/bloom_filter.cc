@@ -0,0 +1,65 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "containers/bloom_filter.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace {
+
+// The finalizer of MurmurHash3, which spreads every input bit over the whole output.
+uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+}  // namespace
+
+bloom_filter_t::bloom_filter_t(size_t capacity, size_t bits_per_value)
+    : capacity_(capacity),
+      num_inserted_(0),
+      // This number of hashes minimizes the false positive rate.
+      num_hashes_(std::max<size_t>(
+          1, static_cast<size_t>(round(bits_per_value * log(2.0))))),
+      words_(std::max<size_t>(1, (capacity * bits_per_value + 63) / 64), 0) {
+    guarantee(bits_per_value > 0);
+}
+
+void bloom_filter_t::insert(const void *data, size_t size) {
+    const uint64_t num_bits = words_.size() * 64;
+    const uint64_t h1 = hash(data, size);
+    const uint64_t h2 = mix(h1 + 1) | 1;
+    for (size_t i = 0; i < num_hashes_; ++i) {
+        const uint64_t bit = (h1 + i * h2) % num_bits;
+        words_[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    ++num_inserted_;
+}
+
+bool bloom_filter_t::may_contain(const void *data, size_t size) const {
+    const uint64_t num_bits = words_.size() * 64;
+    const uint64_t h1 = hash(data, size);
+    const uint64_t h2 = mix(h1 + 1) | 1;
+    for (size_t i = 0; i < num_hashes_; ++i) {
+        const uint64_t bit = (h1 + i * h2) % num_bits;
+        if ((words_[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t bloom_filter_t::hash(const void *data, size_t size) {
+    // FNV-1a, which is fast for short strings but mixes poorly on its own.
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 0x100000001b3ULL;
+    }
+    return mix(h);
+}
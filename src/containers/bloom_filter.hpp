@@ -0,0 +1,44 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_BLOOM_FILTER_HPP_
+#define CONTAINERS_BLOOM_FILTER_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "errors.hpp"
+
+/* `bloom_filter_t` is a set of byte strings that can't be enumerated and doesn't
+support removal. Looking up a string that was inserted always succeeds, but looking up
+one that wasn't can also succeed, with a probability that depends on how many strings
+were inserted compared to the capacity the filter was created with. */
+class bloom_filter_t {
+public:
+    // `bits_per_value` bits get allocated for each of the `capacity` values. With 10
+    // bits per value, about 1% of the lookups of values that weren't inserted succeed
+    // while the filter is at its capacity.
+    bloom_filter_t(size_t capacity, size_t bits_per_value);
+
+    void insert(const void *data, size_t size);
+    // Returns `false` only if the value was never inserted.
+    bool may_contain(const void *data, size_t size) const;
+
+    size_t capacity() const { return capacity_; }
+    // The number of calls to `insert()`, including the ones for duplicate values.
+    size_t num_inserted() const { return num_inserted_; }
+    // The number of bytes the filter takes up in memory.
+    size_t memory_size() const { return words_.size() * sizeof(uint64_t); }
+
+private:
+    static uint64_t hash(const void *data, size_t size);
+
+    const size_t capacity_;
+    size_t num_inserted_;
+    size_t num_hashes_;
+    std::vector<uint64_t> words_;
+
+    DISABLE_COPYING(bloom_filter_t);
+};
+
+#endif  // CONTAINERS_BLOOM_FILTER_HPP_
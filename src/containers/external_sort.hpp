@@ -0,0 +1,189 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_EXTERNAL_SORT_HPP_
+#define CONTAINERS_EXTERNAL_SORT_HPP_
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "containers/disk_backed_queue.hpp"
+#include "containers/scoped.hpp"
+
+/* `external_sorter_t` sorts more values than fit into memory. The values are added in
+runs, which get sorted in memory and spilled to temporary `disk_backed_queue_t` files.
+Reading the values back merges the runs, keeping only one value per run in memory.
+Values that compare equal come out in the order they were added in.
+
+Every run has its own file and cache, so runs get merged as they pile up: once there
+are `MAX_RUNS_PER_LEVEL` runs of the same level, they are merged into a single run of
+the next level. This keeps the number of runs logarithmic in the number of values,
+while every value only gets rewritten once per level.
+
+The comparison is passed to each call rather than stored, since it may depend on state
+that is only available during the call. It must be the same for all calls. */
+template <class T>
+class external_sorter_t {
+public:
+    typedef disk_backed_queue_t<T> run_t;
+
+    // `make_run` is called to create the file for each new run.
+    explicit external_sorter_t(std::function<scoped_ptr_t<run_t>()> _make_run)
+        : make_run(std::move(_make_run)), reading(false) { }
+
+    // Sorts `values`, spills them as a new run and clears `values`. This must only be
+    // called before the values are read.
+    template <class less_t>
+    void add_run(std::vector<T> *values, const less_t &less) {
+        guarantee(!reading);
+        std::stable_sort(values->begin(), values->end(), less);
+        scoped_ptr_t<run_t> run = make_run();
+        for (size_t i = 0; i < values->size(); i += WRITE_BATCH_SIZE) {
+            run->push(std::vector<T>(
+                std::make_move_iterator(values->begin() + i),
+                std::make_move_iterator(
+                    values->begin()
+                    + std::min(i + WRITE_BATCH_SIZE, values->size()))));
+        }
+        values->clear();
+        runs.push_back(std::move(run));
+        levels.push_back(0);
+
+        // Runs are only ever merged with the runs that were added right after them,
+        // which keeps the sort stable.
+        for (;;) {
+            const size_t level = levels.back();
+            if (runs.size() < MAX_RUNS_PER_LEVEL
+                || levels[runs.size() - MAX_RUNS_PER_LEVEL] != level) {
+                break;
+            }
+            const size_t first = runs.size() - MAX_RUNS_PER_LEVEL;
+            scoped_ptr_t<run_t> merged = make_run();
+            {
+                merger_t merger(&runs, first, less);
+                std::vector<T> batch;
+                T value;
+                while (merger.next(&value, less)) {
+                    batch.push_back(std::move(value));
+                    if (batch.size() == WRITE_BATCH_SIZE) {
+                        merged->push(batch);
+                        batch.clear();
+                    }
+                }
+                if (!batch.empty()) {
+                    merged->push(batch);
+                }
+            }
+            runs.resize(first);
+            levels.resize(first);
+            runs.push_back(std::move(merged));
+            levels.push_back(level + 1);
+        }
+    }
+
+    // Sets `*out` to the next value in sorted order and returns `true`, or returns
+    // `false` once all values have been read. No runs can be added after this has been
+    // called.
+    template <class less_t>
+    bool next(T *out, const less_t &less) {
+        if (!reading) {
+            reading = true;
+            final_merger.init(new merger_t(&runs, 0, less));
+        }
+        return final_merger->next(out, less);
+    }
+
+    bool is_exhausted() const {
+        return reading && final_merger->is_exhausted();
+    }
+
+    size_t num_runs() const {
+        return runs.size();
+    }
+
+private:
+    // How many values get written to a run per transaction.
+    static const size_t WRITE_BATCH_SIZE = 256;
+    static const size_t MAX_RUNS_PER_LEVEL = 16;
+
+    // Merges the runs starting at `first` through a heap of the runs that aren't used
+    // up yet, ordered by their smallest remaining value.
+    class merger_t {
+    public:
+        template <class less_t>
+        merger_t(std::vector<scoped_ptr_t<run_t> > *_runs, size_t _first,
+                 const less_t &less)
+            : runs(_runs), first(_first), heads(runs->size() - first) {
+            for (size_t i = 0; i < heads.size(); ++i) {
+                if (!(*runs)[first + i]->empty()) {
+                    (*runs)[first + i]->pop(&heads[i]);
+                    heap.push_back(i);
+                }
+            }
+            std::make_heap(heap.begin(), heap.end(), comes_after(less));
+        }
+
+        template <class less_t>
+        bool next(T *out, const less_t &less) {
+            if (heap.empty()) {
+                return false;
+            }
+            auto cmp = comes_after(less);
+            std::pop_heap(heap.begin(), heap.end(), cmp);
+            const size_t i = heap.back();
+            *out = std::move(heads[i]);
+            if ((*runs)[first + i]->empty()) {
+                heap.pop_back();
+            } else {
+                (*runs)[first + i]->pop(&heads[i]);
+                std::push_heap(heap.begin(), heap.end(), cmp);
+            }
+            return true;
+        }
+
+        bool is_exhausted() const {
+            return heap.empty();
+        }
+
+    private:
+        // `std::push_heap()` and friends put the greatest element first, so this
+        // orders the runs by their heads in reverse, and by their index for equal
+        // heads.
+        template <class less_t>
+        std::function<bool(size_t, size_t)> comes_after(const less_t &less) const {
+            return [this, &less](size_t a, size_t b) {
+                if (less(heads[b], heads[a])) {
+                    return true;
+                } else if (less(heads[a], heads[b])) {
+                    return false;
+                } else {
+                    return a > b;
+                }
+            };
+        }
+
+        std::vector<scoped_ptr_t<run_t> > *runs;
+        const size_t first;
+        std::vector<T> heads;
+        std::vector<size_t> heap;
+
+        DISABLE_COPYING(merger_t);
+    };
+
+    std::function<scoped_ptr_t<run_t>()> make_run;
+    std::vector<scoped_ptr_t<run_t> > runs;
+    // The merge level of each run in `runs`.
+    std::vector<size_t> levels;
+
+    bool reading;
+    scoped_ptr_t<merger_t> final_merger;
+
+    DISABLE_COPYING(external_sorter_t);
+};
+
+template <class T>
+const size_t external_sorter_t<T>::WRITE_BATCH_SIZE;
+template <class T>
+const size_t external_sorter_t<T>::MAX_RUNS_PER_LEVEL;
+
+#endif  // CONTAINERS_EXTERNAL_SORT_HPP_
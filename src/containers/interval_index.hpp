@@ -0,0 +1,118 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_INTERVAL_INDEX_HPP_
+#define CONTAINERS_INTERVAL_INDEX_HPP_
+
+#include <algorithm>
+#include <vector>
+
+#include "errors.hpp"
+
+/* `interval_index_t` finds the intervals that contain a given point. It's built from
+all of its intervals at once and can't be modified afterwards, so it's meant for sets of
+intervals that are queried much more often than they change.
+
+The intervals are sorted by their left bounds. A point's candidates are then a prefix of
+them, and a tree over that order that knows the greatest right bound in each of its
+subtrees skips the candidates that end before the point. A query that finds `m`
+intervals takes `O((m + 1) * log(n))` time.
+
+`traits_t` describes the bounds, which are arbitrary so that they can be open or closed:
+
+    typedef ... point_t;
+    typedef ... left_t;
+    typedef ... right_t;
+    // Strict weak orders. A bound that's before another one excludes more points.
+    static bool left_before(const left_t &a, const left_t &b);
+    static bool right_before(const right_t &a, const right_t &b);
+    // Whether the point is on the inner side of the bound.
+    static bool left_admits(const left_t &l, const point_t &p);
+    static bool right_admits(const right_t &r, const point_t &p);
+
+`left_admits` must be true for every bound before a left bound that admits a point, and
+`right_admits` for every bound after a right bound that admits a point. */
+template<class traits_t, class value_t>
+class interval_index_t {
+public:
+    typedef typename traits_t::point_t point_t;
+    typedef typename traits_t::left_t left_t;
+    typedef typename traits_t::right_t right_t;
+
+    struct interval_t {
+        left_t left;
+        right_t right;
+        value_t value;
+    };
+
+    interval_index_t() { }
+
+    explicit interval_index_t(std::vector<interval_t> &&_intervals)
+        : intervals(std::move(_intervals)) {
+        std::stable_sort(intervals.begin(), intervals.end(),
+            [](const interval_t &a, const interval_t &b) {
+                return traits_t::left_before(a.left, b.left);
+            });
+        if (!intervals.empty()) {
+            max_right.resize(4 * intervals.size());
+            build(1, 0, intervals.size());
+        }
+    }
+
+    MOVABLE_BUT_NOT_COPYABLE(interval_index_t);
+
+    size_t size() const { return intervals.size(); }
+    bool empty() const { return intervals.empty(); }
+
+    /* Calls `cb` with the value of every interval that contains `point`, in the order
+    of their left bounds. */
+    template<class callable_t>
+    void visit_containing(const point_t &point, callable_t &&cb) const {
+        if (intervals.empty()) {
+            return;
+        }
+        // The intervals with left bounds that admit `point` come first.
+        size_t candidates = std::partition_point(
+            intervals.begin(), intervals.end(),
+            [&point](const interval_t &i) {
+                return traits_t::left_admits(i.left, point);
+            }) - intervals.begin();
+        visit(1, 0, intervals.size(), candidates, point, cb);
+    }
+
+private:
+    /* Node `node` covers `intervals[lo, hi)`, and its children are `2 * node` and
+    `2 * node + 1`. `max_right[node]` is the index of the interval with the greatest
+    right bound that it covers. */
+    void build(size_t node, size_t lo, size_t hi) {
+        if (hi - lo == 1) {
+            max_right[node] = lo;
+            return;
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        build(2 * node, lo, mid);
+        build(2 * node + 1, mid, hi);
+        size_t l = max_right[2 * node], r = max_right[2 * node + 1];
+        max_right[node] =
+            traits_t::right_before(intervals[l].right, intervals[r].right) ? r : l;
+    }
+
+    template<class callable_t>
+    void visit(size_t node, size_t lo, size_t hi, size_t candidates,
+               const point_t &point, callable_t &cb) const {
+        if (lo >= candidates
+            || !traits_t::right_admits(intervals[max_right[node]].right, point)) {
+            return;
+        }
+        if (hi - lo == 1) {
+            cb(intervals[lo].value);
+            return;
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        visit(2 * node, lo, mid, candidates, point, cb);
+        visit(2 * node + 1, mid, hi, candidates, point, cb);
+    }
+
+    std::vector<interval_t> intervals;
+    std::vector<size_t> max_right;
+};
+
+#endif  // CONTAINERS_INTERVAL_INDEX_HPP_
@@ -0,0 +1,221 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "containers/lz4_block.hpp"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "errors.hpp"
+
+/* The LZ4 block format is a sequence of "sequences". Each one starts with a
+token byte, whose high nibble is the number of literals and whose low nibble is
+the match length minus `LZ4_MIN_MATCH`. A nibble of 15 means that more length
+bytes follow, each of which gets added to the length until one is less than 255.
+The literals follow the literal length, and then come the 16-bit little-endian
+match offset and the extra match length bytes. The last sequence has literals
+only. */
+
+const size_t LZ4_MIN_MATCH = 4;
+// The last `LZ4_LAST_LITERALS` bytes are always literals, and no match may start
+// in the last `LZ4_MATCH_FIND_LIMIT` bytes. We don't depend on these rules for
+// decoding, but we stick to them so that the output stays valid LZ4.
+const size_t LZ4_LAST_LITERALS = 5;
+const size_t LZ4_MATCH_FIND_LIMIT = 12;
+const size_t LZ4_MAX_OFFSET = 65535;
+const int LZ4_HASH_LOG = 12;
+
+size_t lz4_max_compressed_size(size_t src_size) {
+    return src_size + src_size / 255 + 16;
+}
+
+inline uint32_t lz4_read32(const uint8_t *p) {
+    uint32_t ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+
+inline uint32_t lz4_hash(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+// Writes the remainder of a length that didn't fit into its token nibble.
+inline bool lz4_write_length(size_t length, uint8_t **op, const uint8_t *oend) {
+    for (;;) {
+        if (*op == oend) {
+            return false;
+        }
+        if (length < 255) {
+            *(*op)++ = static_cast<uint8_t>(length);
+            return true;
+        }
+        *(*op)++ = 255;
+        length -= 255;
+    }
+}
+
+// Writes a sequence with `literal_length` literals from `literals` and, unless
+// `match_length` is zero, a match.
+bool lz4_write_sequence(const uint8_t *literals, size_t literal_length,
+                        size_t match_offset, size_t match_length,
+                        uint8_t **op, const uint8_t *oend) {
+    if (*op == oend) {
+        return false;
+    }
+    uint8_t *token = (*op)++;
+    if (literal_length >= 15) {
+        *token = 15 << 4;
+        if (!lz4_write_length(literal_length - 15, op, oend)) {
+            return false;
+        }
+    } else {
+        *token = literal_length << 4;
+    }
+    if (static_cast<size_t>(oend - *op) < literal_length) {
+        return false;
+    }
+    memcpy(*op, literals, literal_length);
+    *op += literal_length;
+
+    if (match_length == 0) {
+        return true;
+    }
+    if (oend - *op < 2) {
+        return false;
+    }
+    *(*op)++ = match_offset & 0xff;
+    *(*op)++ = match_offset >> 8;
+    const size_t extra = match_length - LZ4_MIN_MATCH;
+    if (extra >= 15) {
+        *token |= 15;
+        return lz4_write_length(extra - 15, op, oend);
+    } else {
+        *token |= extra;
+        return true;
+    }
+}
+
+size_t lz4_compress_block(const void *src, size_t src_size,
+                          void *dst, size_t dst_capacity) {
+    const uint8_t *const in = static_cast<const uint8_t *>(src);
+    uint8_t *op = static_cast<uint8_t *>(dst);
+    const uint8_t *const oend = op + dst_capacity;
+
+    size_t anchor = 0;
+    if (src_size > LZ4_MATCH_FIND_LIMIT) {
+        // Holds one plus the last position at which each hash was seen, so that
+        // zero means "never seen".
+        std::vector<uint32_t> table(1 << LZ4_HASH_LOG, 0);
+        const size_t match_find_end = src_size - LZ4_MATCH_FIND_LIMIT;
+        const size_t match_extend_end = src_size - LZ4_LAST_LITERALS;
+        size_t ip = 0;
+        while (ip < match_find_end) {
+            const uint32_t sequence = lz4_read32(in + ip);
+            uint32_t *const slot = &table[lz4_hash(sequence)];
+            const size_t candidate = *slot;
+            *slot = ip + 1;
+            if (candidate == 0
+                || ip - (candidate - 1) > LZ4_MAX_OFFSET
+                || lz4_read32(in + candidate - 1) != sequence) {
+                ++ip;
+                continue;
+            }
+            size_t ref = candidate - 1;
+
+            // Extend the match backwards into the pending literals, then forwards.
+            while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+                --ip;
+                --ref;
+            }
+            size_t match_length = LZ4_MIN_MATCH;
+            while (ip + match_length < match_extend_end
+                   && in[ip + match_length] == in[ref + match_length]) {
+                ++match_length;
+            }
+
+            if (!lz4_write_sequence(in + anchor, ip - anchor, ip - ref, match_length,
+                                    &op, oend)) {
+                return 0;
+            }
+            ip += match_length;
+            anchor = ip;
+        }
+    }
+
+    if (!lz4_write_sequence(in + anchor, src_size - anchor, 0, 0, &op, oend)) {
+        return 0;
+    }
+    return op - static_cast<uint8_t *>(dst);
+}
+
+// Reads the remainder of a length whose token nibble was 15.
+inline bool lz4_read_length(const uint8_t **ip, const uint8_t *iend, size_t *length) {
+    for (;;) {
+        if (*ip == iend) {
+            return false;
+        }
+        const uint8_t b = *(*ip)++;
+        *length += b;
+        if (b != 255) {
+            return true;
+        }
+    }
+}
+
+bool lz4_decompress_block(const void *src, size_t src_size,
+                          void *dst, size_t dst_size) {
+    const uint8_t *ip = static_cast<const uint8_t *>(src);
+    const uint8_t *const iend = ip + src_size;
+    uint8_t *const ostart = static_cast<uint8_t *>(dst);
+    uint8_t *op = ostart;
+    uint8_t *const oend = ostart + dst_size;
+
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !lz4_read_length(&ip, iend, &literal_length)) {
+            return false;
+        }
+        if (static_cast<size_t>(iend - ip) < literal_length
+            || static_cast<size_t>(oend - op) < literal_length) {
+            return false;
+        }
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        if (ip == iend) {
+            // The last sequence has no match.
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+        const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - ostart)) {
+            return false;
+        }
+
+        size_t match_length = token & 15;
+        if (match_length == 15 && !lz4_read_length(&ip, iend, &match_length)) {
+            return false;
+        }
+        match_length += LZ4_MIN_MATCH;
+        if (static_cast<size_t>(oend - op) < match_length) {
+            return false;
+        }
+
+        // The match may overlap the bytes it produces, so copy forwards one byte
+        // at a time.
+        const uint8_t *ref = op - offset;
+        for (size_t i = 0; i < match_length; ++i) {
+            op[i] = ref[i];
+        }
+        op += match_length;
+    }
+
+    return op == oend;
+}
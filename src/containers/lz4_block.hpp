@@ -0,0 +1,31 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_LZ4_BLOCK_HPP_
+#define CONTAINERS_LZ4_BLOCK_HPP_
+
+#include <stddef.h>
+
+#include "arch/compiler.hpp"
+
+/* A compressor and decompressor for the LZ4 block format. The compressor is
+a greedy single-probe matcher, which trades some compression ratio for speed.
+It's meant for compressing serializer blocks and other buffers of up to a few
+megabytes on the hot path; the output is not framed, so the caller has to
+remember both the compressed and the uncompressed size. */
+
+// The largest number of bytes that `lz4_compress_block` can produce for an
+// input of `src_size` bytes.
+size_t lz4_max_compressed_size(size_t src_size);
+
+// Compresses `src_size` bytes from `src` into `dst`. Returns the size of the
+// compressed data, or 0 if it didn't fit into `dst_capacity` bytes. Passing
+// `dst_capacity < src_size` is the cheap way to give up on incompressible data.
+size_t lz4_compress_block(const void *src, size_t src_size,
+                          void *dst, size_t dst_capacity);
+
+// Decompresses `src_size` bytes of compressed data from `src` into `dst`.
+// Returns false if the data is corrupt or does not decompress to exactly
+// `dst_size` bytes.  Never reads or writes out of bounds.
+MUST_USE bool lz4_decompress_block(const void *src, size_t src_size,
+                                   void *dst, size_t dst_size);
+
+#endif  // CONTAINERS_LZ4_BLOCK_HPP_
@@ -0,0 +1,93 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_MPSC_QUEUE_HPP_
+#define CONTAINERS_MPSC_QUEUE_HPP_
+
+#include <atomic>
+
+#include "containers/intrusive_list.hpp"
+#include "errors.hpp"
+
+template <class T> class mpsc_queue_t;
+
+template <class T>
+class mpsc_queue_node_t {
+protected:
+    mpsc_queue_node_t() : mpsc_next_(nullptr) { }
+
+private:
+    friend class mpsc_queue_t<T>;
+    T *mpsc_next_;
+
+    DISABLE_COPYING(mpsc_queue_node_t);
+};
+
+/* `mpsc_queue_t` is an intrusive lock-free queue that any number of threads can push
+onto and one thread pops from. Elements are pushed and popped in batches, taken from
+and appended to `intrusive_list_t`s, so `T` must derive from both
+`intrusive_list_node_t<T>` and `mpsc_queue_node_t<T>`.
+
+It's a stack of elements: a push is one compare-and-swap on the top of the stack, and
+a pop takes the whole stack with one exchange and reverses it. So the elements come out
+in the order in which they were pushed, and the elements of one batch stay together. */
+template <class T>
+class mpsc_queue_t {
+public:
+    mpsc_queue_t() : top_(nullptr) { }
+    ~mpsc_queue_t() {
+        guarantee(empty(), "non-empty mpsc_queue_t destroyed");
+    }
+
+    /* Moves all elements of `list` onto the queue. Returns true if the queue was empty
+    before, so that exactly one of the threads that push onto an empty queue can wake
+    up the consumer. Can be called from any thread. */
+    bool push_all(intrusive_list_t<T> *list) {
+        T *first = list->head();
+        if (first == nullptr) {
+            return false;
+        }
+        // Link the batch up from its last element to its first, which is the order in
+        // which it's going to sit on the stack.
+        T *last = nullptr;
+        while (T *e = list->head()) {
+            list->remove(e);
+            e->mpsc_next_ = last;
+            last = e;
+        }
+        T *top = top_.load(std::memory_order_relaxed);
+        do {
+            first->mpsc_next_ = top;
+        } while (!top_.compare_exchange_weak(top, last));
+        return top == nullptr;
+    }
+
+    /* Appends all elements of the queue to `list`, in the order in which they were
+    pushed. Must only be called from the consumer thread. */
+    void pop_all(intrusive_list_t<T> *list) {
+        T *top = top_.exchange(nullptr);
+        // Reverse the stack, so that the element that was pushed first comes first.
+        T *first = nullptr;
+        while (top != nullptr) {
+            T *next = top->mpsc_next_;
+            top->mpsc_next_ = first;
+            first = top;
+            top = next;
+        }
+        while (first != nullptr) {
+            T *next = first->mpsc_next_;
+            first->mpsc_next_ = nullptr;
+            list->push_back(first);
+            first = next;
+        }
+    }
+
+    bool empty() const {
+        return top_.load() == nullptr;
+    }
+
+private:
+    std::atomic<T *> top_;
+
+    DISABLE_COPYING(mpsc_queue_t);
+};
+
+#endif  // CONTAINERS_MPSC_QUEUE_HPP_
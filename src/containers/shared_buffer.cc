@@ -3,15 +3,25 @@
 
 #include <stdlib.h>
 
+#include <new>
+
 #include "utils.hpp"
 
 counted_t<shared_buf_t> shared_buf_t::create(size_t size) {
+    return create(size, counted_t<const shared_buf_t>());
+}
+
+counted_t<shared_buf_t> shared_buf_t::create(
+        size_t size, const counted_t<const shared_buf_t> &dictionary) {
     // This allocates size bytes for the data_ field (which is declared as char[1])
     size_t memory_size = sizeof(shared_buf_t) + size - 1;
     void *raw_result = ::rmalloc(memory_size);
     shared_buf_t *result = static_cast<shared_buf_t *>(raw_result);
     result->refcount_ = 0;
     result->size_ = size;
+    // `dictionary_` gets destructed by the implicit destructor when the buffer is
+    // deleted, so it has to be constructed properly.
+    new (&result->dictionary_) counted_t<const shared_buf_t>(dictionary);
     return counted_t<shared_buf_t>(result);
 }
 
@@ -30,3 +40,7 @@ const char *shared_buf_t::data(size_t offset) const {
 size_t shared_buf_t::size() const {
     return size_;
 }
+
+const counted_t<const shared_buf_t> &shared_buf_t::dictionary() const {
+    return dictionary_;
+}
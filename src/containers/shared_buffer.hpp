@@ -15,6 +15,10 @@ public:
     shared_buf_t() = delete;
 
     static counted_t<shared_buf_t> create(size_t _size);
+    // Creates a buffer whose contents refer into `dictionary`, e.g. a datum whose
+    // object keys are ids into a table's field dictionary.
+    static counted_t<shared_buf_t> create(
+        size_t _size, const counted_t<const shared_buf_t> &dictionary);
     static void operator delete(void *p);
 
     char *data(size_t offset = 0);
@@ -22,6 +26,9 @@ public:
 
     size_t size() const;
 
+    // Empty unless the buffer was created with a dictionary.
+    const counted_t<const shared_buf_t> &dictionary() const;
+
 private:
     // We duplicate the implementation of slow_atomic_countable_t here for the
     // sole purpose of having full control over the layout of fields. This
@@ -37,6 +44,8 @@ private:
     // The size of data_, for boundary checking.
     size_t size_;
 
+    counted_t<const shared_buf_t> dictionary_;
+
     // We actually allocate more memory than this.
     // It's crucial that this field is the last one in this class.
     char data_[1];
@@ -87,6 +96,12 @@ public:
         return (buf->size() - offset) / sizeof(T);
     }
 
+    // The dictionary of the underlying shared buffer, if it has one.
+    const counted_t<const shared_buf_t> &get_dictionary() const {
+        rassert(buf.has());
+        return buf->dictionary();
+    }
+
 private:
     counted_t<const shared_buf_t> buf;
     size_t offset;
@@ -70,6 +70,41 @@ scoped_perfmon_counter_t::~scoped_perfmon_counter_t() {
     --(*counter);
 }
 
+/* perfmon_high_water_mark_t */
+
+perfmon_high_water_mark_t::perfmon_high_water_mark_t()
+    : perfmon_perthread_t<cache_line_padded_t<int64_t>, int64_t>(),
+      thread_data(new padded_int64_t[MAX_THREADS])
+{
+    for (int i = 0; i < MAX_THREADS; i++) thread_data[i].value = 0;
+}
+
+perfmon_high_water_mark_t::~perfmon_high_water_mark_t() {
+    delete[] thread_data;
+}
+
+void perfmon_high_water_mark_t::record(int64_t value) {
+    rassert(get_thread_id().threadnum >= 0);
+    int64_t *current = &thread_data[get_thread_id().threadnum].value;
+    *current = std::max(*current, value);
+}
+
+void perfmon_high_water_mark_t::get_thread_stat(padded_int64_t *stat) {
+    stat->value = thread_data[get_thread_id().threadnum].value;
+}
+
+int64_t perfmon_high_water_mark_t::combine_stats(const padded_int64_t *data) {
+    int64_t value = 0;
+    for (int i = 0; i < get_num_threads(); i++) {
+        value = std::max(value, data[i].value);
+    }
+    return value;
+}
+
+ql::datum_t perfmon_high_water_mark_t::output_stat(const int64_t &stat) {
+    return ql::datum_t(static_cast<double>(stat));
+}
+
 /* perfmon_sampler_t */
 
 perfmon_sampler_t::perfmon_sampler_t(ticks_t _length, bool _include_rate)
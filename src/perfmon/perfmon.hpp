@@ -87,6 +87,23 @@ private:
     DISABLE_COPYING(scoped_perfmon_counter_t);
 };
 
+/* perfmon_high_water_mark_t is a perfmon_t that reports the largest value that has
+ * ever been passed to record().
+ */
+class perfmon_high_water_mark_t
+    : public perfmon_perthread_t<cache_line_padded_t<int64_t>, int64_t> {
+    typedef cache_line_padded_t<int64_t> padded_int64_t;
+    padded_int64_t *thread_data;
+
+    void get_thread_stat(padded_int64_t *);
+    int64_t combine_stats(const padded_int64_t *);
+    ql::datum_t output_stat(const int64_t&);
+public:
+    perfmon_high_water_mark_t();
+    virtual ~perfmon_high_water_mark_t();
+    void record(int64_t value);
+};
+
 /* perfmon_sampler_t is a perfmon_t that keeps a log of events that happen.
  * When something happens, call the perfmon_sampler_t's record() method. The
  * perfmon_sampler_t will retain that record until 'length' ticks have passed.
@@ -4,6 +4,7 @@
 
 class perfmon_collection_t;
 class perfmon_counter_t;
+class perfmon_high_water_mark_t;
 class perfmon_sampler_t;
 struct perfmon_stddev_t;
 struct perfmon_duration_sampler_t;
@@ -12,6 +12,7 @@
 #include <boost/optional.hpp>
 
 #include "btree/concurrent_traversal.hpp"
+#include "btree/depth_first_traversal.hpp"
 #include "btree/get_distribution.hpp"
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
@@ -19,16 +20,20 @@
 #include "buffer_cache/serialize_onto_blob.hpp"
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
 #include "concurrency/queue/unlimited_fifo.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/external_sort.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/indexing.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/geo_traversal.hpp"
+#include "rdb_protocol/key_filter.hpp"
 #include "rdb_protocol/lazy_btree_val.hpp"
 #include "rdb_protocol/pseudo_geometry.hpp"
 #include "rdb_protocol/serialize_datum_onto_blob.hpp"
@@ -92,6 +97,14 @@ void detach_rdb_value(buf_parent_t parent, const void *value) {
 void rdb_get(const store_key_t &store_key, btree_slice_t *slice,
              superblock_t *superblock, point_read_response_t *response,
              profile::trace_t *trace) {
+    // Point reads never use a snapshot, see `key_filter_t`.
+    if (slice->key_filter != nullptr
+        && slice->key_filter->definitely_absent(store_key)) {
+        superblock->release();
+        response->data = ql::datum_t::null();
+        return;
+    }
+
     keyvalue_location_t kv_location;
     rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
     find_keyvalue_location_for_read(&sizer, superblock,
@@ -102,7 +115,8 @@ void rdb_get(const store_key_t &store_key, btree_slice_t *slice,
         response->data = ql::datum_t::null();
     } else {
         response->data = get_data(static_cast<rdb_value_t *>(kv_location.value.get()),
-                                  buf_parent_t(&kv_location.buf));
+                                  buf_parent_t(&kv_location.buf),
+                                  slice->field_dictionary);
     }
 }
 
@@ -144,6 +158,7 @@ kv_location_set(keyvalue_location_t *kv_location,
                 ql::datum_t data,
                 repli_timestamp_t timestamp,
                 const deletion_context_t *deletion_context,
+                field_dictionary_writer_t *field_dictionary,
                 rdb_modification_info_t *mod_info_out) THROWS_NOTHING {
     scoped_malloc_t<rdb_value_t> new_value(blob::btree_maxreflen);
     memset(new_value.get(), 0, blob::btree_maxreflen);
@@ -153,7 +168,7 @@ kv_location_set(keyvalue_location_t *kv_location,
         blob_t blob(block_size, new_value->value_ref(), blob::btree_maxreflen);
         ql::serialization_result_t res
             = datum_serialize_onto_blob(buf_parent_t(&kv_location->buf),
-                                        &blob, data);
+                                        &blob, data, field_dictionary);
         if (bad(res)) return res;
     }
 
@@ -224,6 +239,14 @@ batched_replace_response_t rdb_replace_and_return_superblock(
     const store_key_t &key = *info.key;
 
     try {
+        // We're still holding the superblock, see `field_dictionary_writer_t` and
+        // `key_filter_t`.
+        field_dictionary_writer_t field_dictionary_writer(
+            info.btree->slice->field_dictionary);
+        if (info.btree->slice->key_filter != nullptr) {
+            info.btree->slice->key_filter->note_key_written(key);
+        }
+
         keyvalue_location_t kv_location;
         rdb_value_sizer_t sizer(info.superblock->cache()->max_block_size());
         find_keyvalue_location_for_write(&sizer, info.superblock,
@@ -243,7 +266,8 @@ batched_replace_response_t rdb_replace_and_return_superblock(
         } else {
             // Otherwise pass the entry with this key to the function.
             old_val = get_data(kv_location.value_as<rdb_value_t>(),
-                               buf_parent_t(&kv_location.buf));
+                               buf_parent_t(&kv_location.buf),
+                               info.btree->slice->field_dictionary);
             guarantee(old_val.get_field(primary_key, ql::NOTHROW).has());
         }
         guarantee(old_val.has());
@@ -275,7 +299,7 @@ batched_replace_response_t rdb_replace_and_return_superblock(
                 ql::serialization_result_t res =
                     kv_location_set(&kv_location, *info.key, new_val,
                                     info.btree->timestamp, deletion_context,
-                                    mod_info_out);
+                                    &field_dictionary_writer, mod_info_out);
                 if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
                     rfail_typed_target(&new_val, "Array too large for disk writes "
                                        "(limit 100,000 elements).");
@@ -454,6 +478,123 @@ batched_replace_response_t rdb_batched_replace(
     return std::move(out).to_datum();
 }
 
+class find_any_pair_helper_t : public depth_first_traversal_callback_t {
+public:
+    find_any_pair_helper_t() : found(false) { }
+    continue_bool_t handle_pair(scoped_key_value_t &&, signal_t *) {
+        found = true;
+        return continue_bool_t::ABORT;
+    }
+    bool found;
+};
+
+bool rdb_batched_insert_into_empty_range(
+    const btree_info_t &info,
+    scoped_ptr_t<real_superblock_t> *superblock,
+    const std::vector<store_key_t> &keys,
+    const btree_batched_replacer_t *replacer,
+    rdb_modification_report_cb_t *sindex_cb,
+    ql::configured_limits_t limits,
+    profile::sampler_t *sampler,
+    profile::trace_t *trace,
+    batched_replace_response_t *response_out) {
+    // Smaller batches don't gain enough to make up for checking the key range.
+    const size_t MIN_KEYS = 32;
+    if (keys.size() < MIN_KEYS) {
+        return false;
+    }
+
+    // Insert the rows in key order. Rows with the same key stay in the order they
+    // were given in, so that their conflicts are resolved the same way as by
+    // `rdb_batched_replace()`.
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t l, size_t r) {
+        return keys[l] < keys[r];
+    });
+    const key_range_t range(key_range_t::closed, keys[order.front()],
+                            key_range_t::closed, keys[order.back()]);
+
+    // We get in line for the changefeed stamp first and keep our spot until we're
+    // done, so that no changefeed can start on the range while we're not sending any
+    // changes.
+    (*superblock)->get()->write_acq_signal()->wait_lazily_unordered();
+    rwlock_in_line_t stamp_spot = sindex_cb->get_in_line_for_cfeed_stamp();
+    if (sindex_cb->has_cfeeds(range)) {
+        return false;
+    }
+    // If none of the keys exist, other rows in the range don't matter. We're holding
+    // the superblock, so the key filter can tell.
+    const bool all_keys_absent = info.slice->key_filter != nullptr
+        && std::all_of(keys.begin(), keys.end(), [&](const store_key_t &key) {
+               return info.slice->key_filter->definitely_absent(key);
+           });
+    if (!all_keys_absent) {
+        cond_t non_interruptor;
+        find_any_pair_helper_t helper;
+        btree_depth_first_traversal(
+            superblock->get(), range, &helper, access_t::read, direction_t::FORWARD,
+            release_superblock_t::KEEP, &non_interruptor);
+        if (helper.found) {
+            return false;
+        }
+    }
+
+    sampler->new_sample();
+    PROFILE_STARTER_IF_ENABLED(
+        trace != nullptr,
+        "Perform sorted inserts.",
+        trace);
+    profile::disabler_t trace_disabler(trace);
+
+    std::vector<ql::datum_t> responses(keys.size());
+    // One report per key. Since none of the keys existed, all of them only add rows.
+    std::vector<rdb_modification_report_t> mod_reports;
+    {
+        scoped_ptr_t<real_superblock_t> current_superblock(superblock->release());
+        rdb_live_deletion_context_t deletion_context;
+        for (size_t i : order) {
+            rdb_modification_report_t mod_report(keys[i]);
+            promise_t<superblock_t *> superblock_promise;
+            const one_replace_t one_replace(replacer, i);
+            responses[i] = rdb_replace_and_return_superblock(
+                btree_loc_info_t(&info, current_superblock.release(), &keys[i]),
+                &one_replace, &deletion_context, &superblock_promise,
+                &mod_report.info, trace);
+            current_superblock.init(
+                static_cast<real_superblock_t *>(superblock_promise.wait()));
+
+            if (!mod_reports.empty() && mod_reports.back().primary_key == keys[i]) {
+                // A later row with the same key replaced or deleted an earlier one.
+                // The net change for the key is an insertion of the new row, or
+                // nothing at all.
+                if (mod_report.info.added.first.has()) {
+                    mod_reports.back().info.added = std::move(mod_report.info.added);
+                } else if (mod_report.info.deleted.first.has()) {
+                    mod_reports.pop_back();
+                }
+            } else if (mod_report.info.added.first.has()) {
+                mod_reports.push_back(std::move(mod_report));
+            }
+        }
+    }
+
+    sindex_cb->on_insert_reports(mod_reports);
+    info.slice->stats.pm_total_sorted_inserts += 1;
+
+    ql::datum_t stats = ql::datum_t::empty_object();
+    std::set<std::string> conditions;
+    for (const auto &response : responses) {
+        stats = stats.merge(response, ql::stats_merge, limits, &conditions);
+    }
+    ql::datum_object_builder_t out(stats);
+    out.add_warnings(conditions, limits);
+    *response_out = std::move(out).to_datum();
+    return true;
+}
+
 void rdb_set(const store_key_t &key,
              ql::datum_t data,
              bool overwrite,
@@ -465,6 +606,13 @@ void rdb_set(const store_key_t &key,
              rdb_modification_info_t *mod_info,
              profile::trace_t *trace,
              promise_t<superblock_t *> *pass_back_superblock) {
+    // We're still holding the superblock, see `field_dictionary_writer_t` and
+    // `key_filter_t`.
+    field_dictionary_writer_t field_dictionary_writer(slice->field_dictionary);
+    if (slice->key_filter != nullptr) {
+        slice->key_filter->note_key_written(key);
+    }
+
     keyvalue_location_t kv_location;
     rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
     find_keyvalue_location_for_write(&sizer, superblock, key.btree_key(), timestamp,
@@ -477,7 +625,8 @@ void rdb_set(const store_key_t &key,
     /* update the modification report */
     if (kv_location.value.has()) {
         mod_info->deleted.first = get_data(kv_location.value_as<rdb_value_t>(),
-                                           buf_parent_t(&kv_location.buf));
+                                           buf_parent_t(&kv_location.buf),
+                                           slice->field_dictionary);
     }
 
     mod_info->added.first = data;
@@ -485,7 +634,7 @@ void rdb_set(const store_key_t &key,
     if (overwrite || !had_value) {
         ql::serialization_result_t res =
             kv_location_set(&kv_location, key, data, timestamp, deletion_context,
-                            mod_info);
+                            &field_dictionary_writer, mod_info);
         if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
             rfail_typed_target(&data, "Array too large for disk writes "
                                "(limit 100,000 elements).");
@@ -522,7 +671,8 @@ void rdb_delete(const store_key_t &key, btree_slice_t *slice,
     /* Update the modification report. */
     if (exists) {
         mod_info->deleted.first = get_data(kv_location.value_as<rdb_value_t>(),
-                                           buf_parent_t(&kv_location.buf));
+                                           buf_parent_t(&kv_location.buf),
+                                           slice->field_dictionary);
         kv_location_delete(&kv_location, key, timestamp, deletion_context,
             delete_mode, mod_info);
         guarantee(!mod_info->deleted.second.empty() && mod_info->added.second.empty());
@@ -731,7 +881,8 @@ continue_bool_t rget_cb_t::handle_pair(
         return continue_bool_t::CONTINUE;
     }
     lazy_btree_val_t row(static_cast<const rdb_value_t *>(keyvalue.value()),
-                         keyvalue.expose_buf());
+                         keyvalue.expose_buf(),
+                         io.slice->field_dictionary);
     ql::datum_t val;
     // Count stats whether or not we deserialize the value
     io.slice->stats.pm_keys_read.record();
@@ -1272,6 +1423,45 @@ INSTANTIATE_SERIALIZABLE_SINCE_v1_13(rdb_modification_info_t);
 
 RDB_IMPL_SERIALIZABLE_2_SINCE_v1_13(rdb_modification_report_t, primary_key, info);
 
+// A secondary index key together with the value of the row it points to.
+typedef std::pair<store_key_t, std::vector<char> > sindex_entry_t;
+
+struct sindex_entry_less_t {
+    bool operator()(const sindex_entry_t &l, const sindex_entry_t &r) const {
+        return l.first < r.first;
+    }
+};
+
+/* Sets `entry` in the secondary index with the given superblock and returns the
+superblock again once the index has been descended. */
+superblock_t *set_sindex_entry(
+        superblock_t *superblock,
+        const sindex_entry_t &entry,
+        const deletion_context_t *deletion_context) {
+    promise_t<superblock_t *> return_superblock_local;
+    {
+        keyvalue_location_t kv_location;
+        rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+        find_keyvalue_location_for_write(
+            &sizer,
+            superblock,
+            entry.first.btree_key(),
+            repli_timestamp_t::distant_past,
+            deletion_context->balancing_detacher(),
+            &kv_location,
+            nullptr,
+            &return_superblock_local);
+
+        ql::serialization_result_t res =
+            kv_location_set(&kv_location, entry.first, entry.second,
+                            repli_timestamp_t::distant_past,
+                            deletion_context);
+        // this particular context cannot fail AT THE MOMENT.
+        guarantee(!bad(res));
+    }
+    return return_superblock_local.wait();
+}
+
 rdb_modification_report_cb_t::rdb_modification_report_cb_t(
         store_t *store,
         buf_lock_t *sindex_block,
@@ -1399,6 +1589,16 @@ void rdb_modification_report_cb_t::on_mod_report(
     }
 }
 
+bool rdb_modification_report_cb_t::has_cfeeds(const key_range_t &range) {
+    auto cservers = store_->access_changefeed_servers();
+    for (auto &&pair : *cservers.first) {
+        if (pair.first.inner.overlaps(range)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void rdb_modification_report_cb_t::on_mod_report_sub(
     const rdb_modification_report_t &mod_report,
     new_mutex_in_line_t *spot,
@@ -1955,6 +2155,55 @@ void rdb_update_sindexes(
     }
 }
 
+void rdb_modification_report_cb_t::on_insert_reports(
+        const std::vector<rdb_modification_report_t> &reports) {
+    new_mutex_in_line_t sindex_spot = get_in_line_for_sindex();
+    store_->sindex_queue_push(reports, &sindex_spot);
+
+    rdb_live_deletion_context_t deletion_context;
+    for (auto &&sindex : sindexes_) {
+        // See the comments in `rdb_update_sindexes()` and
+        // `rdb_update_single_sindex()` for why these are skipped.
+        if (sindex->sindex.being_deleted) {
+            continue;
+        }
+        sindex_disk_info_t sindex_info;
+        try {
+            deserialize_sindex_info_or_crash(sindex->sindex.opaque_definition,
+                                             &sindex_info);
+        } catch (const archive_exc_t &e) {
+            crash("%s", e.what());
+        }
+
+        std::vector<sindex_entry_t> entries;
+        for (const auto &report : reports) {
+            guarantee(!report.info.deleted.first.has());
+            if (!report.info.added.first.has()
+                || sindex->sindex.needs_post_construction_range.contains_key(
+                    report.primary_key)) {
+                continue;
+            }
+            try {
+                std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+                compute_keys(report.primary_key, report.info.added.first, sindex_info,
+                             &keys, nullptr);
+                for (auto &&pair : keys) {
+                    entries.emplace_back(std::move(pair.first),
+                                         report.info.added.second);
+                }
+            } catch (const ql::base_exc_t &) {
+                // Do nothing (we just drop the row from the index).
+            }
+        }
+
+        std::sort(entries.begin(), entries.end(), sindex_entry_less_t());
+        superblock_t *superblock = sindex->superblock.get();
+        for (const auto &entry : entries) {
+            superblock = set_sindex_entry(superblock, entry, &deletion_context);
+        }
+    }
+}
+
 class post_construct_traversal_helper_t : public concurrent_traversal_callback_t {
 public:
     post_construct_traversal_helper_t(
@@ -1968,6 +2217,7 @@ public:
           on_indexes_deleted_(on_indexes_deleted),
           interruptor_(interruptor),
           check_should_abort_(check_should_abort),
+          pacer_(&store->write_latency),
           pairs_constructed_(0),
           stopped_before_completion_(false),
           current_chunk_size_(0) {
@@ -2000,7 +2250,8 @@ public:
             keyvalue.expose_buf().cache()->max_block_size();
         mod_report.info.added
             = std::make_pair(
-                get_data(rdb_value, buf_parent_t(keyvalue.expose_buf())),
+                get_data(rdb_value, buf_parent_t(keyvalue.expose_buf()),
+                         store_->btree->field_dictionary),
                 std::vector<char>(rdb_value->value_ref(),
                     rdb_value->value_ref() + rdb_value->inline_size(block_size)));
 
@@ -2044,6 +2295,7 @@ public:
                 current_chunk_size_ = 0;
                 sindexes_.clear();
                 wtxn_.reset();
+                pacer_.pace(interruptor_);
                 start_write_transaction(&wtxn_acq);
             }
         }
@@ -2133,6 +2385,8 @@ private:
 
     std::function<bool(int64_t)> check_should_abort_;
 
+    sindex_construction_pacer_t pacer_;
+
     // How far we've come in the traversal
     int64_t pairs_constructed_;
     store_key_t traversed_right_bound_;
@@ -2223,4 +2477,481 @@ void post_construct_secondary_index_range(
     }
 }
 
+/* The entries of one secondary index that is being bulk constructed. */
+struct bulk_sindex_build_t {
+    bulk_sindex_build_t(
+            const uuid_u &_id,
+            const sindex_disk_info_t &_info,
+            const std::function<scoped_ptr_t<
+                external_sorter_t<sindex_entry_t>::run_t>()> &make_run)
+        : id(_id), info(_info), num_entries(0), sorter(make_run) { }
+
+    const uuid_u id;
+    const sindex_disk_info_t info;
+    // Entries that haven't been added to `sorter` yet.
+    std::vector<sindex_entry_t> buffer;
+    int64_t num_entries;
+    external_sorter_t<sindex_entry_t> sorter;
+};
+
+/* Returns `true` if all of the indexes in `builds` have been deleted. */
+bool all_bulk_sindexes_deleted(
+        store_t *store,
+        const std::vector<scoped_ptr_t<bulk_sindex_build_t> > &builds,
+        signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    read_token_t read_token;
+    store->new_read_token(&read_token);
+    store->acquire_superblock_for_read(
+        &read_token,
+        &txn,
+        &superblock,
+        interruptor,
+        false /* USE_SNAPSHOT */);
+    buf_lock_t sindex_block(superblock->expose_buf(),
+                            superblock->get_sindex_block_id(),
+                            access_t::read);
+    superblock.reset();
+    for (const auto &build : builds) {
+        secondary_index_t sindex;
+        if (get_secondary_index(&sindex_block, build->id, &sindex)
+            && !sindex.being_deleted) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Collects the entries of the indexes that are being bulk constructed. The traversals
+of all the slices of the primary btree add their entries to the same collector. Every
+now and then it checks whether the indexes have been deleted in the meantime, and
+aborts the construction if they were. */
+class bulk_sindex_collector_t {
+public:
+    bulk_sindex_collector_t(
+            store_t *store,
+            const std::vector<scoped_ptr_t<bulk_sindex_build_t> > *builds,
+            const std::function<void(int64_t)> &on_rows_collected,
+            signal_t *interruptor)
+        : store_(store),
+          builds_(builds),
+          on_rows_collected_(on_rows_collected),
+          interruptor_(interruptor),
+          buffered_bytes_(0),
+          num_rows_(0) { }
+
+    // Adds the entries for one row. `(*entries)[i]` belongs to `(*builds_)[i]`.
+    void add(std::vector<std::vector<sindex_entry_t> > *entries)
+            THROWS_ONLY(interrupted_exc_t) {
+        guarantee(entries->size() == builds_->size());
+        for (size_t i = 0; i < builds_->size(); ++i) {
+            for (auto &&entry : (*entries)[i]) {
+                buffered_bytes_ += entry.first.size() + entry.second.size();
+                (*builds_)[i]->buffer.push_back(std::move(entry));
+                ++(*builds_)[i]->num_entries;
+            }
+        }
+        ++num_rows_;
+        on_rows_collected_(num_rows_);
+        if (buffered_bytes_ >= MAX_BUFFERED_BYTES) {
+            spill();
+        } else if (num_rows_ % ROWS_PER_DELETION_CHECK == 0) {
+            check_indexes_deleted();
+        }
+    }
+
+    // Adds the buffered entries to the sorters.
+    void spill() THROWS_ONLY(interrupted_exc_t) {
+        // There's no point in writing out the entries of deleted indexes.
+        check_indexes_deleted();
+
+        // Other traversals can keep adding entries while we're writing out these.
+        std::vector<std::vector<sindex_entry_t> > runs(builds_->size());
+        for (size_t i = 0; i < builds_->size(); ++i) {
+            runs[i].swap((*builds_)[i]->buffer);
+        }
+        buffered_bytes_ = 0;
+
+        new_mutex_acq_t sorter_acq(&sorter_lock_);
+        for (size_t i = 0; i < builds_->size(); ++i) {
+            if (!runs[i].empty()) {
+                (*builds_)[i]->sorter.add_run(&runs[i], sindex_entry_less_t());
+            }
+        }
+    }
+
+private:
+    void check_indexes_deleted() THROWS_ONLY(interrupted_exc_t) {
+        if (all_bulk_sindexes_deleted(store_, *builds_, interruptor_)) {
+            // This is signalled the same way as in
+            // `post_construct_secondary_index_range`.
+            throw interrupted_exc_t();
+        }
+    }
+
+    // How much entry data we collect in memory before sorting it and writing it out
+    // as a new run.
+    static const size_t MAX_BUFFERED_BYTES = 32 * MEGABYTE;
+    // How many rows we collect between two checks for deleted indexes, unless we
+    // spill before that.
+    static const int64_t ROWS_PER_DELETION_CHECK = 1024;
+
+    store_t *const store_;
+    const std::vector<scoped_ptr_t<bulk_sindex_build_t> > *builds_;
+    std::function<void(int64_t)> on_rows_collected_;
+    signal_t *const interruptor_;
+    size_t buffered_bytes_;
+    int64_t num_rows_;
+    // `external_sorter_t::add_run()` can't be called concurrently.
+    new_mutex_t sorter_lock_;
+
+    DISABLE_COPYING(bulk_sindex_collector_t);
+};
+
+class bulk_construct_traversal_helper_t : public concurrent_traversal_callback_t {
+public:
+    bulk_construct_traversal_helper_t(
+            store_t *store,
+            const std::vector<scoped_ptr_t<bulk_sindex_build_t> > *builds,
+            bulk_sindex_collector_t *collector,
+            sindex_construction_pacer_t *pacer,
+            signal_t *interruptor)
+        : store_(store),
+          builds_(builds),
+          collector_(collector),
+          pacer_(pacer),
+          interruptor_(interruptor),
+          rows_since_pace_(0) { }
+
+    continue_bool_t handle_pair(
+            scoped_key_value_t &&keyvalue,
+            concurrent_traversal_fifo_enforcer_signal_t waiter)
+            THROWS_ONLY(interrupted_exc_t) {
+
+        if (interruptor_->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+
+        store_->btree->stats.pm_keys_read.record();
+        store_->btree->stats.pm_total_keys_read += 1;
+
+        const store_key_t primary_key(keyvalue.key());
+        const rdb_value_t *rdb_value =
+            static_cast<const rdb_value_t *>(keyvalue.value());
+        const max_block_size_t block_size =
+            keyvalue.expose_buf().cache()->max_block_size();
+        ql::datum_t doc = get_data(rdb_value, buf_parent_t(keyvalue.expose_buf()),
+                                   store_->btree->field_dictionary);
+        const std::vector<char> value_ref(
+            rdb_value->value_ref(),
+            rdb_value->value_ref() + rdb_value->inline_size(block_size));
+
+        // The index functions can run concurrently for different rows. Only adding
+        // the entries to the collector happens in key order.
+        std::vector<std::vector<sindex_entry_t> > entries(builds_->size());
+        for (size_t i = 0; i < builds_->size(); ++i) {
+            try {
+                std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+                compute_keys(primary_key, doc, (*builds_)[i]->info, &keys, nullptr);
+                for (auto &&pair : keys) {
+                    entries[i].emplace_back(std::move(pair.first), value_ref);
+                }
+            } catch (const ql::base_exc_t &) {
+                // Do nothing (we just drop the row from the index).
+            }
+        }
+
+        waiter.wait();
+        collector_->add(&entries);
+        if (++rows_since_pace_ == ROWS_PER_PACE) {
+            rows_since_pace_ = 0;
+            pacer_->pace(interruptor_);
+        }
+        return continue_bool_t::CONTINUE;
+    }
+
+private:
+    // How many rows we read between two calls to `pacer_->pace()`.
+    static const int ROWS_PER_PACE = 256;
+
+    store_t *store_;
+    const std::vector<scoped_ptr_t<bulk_sindex_build_t> > *builds_;
+    bulk_sindex_collector_t *collector_;
+    sindex_construction_pacer_t *pacer_;
+    signal_t *interruptor_;
+    int rows_since_pace_;
+};
+
+/* Traverses `slice` of a snapshot of the primary btree and adds the entries for its
+rows to `collector`. */
+void collect_sindex_entries(
+        store_t *store,
+        const key_range_t &slice,
+        const std::vector<scoped_ptr_t<bulk_sindex_build_t> > *builds,
+        bulk_sindex_collector_t *collector,
+        sindex_construction_pacer_t *pacer,
+        signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    // Mind the destructor ordering, as in `post_construct_secondary_index_range`.
+    cache_account_t cache_account;
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+
+    read_token_t read_token;
+    store->new_read_token(&read_token);
+    store->acquire_superblock_for_read(
+        &read_token,
+        &txn,
+        &superblock,
+        interruptor,
+        true /* USE_SNAPSHOT */);
+
+    bulk_construct_traversal_helper_t traversal_cb(
+        store, builds, collector, pacer, interruptor);
+
+    cache_account
+        = txn->cache()->create_cache_account(SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY);
+    txn->set_account(&cache_account);
+
+    continue_bool_t cont = btree_concurrent_traversal(
+        superblock.get(),
+        slice,
+        &traversal_cb,
+        direction_t::FORWARD,
+        release_superblock_t::RELEASE);
+    if (cont == continue_bool_t::ABORT) {
+        throw interrupted_exc_t();
+    }
+}
+
+/* Inserts the entries of `build` into its secondary index in key order. */
+void bulk_write_sindex_entries(
+        store_t *store,
+        bulk_sindex_build_t *build,
+        sindex_construction_pacer_t *pacer,
+        const std::function<void()> &on_entry_written,
+        signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    // Number of entries we insert before releasing the write transaction. See the
+    // comment on `post_construct_traversal_helper_t::wtxn_` for why we don't use a
+    // single transaction.
+    const size_t ENTRIES_PER_TXN = 256;
+
+    sindex_entry_t entry;
+    bool has_entry = build->sorter.next(&entry, sindex_entry_less_t());
+    while (has_entry) {
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+
+        {
+            write_token_t token;
+            store->new_write_token(&token);
+
+            // We use HARD durability for the same reason as the
+            // `post_construct_traversal_helper_t`.
+            scoped_ptr_t<txn_t> txn;
+            scoped_ptr_t<real_superblock_t> superblock;
+            store->acquire_superblock_for_write(
+                2 + ENTRIES_PER_TXN,
+                write_durability_t::HARD,
+                &token,
+                &txn,
+                &superblock,
+                interruptor);
+
+            store_t::sindex_access_vector_t sindexes;
+            {
+                buf_lock_t sindex_block(superblock->expose_buf(),
+                                        superblock->get_sindex_block_id(),
+                                        access_t::write);
+                superblock.reset();
+                store->acquire_sindex_superblocks_for_write(
+                    std::set<uuid_u>{build->id},
+                    &sindex_block,
+                    &sindexes);
+            }
+            if (sindexes.empty() || sindexes[0]->sindex.being_deleted) {
+                // The index has been deleted. This is signalled the same way as in
+                // `post_construct_secondary_index_range`.
+                throw interrupted_exc_t();
+            }
+
+            // The entries go through the normal write path. Since they arrive in key
+            // order, each insert lands in the rightmost leaf. Full leaves still split
+            // at the median, so the left half is never written again and the finished
+            // index's leaves end up about half full.
+            superblock_t *sindex_superblock = sindexes[0]->superblock.get();
+            const rdb_post_construction_deletion_context_t deletion_context;
+            for (size_t i = 0; has_entry && i < ENTRIES_PER_TXN; ++i) {
+                sindex_superblock =
+                    set_sindex_entry(sindex_superblock, entry, &deletion_context);
+
+                store->btree->stats.pm_keys_set.record();
+                store->btree->stats.pm_total_keys_set += 1;
+                on_entry_written();
+
+                has_entry = build->sorter.next(&entry, sindex_entry_less_t());
+            }
+        }
+
+        pacer->pace(interruptor);
+    }
+}
+
+std::vector<key_range_t> split_construction_range(
+        superblock_t *superblock,
+        const key_range_t &range,
+        size_t max_slices,
+        int64_t *rows_in_range_out) {
+    // The keys at this depth of the btree are used as the boundaries of the slices.
+    const int DISTRIBUTION_DEPTH = 2;
+    int64_t key_count;
+    std::vector<store_key_t> keys;
+    get_btree_key_distribution(superblock, DISTRIBUTION_DEPTH, &key_count, &keys);
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<store_key_t> inner_keys;
+    for (const auto &key : keys) {
+        if (range.contains_key(key) && range.left < key) {
+            inner_keys.push_back(key);
+        }
+    }
+    *rows_in_range_out =
+        key_count * static_cast<int64_t>(inner_keys.size() + 1) / (keys.size() + 1);
+
+    std::vector<key_range_t> slices;
+    store_key_t left = range.left;
+    for (size_t i = 1; i < max_slices && !inner_keys.empty(); ++i) {
+        const store_key_t &split = inner_keys[i * inner_keys.size() / max_slices];
+        if (left < split) {
+            slices.push_back(key_range_t(
+                key_range_t::closed, left, key_range_t::open, split));
+            left = split;
+        }
+    }
+    key_range_t last_slice = range;
+    last_slice.left = left;
+    slices.push_back(last_slice);
+    return slices;
+}
+
+void bulk_construct_secondary_index_range(
+        store_t *store,
+        const std::set<uuid_u> &sindex_ids_to_construct,
+        key_range_t *construction_range_inout,
+        sindex_construction_progress_t *progress_inout,
+        signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    // How many slices of the primary btree we traverse in parallel.
+    const size_t MAX_SLICES = 4;
+
+    std::vector<scoped_ptr_t<bulk_sindex_build_t> > builds;
+    auto make_run = [store]() {
+        return make_scoped<external_sorter_t<sindex_entry_t>::run_t>(
+            store->io_backender_,
+            serializer_filepath_t(
+                store->base_path_,
+                "sindex_construction_" + uuid_to_str(generate_uuid())),
+            &store->perfmon_collection);
+    };
+
+    std::vector<key_range_t> slices;
+    int64_t estimated_rows;
+    {
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        read_token_t read_token;
+        store->new_read_token(&read_token);
+        store->acquire_superblock_for_read(
+            &read_token,
+            &txn,
+            &superblock,
+            interruptor,
+            false /* USE_SNAPSHOT */);
+
+        {
+            buf_lock_t sindex_block(superblock->expose_buf(),
+                                    superblock->get_sindex_block_id(),
+                                    access_t::read);
+            for (const uuid_u &id : sindex_ids_to_construct) {
+                secondary_index_t sindex;
+                if (get_secondary_index(&sindex_block, id, &sindex)
+                    && !sindex.being_deleted) {
+                    sindex_disk_info_t info;
+                    try {
+                        deserialize_sindex_info_or_crash(sindex.opaque_definition,
+                                                         &info);
+                    } catch (const archive_exc_t &e) {
+                        crash("%s", e.what());
+                    }
+                    builds.push_back(
+                        make_scoped<bulk_sindex_build_t>(id, info, make_run));
+                }
+            }
+        }
+        if (builds.empty()) {
+            // All indexes have been deleted.
+            throw interrupted_exc_t();
+        }
+
+        slices = split_construction_range(
+            superblock.get(), *construction_range_inout, MAX_SLICES, &estimated_rows);
+    }
+
+    // The first half of the remaining progress is for collecting the entries, and the
+    // second half for writing them.
+    const double start_progress = progress_inout->progress;
+    const double start_rows_done = progress_inout->rows_done;
+    auto set_progress = [&](double fraction, double rows_done) {
+        progress_inout->progress = start_progress + (1.0 - start_progress) * fraction;
+        progress_inout->rows_done = start_rows_done + rows_done;
+    };
+
+    bulk_sindex_collector_t collector(store, &builds, [&](int64_t rows) {
+        set_progress(
+            0.5 * std::min(1.0, static_cast<double>(rows) / std::max<int64_t>(
+                estimated_rows, 1)),
+            0.5 * rows);
+    }, interruptor);
+
+    // We only write to the indexes after releasing the snapshots, so that the cache
+    // doesn't have to keep the old versions of the primary btree blocks around.
+    bool interrupted = false;
+    pmap(slices.size(), [&](int64_t i) {
+        // Each slice needs its own pacer, since a pacer only notices the writes that
+        // happened since it was last updated.
+        sindex_construction_pacer_t slice_pacer(&store->write_latency);
+        try {
+            collect_sindex_entries(
+                store, slices[i], &builds, &collector, &slice_pacer, interruptor);
+        } catch (const interrupted_exc_t &) {
+            interrupted = true;
+        }
+    });
+    if (interrupted) {
+        throw interrupted_exc_t();
+    }
+    collector.spill();
+
+    int64_t total_entries = 0;
+    for (const auto &build : builds) {
+        total_entries += build->num_entries;
+    }
+    const double total_rows = 2 * (progress_inout->rows_done - start_rows_done);
+    int64_t entries_written = 0;
+    sindex_construction_pacer_t pacer(&store->write_latency);
+    for (auto &&build : builds) {
+        bulk_write_sindex_entries(store, build.get(), &pacer, [&]() {
+            ++entries_written;
+            const double written = static_cast<double>(entries_written) / total_entries;
+            set_progress(0.5 + 0.5 * written, 0.5 * total_rows * (1.0 + written));
+        }, interruptor);
+    }
+
+    *construction_range_inout = key_range_t::empty();
+}
+
 void noop_value_deleter_t::delete_value(buf_parent_t, const void *) const { }
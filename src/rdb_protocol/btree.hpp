@@ -113,6 +113,23 @@ batched_replace_response_t rdb_batched_replace(
     profile::sampler_t *sampler,
     profile::trace_t *trace);
 
+/* An import mode for `rdb_batched_replace()` with an insert replacer. If no rows
+exist in the key range of `keys` (or the key filter shows that none of `keys` exist) and
+there are no changefeeds on it, it inserts the rows in key order without running them
+concurrently, updates the secondary indexes with sorted entries, sets `*response_out`
+and returns `true`. Otherwise it returns `false` without changing anything, and
+`rdb_batched_replace()` must be used instead. */
+bool rdb_batched_insert_into_empty_range(
+    const btree_info_t &info,
+    scoped_ptr_t<real_superblock_t> *superblock,
+    const std::vector<store_key_t> &keys,
+    const btree_batched_replacer_t *replacer,
+    rdb_modification_report_cb_t *sindex_cb,
+    ql::configured_limits_t limits,
+    profile::sampler_t *sampler,
+    profile::trace_t *trace,
+    batched_replace_response_t *response_out);
+
 void rdb_set(const store_key_t &key, ql::datum_t data,
              bool overwrite,
              btree_slice_t *slice, repli_timestamp_t timestamp,
@@ -301,6 +318,13 @@ public:
     bool has_pkey_cfeeds(const std::vector<store_key_t> &keys);
     void finish(btree_slice_t *btree, real_superblock_t *superblock);
 
+    // Whether any changefeeds might be interested in changes to `range`.
+    bool has_cfeeds(const key_range_t &range);
+    // Updates the secondary indexes for `reports`, which must only add rows, in key
+    // order rather than one report at a time. Changefeeds are not notified, so this
+    // must only be used if `has_cfeeds()` returned `false` for their range.
+    void on_insert_reports(const std::vector<rdb_modification_report_t> &reports);
+
 private:
     void on_mod_report_sub(
         const rdb_modification_report_t &mod_report,
@@ -337,6 +361,29 @@ void post_construct_secondary_index_range(
         signal_t *interruptor)
     THROWS_ONLY(interrupted_exc_t);
 
+/* Constructs the indexes for all of `*construction_range_inout` in one pass and sets
+it to the empty range. Instead of inserting the entries row by row, it collects them
+from snapshots of several slices of the primary btree in parallel, sorts them externally
+and then inserts them into each index in key order. Writes that happen in the meantime
+must be applied from a queue afterwards. `*progress_inout` is updated as the
+construction goes on. */
+void bulk_construct_secondary_index_range(
+        store_t *store,
+        const std::set<uuid_u> &sindexes_to_construct,
+        key_range_t *construction_range_inout,
+        sindex_construction_progress_t *progress_inout,
+        signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t);
+
+/* Splits `range` into at most `max_slices` contiguous slices with roughly the same number
+of rows, based on the key distribution of the primary btree. `*rows_in_range_out` is
+set to an estimate of the number of rows in `range`. */
+std::vector<key_range_t> split_construction_range(
+        superblock_t *superblock,
+        const key_range_t &range,
+        size_t max_slices,
+        int64_t *rows_in_range_out);
+
 /* This deleter actually deletes the value and all associated blocks. */
 class rdb_value_deleter_t : public value_deleter_t {
 public:
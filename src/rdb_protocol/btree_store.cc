@@ -92,6 +92,8 @@ store_t::store_t(const region_t &region,
       perfmon_collection(),
       io_backender_(io_backender), base_path_(base_path),
       perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name),
+      write_latency(&perfmon_collection),
+      key_filter(this),
       ctx(_ctx),
       table_id(_table_id),
       write_superblock_acq_semaphore(WRITE_SUPERBLOCK_ACQ_WAITERS_LIMIT)
@@ -122,6 +124,8 @@ store_t::store_t(const region_t &region,
                                  &perfmon_collection,
                                  "primary",
                                  index_type_t::PRIMARY));
+    btree->field_dictionary = &field_dictionary;
+    btree->key_filter = &key_filter;
 
     // Initialize sindex slices and metainfo
     {
@@ -139,7 +143,8 @@ store_t::store_t(const region_t &region,
                                     &dummy_interruptor,
                                     false /* don't use snapshot */ );
 
-        metainfo.init(new store_metainfo_manager_t(superblock.get()));
+        metainfo.init(new store_metainfo_manager_t(superblock.get(),
+                                                   &field_dictionary));
 
         buf_lock_t sindex_block(superblock->expose_buf(),
                                 superblock->get_sindex_block_id(),
@@ -158,6 +163,7 @@ store_t::store_t(const region_t &region,
                                                     pc,
                                                     it->first.name,
                                                     index_type_t::SECONDARY);
+            slice->field_dictionary = &field_dictionary;
             secondary_index_slices.insert(std::make_pair(it->second.id,
                                                          std::move(slice)));
         }
@@ -211,6 +217,8 @@ void store_t::write(
         THROWS_ONLY(interrupted_exc_t) {
     assert_thread();
 
+    // This must be destructed after `txn`, so that it includes the flush.
+    write_latency_monitor_t::sentry_t write_latency_sentry(&write_latency);
     scoped_ptr_t<txn_t> txn;
     scoped_ptr_t<real_superblock_t> real_superblock;
     // We assume one block per document, plus changes to the stats block and superblock.
@@ -327,11 +335,13 @@ std::map<std::string, std::pair<sindex_config_t, sindex_status_t> > store_t::sin
             res->second.ready = true;
             res->second.progress_numerator = 0.0;
             res->second.progress_denominator = 0.0;
+            res->second.rows_per_second = 0.0;
             res->second.start_time = -1;
         } else {
             res->second.ready = false;
             res->second.progress_numerator = get_sindex_progress(pair.second.id);
             res->second.progress_denominator = 1.0;
+            res->second.rows_per_second = get_sindex_rows_per_second(pair.second.id);
             res->second.start_time = get_sindex_start_time(pair.second.id);
         }
     }
@@ -463,6 +473,38 @@ void store_t::configure_flush_interval(flush_interval_t interval) {
     cache->configure_flush_interval(interval);
 }
 
+void store_t::configure_block_compression(block_compression_t compression) {
+    cache->configure_block_compression(compression);
+}
+
+void store_t::configure_eviction_policy(eviction_policy_t policy) {
+    cache->configure_eviction_policy(policy);
+}
+
+void store_t::configure_cache_quota(cache_quota_t quota) {
+    cache->configure_cache_quota(quota);
+}
+
+void store_t::configure_field_dictionary(bool enabled) {
+    field_dictionary.set_enabled(enabled);
+}
+
+void store_t::configure_key_filter(bool enabled) {
+    key_filter.set_enabled(enabled);
+}
+
+std::vector<block_id_t> store_t::hot_block_ids(size_t max_count) const {
+    assert_thread();
+    return cache->hot_block_ids(max_count);
+}
+
+void store_t::warm_up_cache(const std::vector<block_id_t> &block_ids,
+                            signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    cache->warm_up(block_ids, interruptor);
+}
+
 new_mutex_in_line_t store_t::get_in_line_for_sindex_queue(buf_lock_t *sindex_block) {
     assert_thread();
     // The line for the sindex queue is there to guarantee that we push things to
@@ -585,7 +627,7 @@ double store_t::get_sindex_progress(uuid_u const &id) {
     if (iterator == sindex_context.end()) {
         return 0.0;
     } else {
-        return *iterator->second.second;
+        return iterator->second->progress;
     }
 }
 
@@ -594,8 +636,21 @@ microtime_t store_t::get_sindex_start_time(uuid_u const &id) {
     if (iterator == sindex_context.end()) {
         return -1;
     } else {
-        return iterator->second.first;
+        return iterator->second->start_time;
+    }
+}
+
+double store_t::get_sindex_rows_per_second(uuid_u const &id) {
+    auto iterator = sindex_context.find(id);
+    if (iterator == sindex_context.end()) {
+        return 0.0;
+    }
+    const microtime_t now = current_microtime();
+    if (now <= iterator->second->start_time) {
+        return 0.0;
     }
+    return iterator->second->rows_done
+        / (static_cast<double>(now - iterator->second->start_time) / MILLION);
 }
 
 boost::optional<uuid_u> store_t::add_sindex_internal(
@@ -615,12 +670,12 @@ boost::optional<uuid_u> store_t::add_sindex_internal(
             btree_slice_t::init_sindex_superblock(&superblock);
         }
 
-        secondary_index_slices.insert(
-                std::make_pair(sindex.id,
-                               make_scoped<btree_slice_t>(cache.get(),
-                                                          &perfmon_collection,
-                                                          name.name,
-                                                          index_type_t::SECONDARY)));
+        auto slice = make_scoped<btree_slice_t>(cache.get(),
+                                                &perfmon_collection,
+                                                name.name,
+                                                index_type_t::SECONDARY);
+        slice->field_dictionary = &field_dictionary;
+        secondary_index_slices.insert(std::make_pair(sindex.id, std::move(slice)));
 
         sindex.needs_post_construction_range = key_range_t::universe();
 
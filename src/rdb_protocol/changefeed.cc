@@ -10,6 +10,8 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/interruptor.hpp"
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "containers/interval_index.hpp"
 #include "rdb_protocol/artificial_table/backend.hpp"
 #include "rdb_protocol/btree.hpp"
 #include "rdb_protocol/env.hpp"
@@ -493,17 +495,49 @@ void server_t::add_client_cb(
 }
 
 struct stamped_msg_t {
-    stamped_msg_t() { }
+    stamped_msg_t() : serialized_submsg(nullptr) { }
     stamped_msg_t(uuid_u _server_uuid, uint64_t _stamp, msg_t _submsg)
         : server_uuid(std::move(_server_uuid)),
           stamp(_stamp),
-          submsg(std::move(_submsg)) { }
+          submsg(std::move(_submsg)),
+          serialized_submsg(nullptr) { }
+    // `send_all` serializes a message only once for all of its clients. This
+    // sends `*_serialized_submsg` instead of `submsg`, which is left empty.
+    stamped_msg_t(uuid_u _server_uuid,
+                  uint64_t _stamp,
+                  const std::vector<char> *_serialized_submsg)
+        : server_uuid(std::move(_server_uuid)),
+          stamp(_stamp),
+          serialized_submsg(_serialized_submsg) { }
     uuid_u server_uuid;
     uint64_t stamp;
     msg_t submsg;
+    // Only ever set on the sending side, and only for the duration of `send`.
+    const std::vector<char> *serialized_submsg;
 };
 
-RDB_MAKE_SERIALIZABLE_3(stamped_msg_t, server_uuid, stamp, submsg);
+// This has the format of `RDB_MAKE_SERIALIZABLE_3(stamped_msg_t, server_uuid, stamp,
+// submsg)` whether or not the message was serialized ahead of time.
+template <cluster_version_t W>
+void serialize(write_message_t *wm, const stamped_msg_t &msg) {
+    serialize<W>(wm, msg.server_uuid);
+    serialize<W>(wm, msg.stamp);
+    if (msg.serialized_submsg != nullptr) {
+        guarantee(W == cluster_version_t::CLUSTER);
+        wm->append(msg.serialized_submsg->data(), msg.serialized_submsg->size());
+    } else {
+        serialize<W>(wm, msg.submsg);
+    }
+}
+
+template <cluster_version_t W>
+archive_result_t deserialize(read_stream_t *s, stamped_msg_t *msg) {
+    archive_result_t res = deserialize<W>(s, &msg->server_uuid);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &msg->stamp);
+    if (bad(res)) { return res; }
+    return deserialize<W>(s, &msg->submsg);
+}
 
 // This function takes a `lock_t` to make sure you have one.  (We can't just
 // always acquire a drainer lock before sending because we sometimes send a
@@ -547,8 +581,24 @@ void server_t::send_all(
     }
     acq.reset();
     stamp_spot->reset(); // Done stamping, no need to hold onto it while we send.
+    if (stamps.empty()) {
+        return;
+    }
+    // Only the stamps differ between the clients, so we serialize the message
+    // itself just once.  That's where most of the time goes for large rows and
+    // popular tables.
+    std::vector<char> serialized_msg;
+    {
+        write_message_t wm;
+        serialize<cluster_version_t::CLUSTER>(&wm, msg);
+        vector_stream_t stream;
+        stream.reserve(wm.size());
+        DEBUG_VAR int res = send_write_message(&stream, &wm);
+        rassert(res == 0);
+        serialized_msg = stream.vector();
+    }
     for (const auto &pair : stamps) {
-        send(manager, pair.first, stamped_msg_t(uuid, pair.second, msg));
+        send(manager, pair.first, stamped_msg_t(uuid, pair.second, &serialized_msg));
     }
 }
 
@@ -1610,6 +1660,80 @@ class empty_sub_t;
 class point_sub_t;
 class limit_sub_t;
 
+struct primary_key_bounds_t {
+    typedef store_key_t point_t;
+    typedef store_key_t left_t;
+    typedef key_range_t::right_bound_t right_t;
+    static bool left_before(const left_t &a, const left_t &b) { return a < b; }
+    static bool right_before(const right_t &a, const right_t &b) { return a < b; }
+    static bool left_admits(const left_t &l, const point_t &p) { return l <= p; }
+    static bool right_admits(const right_t &r, const point_t &p) {
+        return r.unbounded || p < r.key();
+    }
+};
+
+// These match `datum_range_t::contains`.
+struct sindex_key_bounds_t {
+    typedef datum_t point_t;
+    typedef std::pair<datum_t, key_range_t::bound_t> left_t;
+    typedef std::pair<datum_t, key_range_t::bound_t> right_t;
+    static bool left_before(const left_t &a, const left_t &b) {
+        int cmp = a.first.cmp(b.first);
+        return cmp < 0 || (cmp == 0
+                           && a.second == key_range_t::closed
+                           && b.second != key_range_t::closed);
+    }
+    static bool right_before(const right_t &a, const right_t &b) {
+        int cmp = a.first.cmp(b.first);
+        return cmp < 0 || (cmp == 0
+                           && a.second != key_range_t::closed
+                           && b.second == key_range_t::closed);
+    }
+    static bool left_admits(const left_t &l, const point_t &p) {
+        int cmp = l.first.cmp(p);
+        return cmp < 0 || (cmp == 0 && l.second == key_range_t::closed);
+    }
+    static bool right_admits(const right_t &r, const point_t &p) {
+        int cmp = r.first.cmp(p);
+        return cmp > 0 || (cmp == 0 && r.second == key_range_t::closed);
+    }
+};
+
+/* Range subs with identical transforms get identical results for a change, so
+`msg_visitor_t` only applies them once per thread. This maps the serialized
+transforms to the transformed new and old values. */
+typedef std::map<std::string, std::pair<datum_t, datum_t> > shared_transforms_t;
+
+/* `range_sub_index_t` indexes the range subscriptions on one thread by the keys they're
+interested in, so that a change only visits the subscriptions whose ranges contain its
+primary key or one of its sindex keys. Subscriptions get added and removed much less
+often than changes arrive, so the index is simply rebuilt the next time it's used after
+the set of subscriptions changed. That happens on the subscriptions' thread, which is
+the only place where their `datum_t`s may be copied. */
+class range_sub_index_t {
+public:
+    range_sub_index_t() : stale(true) { }
+
+    // Called with the feed's `range_subs_lock` held for writing.
+    void mark_stale() { stale = true; }
+
+    // Must be called on the subscriptions' thread with `range_subs_lock` held.
+    void each_sub_for_change(
+        const std::set<range_sub_t *> &subs,
+        const msg_t::change_t &change,
+        const std::function<void(range_sub_t *, shared_transforms_t *)> &f);
+
+private:
+    void rebuild(const std::set<range_sub_t *> &subs);
+
+    bool stale;
+    interval_index_t<primary_key_bounds_t, range_sub_t *> primary;
+    std::map<std::string, interval_index_t<sindex_key_bounds_t, range_sub_t *> >
+        sindexes;
+
+    DISABLE_COPYING(range_sub_index_t);
+};
+
 class feed_t : public home_thread_mixin_t, public slow_atomic_countable_t<feed_t> {
 public:
     feed_t(namespace_id_t const &, table_meta_client_t *);
@@ -1627,8 +1751,13 @@ public:
     void add_limit_sub(limit_sub_t *sub, const uuid_u &uuid) THROWS_NOTHING;
     void del_limit_sub(limit_sub_t *sub, const uuid_u &uuid) THROWS_NOTHING;
 
-    void each_range_sub(const auto_drainer_t::lock_t &lock,
-                        const std::function<void(range_sub_t *)> &f) THROWS_NOTHING;
+    // Calls `f` on the range subs that `change` might concern, along with a cache
+    // that's shared by the subs on the same thread.
+    void each_range_sub_for_change(
+        const auto_drainer_t::lock_t &lock,
+        const msg_t::change_t &change,
+        const std::function<void(range_sub_t *, shared_transforms_t *)> &f)
+        THROWS_NOTHING;
     void update_stamps(uuid_u server_uuid, uint64_t stamp);
     std::map<uuid_u, uint64_t> get_stamps();
     void on_point_sub(
@@ -1679,6 +1808,11 @@ private:
                             const std::vector<std::set<Sub *> > &vec,
                             const std::vector<int> &sub_threads,
                             int i);
+    void each_range_sub_for_change_cb(
+        const msg_t::change_t &change,
+        const std::function<void(range_sub_t *, shared_transforms_t *)> &f,
+        const std::vector<int> &sub_threads,
+        int i);
     void each_point_sub_cb(const std::function<void(point_sub_t *)> &f, int i);
     void each_point_sub_with_lock(
         rwlock_in_line_t *spot,
@@ -1693,6 +1827,9 @@ private:
     std::vector<std::set<empty_sub_t *> > empty_subs;
     rwlock_t empty_subs_lock;
     std::vector<std::set<range_sub_t *> > range_subs;
+    // `range_subs` indexed by key, one per thread.  These are protected by
+    // `range_subs_lock` as well.
+    std::vector<scoped_ptr_t<range_sub_index_t> > range_sub_indexes;
     rwlock_t range_subs_lock;
     std::map<uuid_u, std::vector<std::set<limit_sub_t *> > > limit_subs;
     rwlock_t limit_subs_lock;
@@ -2193,9 +2330,28 @@ public:
         for (const auto &transform : spec.transforms) {
             ops.push_back(make_op(transform));
         }
-        store_keys = spec.datumspec.primary_key_map();
-        if (!store_keys) {
-            store_key_range = spec.datumspec.covering_range().to_primary_keyrange();
+        if (!spec.transforms.empty()) {
+            // What the transforms return also depends on the environment they run
+            // in, so subs only share their results if that matches as well.
+            write_message_t wm;
+            serialize<cluster_version_t::CLUSTER>(
+                &wm, static_cast<int8_t>(env->reql_version()));
+            serialize<cluster_version_t::CLUSTER>(&wm, env->limits());
+            serialize<cluster_version_t::CLUSTER>(&wm, spec.transforms);
+            vector_stream_t stream;
+            stream.reserve(wm.size());
+            DEBUG_VAR int res = send_write_message(&stream, &wm);
+            rassert(res == 0);
+            transforms_key.assign(stream.vector().begin(), stream.vector().end());
+        }
+        if (spec.sindex) {
+            sindex_covering_range = spec.datumspec.covering_range();
+        } else {
+            store_keys = spec.datumspec.primary_key_map();
+            if (!store_keys) {
+                store_key_range =
+                    spec.datumspec.covering_range().to_primary_keyrange();
+            }
         }
         feed->add_range_sub(this);
     }
@@ -2231,7 +2387,29 @@ public:
         }
     }
 
+    // The keys that `copies` can be nonzero for, which `range_sub_index_t` uses.
+    key_range_t covering_pkey_range() const {
+        guarantee(!spec.sindex);
+        if (store_keys) {
+            if (store_keys->empty()) {
+                return key_range_t::empty();
+            }
+            return key_range_t(key_range_t::closed, store_keys->begin()->first,
+                               key_range_t::closed, store_keys->rbegin()->first);
+        } else {
+            guarantee(store_key_range);
+            return *store_key_range;
+        }
+    }
+    const datum_range_t &covering_sindex_range() const {
+        guarantee(spec.sindex);
+        return sindex_covering_range;
+    }
+
     bool has_ops() { return ops.size() != 0; }
+    // Subs with the same transforms, `reql_version` and limits have the same
+    // `transforms_key`.
+    const std::string &get_transforms_key() const { return transforms_key; }
 
     boost::optional<datum_t> apply_ops(datum_t val) {
         guarantee(active());
@@ -2414,8 +2592,10 @@ private:
     // our subscription.
     std::map<uuid_u, uint64_t> orig_stamps, next_stamps;
     keyspec_t::range_t spec;
+    std::string transforms_key;
     boost::optional<std::map<store_key_t, uint64_t> > store_keys;
     boost::optional<key_range_t> store_key_range;
+    datum_range_t sindex_covering_range;
     state_t state, sent_state;
     std::vector<datum_t> artificial_initial_vals;
     bool artificial_include_initial;
@@ -2424,6 +2604,78 @@ private:
     auto_drainer_t drainer;
 };
 
+void range_sub_index_t::rebuild(const std::set<range_sub_t *> &subs) {
+    std::vector<interval_index_t<primary_key_bounds_t, range_sub_t *>::interval_t>
+        primary_intervals;
+    std::map<std::string,
+             std::vector<interval_index_t<sindex_key_bounds_t,
+                                          range_sub_t *>::interval_t> >
+        sindex_intervals;
+    for (range_sub_t *sub : subs) {
+        boost::optional<std::string> sindex = sub->sindex();
+        if (sindex) {
+            const datum_range_t &range = sub->covering_sindex_range();
+            if (range.is_empty()) {
+                continue;
+            }
+            sindex_intervals[*sindex].push_back({
+                std::make_pair(range.get_left_bound(), range.left_bound_type),
+                std::make_pair(range.get_right_bound(), range.right_bound_type),
+                sub});
+        } else {
+            key_range_t range = sub->covering_pkey_range();
+            if (range.is_empty()) {
+                continue;
+            }
+            primary_intervals.push_back({range.left, range.right, sub});
+        }
+    }
+    primary = interval_index_t<primary_key_bounds_t, range_sub_t *>(
+        std::move(primary_intervals));
+    sindexes.clear();
+    for (auto &&pair : sindex_intervals) {
+        sindexes.insert(std::make_pair(
+            pair.first,
+            interval_index_t<sindex_key_bounds_t, range_sub_t *>(
+                std::move(pair.second))));
+    }
+    stale = false;
+}
+
+void range_sub_index_t::each_sub_for_change(
+        const std::set<range_sub_t *> &subs,
+        const msg_t::change_t &change,
+        const std::function<void(range_sub_t *, shared_transforms_t *)> &f) {
+    std::vector<range_sub_t *> matches;
+    {
+        ASSERT_NO_CORO_WAITING;
+        if (stale) {
+            rebuild(subs);
+        }
+        auto add_match = [&matches](range_sub_t *sub) { matches.push_back(sub); };
+        primary.visit_containing(change.pkey, add_match);
+        for (const auto &pair : sindexes) {
+            for (const index_vals_t *vals : {&change.old_indexes,
+                                             &change.new_indexes}) {
+                auto it = vals->find(pair.first);
+                if (it != vals->end()) {
+                    for (const auto &idx : it->second) {
+                        pair.second.visit_containing(idx.first, add_match);
+                    }
+                }
+            }
+        }
+    }
+    // A sub might match several sindex keys, but it must only see the change once.
+    // This also visits the subs in the same order as `subs`.
+    std::sort(matches.begin(), matches.end(), std::less<range_sub_t *>());
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+    shared_transforms_t shared_transforms;
+    for (range_sub_t *sub : matches) {
+        f(sub, &shared_transforms);
+    }
+}
+
 class limit_sub_t : public subscription_t {
     struct limit_change_t {
         datum_t old_d, new_d;
@@ -2848,23 +3100,35 @@ public:
     void operator()(const msg_t::change_t &change) const {
         datum_t null = datum_t::null();
 
-        feed->each_range_sub(*lock, [&](range_sub_t *sub) {
+        feed->each_range_sub_for_change(
+            *lock, change,
+            [&](range_sub_t *sub, shared_transforms_t *shared_transforms) {
             datum_t new_val = null, old_val = null;
             if (!sub->active()) return;
             bool trivial = false;
             if (sub->has_ops()) {
-                if (change.new_val.has()) {
-                    if (boost::optional<datum_t> d = sub->apply_ops(change.new_val)) {
-                        new_val = *d;
+                auto shared = shared_transforms->find(sub->get_transforms_key());
+                if (shared != shared_transforms->end()) {
+                    new_val = shared->second.first;
+                    old_val = shared->second.second;
+                } else {
+                    if (change.new_val.has()) {
+                        if (boost::optional<datum_t> d =
+                                sub->apply_ops(change.new_val)) {
+                            new_val = *d;
+                        }
                     }
-                }
-                if (!sub->active()) return;
-                if (change.old_val.has()) {
-                    if (boost::optional<datum_t> d = sub->apply_ops(change.old_val)) {
-                        old_val = *d;
+                    if (!sub->active()) return;
+                    if (change.old_val.has()) {
+                        if (boost::optional<datum_t> d =
+                                sub->apply_ops(change.old_val)) {
+                            old_val = *d;
+                        }
                     }
+                    if (!sub->active()) return;
+                    shared_transforms->insert(std::make_pair(
+                        sub->get_transforms_key(), std::make_pair(new_val, old_val)));
                 }
-                if (!sub->active()) return;
                 // Duplicate values are caught before being written to disk and
                 // don't generate a `mod_report`, but if we have transforms the
                 // values might have changed.
@@ -3530,12 +3794,14 @@ void feed_t::add_range_sub(range_sub_t *sub) THROWS_NOTHING {
     add_sub_with_lock(&range_subs_lock, [this, sub]() {
             auto pair = range_subs[sub->home_thread().threadnum].insert(sub);
             guarantee(pair.second);
+            range_sub_indexes[sub->home_thread().threadnum]->mark_stale();
         });
 }
 
 // Can't throw because it's called in a destructor.
 void feed_t::del_range_sub(range_sub_t *sub) THROWS_NOTHING {
     del_sub_with_lock(&range_subs_lock, [this, sub]() {
+            range_sub_indexes[sub->home_thread().threadnum]->mark_stale();
             return range_subs[sub->home_thread().threadnum].erase(sub);
         });
 }
@@ -3607,12 +3873,40 @@ void feed_t::each_sub_in_vec_cb(const std::function<void(Sub *)> &f,
     }
 }
 
-void feed_t::each_range_sub(
+void feed_t::each_range_sub_for_change(
     const auto_drainer_t::lock_t &lock,
-    const std::function<void(range_sub_t *)> &f) THROWS_NOTHING {
+    const msg_t::change_t &change,
+    const std::function<void(range_sub_t *, shared_transforms_t *)> &f)
+    THROWS_NOTHING {
     assert_thread();
+    guarantee(lock.has_lock());
     rwlock_in_line_t spot(&range_subs_lock, access_t::read);
-    each_sub_in_vec(range_subs, &spot, lock, f);
+    spot.read_signal()->wait_lazily_unordered();
+
+    std::vector<int> subscription_threads;
+    for (int i = 0; i < get_num_threads(); ++i) {
+        if (range_subs[i].size() != 0) {
+            subscription_threads.push_back(i);
+        }
+    }
+    pmap(subscription_threads.size(),
+         std::bind(&feed_t::each_range_sub_for_change_cb,
+                   this,
+                   std::cref(change),
+                   std::cref(f),
+                   std::cref(subscription_threads),
+                   ph::_1));
+}
+
+void feed_t::each_range_sub_for_change_cb(
+        const msg_t::change_t &change,
+        const std::function<void(range_sub_t *, shared_transforms_t *)> &f,
+        const std::vector<int> &subscription_threads,
+        int i) {
+    int thread = subscription_threads[i];
+    guarantee(range_subs[thread].size() != 0);
+    on_thread_t th((threadnum_t(thread)));
+    range_sub_indexes[thread]->each_sub_for_change(range_subs[thread], change, f);
 }
 
 void feed_t::each_point_sub_cb(const std::function<void(point_sub_t *)> &f, int i) {
@@ -3710,6 +4004,9 @@ void feed_t::stop_subs(const auto_drainer_t::lock_t &lock) {
             num_subs -= set.size();
             set.clear();
         }
+        for (auto &&index : range_sub_indexes) {
+            index->mark_stale();
+        }
     }
     {
         rwlock_in_line_t spot(&empty_subs_lock, access_t::write);
@@ -3750,8 +4047,13 @@ feed_t::feed_t(namespace_id_t const &_table_id, table_meta_client_t *_table_meta
     num_subs(0),
     empty_subs(get_num_threads()),
     range_subs(get_num_threads()),
+    range_sub_indexes(get_num_threads()),
     table_id(_table_id),
-    table_meta_client(_table_meta_client) { }
+    table_meta_client(_table_meta_client) {
+    for (auto &&index : range_sub_indexes) {
+        index.init(new range_sub_index_t());
+    }
+}
 
 feed_t::~feed_t() {
     guarantee(num_subs == 0);
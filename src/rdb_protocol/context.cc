@@ -4,6 +4,7 @@
 #include "clustering/administration/metadata.hpp"
 #include "concurrency/cross_thread_watchable.hpp"
 #include "rdb_protocol/query_cache.hpp"
+#include "rdb_protocol/query_shape_cache.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rpc/semilattice/view/field.hpp"
 #include "rpc/semilattice/watchable.hpp"
@@ -32,11 +33,13 @@ RDB_IMPL_SERIALIZABLE_4_SINCE_v2_1(sindex_config_t,
 void sindex_status_t::accum(const sindex_status_t &other) {
     progress_numerator += other.progress_numerator;
     progress_denominator += other.progress_denominator;
+    rows_per_second += other.rows_per_second;
     ready &= other.ready;
     start_time = std::min(start_time, other.start_time);
     rassert(outdated == other.outdated);
 }
 
+// `rows_per_second` stays local, see the comment in `sindex_status_t`.
 RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(sindex_status_t,
     progress_numerator, progress_denominator, ready, outdated, start_time);
 
@@ -59,6 +62,8 @@ rdb_context_t::rdb_context_t()
       cluster_interface(nullptr),
       manager(nullptr),
       reql_http_proxy(),
+      io_backender(nullptr),
+      base_path(""),
       stats(&get_global_perfmon_collection()) { }
 
 rdb_context_t::rdb_context_t(
@@ -70,6 +75,8 @@ rdb_context_t::rdb_context_t(
       cluster_interface(_cluster_interface),
       manager(nullptr),
       reql_http_proxy(),
+      io_backender(nullptr),
+      base_path(""),
       stats(&get_global_perfmon_collection()) {
     init_auth_watchables(auth_semilattice_view);
 }
@@ -81,11 +88,15 @@ rdb_context_t::rdb_context_t(
         boost::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
             auth_semilattice_view,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy)
+        const std::string &_reql_http_proxy,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path)
     : extproc_pool(_extproc_pool),
       cluster_interface(_cluster_interface),
       manager(_mailbox_manager),
       reql_http_proxy(_reql_http_proxy),
+      io_backender(_io_backender),
+      base_path(_base_path),
       stats(global_stats) {
     init_auth_watchables(auth_semilattice_view);
 }
@@ -109,6 +120,10 @@ std::set<ql::query_cache_t *> *rdb_context_t::get_query_caches_for_this_thread()
     return query_caches.get();
 }
 
+ql::query_shape_cache_t *rdb_context_t::get_query_shape_cache_for_this_thread() {
+    return query_shape_caches.get();
+}
+
 clone_ptr_t<watchable_t<auth_semilattice_metadata_t>>
         rdb_context_t::get_auth_watchable() const{
     return m_cross_thread_auth_watchables[get_thread_id().threadnum]->get_watchable();
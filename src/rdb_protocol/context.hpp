@@ -25,6 +25,7 @@
 #include "rdb_protocol/geo/lon_lat_types.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/wire_func.hpp"
+#include "utils.hpp"
 
 namespace auth {
 
@@ -47,6 +48,7 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
 class auth_semilattice_metadata_t;
 class ellipsoid_spec_t;
 class extproc_pool_t;
+class io_backender_t;
 class name_string_t;
 class namespace_interface_t;
 template <class> class cross_thread_watchable_variable_t;
@@ -84,12 +86,17 @@ public:
     sindex_status_t() :
         progress_numerator(0),
         progress_denominator(0),
+        rows_per_second(0),
         ready(true),
         outdated(false),
         start_time(-1) { }
     void accum(const sindex_status_t &other);
     double progress_numerator;
     double progress_denominator;
+    /* An estimate of the construction throughput, only valid when `ready` is false.
+    It isn't serialized, because servers running a previous version don't send it.
+    The jobs manager reads it from the local stores. */
+    double rows_per_second;
     bool ready;
     bool outdated;
     /* Note that `start_time` is only valid when `ready` is false, and while we
@@ -105,6 +112,7 @@ namespace ql {
 class configured_limits_t;
 class env_t;
 class query_cache_t;
+class query_shape_cache_t;
 class db_t : public single_threaded_countable_t<db_t> {
 public:
     db_t(uuid_u _id, const name_string_t &_name) : id(_id), name(_name) { }
@@ -435,7 +443,9 @@ public:
         boost::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
             auth_semilattice_view,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy);
+        const std::string &_reql_http_proxy,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path);
 
     ~rdb_context_t();
 
@@ -446,6 +456,12 @@ public:
 
     const std::string reql_http_proxy;
 
+    // Queries that don't fit into memory can spill data into temporary files in
+    // `base_path`. `io_backender` is NULL if they can't, which is the case on proxies
+    // and in unit tests.
+    io_backender_t *io_backender;
+    const base_path_t base_path;
+
     class stats_t {
     public:
         explicit stats_t(perfmon_collection_t *global_stats);
@@ -466,6 +482,8 @@ public:
 
     std::set<ql::query_cache_t *> *get_query_caches_for_this_thread();
 
+    ql::query_shape_cache_t *get_query_shape_cache_for_this_thread();
+
     clone_ptr_t<watchable_t<auth_semilattice_metadata_t>> get_auth_watchable() const;
 
 private:
@@ -478,6 +496,8 @@ private:
 
     one_per_thread_t<std::set<ql::query_cache_t *> > query_caches;
 
+    one_per_thread_t<ql::query_shape_cache_t> query_shape_caches;
+
     DISABLE_COPYING(rdb_context_t);
 };
 
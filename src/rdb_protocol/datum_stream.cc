@@ -1580,6 +1580,77 @@ bool array_datum_stream_t::is_array() const {
     return !is_grouped();
 }
 
+// EXTERNAL_SORT_DATUM_STREAM_T
+
+// Returns the function that creates the temporary file for each run of an
+// `external_sort_datum_stream_t`.
+static std::function<scoped_ptr_t<external_sorter_t<datum_t>::run_t>()>
+make_order_by_run_fn(rdb_context_t *ctx, perfmon_collection_t *perfmon_collection) {
+    return [ctx, perfmon_collection]() {
+        r_sanity_check(ctx != nullptr && ctx->io_backender != nullptr);
+        return make_scoped<external_sorter_t<datum_t>::run_t>(
+            ctx->io_backender,
+            serializer_filepath_t(ctx->base_path,
+                                  "order_by_" + uuid_to_str(generate_uuid())),
+            perfmon_collection);
+    };
+}
+
+external_sort_datum_stream_t::external_sort_datum_stream_t(env_t *env,
+                                                           lt_cmp_t _lt_cmp,
+                                                           backtrace_id_t bt)
+    : eager_datum_stream_t(bt),
+      lt_cmp(std::move(_lt_cmp)),
+      sorter(make_order_by_run_fn(env->get_rdb_ctx(), &perfmon_collection)) { }
+
+external_sort_datum_stream_t::~external_sort_datum_stream_t() { }
+
+bool external_sort_datum_stream_t::can_spill(env_t *env) {
+    return env->get_rdb_ctx() != nullptr
+        && env->get_rdb_ctx()->io_backender != nullptr;
+}
+
+void external_sort_datum_stream_t::add_run(env_t *env, std::vector<datum_t> *rows) {
+    profile::sampler_t sampler("Sorting rows and spilling them to disk.", env->trace);
+    sorter.add_run(rows, [&](const datum_t &l, const datum_t &r) {
+        return lt_cmp(env, &sampler, l, r);
+    });
+}
+
+bool external_sort_datum_stream_t::is_exhausted() const {
+    return sorter.is_exhausted();
+}
+feed_type_t external_sort_datum_stream_t::cfeed_type() const {
+    return feed_type_t::not_feed;
+}
+bool external_sort_datum_stream_t::is_infinite() const {
+    return false;
+}
+bool external_sort_datum_stream_t::is_array() const {
+    return false;
+}
+
+std::vector<datum_t>
+external_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+    std::vector<datum_t> v;
+    batcher_t batcher = batchspec.to_batcher();
+
+    profile::sampler_t sampler("Merging sorted rows.", env->trace);
+    auto less = [&](const datum_t &l, const datum_t &r) {
+        return lt_cmp(env, nullptr, l, r);
+    };
+    datum_t d;
+    while (sorter.next(&d, less)) {
+        batcher.note_el(d);
+        v.push_back(std::move(d));
+        if (batcher.should_send_batch()) {
+            break;
+        }
+        sampler.new_sample();
+    }
+    return v;
+}
+
 // INDEXED_SORT_DATUM_STREAM_T
 indexed_sort_datum_stream_t::indexed_sort_datum_stream_t(
     counted_t<datum_stream_t> stream,
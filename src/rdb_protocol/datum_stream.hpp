@@ -18,6 +18,8 @@
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/queue/unlimited_fifo.hpp"
 #include "containers/counted.hpp"
+#include "containers/disk_backed_queue.hpp"
+#include "containers/external_sort.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/changefeed.hpp"
 #include "rdb_protocol/context.hpp"
@@ -261,6 +263,36 @@ private:
     std::vector<datum_t> data;
 };
 
+/* `external_sort_datum_stream_t` sorts more rows than fit into an array. The rows are
+added in runs, which get sorted in memory and spilled to temporary files on disk by an
+`external_sorter_t`. The stream then merges the runs as it's read. Rows that compare
+equal stay in the order they were added in. */
+class external_sort_datum_stream_t : public eager_datum_stream_t {
+public:
+    external_sort_datum_stream_t(env_t *env, lt_cmp_t lt_cmp, backtrace_id_t bt);
+    ~external_sort_datum_stream_t();
+
+    // Whether rows can be spilled to disk in this environment.
+    static bool can_spill(env_t *env);
+
+    // Sorts `rows`, spills them and clears `rows`. This must only be called before the
+    // stream is read.
+    void add_run(env_t *env, std::vector<datum_t> *rows);
+
+    virtual bool is_exhausted() const;
+    virtual feed_type_t cfeed_type() const;
+    virtual bool is_infinite() const;
+
+private:
+    virtual bool is_array() const;
+    virtual std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec);
+
+    const lt_cmp_t lt_cmp;
+    perfmon_collection_t perfmon_collection;
+    external_sorter_t<datum_t> sorter;
+};
+
 struct coro_info_t;
 class coro_stream_t;
 
@@ -50,6 +50,10 @@ public:
                          right_bound_type == key_range_t::open ? ')' : ']');
     }
 
+    // These are meant for ordering ranges. Use `contains` to check for keys.
+    const datum_t &get_left_bound() const { return left_bound; }
+    const datum_t &get_right_bound() const { return right_bound; }
+
     key_range_t::bound_t left_bound_type, right_bound_type;
 
 private:
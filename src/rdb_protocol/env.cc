@@ -77,6 +77,7 @@ env_t::env_t(rdb_context_t *ctx,
       limits_(from_optargs(ctx, _interruptor, &global_optargs_)),
       reql_version_(reql_version_t::LATEST),
       regex_cache_(LRU_CACHE_SIZE),
+      literal_slots_(nullptr),
       return_empty_normal_batches(_return_empty_normal_batches),
       interruptor(_interruptor),
       trace(_trace),
@@ -97,6 +98,7 @@ env_t::env_t(signal_t *_interruptor,
         auth::user_context_t(auth::permissions_t(false, false, false, false))),
       reql_version_(reql_version),
       regex_cache_(LRU_CACHE_SIZE),
+      literal_slots_(nullptr),
       return_empty_normal_batches(_return_empty_normal_batches),
       interruptor(_interruptor),
       trace(NULL),
@@ -106,6 +108,25 @@ env_t::env_t(signal_t *_interruptor,
     rassert(interruptor != NULL);
 }
 
+env_t::env_t(signal_t *_interruptor,
+             reql_version_t reql_version,
+             configured_limits_t limits)
+    : global_optargs_(),
+      m_user_context(
+        auth::user_context_t(auth::permissions_t(false, false, false, false))),
+      limits_(std::move(limits)),
+      reql_version_(reql_version),
+      regex_cache_(LRU_CACHE_SIZE),
+      literal_slots_(nullptr),
+      return_empty_normal_batches(return_empty_normal_batches_t::NO),
+      interruptor(_interruptor),
+      trace(NULL),
+      evals_since_yield_(0),
+      rdb_ctx_(NULL),
+      eval_callback_(NULL) {
+    rassert(interruptor != NULL);
+}
+
 env_t::~env_t() { }
 
 void env_t::maybe_yield() {
@@ -22,6 +22,7 @@
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/optargs.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/term_storage.hpp"
 #include "rdb_protocol/val.hpp"
 #include "rdb_protocol/var_types.hpp"
 #include "rdb_protocol/wire_func.hpp"
@@ -61,6 +62,12 @@ public:
                    return_empty_normal_batches_t return_empty_normal_batches,
                    reql_version_t reql_version);
 
+    // Used for evaluating deterministic functions of another environment's query on
+    // other threads. It only carries over what those functions can depend on.
+    env_t(signal_t *interruptor,
+          reql_version_t reql_version,
+          configured_limits_t limits);
+
     ~env_t();
 
     // Will yield after EVALS_BEFORE_YIELD calls
@@ -119,6 +126,14 @@ public:
 
     reql_version_t reql_version() const { return reql_version_; }
 
+    // The values of the literal slots of a term tree that was taken from the query
+    // shape cache (see `query_shape_t`), or null if the term tree was compiled for
+    // this query, in which case its `datum_term_t`s hold the right values already.
+    const std::vector<datum_t> *literal_slots() const { return literal_slots_; }
+    void set_literal_slots(const std::vector<datum_t> *literal_slots) {
+        literal_slots_ = literal_slots;
+    }
+
 private:
     // The global optargs values passed to .run(...) in the Python, Ruby, and JS
     // drivers.
@@ -138,6 +153,8 @@ private:
     // query specific cache parameters; for example match regexes.
     regex_cache_t regex_cache_;
 
+    const std::vector<datum_t> *literal_slots_;
+
 public:
     const return_empty_normal_batches_t return_empty_normal_batches;
 
@@ -169,8 +186,12 @@ private:
 class compile_env_t {
 public:
     explicit compile_env_t(var_visibility_t &&_visibility)
-        : visibility(std::move(_visibility)) { }
+        : visibility(std::move(_visibility)), literal_slots(nullptr) { }
     var_visibility_t visibility;
+
+    // If this isn't null, literals found in it compile to `datum_term_t`s that
+    // read their value from `env_t::literal_slots()` when that is set.
+    const literal_slots_t *literal_slots;
 };
 
 // This is an environment for evaluating things that use variables in scope.  It
@@ -0,0 +1,173 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/field_dictionary.hpp"
+
+#include <string.h>
+
+#include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "rdb_protocol/datum.hpp"
+
+// The dictionary gets rewritten together with the rest of the metainfo on every write,
+// so it has to stay small. Field names that don't fit stay spelled out in the rows.
+const size_t FIELD_DICTIONARY_MAX_NAMES_SIZE = 2 * KILOBYTE;
+
+namespace ql {
+
+datum_field_dictionary_t::datum_field_dictionary_t() {
+    init();
+}
+
+datum_field_dictionary_t::datum_field_dictionary_t(
+        std::vector<datum_string_t> &&_names)
+    : names(std::move(_names)) {
+    init();
+}
+
+void datum_field_dictionary_t::init() {
+    total_names_size = 0;
+    std::vector<datum_t> strings;
+    strings.reserve(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        DEBUG_VAR auto res = ids.insert(std::make_pair(names[i], i));
+        rassert(res.second, "Duplicate name in the field dictionary.");
+        total_names_size += names[i].size();
+        strings.push_back(datum_t(names[i]));
+    }
+
+    write_message_t wm;
+    datum_serialize(&wm,
+                    datum_t(std::move(strings), configured_limits_t::unlimited),
+                    check_datum_serialization_errors_t::NO);
+    vector_stream_t stream;
+    stream.reserve(wm.size());
+    DEBUG_VAR int res = send_write_message(&stream, &wm);
+    rassert(!res);
+    serialized = stream.vector();
+
+    // Drop the type tag, which buffers of `BUF_R_ARRAY` datums don't include.
+    guarantee(!serialized.empty());
+    counted_t<shared_buf_t> new_buf = shared_buf_t::create(serialized.size() - 1);
+    memcpy(new_buf->data(), serialized.data() + 1, serialized.size() - 1);
+    buf = std::move(new_buf);
+}
+
+counted_t<const datum_field_dictionary_t> datum_field_dictionary_t::deserialize(
+        const std::vector<char> &serialized) {
+    buffer_read_stream_t stream(serialized.data(), serialized.size());
+    datum_t array;
+    guarantee_deserialization(datum_deserialize(&stream, &array),
+                              "field dictionary");
+    guarantee(array.get_type() == datum_t::R_ARRAY,
+              "Corrupted field dictionary in the metainfo.");
+
+    std::vector<datum_string_t> names;
+    names.reserve(array.arr_size());
+    for (size_t i = 0; i < array.arr_size(); ++i) {
+        datum_t name = array.get(i);
+        guarantee(name.get_type() == datum_t::R_STR,
+                  "Corrupted field dictionary in the metainfo.");
+        names.push_back(name.as_str());
+    }
+    return make_counted<const datum_field_dictionary_t>(std::move(names));
+}
+
+bool datum_field_dictionary_t::find(const datum_string_t &name, uint64_t *id_out) const {
+    auto it = ids.find(name);
+    if (it == ids.end()) {
+        return false;
+    }
+    *id_out = it->second;
+    return true;
+}
+
+counted_t<const datum_field_dictionary_t> datum_field_dictionary_t::with_names_added(
+        const std::set<datum_string_t> &new_names) const {
+    std::vector<datum_string_t> all_names = names;
+    for (const datum_string_t &name : new_names) {
+        if (ids.count(name) == 0) {
+            all_names.push_back(name);
+        }
+    }
+    return make_counted<const datum_field_dictionary_t>(std::move(all_names));
+}
+
+}  // namespace ql
+
+field_dictionary_manager_t::field_dictionary_manager_t()
+    : enabled(false),
+      dictionary(make_counted<const ql::datum_field_dictionary_t>()),
+      missing_fields_size(0) { }
+
+void field_dictionary_manager_t::set_enabled(bool _enabled) {
+    assert_thread();
+    enabled = _enabled;
+    if (!enabled) {
+        missing_fields.clear();
+        missing_fields_size = 0;
+    }
+}
+
+const counted_t<const ql::datum_field_dictionary_t> &
+field_dictionary_manager_t::get() const {
+    assert_thread();
+    return dictionary;
+}
+
+void field_dictionary_manager_t::load(
+        counted_t<const ql::datum_field_dictionary_t> &&_dictionary) {
+    assert_thread();
+    guarantee(_dictionary.has());
+    dictionary = std::move(_dictionary);
+}
+
+void field_dictionary_manager_t::add_missing_fields() {
+    assert_thread();
+    if (missing_fields.empty()) {
+        return;
+    }
+    dictionary = dictionary->with_names_added(missing_fields);
+    missing_fields.clear();
+    missing_fields_size = 0;
+}
+
+void field_dictionary_manager_t::note_missing_fields(
+        const std::set<datum_string_t> &names) {
+    assert_thread();
+    if (!enabled) {
+        return;
+    }
+    for (const datum_string_t &name : names) {
+        uint64_t id;
+        if (missing_fields.count(name) != 0 || dictionary->find(name, &id)) {
+            // Another writer might have reported it, or it was added since.
+            continue;
+        }
+        if (dictionary->names_size() + missing_fields_size + name.size()
+                > FIELD_DICTIONARY_MAX_NAMES_SIZE) {
+            continue;
+        }
+        missing_fields.insert(name);
+        missing_fields_size += name.size();
+    }
+}
+
+field_dictionary_writer_t::field_dictionary_writer_t(
+        field_dictionary_manager_t *_manager)
+    : manager(_manager) {
+    if (manager != nullptr && manager->enabled) {
+        dictionary = manager->get();
+    }
+}
+
+ql::serialization_result_t field_dictionary_writer_t::serialize(
+        write_message_t *wm, const ql::datum_t &row) {
+    // Check for errors to enforce the static array size limit when writing to disk
+    std::set<datum_string_t> missing_fields;
+    ql::serialization_result_t res =
+        datum_serialize(wm, row, ql::check_datum_serialization_errors_t::YES,
+                        dictionary.get(), &missing_fields);
+    if (!missing_fields.empty()) {
+        manager->note_missing_fields(missing_fields);
+    }
+    return res;
+}
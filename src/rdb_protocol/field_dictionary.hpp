@@ -0,0 +1,123 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_FIELD_DICTIONARY_HPP_
+#define RDB_PROTOCOL_FIELD_DICTIONARY_HPP_
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "containers/counted.hpp"
+#include "containers/shared_buffer.hpp"
+#include "rdb_protocol/datum_string.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+#include "threading.hpp"
+
+namespace ql {
+
+class datum_t;
+
+/* A `datum_field_dictionary_t` assigns small integer ids to the field names of a table.
+Rows that are serialized against it refer to their field names by id instead of spelling
+them out, which saves a lot of space for tables with fixed schemas and long field names.
+
+The dictionary is immutable. New names are only ever appended to a copy of it, so a row
+stays readable with every later version of the dictionary it was written against. */
+class datum_field_dictionary_t
+    : public single_threaded_countable_t<datum_field_dictionary_t> {
+public:
+    // Creates an empty dictionary.
+    datum_field_dictionary_t();
+    explicit datum_field_dictionary_t(std::vector<datum_string_t> &&names);
+
+    // Reads a dictionary in the format of `get_serialized()`.
+    static counted_t<const datum_field_dictionary_t> deserialize(
+        const std::vector<char> &serialized);
+
+    size_t size() const { return names.size(); }
+    // The sum of the lengths of the field names.
+    size_t names_size() const { return total_names_size; }
+
+    // Returns false if `name` doesn't have an id.
+    bool find(const datum_string_t &name, uint64_t *id_out) const;
+
+    // Returns a copy of the dictionary with the names appended that it doesn't have yet.
+    counted_t<const datum_field_dictionary_t> with_names_added(
+        const std::set<datum_string_t> &new_names) const;
+
+    // The dictionary serialized as an array of strings, which is how it's stored.
+    const std::vector<char> &get_serialized() const { return serialized; }
+
+    // What rows that get deserialized against this dictionary have attached to their
+    // buffers. It has the format of a `BUF_R_ARRAY` datum, so looking up a name by id
+    // takes constant time and doesn't copy the name.
+    const counted_t<const shared_buf_t> &get_buf() const { return buf; }
+
+private:
+    void init();
+
+    std::vector<datum_string_t> names;
+    std::map<datum_string_t, uint64_t> ids;
+    size_t total_names_size;
+    std::vector<char> serialized;
+    counted_t<const shared_buf_t> buf;
+
+    DISABLE_COPYING(datum_field_dictionary_t);
+};
+
+}  // namespace ql
+
+/* `field_dictionary_manager_t` keeps track of the field dictionary of a `store_t`. It's
+shared by the store's primary and sindex B-tree slices, and `store_metainfo_manager_t`
+stores it in the superblock metainfo.
+
+Writers report the field names they didn't find in the dictionary. Those get added the
+next time the metainfo is written. Since writers take the dictionary while they hold
+the superblock for writing (see `field_dictionary_writer_t`), any id that a row refers
+to is on disk in the same transaction as the row or in an earlier one. */
+class field_dictionary_manager_t : public home_thread_mixin_debug_only_t {
+public:
+    field_dictionary_manager_t();
+
+    // Whether new rows get serialized against the dictionary. Rows that already refer
+    // to it stay readable either way.
+    void set_enabled(bool enabled);
+
+    // The dictionary to deserialize rows with.
+    const counted_t<const ql::datum_field_dictionary_t> &get() const;
+
+    // These are called by `store_metainfo_manager_t`. `add_missing_fields()` must only
+    // be called while the superblock is held for writing, and the new dictionary must
+    // be written in the same transaction.
+    void load(counted_t<const ql::datum_field_dictionary_t> &&dictionary);
+    void add_missing_fields();
+
+private:
+    friend class field_dictionary_writer_t;
+
+    void note_missing_fields(const std::set<datum_string_t> &names);
+
+    bool enabled;
+    counted_t<const ql::datum_field_dictionary_t> dictionary;
+
+    // Names that will be added by `add_missing_fields()`, and their total length.
+    std::set<datum_string_t> missing_fields;
+    size_t missing_fields_size;
+
+    DISABLE_COPYING(field_dictionary_manager_t);
+};
+
+/* `field_dictionary_writer_t` serializes rows against the dictionary that was current
+when it was constructed, which must happen while the superblock is held for writing. If
+`manager` is NULL or the dictionary is disabled, rows get serialized without one. */
+class field_dictionary_writer_t {
+public:
+    explicit field_dictionary_writer_t(field_dictionary_manager_t *manager);
+
+    ql::serialization_result_t serialize(write_message_t *wm, const ql::datum_t &row);
+
+private:
+    field_dictionary_manager_t *manager;
+    counted_t<const ql::datum_field_dictionary_t> dictionary;
+};
+
+#endif  // RDB_PROTOCOL_FIELD_DICTIONARY_HPP_
@@ -99,6 +99,48 @@ bool reql_func_t::is_simple_selector() const {
     return body->is_simple_selector();
 }
 
+bool reql_func_t::is_field_getter(datum_string_t *field_out) const {
+    if (arg_names.size() != 1) {
+        return false;
+    }
+    const raw_term_t &src = body->get_src();
+    if ((src.type() != Term::BRACKET && src.type() != Term::GET_FIELD)
+        || src.num_args() != 2 || src.num_optargs() != 0) {
+        return false;
+    }
+    raw_term_t field = src.arg(1);
+    if (field.type() != Term::DATUM) {
+        return false;
+    }
+    datum_t field_datum = field.datum();
+    if (field_datum.get_type() != datum_t::R_STR) {
+        return false;
+    }
+
+    raw_term_t obj = src.arg(0);
+    if (obj.type() == Term::VAR) {
+        if (obj.num_args() != 1 || obj.arg(0).type() != Term::DATUM) {
+            return false;
+        }
+        datum_t var = obj.arg(0).datum();
+        if (var.get_type() != datum_t::R_NUM
+            || var.as_int() != arg_names[0].value) {
+            return false;
+        }
+    } else if (obj.type() == Term::IMPLICIT_VAR) {
+        // `r.row` only refers to the argument if this isn't a nested function.
+        if (!function_emits_implicit_variable(arg_names)
+            || captured_scope.compute_visibility().get_implicit_depth() != 0) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    *field_out = field_datum.as_str();
+    return true;
+}
+
 js_func_t::js_func_t(const std::string &_js_source,
                      uint64_t timeout_ms,
                      backtrace_id_t backtrace)
@@ -70,6 +70,13 @@ public:
         return false;
     }
 
+    // Returns true if the function just returns a field of its argument, like
+    // `r.row('x')` or the `GET_FIELD_SHORTCUT` for `'x'`, and sets `field_out` to the
+    // name of the field. Calling it on an object is then the same as `get_field()`.
+    virtual bool is_field_getter(UNUSED datum_string_t *field_out) const {
+        return false;
+    }
+
 protected:
     explicit func_t(backtrace_id_t bt);
 
@@ -110,6 +117,8 @@ public:
 
     bool is_simple_selector() const final;
 
+    bool is_field_getter(datum_string_t *field_out) const final;
+
 private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
     bool filter_helper(env_t *env, datum_t arg) const;
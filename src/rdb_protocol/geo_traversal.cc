@@ -133,7 +133,8 @@ continue_bool_t geo_intersecting_cb_t::on_candidate(
     }
 
     lazy_btree_val_t row(static_cast<const rdb_value_t *>(keyvalue.value()),
-                         keyvalue.expose_buf());
+                         keyvalue.expose_buf(),
+                         slice->field_dictionary);
     ql::datum_t val = row.get();
     slice->stats.pm_keys_read.record();
     slice->stats.pm_total_keys_read += 1;
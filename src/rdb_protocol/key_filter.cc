@@ -0,0 +1,151 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/key_filter.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "btree/depth_first_traversal.hpp"
+#include "btree/get_distribution.hpp"
+#include "btree/reql_specific.hpp"
+#include "buffer_cache/alt.hpp"
+#include "rdb_protocol/store.hpp"
+
+class key_filter_t::rebuild_traversal_cb_t : public depth_first_traversal_callback_t {
+public:
+    rebuild_traversal_cb_t(key_filter_t *_parent, uint64_t _rebuild_generation)
+        : parent(_parent), rebuild_generation(_rebuild_generation) { }
+
+    continue_bool_t handle_pair(scoped_key_value_t &&keyvalue, signal_t *) {
+        if (parent->generation != rebuild_generation) {
+            return continue_bool_t::ABORT;
+        }
+        const btree_key_t *key = keyvalue.key();
+        if (!parent->filter->may_contain(key->contents, key->size)) {
+            parent->filter->insert(key->contents, key->size);
+        }
+        return continue_bool_t::CONTINUE;
+    }
+
+private:
+    key_filter_t *const parent;
+    const uint64_t rebuild_generation;
+};
+
+key_filter_t::key_filter_t(store_t *_store)
+    : store(_store), enabled(false), ready(false), generation(0) { }
+
+key_filter_t::~key_filter_t() {
+    assert_thread();
+    set_filter(scoped_ptr_t<bloom_filter_t>());
+}
+
+void key_filter_t::set_enabled(bool _enabled) {
+    assert_thread();
+    if (_enabled == enabled) {
+        return;
+    }
+    enabled = _enabled;
+    if (enabled) {
+        start_rebuild(KEY_FILTER_MIN_CAPACITY);
+    } else {
+        // This also stops the rebuild, if there is one.
+        ++generation;
+        ready = false;
+        set_filter(scoped_ptr_t<bloom_filter_t>());
+    }
+}
+
+void key_filter_t::note_key_written(const store_key_t &key) {
+    assert_thread();
+    if (!filter.has() || filter->may_contain(key.contents(), key.size())) {
+        return;
+    }
+    filter->insert(key.contents(), key.size());
+    // A filter that is still being built gets checked once the rebuild is done.
+    if (ready && filter->num_inserted() > filter->capacity()) {
+        start_rebuild(filter->num_inserted());
+    }
+}
+
+bool key_filter_t::definitely_absent(const store_key_t &key) const {
+    assert_thread();
+    return ready && !filter->may_contain(key.contents(), key.size());
+}
+
+size_t key_filter_t::capacity() const {
+    assert_thread();
+    return filter.has() ? filter->capacity() : 0;
+}
+
+void key_filter_t::start_rebuild(size_t min_capacity) {
+    ++generation;
+    ready = false;
+    set_filter(scoped_ptr_t<bloom_filter_t>());
+    coro_t::spawn_sometime(std::bind(&key_filter_t::rebuild, this, generation,
+                                     min_capacity, store->drainer.lock()));
+}
+
+void key_filter_t::rebuild(uint64_t rebuild_generation,
+                           size_t min_capacity,
+                           auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    try {
+        // Estimate how many keys there are, so that the filter can be sized before the
+        // snapshot is taken.
+        int64_t key_count;
+        {
+            read_token_t token;
+            store->new_read_token(&token);
+            scoped_ptr_t<txn_t> txn;
+            scoped_ptr_t<real_superblock_t> superblock;
+            store->acquire_superblock_for_read(&token, &txn, &superblock,
+                                               keepalive.get_drain_signal(),
+                                               true /* use snapshot */);
+            std::vector<store_key_t> keys;
+            get_btree_key_distribution(superblock.get(), 2, &key_count, &keys);
+        }
+        if (rebuild_generation != generation) {
+            return;
+        }
+        set_filter(make_scoped<bloom_filter_t>(
+            2 * std::max<size_t>(min_capacity, std::max<int64_t>(key_count, 0)),
+            KEY_FILTER_BITS_PER_KEY));
+
+        // From here on, writes add their keys to the new filter. The superblock
+        // must only be acquired after this, and the txn must be destructed before the
+        // cache account.
+        cache_account_t cache_account =
+            store->cache->create_cache_account(KEY_FILTER_REBUILD_CACHE_PRIORITY);
+        read_token_t token;
+        store->new_read_token(&token);
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        store->acquire_superblock_for_read(&token, &txn, &superblock,
+                                           keepalive.get_drain_signal(),
+                                           true /* use snapshot */);
+        txn->set_account(&cache_account);
+
+        rebuild_traversal_cb_t cb(this, rebuild_generation);
+        btree_depth_first_traversal(
+            superblock.get(), key_range_t::universe(), &cb, access_t::read,
+            direction_t::FORWARD, release_superblock_t::RELEASE,
+            keepalive.get_drain_signal());
+        if (rebuild_generation != generation) {
+            return;
+        }
+        if (filter->num_inserted() > filter->capacity()) {
+            start_rebuild(filter->num_inserted());
+        } else {
+            ready = true;
+        }
+    } catch (const interrupted_exc_t &) {
+        // The store is shutting down.
+    }
+}
+
+void key_filter_t::set_filter(scoped_ptr_t<bloom_filter_t> &&new_filter) {
+    filter = std::move(new_filter);
+    store->cache->set_external_memory_size(filter.has() ? filter->memory_size() : 0);
+}
@@ -0,0 +1,78 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_KEY_FILTER_HPP_
+#define RDB_PROTOCOL_KEY_FILTER_HPP_
+
+#include "btree/keys.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "containers/bloom_filter.hpp"
+#include "containers/scoped.hpp"
+#include "threading.hpp"
+
+class store_t;
+
+/* `key_filter_t` keeps a bloom filter of the primary keys of a `store_t`, so that point
+reads of keys that don't exist can skip descending the primary B-tree, and batches of
+new keys can be inserted without checking their key range first (see
+`rdb_batched_insert_into_empty_range()`). It's enabled per table with the
+`"srh/key_filter"` setting. Whenever it gets enabled, which includes loading the table,
+it gets built by traversing a snapshot of the primary B-tree. Until that is done it
+doesn't answer any lookups. Keys are never removed from the filter, so deleted keys
+turn into false positives. Once more keys were added than the filter has room for, it
+gets rebuilt with twice the capacity.
+
+Writers add their key while they hold the superblock for writing, before they descend
+the B-tree, and lookups happen while the superblock is held without a snapshot. So if
+a key isn't in the filter, there's no earlier write that could have created it. Since
+the filter gets created before the rebuild acquires its snapshot, every key is either
+in the snapshot or written after the filter was created.
+
+The memory of the filter gets accounted to the store's cache, which evicts pages to
+make room for it. */
+class key_filter_t : public home_thread_mixin_debug_only_t {
+public:
+    explicit key_filter_t(store_t *store);
+    ~key_filter_t();
+
+    // Starts building the filter if it wasn't enabled before, and frees it if it
+    // gets disabled.
+    void set_enabled(bool enabled);
+
+    // Must be called while the superblock is held for writing, before a write that may
+    // create a row with `key` descends the primary B-tree.
+    void note_key_written(const store_key_t &key);
+
+    // Returns `true` if there's no row with `key`. Must be called while the superblock
+    // is held without a snapshot. Always returns `false` while the filter is disabled
+    // or being built.
+    bool definitely_absent(const store_key_t &key) const;
+
+    // The number of keys the filter is sized for. 0 while the filter is disabled, and
+    // while a rebuild estimates its size.
+    size_t capacity() const;
+
+private:
+    class rebuild_traversal_cb_t;
+
+    // Frees the current filter and spawns a coroutine that builds a new one for at
+    // least `min_capacity` keys.
+    void start_rebuild(size_t min_capacity);
+    void rebuild(uint64_t rebuild_generation,
+                 size_t min_capacity,
+                 auto_drainer_t::lock_t keepalive);
+    void set_filter(scoped_ptr_t<bloom_filter_t> &&new_filter);
+
+    store_t *const store;
+
+    bool enabled;
+    // Empty while the filter is disabled, and while a rebuild estimates its size.
+    scoped_ptr_t<bloom_filter_t> filter;
+    // Whether `filter` has all the keys of the store.
+    bool ready;
+    // Incremented by every rebuild, so that outdated rebuilds stop. The rebuilds hold
+    // a lock on the drainer of the store, which stops them when the store shuts down.
+    uint64_t generation;
+
+    DISABLE_COPYING(key_filter_t);
+};
+
+#endif  // RDB_PROTOCOL_KEY_FILTER_HPP_
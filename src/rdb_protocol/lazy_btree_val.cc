@@ -4,8 +4,10 @@
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/versioned.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
+#include "rdb_protocol/field_dictionary.hpp"
 
-ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
+ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent,
+                     const field_dictionary_manager_t *field_dictionary) {
     // TODO: Just use deserialize_from_blob?
     rdb_blob_wrapper_t blob(parent.cache()->max_block_size(),
                             const_cast<rdb_value_t *>(value)->value_ref(),
@@ -17,8 +19,10 @@ ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
     buffer_group_t buffer_group;
     blob.expose_all(parent, access_t::read, &buffer_group, &acq_group);
     buffer_group_read_stream_t read_stream(const_view(&buffer_group));
-    archive_result_t res
-        = datum_deserialize(&read_stream, &data);
+    archive_result_t res = datum_deserialize(
+        &read_stream,
+        field_dictionary == NULL ? NULL : field_dictionary->get().get(),
+        &data);
     guarantee_deserialization(res, "rdb value");
 
     return data;
@@ -27,9 +31,11 @@ ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
 const ql::datum_t &lazy_btree_val_t::get() const {
     guarantee(pointee.has());
     if (!pointee->ptr.has()) {
-        pointee->ptr = get_data(pointee->rdb_value, pointee->parent);
+        pointee->ptr = get_data(pointee->rdb_value, pointee->parent,
+                                pointee->field_dictionary);
         pointee->rdb_value = NULL;
         pointee->parent = buf_parent_t();
+        pointee->field_dictionary = NULL;
     }
     return pointee->ptr;
 }
@@ -27,18 +27,25 @@ public:
     }
 };
 
+class field_dictionary_manager_t;
+
+// `field_dictionary` is the field dictionary of the table the value belongs to, if it
+// has one.
 ql::datum_t get_data(const rdb_value_t *value,
-                     buf_parent_t parent);
+                     buf_parent_t parent,
+                     const field_dictionary_manager_t *field_dictionary);
 
 class lazy_btree_val_pointee_t
         : public single_threaded_countable_t<lazy_btree_val_pointee_t> {
-    lazy_btree_val_pointee_t(const rdb_value_t *_rdb_value, buf_parent_t _parent)
-        : rdb_value(_rdb_value), parent(_parent) {
+    lazy_btree_val_pointee_t(const rdb_value_t *_rdb_value, buf_parent_t _parent,
+                             const field_dictionary_manager_t *_field_dictionary)
+        : rdb_value(_rdb_value), parent(_parent),
+          field_dictionary(_field_dictionary) {
         guarantee(rdb_value != NULL);
     }
 
     explicit lazy_btree_val_pointee_t(const ql::datum_t &_ptr)
-        : ptr(_ptr), rdb_value(NULL), parent() {
+        : ptr(_ptr), rdb_value(NULL), parent(), field_dictionary(NULL) {
         guarantee(ptr.has());
     }
 
@@ -51,6 +58,7 @@ class lazy_btree_val_pointee_t
     // the transaction with which to load it.  Non-NULL only if ptr is empty.
     const rdb_value_t *rdb_value;
     buf_parent_t parent;
+    const field_dictionary_manager_t *field_dictionary;
 
     DISABLE_COPYING(lazy_btree_val_pointee_t);
 };
@@ -60,8 +68,10 @@ public:
     explicit lazy_btree_val_t(const ql::datum_t &ptr)
         : pointee(new lazy_btree_val_pointee_t(ptr)) { }
 
-    lazy_btree_val_t(const rdb_value_t *rdb_value, buf_parent_t parent)
-        : pointee(new lazy_btree_val_pointee_t(rdb_value, parent)) { }
+    lazy_btree_val_t(const rdb_value_t *rdb_value, buf_parent_t parent,
+                     const field_dictionary_manager_t *field_dictionary)
+        : pointee(new lazy_btree_val_pointee_t(rdb_value, parent,
+                                               field_dictionary)) { }
 
     const ql::datum_t &get() const;
     bool references_parent() const;
@@ -87,6 +87,7 @@ static const std::set<std::string> acceptable_optargs({
     "overwrite",
     "page",
     "page_limit",
+    "parallel",
     "params",
     "primary_key",
     "primary_replica_tag",
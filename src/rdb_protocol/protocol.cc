@@ -29,11 +29,15 @@ store_key_t key_max(sorting_t sorting) {
 
 namespace rdb_protocol {
 
+enum class bulk_construction_t { NO, YES };
+
 void post_construct_and_drain_queue(
         auto_drainer_t::lock_t lock,
         uuid_u sindex_id_to_bring_up_to_date,
         key_range_t *construction_range_inout,
+        bulk_construction_t bulk,
         int64_t max_pairs_to_construct,
+        sindex_construction_progress_t *progress_inout,
         store_t *store,
         scoped_ptr_t<disk_backed_queue_wrapper_t<rdb_modification_report_t> >
             &&mod_queue)
@@ -66,14 +70,14 @@ void resume_construct_sindex(
     // construction.
     distribution_progress_estimator_t progress_estimator(
         store, store_keepalive.get_drain_signal());
-    double current_progress =
-        progress_estimator.estimate_progress(construct_range.left);
+    sindex_construction_progress_t progress;
+    progress.progress = progress_estimator.estimate_progress(construct_range.left);
     map_insertion_sentry_t<
         store_t::sindex_context_map_t::key_type,
         store_t::sindex_context_map_t::mapped_type> sindex_context_sentry(
             store->get_sindex_context_map(),
             sindex_to_construct,
-            std::make_pair(current_microtime(), &current_progress));
+            &progress);
 
     /* We start by clearing out any residual data in the index left behind by a previous
     post construction process (if the server got terminated in the middle). */
@@ -99,9 +103,13 @@ void resume_construct_sindex(
     certain number of primary keys and put the corresponding entries into the secondary
     index. While this happens, we use a queue to keep track of any writes to the range
     we're constructing. We then drain the queue and atomically delete it, before we
-    start the next pass. */
+    start the next pass.
+    The first pass constructs the whole range in bulk (see
+    `bulk_construct_secondary_index_range`), so there's usually only one pass. If it
+    doesn't complete, the remaining passes only construct a limited number of pairs. */
     const int64_t PAIRS_TO_CONSTRUCT_PER_PASS = 512;
     key_range_t remaining_range = construct_range;
+    bulk_construction_t bulk = bulk_construction_t::YES;
     while (!remaining_range.is_empty()) {
         scoped_ptr_t<disk_backed_queue_wrapper_t<rdb_modification_report_t> > mod_queue;
         {
@@ -163,15 +171,132 @@ void resume_construct_sindex(
             store_keepalive,
             sindex_to_construct,
             &remaining_range,
+            bulk,
             PAIRS_TO_CONSTRUCT_PER_PASS,
+            &progress,
             store,
             std::move(mod_queue));
 
+        bulk = bulk_construction_t::NO;
+
         // Update the progress value
-        current_progress = progress_estimator.estimate_progress(remaining_range.left);
+        progress.progress = progress_estimator.estimate_progress(remaining_range.left);
+    }
+}
+
+/* Pops up to `max_reports` modifications from `mod_queue` and applies them to
+`sindexes`, which must have been acquired for write in `txn`. */
+static void apply_queued_modifications(
+        store_t *store,
+        const store_t::sindex_access_vector_t &sindexes,
+        txn_t *txn,
+        const key_range_t &construction_range,
+        disk_backed_queue_wrapper_t<rdb_modification_report_t> *mod_queue,
+        size_t max_reports,
+        signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    for (size_t i = 0; i < max_reports && mod_queue->size() > 0; ++i) {
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+        // The `disk_backed_queue_wrapper` can sometimes be non-empty, but not
+        // have a value available because it's still loading from disk.
+        // In that case we must wait until a value becomes available.
+        while (!mod_queue->available->get()) {
+            // TODO: The availability_callback_t interface on passive producers
+            //   is difficult to use and should be simplified.
+            struct on_availability_t : public availability_callback_t {
+                void on_source_availability_changed() {
+                    cond.pulse_if_not_already_pulsed();
+                }
+                cond_t cond;
+            } on_availability;
+            mod_queue->available->set_callback(&on_availability);
+            try {
+                wait_interruptible(&on_availability.cond, interruptor);
+            } catch (const interrupted_exc_t &) {
+                mod_queue->available->unset_callback();
+                throw;
+            }
+            mod_queue->available->unset_callback();
+        }
+        rdb_modification_report_t mod_report = mod_queue->pop();
+        // We only need to apply modifications that fall in the range that
+        // has actually been constructed.
+        // If it's in the range that is still to be constructed we ignore it.
+        if (!construction_range.contains_key(mod_report.primary_key)) {
+            rdb_post_construction_deletion_context_t deletion_context;
+            rdb_update_sindexes(store,
+                                sindexes,
+                                &mod_report,
+                                txn,
+                                &deletion_context,
+                                NULL,
+                                NULL,
+                                NULL);
+        }
     }
 }
 
+/* Applies up to `max_reports` modifications from `mod_queue` in a transaction of its
+own, without deregistering the queue. Writes to the store are blocked while this
+happens, so `max_reports` should be small. */
+static void drain_mod_queue_chunk(
+        store_t *store,
+        const std::set<uuid_u> &sindex_ids,
+        const key_range_t &construction_range,
+        disk_backed_queue_wrapper_t<rdb_modification_report_t> *mod_queue,
+        size_t max_reports,
+        signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    write_token_t token;
+    store->new_write_token(&token);
+
+    scoped_ptr_t<txn_t> queue_txn;
+    scoped_ptr_t<real_superblock_t> queue_superblock;
+
+    // We use HARD durability for the same reason as the final drain in
+    // `post_construct_and_drain_queue`.
+    store->acquire_superblock_for_write(
+        2 + max_reports,
+        write_durability_t::HARD,
+        &token,
+        &queue_txn,
+        &queue_superblock,
+        interruptor);
+
+    buf_lock_t queue_sindex_block(queue_superblock->expose_buf(),
+                                  queue_superblock->get_sindex_block_id(),
+                                  access_t::write);
+
+    queue_superblock->release();
+
+    store_t::sindex_access_vector_t sindexes;
+    store->acquire_sindex_superblocks_for_write(
+            sindex_ids,
+            &queue_sindex_block,
+            &sindexes);
+    if (sindexes.empty()) {
+        throw interrupted_exc_t();
+    }
+    // See the final drain in `post_construct_and_drain_queue`.
+    for (auto &&access : sindexes) {
+        access->sindex.needs_post_construction_range = construction_range;
+    }
+
+    new_mutex_in_line_t acq = store->get_in_line_for_sindex_queue(&queue_sindex_block);
+    acq.acq_signal()->wait_lazily_unordered();
+
+    apply_queued_modifications(
+        store,
+        sindexes,
+        queue_txn.get(),
+        construction_range,
+        mod_queue,
+        max_reports,
+        interruptor);
+}
+
 /* This function is used by resume_construct_sindex. It traverses the primary btree
 and creates entries in the given secondary index. It then applies outstanding changes
 from the mod_queue and deregisters it. */
@@ -179,7 +304,9 @@ void post_construct_and_drain_queue(
         auto_drainer_t::lock_t lock,
         uuid_u sindex_id_to_bring_up_to_date,
         key_range_t *construction_range_inout,
+        bulk_construction_t bulk,
         int64_t max_pairs_to_construct,
+        sindex_construction_progress_t *progress_inout,
         store_t *store,
         scoped_ptr_t<disk_backed_queue_wrapper_t<rdb_modification_report_t> >
             &&mod_queue)
@@ -196,17 +323,42 @@ void post_construct_and_drain_queue(
         const size_t MOD_QUEUE_SIZE_LIMIT = 16;
         // This constructs a part of the index and updates `construction_range_inout`
         // to the range that's still remaining.
-        post_construct_secondary_index_range(
-            store,
-            sindexes_to_bring_up_to_date,
-            construction_range_inout,
-            // Abort if the mod_queue gets larger than the `MOD_QUEUE_SIZE_LIMIT`, or
-            // we've constructed `max_pairs_to_construct` pairs.
-            [&](int64_t pairs_constructed) {
-                return pairs_constructed >= max_pairs_to_construct
-                    || mod_queue->size() > MOD_QUEUE_SIZE_LIMIT;
-            },
-            lock.get_drain_signal());
+        if (bulk == bulk_construction_t::YES) {
+            // The mod queue isn't limited while the bulk construction runs, since it's
+            // stored on disk once it gets large. It can grow very long though, and the
+            // final drain below blocks all writes to the store. So we first apply it
+            // in small transactions until it's as short as after a regular pass.
+            bulk_construct_secondary_index_range(
+                store,
+                sindexes_to_bring_up_to_date,
+                construction_range_inout,
+                progress_inout,
+                lock.get_drain_signal());
+            const size_t MOD_QUEUE_REPORTS_PER_CHUNK = 256;
+            while (mod_queue->size() > MOD_QUEUE_SIZE_LIMIT) {
+                drain_mod_queue_chunk(
+                    store,
+                    sindexes_to_bring_up_to_date,
+                    *construction_range_inout,
+                    mod_queue.get(),
+                    MOD_QUEUE_REPORTS_PER_CHUNK,
+                    lock.get_drain_signal());
+            }
+        } else {
+            const double start_rows_done = progress_inout->rows_done;
+            post_construct_secondary_index_range(
+                store,
+                sindexes_to_bring_up_to_date,
+                construction_range_inout,
+                // Abort if the mod_queue gets larger than the `MOD_QUEUE_SIZE_LIMIT`,
+                // or we've constructed `max_pairs_to_construct` pairs.
+                [&](int64_t pairs_constructed) {
+                    progress_inout->rows_done = start_rows_done + pairs_constructed;
+                    return pairs_constructed >= max_pairs_to_construct
+                        || mod_queue->size() > MOD_QUEUE_SIZE_LIMIT;
+                },
+                lock.get_drain_signal());
+        }
 
         // Drain the queue.
         {
@@ -266,48 +418,14 @@ void post_construct_and_drain_queue(
                 store->get_in_line_for_sindex_queue(&queue_sindex_block);
             acq.acq_signal()->wait_lazily_unordered();
 
-            while (mod_queue->size() > 0) {
-                if (lock.get_drain_signal()->is_pulsed()) {
-                    throw interrupted_exc_t();
-                }
-                // The `disk_backed_queue_wrapper` can sometimes be non-empty, but not
-                // have a value available because it's still loading from disk.
-                // In that case we must wait until a value becomes available.
-                while (!mod_queue->available->get()) {
-                    // TODO: The availability_callback_t interface on passive producers
-                    //   is difficult to use and should be simplified.
-                    struct on_availability_t : public availability_callback_t {
-                        void on_source_availability_changed() {
-                            cond.pulse_if_not_already_pulsed();
-                        }
-                        cond_t cond;
-                    } on_availability;
-                    mod_queue->available->set_callback(&on_availability);
-                    try {
-                        wait_interruptible(&on_availability.cond,
-                                           lock.get_drain_signal());
-                    } catch (const interrupted_exc_t &) {
-                        mod_queue->available->unset_callback();
-                        throw;
-                    }
-                    mod_queue->available->unset_callback();
-                }
-                rdb_modification_report_t mod_report = mod_queue->pop();
-                // We only need to apply modifications that fall in the range that
-                // has actually been constructed.
-                // If it's in the range that is still to be constructed we ignore it.
-                if (!construction_range_inout->contains_key(mod_report.primary_key)) {
-                    rdb_post_construction_deletion_context_t deletion_context;
-                    rdb_update_sindexes(store,
-                                        sindexes,
-                                        &mod_report,
-                                        queue_txn.get(),
-                                        &deletion_context,
-                                        NULL,
-                                        NULL,
-                                        NULL);
-                }
-            }
+            apply_queued_modifications(
+                store,
+                sindexes,
+                queue_txn.get(),
+                *construction_range_inout,
+                mod_queue.get(),
+                mod_queue->size(),
+                lock.get_drain_signal());
 
             // Mark parts of the index up to date (except for what remains in
             // `construction_range_inout`).
@@ -1,10 +1,12 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/query_cache.hpp"
 
+#include "clustering/administration/admin_op_exc.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/pseudo_time.hpp"
 #include "rdb_protocol/response.hpp"
 #include "rdb_protocol/term_walker.hpp"
+#include "rdb_protocol/val.hpp"
 
 namespace ql {
 
@@ -46,20 +48,67 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_p
             backtrace_registry_t::EMPTY_BACKTRACE);
     }
 
+    // Queries with the same shape as an earlier one reuse its term tree, with the
+    // literals that differ bound to its slots at evaluation time.
+    query_shape_cache_t *shape_cache = rdb_ctx->get_query_shape_cache_for_this_thread();
+    std::string shape_key;
+    std::vector<const rapidjson::Value *> slot_values;
+    const bool cacheable =
+        query_params->term_storage->query_shape(&shape_key, &slot_values);
+    counted_t<const query_shape_t> shape;
+    if (cacheable) {
+        shape = shape_cache->find(shape_key);
+    }
+
     global_optargs_t global_optargs;
     counted_t<const term_t> term_tree;
+    std::vector<datum_t> literal_slots;
     try {
-        query_params->term_storage->preprocess();
-        global_optargs = query_params->term_storage->global_optargs();
-
-        compile_env_t compile_env((var_visibility_t()));
-        term_tree = compile_term(&compile_env, query_params->term_storage->root_term());
-
+        if (shape.has()) {
+            guarantee(shape->num_slots == slot_values.size());
+            literal_slots.reserve(slot_values.size());
+            for (const rapidjson::Value *value : slot_values) {
+                // This matches how `datum_term_t` parses its literal.
+                literal_slots.push_back(to_datum(*value,
+                                                 configured_limits_t::unlimited,
+                                                 reql_version_t::LATEST));
+            }
+            global_optargs = shape->global_optargs;
+            term_tree = shape->term_tree;
+        } else {
+            query_params->term_storage->preprocess();
+            global_optargs = query_params->term_storage->global_optargs();
+
+            // The term walker rewrites literals in place, so `slot_values` still
+            // point at them.
+            literal_slots_t slot_indexes;
+            for (size_t i = 0; i < slot_values.size(); ++i) {
+                slot_indexes.insert(std::make_pair(slot_values[i], i));
+            }
+            compile_env_t compile_env((var_visibility_t()));
+            if (cacheable) {
+                compile_env.literal_slots = &slot_indexes;
+            }
+            term_tree = compile_term(&compile_env,
+                                     query_params->term_storage->root_term());
+
+            if (cacheable) {
+                shape = make_counted<query_shape_t>(
+                    std::move(query_params->term_storage),
+                    global_optargs,
+                    term_tree,
+                    slot_values.size());
+                shape_cache->insert(shape_key, shape);
+            }
+        }
     } catch (const exc_t &e) {
+        const term_storage_t *term_storage = shape.has()
+            ? shape->term_storage.get()
+            : query_params->term_storage.get();
         throw bt_exc_t(Response::COMPILE_ERROR,
             e.get_error_type(),
             e.what(),
-            query_params->term_storage->backtrace_registry().datum_backtrace(e));
+            term_storage->backtrace_registry().datum_backtrace(e));
     } catch (const datum_exc_t &e) {
         throw bt_exc_t(Response::COMPILE_ERROR,
                        e.get_error_type(),
@@ -68,7 +117,9 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_p
     }
     scoped_ptr_t<entry_t> entry(new entry_t(query_params,
                                             std::move(global_optargs),
-                                            std::move(term_tree)));
+                                            std::move(term_tree),
+                                            std::move(shape),
+                                            std::move(literal_slots)));
 
     scoped_ptr_t<ref_t> ref(new ref_t(this,
                                       query_params->token,
@@ -99,6 +150,60 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::get(query_params_t *query_para
                                          interruptor));
 }
 
+bool query_cache_t::run_point_get(query_params_t *query_params,
+                                  response_t *res,
+                                  signal_t *interruptor) {
+    guarantee(this == query_params->query_cache);
+    point_get_query_t point_get;
+    if (query_params->profile ||
+        queries.find(query_params->token) != queries.end() ||
+        !query_params->term_storage->match_point_get(&point_get)) {
+        return false;
+    }
+    name_string_t db_name;
+    name_string_t table_name;
+    if (!db_name.assign_value(point_get.db_name) ||
+        !table_name.assign_value(point_get.table_name)) {
+        return false;
+    }
+
+    try {
+        env_t env(rdb_ctx,
+                  return_empty_normal_batches,
+                  interruptor,
+                  global_optargs_t(),
+                  user_context,
+                  nullptr);
+
+        admin_err_t error;
+        counted_t<const db_t> db;
+        counted_t<base_table_t> base_table;
+        if (!env.reql_cluster_interface()->db_find(
+                db_name, interruptor, &db, &error) ||
+            !env.reql_cluster_interface()->table_find(
+                table_name, db, boost::none, interruptor, &base_table, &error)) {
+            return false;
+        }
+        counted_t<table_t> table = make_counted<table_t>(
+            std::move(base_table), db, table_name.str(), read_mode_t::SINGLE,
+            backtrace_id_t::empty());
+        datum_t key = to_datum(*point_get.key, env.limits(), reql_version_t::LATEST);
+        datum_t row = single_selection_t::from_key(
+            &env, backtrace_id_t::empty(), table, key)->get();
+
+        res->set_type(Response::SUCCESS_ATOM);
+        res->set_data(row);
+    } catch (const interrupted_exc_t &) {
+        throw;
+    } catch (const std::exception &) {
+        // A point read has no side effects, so it's safe to run it again.
+        return false;
+    }
+
+    query_params->maybe_release_query_id();
+    return true;
+}
+
 void query_cache_t::noreply_wait(const query_params_t &query_params,
                                  signal_t *interruptor) {
     guarantee(this == query_params.query_cache);
@@ -204,6 +309,9 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
             entry->global_optargs,
             query_cache->get_user_context(),
             trace.get_or_null());
+        if (!entry->literal_slots.empty()) {
+            env.set_literal_slots(&entry->literal_slots);
+        }
 
         if (entry->state == entry_t::state_t::START) {
             run(&env, res);
@@ -251,13 +359,13 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
         throw bt_exc_t(Response::RUNTIME_ERROR,
                        ex.get_error_type(),
                        ex.what(),
-                       entry->term_storage->backtrace_registry().datum_backtrace(ex));
+                       entry->backtrace_registry().datum_backtrace(ex));
     } catch (const datum_exc_t &ex) {
         query_cache->terminate_internal(entry);
         throw bt_exc_t(Response::RUNTIME_ERROR,
                        ex.get_error_type(),
                        ex.what(),
-                       entry->term_storage->backtrace_registry().datum_backtrace(
+                       entry->backtrace_registry().datum_backtrace(
                             backtrace_id_t::empty(), 0));
     } catch (const std::exception &ex) {
         query_cache->terminate_internal(entry);
@@ -357,7 +465,9 @@ void query_cache_t::ref_t::serve(env_t *env, response_t *res) {
 
 query_cache_t::entry_t::entry_t(query_params_t *query_params,
                                 global_optargs_t &&_global_optargs,
-                                counted_t<const term_t> &&_term_tree) :
+                                counted_t<const term_t> &&_term_tree,
+                                counted_t<const query_shape_t> &&_shape,
+                                std::vector<datum_t> &&_literal_slots) :
         state(state_t::START),
         interrupt_reason(interrupt_reason_t::UNKNOWN),
         job_id(generate_uuid()),
@@ -365,6 +475,11 @@ query_cache_t::entry_t::entry_t(query_params_t *query_params,
         profile(query_params->profile ? profile_bool_t::PROFILE :
                                         profile_bool_t::DONT_PROFILE),
         term_storage(std::move(query_params->term_storage)),
+        // If there is a shape, the term storage was either left unprocessed because
+        // the term tree came from the cache, or moved into the shape.
+        term_storage_preprocessed(!_shape.has()),
+        shape(std::move(_shape)),
+        literal_slots(std::move(_literal_slots)),
         global_optargs(std::move(_global_optargs)),
         start_time(current_microtime()),
         term_tree(std::move(_term_tree)),
@@ -372,4 +487,21 @@ query_cache_t::entry_t::entry_t(query_params_t *query_params,
 
 query_cache_t::entry_t::~entry_t() { }
 
+raw_term_t query_cache_t::entry_t::root_term() {
+    if (!term_storage.has()) {
+        return shape->term_storage->root_term();
+    }
+    if (!term_storage_preprocessed) {
+        term_storage->preprocess();
+        term_storage_preprocessed = true;
+    }
+    return term_storage->root_term();
+}
+
+const backtrace_registry_t &query_cache_t::entry_t::backtrace_registry() const {
+    return shape.has()
+        ? shape->term_storage->backtrace_registry()
+        : term_storage->backtrace_registry();
+}
+
 } // namespace ql
@@ -8,6 +8,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "arch/address.hpp"
 #include "clustering/administration/auth/user_context.hpp"
@@ -26,6 +27,7 @@
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/ql2.pb.h"
 #include "rdb_protocol/query_params.hpp"
+#include "rdb_protocol/query_shape_cache.hpp"
 #include "rdb_protocol/term.hpp"
 #include "rdb_protocol/term_storage.hpp"
 #include "rdb_protocol/wire_func.hpp"
@@ -88,6 +90,15 @@ public:
     scoped_ptr_t<ref_t> get(query_params_t *query_params,
                             signal_t *interruptor);
 
+    // Runs a `START` query that is a plain point `get` on a table (see
+    // `term_storage_t::match_point_get()`) without compiling it or adding it to the
+    // cache. Returns `false` if the query doesn't qualify or if running it fails in
+    // any way other than being interrupted; the caller should then run it through
+    // `create()`, which reports errors with proper backtraces.
+    bool run_point_get(query_params_t *query_params,
+                       response_t *res,
+                       signal_t *interruptor);
+
     void noreply_wait(const query_params_t &query_params,
                       signal_t *interruptor);
 
@@ -106,16 +117,37 @@ private:
     public:
         entry_t(query_params_t *query_params,
                 global_optargs_t &&_global_optargs,
-                counted_t<const term_t> &&_term_tree);
+                counted_t<const term_t> &&_term_tree,
+                counted_t<const query_shape_t> &&_shape,
+                std::vector<datum_t> &&_literal_slots);
         ~entry_t();
 
+        // The root term of the query, for the jobs table. This preprocesses the
+        // query's own term storage if the term tree was taken from the query shape
+        // cache. That doesn't block, because cached queries are too shallow for the
+        // term walker to need another stack.
+        raw_term_t root_term();
+
+        const backtrace_registry_t &backtrace_registry() const;
+
         enum class state_t { START, STREAM, DONE, DELETING } state;
         interrupt_reason_t interrupt_reason;
 
         const uuid_u job_id;
         const bool noreply;
         const profile_bool_t profile;
-        const scoped_ptr_t<const term_storage_t> term_storage;
+        // The query's own term storage. This is empty if it was moved into `shape`,
+        // and it is only preprocessed on demand if the term tree came from the
+        // query shape cache.
+        scoped_ptr_t<term_storage_t> term_storage;
+        bool term_storage_preprocessed;
+
+        // The shape the term tree belongs to, if the query could be cached.
+        const counted_t<const query_shape_t> shape;
+        // The values for the literal slots of `shape` if the term tree was taken from
+        // the cache, and empty otherwise.
+        const std::vector<datum_t> literal_slots;
+
         const global_optargs_t global_optargs;
         const microtime_t start_time;
 
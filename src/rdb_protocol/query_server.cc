@@ -40,6 +40,11 @@ void rdb_query_server_t::run_query(ql::query_params_t *query_params,
 
         switch (query_params->type) {
         case Query::START: {
+            // Point `get`s are the most common small query, so they skip compilation.
+            if (query_params->query_cache->run_point_get(
+                    query_params, response_out, interruptor)) {
+                break;
+            }
             scoped_ptr_t<ql::query_cache_t::ref_t> query_ref =
                 query_params->query_cache->create(query_params, interruptor);
             query_ref->fill_response(response_out);
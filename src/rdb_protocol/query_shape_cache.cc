@@ -0,0 +1,33 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/query_shape_cache.hpp"
+
+namespace ql {
+
+// The number of query shapes that are kept per thread.
+const size_t QUERY_SHAPE_CACHE_SIZE = 1024;
+
+query_shape_t::query_shape_t(scoped_ptr_t<term_storage_t> &&_term_storage,
+                             const global_optargs_t &_global_optargs,
+                             const counted_t<const term_t> &_term_tree,
+                             size_t _num_slots) :
+    term_storage(std::move(_term_storage)),
+    global_optargs(_global_optargs),
+    term_tree(_term_tree),
+    num_slots(_num_slots) { }
+
+query_shape_cache_t::query_shape_cache_t() : shapes(QUERY_SHAPE_CACHE_SIZE) { }
+
+counted_t<const query_shape_t> query_shape_cache_t::find(const std::string &key) {
+    auto it = shapes.find(key);
+    if (it == shapes.end()) {
+        return counted_t<const query_shape_t>();
+    }
+    return it->second;
+}
+
+void query_shape_cache_t::insert(const std::string &key,
+                                 counted_t<const query_shape_t> shape) {
+    shapes[key] = std::move(shape);
+}
+
+} // namespace ql
@@ -0,0 +1,56 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_QUERY_SHAPE_CACHE_HPP_
+#define RDB_PROTOCOL_QUERY_SHAPE_CACHE_HPP_
+
+#include <string>
+
+#include "containers/counted.hpp"
+#include "containers/lru_cache.hpp"
+#include "containers/scoped.hpp"
+#include "rdb_protocol/optargs.hpp"
+#include "rdb_protocol/term.hpp"
+#include "rdb_protocol/term_storage.hpp"
+
+namespace ql {
+
+// A `query_shape_t` is the compiled term tree of a query that can be rerun for other
+// queries with the same shape by binding new values to its literal slots (see
+// `term_storage_t::query_shape()` and `env_t::literal_slots()`). It owns the
+// preprocessed term storage of the query it was compiled from, since the term tree
+// points into it. The backtrace registry of that storage only depends on the shape of
+// the query, so it is also used to report errors for later queries.
+class query_shape_t : public single_threaded_countable_t<query_shape_t> {
+public:
+    query_shape_t(scoped_ptr_t<term_storage_t> &&_term_storage,
+                  const global_optargs_t &_global_optargs,
+                  const counted_t<const term_t> &_term_tree,
+                  size_t _num_slots);
+
+    const scoped_ptr_t<const term_storage_t> term_storage;
+    const global_optargs_t global_optargs;
+    const counted_t<const term_t> term_tree;
+    const size_t num_slots;
+
+private:
+    DISABLE_COPYING(query_shape_t);
+};
+
+// There is one `query_shape_cache_t` per thread, shared by all the connections on
+// that thread (see `rdb_context_t::get_query_shape_cache_for_this_thread()`).
+class query_shape_cache_t {
+public:
+    query_shape_cache_t();
+
+    // Returns an empty `counted_t` if there is no shape for `key`.
+    counted_t<const query_shape_t> find(const std::string &key);
+    void insert(const std::string &key, counted_t<const query_shape_t> shape);
+
+private:
+    lru_cache_t<std::string, counted_t<const query_shape_t> > shapes;
+
+    DISABLE_COPYING(query_shape_cache_t);
+};
+
+} // namespace ql
+
+#endif  // RDB_PROTOCOL_QUERY_SHAPE_CACHE_HPP_
@@ -4,11 +4,13 @@
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "arch/runtime/coroutines.hpp"
 #include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/shared_buf_stream.hpp"
 #include "containers/archive/stl_types.hpp"
 #include "containers/archive/versioned.hpp"
 #include "containers/counted.hpp"
@@ -16,6 +18,7 @@
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/error.hpp"
+#include "rdb_protocol/field_dictionary.hpp"
 
 namespace ql {
 
@@ -38,6 +41,11 @@ enum class datum_serialized_type_t {
     UNINITIALIZED = 12,
     MINVAL = 13,
     MAXVAL = 14,
+    // A `BUF_R_OBJECT` whose object keys (including the ones of nested objects) refer
+    // to a field dictionary. Only used for the outermost datum. Older versions crash
+    // on this type, so files move to serializer version 2.4, which they refuse to
+    // open, once they store a field dictionary (see `store_metainfo_manager_t`).
+    DICT_BUF_R_OBJECT = 15,
 };
 
 // Objects and arrays use different word sizes for storing offsets,
@@ -74,7 +82,7 @@ struct size_tree_node_t {
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(datum_serialized_type_t, int8_t,
                                       datum_serialized_type_t::R_ARRAY,
-                                      datum_serialized_type_t::MAXVAL);
+                                      datum_serialized_type_t::DICT_BUF_R_OBJECT);
 
 serialization_result_t datum_serialize(write_message_t *wm,
                                        datum_serialized_type_t type) {
@@ -94,15 +102,28 @@ inline serialization_result_t operator |(const serialization_result_t &first,
                                                static_cast<int>(second));
 }
 
+// Object keys in a buffer that has a field dictionary attached start with a varint.
+// Zero means that the key is spelled out as a regular serialized string after it, and
+// anything else is one more than the key's id in the dictionary.
+// `field_encoding_t` is what we need to serialize datums into such a buffer. It's
+// passed around as NULL when serializing into a regular buffer.
+struct field_encoding_t {
+    const datum_field_dictionary_t *dictionary;
+    // Collects the keys that didn't have an id. Can be NULL.
+    std::set<datum_string_t> *missing_fields;
+};
+
 /* Forward declarations */
 size_t datum_serialized_size(const datum_t &datum,
                              check_datum_serialization_errors_t check_errors,
-                             std::vector<size_tree_node_t> *child_sizes_out);
+                             std::vector<size_tree_node_t> *child_sizes_out,
+                             const field_encoding_t *encoding);
 serialization_result_t datum_serialize(
         write_message_t *wm,
         const datum_t &datum,
         check_datum_serialization_errors_t check_errors,
-        const size_tree_node_t &precomputed_size);
+        const size_tree_node_t &precomputed_size,
+        const field_encoding_t *encoding);
 
 // Some of the following looks like it duplicates code of other deserialization
 // functions.  It does. Keeping this separate means that we don't have to worry
@@ -111,6 +132,92 @@ serialization_result_t datum_serialize(
 
 /* Helper functions shared by datum_array_* and datum_object_* */
 
+// Whether we can copy the existing serialization of an array or object as it is.
+bool can_reuse_existing_buf(const shared_buf_ref_t<char> *existing_buf_ref,
+                            check_datum_serialization_errors_t check_errors,
+                            const field_encoding_t *encoding) {
+    if (existing_buf_ref == NULL
+        || check_errors != check_datum_serialization_errors_t::NO) {
+        return false;
+    }
+    // The object keys in the existing serialization have to be encoded the same way
+    // as the ones we're writing.
+    const shared_buf_t *dictionary_buf =
+        encoding == NULL ? NULL : encoding->dictionary->get_buf().get();
+    return existing_buf_ref->get_dictionary().get() == dictionary_buf;
+}
+
+// Keep in sync with datum_key_serialize
+size_t datum_key_serialized_size(const datum_string_t &key,
+                                 const field_encoding_t *encoding) {
+    if (encoding == NULL) {
+        return datum_serialized_size(key);
+    }
+    uint64_t id;
+    if (encoding->dictionary->find(key, &id)) {
+        return varint_uint64_serialized_size(id + 1);
+    }
+    if (encoding->missing_fields != NULL) {
+        encoding->missing_fields->insert(key);
+    }
+    return varint_uint64_serialized_size(0) + datum_serialized_size(key);
+}
+
+// Keep in sync with datum_key_serialized_size
+// Keep in sync with datum_key_deserialize_from_buf
+serialization_result_t datum_key_serialize(write_message_t *wm,
+                                           const datum_string_t &key,
+                                           const field_encoding_t *encoding) {
+    if (encoding == NULL) {
+        return datum_serialize(wm, key);
+    }
+    uint64_t id;
+    if (encoding->dictionary->find(key, &id)) {
+        serialize_varint_uint64(wm, id + 1);
+        return serialization_result_t::SUCCESS;
+    }
+    serialize_varint_uint64(wm, 0);
+    return datum_serialize(wm, key);
+}
+
+// Reads an object key, looking it up in the buffer's dictionary if it has one.
+datum_string_t datum_key_deserialize_from_buf(const shared_buf_ref_t<char> &buf,
+                                              size_t at_offset,
+                                              size_t *ser_size_out) {
+    const counted_t<const shared_buf_t> &dictionary = buf.get_dictionary();
+    if (!dictionary.has()) {
+        datum_string_t key(buf.make_child(at_offset));
+        // Relies on the fact that the datum_string_t serialization format hasn't
+        // changed, specifically that we would still get the same size if we
+        // re-serialized the datum_string_t now.
+        *ser_size_out = datum_serialized_size(key);
+        return key;
+    }
+
+    buf.guarantee_in_boundary(at_offset);
+    buffer_read_stream_t read_stream(buf.get() + at_offset,
+                                     buf.get_safety_boundary() - at_offset);
+    uint64_t tag = 0;
+    guarantee_deserialization(deserialize_varint_uint64(&read_stream, &tag),
+                              "datum object key");
+    const size_t tag_size = static_cast<size_t>(read_stream.tell());
+    if (tag == 0) {
+        datum_string_t key(buf.make_child(at_offset + tag_size));
+        *ser_size_out = tag_size + datum_serialized_size(key);
+        return key;
+    }
+
+    // The dictionary has the format of a serialized array of strings.
+    const shared_buf_ref_t<char> dictionary_ref(dictionary, 0);
+    const uint64_t id = tag - 1;
+    guarantee(id < datum_get_array_size(dictionary_ref),
+              "Datum refers to a field that isn't in the field dictionary.");
+    const size_t name_offset =
+        datum_get_element_offset(dictionary_ref, static_cast<size_t>(id));
+    *ser_size_out = tag_size;
+    return datum_deserialize_from_buf(dictionary_ref, name_offset).as_str();
+}
+
 // Keep in sync with offset_table_serialized_size
 void serialize_offset_table(write_message_t *wm,
                             datum_t::type_t datum_type,
@@ -253,13 +360,13 @@ size_t datum_array_inner_serialized_size(
 // Keep in sync with datum_array_serialize.
 size_t datum_array_serialized_size(const datum_t &datum,
                                    check_datum_serialization_errors_t check_errors,
-                                   std::vector<size_tree_node_t> *element_sizes_out) {
+                                   std::vector<size_tree_node_t> *element_sizes_out,
+                                   const field_encoding_t *encoding) {
     size_t sz = 0;
 
     // Can we use an existing serialization?
     const shared_buf_ref_t<char> *existing_buf_ref = datum.get_buf_ref();
-    if (existing_buf_ref != NULL
-        && check_errors == check_datum_serialization_errors_t::NO) {
+    if (can_reuse_existing_buf(existing_buf_ref, check_errors, encoding)) {
 
         // We don't initialize element_sizes_out, but that's ok. We don't need it
         // if there already is a serialization.
@@ -271,7 +378,7 @@ size_t datum_array_serialized_size(const datum_t &datum,
             auto elem = datum.get(i);
             size_tree_node_t elem_size;
             elem_size.size = datum_serialized_size(elem, check_errors,
-                                                   &elem_size.child_sizes);
+                                                   &elem_size.child_sizes, encoding);
             elem_sizes.push_back(std::move(elem_size));
         }
         datum_offset_size_t offset_size;
@@ -296,12 +403,12 @@ serialization_result_t datum_array_serialize(
         write_message_t *wm,
         const datum_t &datum,
         check_datum_serialization_errors_t check_errors,
-        const size_tree_node_t &precomputed_sizes) {
+        const size_tree_node_t &precomputed_sizes,
+        const field_encoding_t *encoding) {
 
     // Can we use an existing serialization?
     const shared_buf_ref_t<char> *existing_buf_ref = datum.get_buf_ref();
-    if (existing_buf_ref != NULL
-        && check_errors == check_datum_serialization_errors_t::NO) {
+    if (can_reuse_existing_buf(existing_buf_ref, check_errors, encoding)) {
 
         // Subtract 1 for the type byte, which we don't have to rewrite
         wm->append(existing_buf_ref->get(), precomputed_sizes.size - 1);
@@ -323,7 +430,7 @@ serialization_result_t datum_array_serialize(
     for (size_t i = 0; i < datum.arr_size(); ++i) {
         auto elem = datum.get(i);
         const size_tree_node_t &child_size = precomputed_sizes.child_sizes[i];
-        res = res | datum_serialize(wm, elem, check_errors, child_size);
+        res = res | datum_serialize(wm, elem, check_errors, child_size, encoding);
     }
 
     return res;
@@ -358,13 +465,13 @@ datum_deserialize(read_stream_t *s, std::vector<datum_t> *v) {
 // Keep in sync with datum_object_serialize.
 size_t datum_object_serialized_size(const datum_t &datum,
                                     check_datum_serialization_errors_t check_errors,
-                                    std::vector<size_tree_node_t> *child_sizes_out) {
+                                    std::vector<size_tree_node_t> *child_sizes_out,
+                                    const field_encoding_t *encoding) {
     size_t sz = 0;
 
     // Can we use an existing serialization?
     const shared_buf_ref_t<char> *existing_buf_ref = datum.get_buf_ref();
-    if (existing_buf_ref != NULL
-        && check_errors == check_datum_serialization_errors_t::NO) {
+    if (can_reuse_existing_buf(existing_buf_ref, check_errors, encoding)) {
 
         // We don't initialize element_sizes_out, but that's ok. We don't need it
         // if there already is a serialization.
@@ -375,10 +482,10 @@ size_t datum_object_serialized_size(const datum_t &datum,
         for (size_t i = 0; i < datum.obj_size(); ++i) {
             auto pair = datum.get_pair(i);
             size_tree_node_t key_size;
-            key_size.size = datum_serialized_size(pair.first);
+            key_size.size = datum_key_serialized_size(pair.first, encoding);
             size_tree_node_t val_size;
             val_size.size = datum_serialized_size(pair.second, check_errors,
-                                                  &val_size.child_sizes);
+                                                  &val_size.child_sizes, encoding);
             child_sizes.push_back(std::move(key_size));
             child_sizes.push_back(std::move(val_size));
         }
@@ -404,12 +511,12 @@ serialization_result_t datum_object_serialize(
         write_message_t *wm,
         const datum_t &datum,
         check_datum_serialization_errors_t check_errors,
-        const size_tree_node_t &precomputed_sizes) {
+        const size_tree_node_t &precomputed_sizes,
+        const field_encoding_t *encoding) {
 
     // Can we use an existing serialization?
     const shared_buf_ref_t<char> *existing_buf_ref = datum.get_buf_ref();
-    if (existing_buf_ref != NULL
-        && check_errors == check_datum_serialization_errors_t::NO) {
+    if (can_reuse_existing_buf(existing_buf_ref, check_errors, encoding)) {
 
         // Subtract 1 for the type byte, which we don't have to rewrite
         wm->append(existing_buf_ref->get(), precomputed_sizes.size - 1);
@@ -431,8 +538,8 @@ serialization_result_t datum_object_serialize(
     for (size_t i = 0; i < datum.obj_size(); ++i) {
         auto pair = datum.get_pair(i);
         const size_tree_node_t &val_size = precomputed_sizes.child_sizes[i*2+1];
-        res = res | datum_serialize(wm, pair.first);
-        res = res | datum_serialize(wm, pair.second, check_errors, val_size);
+        res = res | datum_key_serialize(wm, pair.first, encoding);
+        res = res | datum_serialize(wm, pair.second, check_errors, val_size, encoding);
     }
 
     return res;
@@ -474,12 +581,13 @@ MUST_USE archive_result_t datum_deserialize(
 
 size_t datum_serialized_size(const datum_t &datum,
                              check_datum_serialization_errors_t check_errors) {
-    return datum_serialized_size(datum, check_errors, NULL);
+    return datum_serialized_size(datum, check_errors, NULL, NULL);
 }
 
 size_t datum_serialized_size(const datum_t &datum,
                              check_datum_serialization_errors_t check_errors,
-                             std::vector<size_tree_node_t> *child_sizes_out) {
+                             std::vector<size_tree_node_t> *child_sizes_out,
+                             const field_encoding_t *encoding) {
     rassert(child_sizes_out == NULL || child_sizes_out->empty());
     // Update datum_object_serialize() and datum_array_serialize() if the size of
     // the type prefix should ever change.
@@ -490,7 +598,8 @@ size_t datum_serialized_size(const datum_t &datum,
         sz += call_with_enough_stack<size_t>([&] () {
                 return datum_array_serialized_size(datum,
                                                    check_errors,
-                                                   child_sizes_out);
+                                                   child_sizes_out,
+                                                   encoding);
             }, MIN_DATUM_SERIALIZATION_STACK_SPACE);
     } break;
     case datum_t::R_BINARY: {
@@ -513,7 +622,8 @@ size_t datum_serialized_size(const datum_t &datum,
         sz += call_with_enough_stack<size_t>([&] () {
                 return datum_object_serialized_size(datum,
                                                     check_errors,
-                                                    child_sizes_out);
+                                                    child_sizes_out,
+                                                    encoding);
             }, MIN_DATUM_SERIALIZATION_STACK_SPACE);
     } break;
     case datum_t::R_STR: {
@@ -531,7 +641,8 @@ serialization_result_t datum_serialize(
         write_message_t *wm,
         const datum_t &datum,
         check_datum_serialization_errors_t check_errors,
-        const size_tree_node_t &precomputed_size) {
+        const size_tree_node_t &precomputed_size,
+        const field_encoding_t *encoding) {
     serialization_result_t res = serialization_result_t::SUCCESS;
 
     switch (datum.get_type()) {
@@ -548,7 +659,8 @@ serialization_result_t datum_serialize(
                 return datum_array_serialize(wm,
                                              datum,
                                              check_errors,
-                                             precomputed_size);
+                                             precomputed_size,
+                                             encoding);
             }, MIN_DATUM_SERIALIZATION_STACK_SPACE);
     } break;
     case datum_t::R_BINARY: {
@@ -590,7 +702,8 @@ serialization_result_t datum_serialize(
                 return datum_object_serialize(wm,
                                               datum,
                                               check_errors,
-                                              precomputed_size);
+                                              precomputed_size,
+                                              encoding);
             }, MIN_DATUM_SERIALIZATION_STACK_SPACE);
     } break;
     case datum_t::R_STR: {
@@ -618,12 +731,112 @@ serialization_result_t datum_serialize(
         check_datum_serialization_errors_t check_errors) {
     // Precompute serialized sizes
     size_tree_node_t size;
-    size.size = datum_serialized_size(datum, check_errors, &size.child_sizes);
+    size.size = datum_serialized_size(datum, check_errors, &size.child_sizes, NULL);
 
-    return datum_serialize(wm, datum, check_errors, size);
+    return datum_serialize(wm, datum, check_errors, size, NULL);
+}
+
+serialization_result_t datum_serialize(
+        write_message_t *wm,
+        const datum_t &datum,
+        check_datum_serialization_errors_t check_errors,
+        const datum_field_dictionary_t *dictionary,
+        std::set<datum_string_t> *missing_fields_out) {
+    if (dictionary == NULL || datum.get_type() != datum_t::R_OBJECT) {
+        return datum_serialize(wm, datum, check_errors);
+    }
+
+    field_encoding_t encoding;
+    encoding.dictionary = dictionary;
+    encoding.missing_fields = missing_fields_out;
+
+    // Precompute serialized sizes
+    size_tree_node_t size;
+    size.size = datum_serialized_size(datum, check_errors, &size.child_sizes,
+                                      &encoding);
+
+    serialization_result_t res =
+        datum_serialize(wm, datum_serialized_type_t::DICT_BUF_R_OBJECT);
+    res = res | call_with_enough_stack<serialization_result_t>([&] () {
+            return datum_object_serialize(wm, datum, check_errors, size, &encoding);
+        }, MIN_DATUM_SERIALIZATION_STACK_SPACE);
+    return res;
+}
+
+bool datum_uses_field_dictionary(const std::vector<char> &serialized) {
+    return !serialized.empty()
+        && serialized[0]
+           == static_cast<char>(datum_serialized_type_t::DICT_BUF_R_OBJECT);
+}
+
+// Smaller values get copied out of shared buffers rather than referring into them.
+// Copying them is cheap, and each one could otherwise keep a much larger message
+// alive.
+const size_t MIN_SHARED_BUF_SLICE_SIZE = KILOBYTE;
+
+/* Reads a size prefix and that many bytes after it into a buffer that starts with the
+prefix, which is the format of `datum_string_t`s and buffer-backed datums. If `s` reads
+from a shared buffer, results of at least `MIN_SHARED_BUF_SLICE_SIZE` bytes refer into
+it instead of getting copied, unless they need `dictionary_buf` attached or the stream
+doesn't allow slices. */
+MUST_USE archive_result_t datum_deserialize_buf(
+        read_stream_t *s,
+        const counted_t<const shared_buf_t> &dictionary_buf,
+        shared_buf_ref_t<char> *out) {
+    shared_buf_read_stream_t *shared_s = dictionary_buf.has()
+        ? nullptr
+        : dynamic_cast<shared_buf_read_stream_t *>(s);
+    if (shared_s != nullptr && !shared_s->allows_slices()) {
+        shared_s = nullptr;
+    }
+    const size_t prefix_pos = shared_s != nullptr ? shared_s->tell() : 0;
+
+    // First read the serialized size of the buffer
+    uint64_t ser_size;
+    archive_result_t res = deserialize_varint_uint64(s, &ser_size);
+    if (bad(res)) {
+        return res;
+    }
+    const size_t ser_size_sz = varint_uint64_serialized_size(ser_size);
+    if (ser_size > std::numeric_limits<size_t>::max() - ser_size_sz
+        || ser_size > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())
+                      - ser_size_sz) {
+        return archive_result_t::RANGE_ERROR;
+    }
+
+    // The prefix can only be reused if it was written in its shortest form, which is
+    // what we'd write into a new buffer.
+    if (shared_s != nullptr && shared_s->tell() - prefix_pos == ser_size_sz
+        && ser_size + ser_size_sz >= MIN_SHARED_BUF_SLICE_SIZE) {
+        if (!shared_s->skip(ser_size)) {
+            return archive_result_t::SOCK_EOF;
+        }
+        *out = shared_buf_ref_t<char>(shared_s->get_buf(), prefix_pos);
+        return archive_result_t::SUCCESS;
+    }
+
+    // Then read the data into a shared_buf_t
+    counted_t<shared_buf_t> buf = shared_buf_t::create(
+        static_cast<size_t>(ser_size) + ser_size_sz, dictionary_buf);
+    serialize_varint_uint64_into_buf(ser_size, reinterpret_cast<uint8_t *>(buf->data()));
+    int64_t num_read = force_read(s, buf->data() + ser_size_sz, ser_size);
+    if (num_read == -1) {
+        return archive_result_t::SOCK_ERROR;
+    }
+    if (static_cast<uint64_t>(num_read) < ser_size) {
+        return archive_result_t::SOCK_EOF;
+    }
+    *out = shared_buf_ref_t<char>(std::move(buf), 0);
+    return archive_result_t::SUCCESS;
 }
 
 archive_result_t datum_deserialize(read_stream_t *s, datum_t *datum) {
+    return datum_deserialize(s, NULL, datum);
+}
+
+archive_result_t datum_deserialize(read_stream_t *s,
+                                   const datum_field_dictionary_t *dictionary,
+                                   datum_t *datum) {
     // Datums on disk should always be read no matter how stupid big
     // they are; there's no way to fix the problem otherwise.
     // Similarly we don't want to reject array reads from cluster
@@ -748,30 +961,23 @@ archive_result_t datum_deserialize(read_stream_t *s, datum_t *datum) {
         }
     } break;
     case datum_serialized_type_t::BUF_R_ARRAY: // fallthru
-    case datum_serialized_type_t::BUF_R_OBJECT:
+    case datum_serialized_type_t::BUF_R_OBJECT: // fallthru
+    case datum_serialized_type_t::DICT_BUF_R_OBJECT:
     {
-        // First read the serialized size of the buffer
-        uint64_t ser_size;
-        res = deserialize_varint_uint64(s, &ser_size);
-        if (bad(res)) {
-            return res;
-        }
-        const size_t ser_size_sz = varint_uint64_serialized_size(ser_size);
-        if (ser_size > std::numeric_limits<size_t>::max() - ser_size_sz
-            || ser_size > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())
-                          - ser_size_sz) {
-            return archive_result_t::RANGE_ERROR;
+        // The object keys of a `DICT_BUF_R_OBJECT` refer to the dictionary, so the
+        // buffer gets it attached.
+        counted_t<const shared_buf_t> dictionary_buf;
+        if (type == datum_serialized_type_t::DICT_BUF_R_OBJECT) {
+            if (dictionary == NULL) {
+                return archive_result_t::RANGE_ERROR;
+            }
+            dictionary_buf = dictionary->get_buf();
         }
 
-        // Then read the data into a shared_buf_t
-        counted_t<shared_buf_t> buf = shared_buf_t::create(static_cast<size_t>(ser_size) + ser_size_sz);
-        serialize_varint_uint64_into_buf(ser_size, reinterpret_cast<uint8_t *>(buf->data()));
-        int64_t num_read = force_read(s, buf->data() + ser_size_sz, ser_size);
-        if (num_read == -1) {
-            return archive_result_t::SOCK_ERROR;
-        }
-        if (static_cast<uint64_t>(num_read) < ser_size) {
-            return archive_result_t::SOCK_EOF;
+        shared_buf_ref_t<char> buf;
+        res = datum_deserialize_buf(s, dictionary_buf, &buf);
+        if (bad(res)) {
+            return res;
         }
 
         // ...from which we create the datum_t
@@ -779,7 +985,7 @@ archive_result_t datum_deserialize(read_stream_t *s, datum_t *datum) {
                                 ? datum_t::R_ARRAY
                                 : datum_t::R_OBJECT;
         try {
-            *datum = datum_t(dtype, shared_buf_ref_t<char>(std::move(buf), 0));
+            *datum = datum_t(dtype, std::move(buf));
         } catch (const base_exc_t &) {
             return archive_result_t::RANGE_ERROR;
         }
@@ -848,6 +1054,9 @@ datum_t datum_deserialize_from_buf(const shared_buf_ref_t<char> &buf, size_t at_
                                   "datum from buf");
         return res;
     }
+    case datum_serialized_type_t::DICT_BUF_R_OBJECT:
+        // Only whole rows are serialized against a field dictionary.
+        unreachable();
     default:
         unreachable();
     }
@@ -855,11 +1064,8 @@ datum_t datum_deserialize_from_buf(const shared_buf_ref_t<char> &buf, size_t at_
 
 std::pair<datum_string_t, datum_t> datum_deserialize_pair_from_buf(
         const shared_buf_ref_t<char> &buf, size_t at_offset) {
-    datum_string_t key(buf.make_child(at_offset));
-    // Relies on the fact that the datum_string_t serialization format hasn't
-    // changed, specifically that we would still get the same size if we re-serialized
-    // the datum_string_t now.
-    const size_t key_ser_size = datum_serialized_size(key);
+    size_t key_ser_size;
+    datum_string_t key = datum_key_deserialize_from_buf(buf, at_offset, &key_ser_size);
 
     datum_t value(datum_deserialize_from_buf(buf, at_offset + key_ser_size));
 
@@ -981,27 +1187,14 @@ serialization_result_t datum_serialize(write_message_t *wm, const datum_string_t
 MUST_USE archive_result_t datum_deserialize(
         read_stream_t *s,
         datum_string_t *out) {
-    uint64_t sz;
-    archive_result_t res = deserialize_varint_uint64(s, &sz);
-    if (res != archive_result_t::SUCCESS) { return res; }
-
-    if (sz > std::numeric_limits<size_t>::max()) {
-        return archive_result_t::RANGE_ERROR;
-    }
-
-    const size_t str_offset = varint_uint64_serialized_size(sz);
-    counted_t<shared_buf_t> buf =
-        shared_buf_t::create(str_offset + static_cast<size_t>(sz));
-    serialize_varint_uint64_into_buf(sz, reinterpret_cast<uint8_t *>(buf->data()));
-    int64_t num_read = force_read(s, buf->data() + str_offset, sz);
-    if (num_read == -1) {
-        return archive_result_t::SOCK_ERROR;
-    }
-    if (static_cast<uint64_t>(num_read) < sz) {
-        return archive_result_t::SOCK_EOF;
+    shared_buf_ref_t<char> buf;
+    archive_result_t res =
+        datum_deserialize_buf(s, counted_t<const shared_buf_t>(), &buf);
+    if (bad(res)) {
+        return res;
     }
 
-    *out = datum_string_t(shared_buf_ref_t<char>(std::move(buf), 0));
+    *out = datum_string_t(std::move(buf));
 
     return archive_result_t::SUCCESS;
 }
@@ -1,7 +1,9 @@
 #ifndef RDB_PROTOCOL_SERIALIZE_DATUM_HPP_
 #define RDB_PROTOCOL_SERIALIZE_DATUM_HPP_
 
+#include <set>
 #include <utility>
+#include <vector>
 
 #include "containers/archive/archive.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
@@ -11,6 +13,7 @@
 
 namespace ql {
 
+class datum_field_dictionary_t;
 class datum_t;
 
 // Results of serialization.  Serialization, since it is happening to
@@ -49,6 +52,22 @@ serialization_result_t datum_serialize(write_message_t *wm, const datum_t &datum
                                        check_datum_serialization_errors_t check_errors);
 archive_result_t datum_deserialize(read_stream_t *s, datum_t *datum);
 
+// Serializes a row for storage in a table that has the field dictionary `dictionary`.
+// If the datum is an object, the field names that are in the dictionary get stored as
+// their ids, and the ones that aren't get spelled out and added to
+// `missing_fields_out` (which can be NULL). A NULL `dictionary` means no dictionary.
+serialization_result_t datum_serialize(write_message_t *wm, const datum_t &datum,
+                                       check_datum_serialization_errors_t check_errors,
+                                       const datum_field_dictionary_t *dictionary,
+                                       std::set<datum_string_t> *missing_fields_out);
+// Also deserializes datums that were serialized against `dictionary`, or any earlier
+// version of it. Those fail to deserialize if `dictionary` is NULL.
+archive_result_t datum_deserialize(read_stream_t *s,
+                                   const datum_field_dictionary_t *dictionary,
+                                   datum_t *datum);
+// Whether the serialized datum needs a field dictionary to be deserialized.
+bool datum_uses_field_dictionary(const std::vector<char> &serialized);
+
 datum_t datum_deserialize_from_buf(const shared_buf_ref_t<char> &buf, size_t at_offset);
 std::pair<datum_string_t, datum_t> datum_deserialize_pair_from_buf(
         const shared_buf_ref_t<char> &buf, size_t at_offset);
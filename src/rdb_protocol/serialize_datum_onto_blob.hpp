@@ -1,22 +1,20 @@
 #ifndef RDB_PROTOCOL_SERIALIZE_DATUM_ONTO_BLOB_HPP_
 #define RDB_PROTOCOL_SERIALIZE_DATUM_ONTO_BLOB_HPP_
 
+#include "rdb_protocol/field_dictionary.hpp"
 #include "rdb_protocol/serialize_datum.hpp"
 
 inline ql::serialization_result_t
 datum_serialize_onto_blob(buf_parent_t parent, blob_t *blob,
-                          const ql::datum_t &value) {
+                          const ql::datum_t &value,
+                          field_dictionary_writer_t *field_dictionary) {
     // We still make an unnecessary copy: serializing to a write_message_t instead of
     // directly onto the stream.  (However, don't be so sure it would be more
     // efficient to serialize onto an abstract stream type -- you've got a whole
     // bunch of virtual function calls that way.  But we do _deserialize_ off an
     // abstract stream type already, so what's the big deal?)
     write_message_t wm;
-    // Check for errors to enforce the static array size limit when writing
-    // to disk
-    ql::serialization_result_t res =
-        datum_serialize(&wm, value,
-                        ql::check_datum_serialization_errors_t::YES);
+    ql::serialization_result_t res = field_dictionary->serialize(&wm, value);
     if (bad(res)) return res;
     write_onto_blob(parent, blob, wm);
     return res;
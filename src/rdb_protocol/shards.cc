@@ -1,12 +1,17 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/shards.hpp"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <utility>
 
 #include "errors.hpp"
 #include <boost/optional.hpp>
 #include <boost/variant.hpp>
 
+#include "concurrency/work_stealing.hpp"
 #include "debug.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/profile.hpp"
@@ -14,6 +19,9 @@
 
 bool reversed(sorting_t sorting) { return sorting == sorting_t::DESCENDING; }
 
+// How many numbers `sum` and `avg` collect before adding them up.
+const size_t NUMBER_BATCH_SIZE = 256;
+
 namespace ql {
 
 
@@ -529,10 +537,16 @@ private:
         groups->clear();
     }
 
+    virtual void finish_impl(continue_bool_t last_cb, result_t *out) {
+        flush();
+        grouped_acc_t<T>::finish_impl(last_cb, out);
+    }
+
     virtual scoped_ptr_t<val_t> finish_eager(backtrace_id_t bt,
                                              bool is_grouped,
                                              UNUSED const configured_limits_t &limits) {
         accumulator_t::mark_finished();
+        flush();
         grouped_t<T> *acc = grouped_acc_t<T>::get_acc();
         const T *default_val = grouped_acc_t<T>::get_default_val();
         scoped_ptr_t<val_t> retval;
@@ -558,6 +572,7 @@ private:
     virtual datum_t unpack(T *t) = 0;
 
     virtual void add_res(env_t *env, result_t *res, sorting_t) {
+        flush();
         grouped_t<T> *acc = grouped_acc_t<T>::get_acc();
         const T *default_val = grouped_acc_t<T>::get_default_val();
         if (auto e = boost::get<exc_t>(res)) {
@@ -597,6 +612,10 @@ private:
     }
     virtual void unshard_impl(env_t *env, T *out, T *el) = 0;
     virtual bool should_send_batch() { return false; }
+
+    // Terminals that don't apply every element to the accumulated values right away
+    // must do so here. It's called before the values are read.
+    virtual void flush() { }
 };
 
 class count_terminal_t : public terminal_t<uint64_t> {
@@ -621,14 +640,53 @@ private:
 
 class acc_func_t {
 public:
-    explicit acc_func_t(const counted_t<const func_t> &_f) : f(_f) { }
+    explicit acc_func_t(const counted_t<const func_t> &_f)
+        : f(_f), is_field_getter(f.has() && f->is_field_getter(&field)) { }
     datum_t operator()(env_t *env, const datum_t &el) const {
+        // Reading the field directly saves evaluating the function for every row.
+        // Anything other than an object goes through the function, which maps
+        // over arrays and produces the usual errors.
+        if (is_field_getter && el.get_type() == datum_t::R_OBJECT) {
+            return el.get_field(field);
+        }
         return f.has() ? f->call(env, el)->as_datum() : el;
     }
 private:
     counted_t<const func_t> f;
+    datum_string_t field;
+    bool is_field_getter;
 };
 
+// Adds up `count` numbers. They're added in several independent lanes, which lets the
+// CPU add up to four of them at once.
+double sum_numbers(const double *numbers, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128d sum0 = _mm_setzero_pd();
+    __m128d sum1 = _mm_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        sum0 = _mm_add_pd(sum0, _mm_loadu_pd(numbers + i));
+        sum1 = _mm_add_pd(sum1, _mm_loadu_pd(numbers + i + 2));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+    double sum = lanes[0] + lanes[1];
+#else
+    double sums[4] = {0.0, 0.0, 0.0, 0.0};
+    for (; i + 4 <= count; i += 4) {
+        sums[0] += numbers[i];
+        sums[1] += numbers[i + 1];
+        sums[2] += numbers[i + 2];
+        sums[3] += numbers[i + 3];
+    }
+    double sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#endif
+    for (; i < count; ++i) {
+        sum += numbers[i];
+    }
+    return sum;
+}
+
 template<class T>
 class skip_terminal_t : public terminal_t<T> {
 protected:
@@ -663,16 +721,58 @@ private:
     backtrace_id_t bt;
 };
 
-class sum_terminal_t : public skip_terminal_t<double> {
-public:
-    explicit sum_terminal_t(const sum_wire_func_t &f)
-        : skip_terminal_t<double>(f, 0.0L) { }
+/* `number_batch_terminal_t` collects the numbers that `sum` and `avg` accumulate in a
+contiguous array and adds them up a whole batch at a time, rather than applying every
+element to the accumulated value on its own. A batch only ever belongs to one group. */
+template<class T>
+class number_batch_terminal_t : public skip_terminal_t<T> {
+protected:
+    number_batch_terminal_t(const skip_wire_func_t &f, T &&t)
+        : skip_terminal_t<T>(f, std::move(t)), batch_out(nullptr) {
+        batch.reserve(NUMBER_BATCH_SIZE);
+    }
+
+    void add_number(double number, T *out) {
+        if (out != batch_out) {
+            flush();
+            batch_out = out;
+        }
+        batch.push_back(number);
+        if (batch.size() == NUMBER_BATCH_SIZE) {
+            flush();
+        }
+    }
+
 private:
     virtual void maybe_acc(env_t *env,
                            const datum_t &el,
-                           double *out,
+                           T *out,
                            const acc_func_t &f) {
-        *out += f(env, el).as_num();
+        add_number(f(env, el).as_num(), out);
+    }
+
+    // Applies the sum of `count` numbers to `out`.
+    virtual void add_sum(double sum, uint64_t count, T *out) = 0;
+
+    void flush() final {
+        if (!batch.empty()) {
+            add_sum(sum_numbers(batch.data(), batch.size()), batch.size(), batch_out);
+            batch.clear();
+        }
+        batch_out = nullptr;
+    }
+
+    std::vector<double> batch;
+    T *batch_out;
+};
+
+class sum_terminal_t : public number_batch_terminal_t<double> {
+public:
+    explicit sum_terminal_t(const sum_wire_func_t &f)
+        : number_batch_terminal_t<double>(f, 0.0L) { }
+private:
+    virtual void add_sum(double sum, uint64_t, double *out) {
+        *out += sum;
     }
     virtual datum_t unpack(double *d) {
         return datum_t(*d);
@@ -682,18 +782,16 @@ private:
     }
 };
 
-class avg_terminal_t : public skip_terminal_t<std::pair<double, uint64_t> > {
+class avg_terminal_t : public number_batch_terminal_t<std::pair<double, uint64_t> > {
 public:
     explicit avg_terminal_t(const avg_wire_func_t &f)
-        : skip_terminal_t<std::pair<double, uint64_t> >(
+        : number_batch_terminal_t<std::pair<double, uint64_t> >(
             f, std::make_pair(0.0L, 0ULL)) { }
 private:
-    virtual void maybe_acc(env_t *env,
-                           const datum_t &el,
-                           std::pair<double, uint64_t> *out,
-                           const acc_func_t &f) {
-        out->first += f(env, el).as_num();
-        out->second += 1;
+    virtual void add_sum(double sum, uint64_t count,
+                         std::pair<double, uint64_t> *out) {
+        out->first += sum;
+        out->second += count;
     }
     virtual datum_t unpack(
         std::pair<double, uint64_t> *p) {
@@ -981,6 +1079,12 @@ private:
     backtrace_id_t bt;
 };
 
+// Lists this long get mapped in parallel if the query asks for it.
+const size_t MIN_PARALLEL_MAP_SIZE = 16;
+// Parallel maps split their lists into this many tasks per thread, so that threads
+// that get to them late can still take some of the work.
+const size_t PARALLEL_MAP_TASKS_PER_THREAD = 4;
+
 class map_trans_t : public ungrouped_op_t {
 public:
     explicit map_trans_t(const map_wire_func_t &_f)
@@ -989,6 +1093,10 @@ private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
         try {
+            if (lst->size() >= MIN_PARALLEL_MAP_SIZE && can_map_in_parallel(env)) {
+                parallel_lst_transform(env, lst);
+                return;
+            }
             for (auto it = lst->begin(); it != lst->end(); ++it) {
                 *it = f->call(env, *it)->as_datum();
             }
@@ -996,7 +1104,53 @@ private:
             throw exc_t(e, f->backtrace(), 1);
         }
     }
+
+    /* The `parallel` optarg lets idle threads help with the map. That's only safe for
+    deterministic functions, which don't touch tables or anything else that belongs to
+    the query's thread. Profiles can't be collected from other threads. */
+    bool can_map_in_parallel(env_t *env) {
+        if (!parallel) {
+            parallel = f->is_deterministic() != deterministic_t::no
+                && env->profile() == profile_bool_t::DONT_PROFILE
+                && get_num_db_threads() > 1;
+            if (*parallel) {
+                scoped_ptr_t<val_t> optarg = env->get_optarg(env, "parallel");
+                parallel = optarg.has() && optarg->as_bool();
+            }
+        }
+        return *parallel;
+    }
+
+    /* Maps contiguous chunks of `lst` on whichever threads get to them. Each chunk
+    stops at its first error, and the error of the first failing chunk gets thrown, so
+    it's the same error that mapping the list in order would have thrown. */
+    void parallel_lst_transform(env_t *env, datums_t *lst) {
+        const size_t num_tasks = std::min(
+            lst->size(), get_num_db_threads() * PARALLEL_MAP_TASKS_PER_THREAD);
+        const reql_version_t reql_version = env->reql_version();
+        const configured_limits_t limits = env->limits();
+        std::vector<std::exception_ptr> errors(num_tasks);
+        work_stealing_pmap(num_tasks, [&](size_t task) {
+            cond_t non_interruptor;
+            env_t task_env(&non_interruptor, reql_version, limits);
+            try {
+                size_t end = lst->size() * (task + 1) / num_tasks;
+                for (size_t i = lst->size() * task / num_tasks; i < end; ++i) {
+                    (*lst)[i] = f->call(&task_env, (*lst)[i])->as_datum();
+                }
+            } catch (...) {
+                errors[task] = std::current_exception();
+            }
+        }, env->interruptor);
+        for (const std::exception_ptr &error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
     counted_t<const func_t> f;
+    boost::optional<bool> parallel;
 };
 
 // Note: this removes duplicates ONLY TO SAVE NETWORK TRAFFIC.  It's possible
@@ -432,6 +432,9 @@ scoped_ptr_t<eager_acc_t> make_to_array();
 scoped_ptr_t<eager_acc_t> make_eager_terminal(const terminal_variant_t &t);
 scoped_ptr_t<op_t> make_op(const transform_variant_t &tv);
 
+// Adds up `count` numbers for the batched `sum` and `avg` terminals.
+double sum_numbers(const double *numbers, size_t count);
+
 } // namespace ql
 
 #endif  // RDB_PROTOCOL_SHARDS_HPP_
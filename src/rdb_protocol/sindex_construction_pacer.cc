@@ -0,0 +1,61 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/sindex_construction_pacer.hpp"
+
+#include <algorithm>
+
+#include "arch/timing.hpp"
+#include "config/args.hpp"
+
+// How much weight the latest write gets in the moving average.
+const double WRITE_LATENCY_SMOOTHING = 0.1;
+
+write_latency_monitor_t::write_latency_monitor_t(perfmon_collection_t *parent)
+    : pm_write_latency_(secs_to_ticks(1), true),
+      pm_write_latency_membership_(parent, &pm_write_latency_, "write_latency"),
+      average_latency_ms_(0),
+      num_writes_(0) { }
+
+write_latency_monitor_t::sentry_t::sentry_t(write_latency_monitor_t *parent)
+    : parent_(parent),
+      start_(get_ticks()),
+      pm_duration_(&parent->pm_write_latency_) { }
+
+write_latency_monitor_t::sentry_t::~sentry_t() {
+    parent_->record_write(ticks_to_secs(get_ticks() - start_) * 1000.0);
+}
+
+void write_latency_monitor_t::record_write(double latency_ms) {
+    if (num_writes_ == 0) {
+        average_latency_ms_ = latency_ms;
+    } else {
+        average_latency_ms_ +=
+            WRITE_LATENCY_SMOOTHING * (latency_ms - average_latency_ms_);
+    }
+    ++num_writes_;
+}
+
+sindex_construction_pacer_t::sindex_construction_pacer_t(
+        const write_latency_monitor_t *write_latency)
+    : write_latency_(write_latency),
+      last_num_writes_(write_latency->num_writes()),
+      pause_ms_(0) { }
+
+void sindex_construction_pacer_t::pace(signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    if (update_pause_ms() > 0) {
+        nap(pause_ms_, interruptor);
+    }
+}
+
+int64_t sindex_construction_pacer_t::update_pause_ms() {
+    const bool had_writes = write_latency_->num_writes() != last_num_writes_;
+    last_num_writes_ = write_latency_->num_writes();
+    if (had_writes && write_latency_->average_latency_ms()
+                      > SINDEX_CONSTRUCTION_TARGET_WRITE_LATENCY_MS) {
+        pause_ms_ = std::min<int64_t>(std::max<int64_t>(2 * pause_ms_, 1),
+                                      SINDEX_CONSTRUCTION_MAX_PAUSE_MS);
+    } else {
+        pause_ms_ /= 2;
+    }
+    return pause_ms_;
+}
@@ -0,0 +1,71 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_SINDEX_CONSTRUCTION_PACER_HPP_
+#define RDB_PROTOCOL_SINDEX_CONSTRUCTION_PACER_HPP_
+
+#include "concurrency/interruptor.hpp"
+#include "perfmon/perfmon.hpp"
+#include "time.hpp"
+
+/* `write_latency_monitor_t` measures how long the writes to a store take, including
+waiting for the superblock and flushing the transaction. The durations are exposed as
+the `write_latency` perfmon stat of the store, and are also kept as a moving average
+for `sindex_construction_pacer_t`. It must only be used on the store's thread. */
+class write_latency_monitor_t {
+public:
+    explicit write_latency_monitor_t(perfmon_collection_t *parent);
+
+    // Measures the write during which it exists.
+    class sentry_t {
+    public:
+        explicit sentry_t(write_latency_monitor_t *parent);
+        ~sentry_t();
+    private:
+        write_latency_monitor_t *parent_;
+        ticks_t start_;
+        block_pm_duration pm_duration_;
+        DISABLE_COPYING(sentry_t);
+    };
+
+    // Adds a write that took `latency_ms` to the moving average.
+    void record_write(double latency_ms);
+
+    double average_latency_ms() const { return average_latency_ms_; }
+    // The number of writes that have been measured so far.
+    uint64_t num_writes() const { return num_writes_; }
+
+private:
+    perfmon_duration_sampler_t pm_write_latency_;
+    perfmon_membership_t pm_write_latency_membership_;
+
+    double average_latency_ms_;
+    uint64_t num_writes_;
+
+    DISABLE_COPYING(write_latency_monitor_t);
+};
+
+/* Secondary index construction calls `pace()` between its chunks of work, which pauses
+for a while if the construction seems to slow down the writes to the table. The pause
+doubles for every chunk during which the average write latency is above
+`SINDEX_CONSTRUCTION_TARGET_WRITE_LATENCY_MS`, and halves for every chunk during which
+it isn't or there haven't been any writes. Unlike the cache priority of the
+construction, this also accounts for the disk and for the time that writes spend
+waiting for the sindex queue and superblock. */
+class sindex_construction_pacer_t {
+public:
+    explicit sindex_construction_pacer_t(const write_latency_monitor_t *write_latency);
+
+    void pace(signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+
+    // Updates the pause for the chunk that just finished and returns it, without
+    // pausing. `pace()` calls this.
+    int64_t update_pause_ms();
+
+private:
+    const write_latency_monitor_t *write_latency_;
+    uint64_t last_num_writes_;
+    int64_t pause_ms_;
+
+    DISABLE_COPYING(sindex_construction_pacer_t);
+};
+
+#endif  // RDB_PROTOCOL_SINDEX_CONSTRUCTION_PACER_HPP_
@@ -818,6 +818,20 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
         for (auto it = bi.inserts.begin(); it != bi.inserts.end(); ++it) {
             keys.emplace_back(it->get_field(datum_string_t(bi.pkey)).print_primary());
         }
+        batched_replace_response_t bulk_response;
+        if (rdb_batched_insert_into_empty_range(
+                btree_info_t(btree, timestamp, datum_string_t(bi.pkey)),
+                superblock,
+                keys,
+                &replacer,
+                &sindex_cb,
+                bi.limits,
+                sampler,
+                trace,
+                &bulk_response)) {
+            response->response = bulk_response;
+            return;
+        }
         response->response =
             rdb_batched_replace(
                 btree_info_t(btree, timestamp, datum_string_t(bi.pkey)),
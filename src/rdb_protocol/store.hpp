@@ -24,7 +24,10 @@
 #include "perfmon/perfmon.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/field_dictionary.hpp"
+#include "rdb_protocol/key_filter.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/sindex_construction_pacer.hpp"
 #include "rdb_protocol/store_metainfo.hpp"
 #include "rpc/mailbox/typed.hpp"
 #include "store_view.hpp"
@@ -75,6 +78,18 @@ enum class update_sindexes_t {
     LEAVE_ALONE
 };
 
+/* How far a secondary index construction has come, for the `jobs` table and
+`indexStatus`. */
+struct sindex_construction_progress_t {
+    sindex_construction_progress_t()
+        : start_time(current_microtime()), progress(0), rows_done(0) { }
+    microtime_t start_time;
+    // Between 0.0 and 1.0
+    double progress;
+    // An estimate of how many rows have been put into the index so far.
+    double rows_done;
+};
+
 class store_t final : public store_view_t {
 public:
     using home_thread_mixin_t::assert_thread;
@@ -202,6 +217,15 @@ public:
             THROWS_ONLY(interrupted_exc_t);
 
     void configure_flush_interval(flush_interval_t interval);
+    void configure_block_compression(block_compression_t compression);
+    void configure_eviction_policy(eviction_policy_t policy);
+    void configure_cache_quota(cache_quota_t quota);
+    void configure_field_dictionary(bool enabled);
+    void configure_key_filter(bool enabled);
+
+    std::vector<block_id_t> hot_block_ids(size_t max_count) const;
+    void warm_up_cache(const std::vector<block_id_t> &block_ids, signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
 
     new_mutex_in_line_t get_in_line_for_sindex_queue(buf_lock_t *sindex_block);
     rwlock_in_line_t get_in_line_for_cfeed_stamp(access_t access);
@@ -361,13 +385,13 @@ private:
 public:
     namespace_id_t const &get_table_id() const;
 
-    // The `double` is the progress of the secondary index construction.
-    typedef std::map<uuid_u, std::pair<microtime_t, double const *> >
+    typedef std::map<uuid_u, sindex_construction_progress_t const *>
         sindex_context_map_t;
     sindex_context_map_t *get_sindex_context_map();
 
     double get_sindex_progress(uuid_u const &id);
     microtime_t get_sindex_start_time(uuid_u const &id);
+    double get_sindex_rows_per_second(uuid_u const &id);
 
     fifo_enforcer_source_t main_token_source, sindex_token_source;
     fifo_enforcer_sink_t main_token_sink, sindex_token_sink;
@@ -381,6 +405,9 @@ public:
     io_backender_t *io_backender_;
     base_path_t base_path_;
     perfmon_membership_t perfmon_collection_membership;
+    write_latency_monitor_t write_latency;
+    field_dictionary_manager_t field_dictionary;
+    key_filter_t key_filter;
     scoped_ptr_t<store_metainfo_manager_t> metainfo;
 
     std::map<uuid_u, scoped_ptr_t<btree_slice_t> > secondary_index_slices;
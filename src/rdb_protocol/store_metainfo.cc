@@ -4,14 +4,23 @@
 #include "btree/reql_specific.hpp"
 #include "containers/archive/buffer_stream.hpp"
 #include "containers/archive/vector_stream.hpp"
+#include "rdb_protocol/field_dictionary.hpp"
 
-store_metainfo_manager_t::store_metainfo_manager_t(real_superblock_t *superblock) {
+store_metainfo_manager_t::store_metainfo_manager_t(
+        real_superblock_t *superblock,
+        field_dictionary_manager_t *_field_dictionary)
+    : field_dictionary(_field_dictionary) {
     std::vector<std::pair<std::vector<char>, std::vector<char> > > kv_pairs;
     // TODO: this is inefficient, cut out the middleman (vector)
     get_superblock_metainfo(superblock, &kv_pairs, &cache_version);
     std::vector<region_t> regions;
     std::vector<binary_blob_t> values;
     for (auto &pair : kv_pairs) {
+        if (pair.first.empty()) {
+            field_dictionary->load(
+                ql::datum_field_dictionary_t::deserialize(pair.second));
+            continue;
+        }
         region_t region;
         {
             buffer_read_stream_t key(pair.first.data(), pair.first.size());
@@ -77,6 +86,20 @@ void store_metainfo_manager_t::update(
             values.push_back(value);
         });
 
+    // Field names that writers reported since the last update become usable from now
+    // on, because they get written in the same transaction.
+    field_dictionary->add_missing_fields();
+    const counted_t<const ql::datum_field_dictionary_t> &dictionary =
+        field_dictionary->get();
+    if (dictionary->size() > 0) {
+        // The empty key can't be a serialized region. Older versions crash on it, so
+        // this moves the file to serializer version 2.4, which they refuse to open.
+        superblock->get()->cache()->require_current_serializer_format();
+        keys.push_back(std::vector<char>());
+        values.push_back(binary_blob_t(dictionary->get_serialized().begin(),
+                                       dictionary->get_serialized().end()));
+    }
+
     set_superblock_metainfo(superblock, keys, values, cache_version);
 }
 
@@ -7,11 +7,16 @@
 #include "containers/binary_blob.hpp"
 #include "region/region_map.hpp"
 
+class field_dictionary_manager_t;
 class real_superblock_t;
 
+/* Besides the metainfo, `store_metainfo_manager_t` also loads and stores the store's
+field dictionary. It's kept in the superblock metainfo under an empty key, which can't
+be confused with a serialized region. */
 class store_metainfo_manager_t {
 public:
-    explicit store_metainfo_manager_t(real_superblock_t *superblock);
+    store_metainfo_manager_t(real_superblock_t *superblock,
+                             field_dictionary_manager_t *field_dictionary);
 
     region_map_t<binary_blob_t> get(
         real_superblock_t *superblock,
@@ -36,6 +41,8 @@ public:
     cluster_version_t get_version(real_superblock_t *superblock) const;
 
 private:
+    field_dictionary_manager_t *const field_dictionary;
+
     cluster_version_t cache_version;
     region_map_t<binary_blob_t> cache;
 };
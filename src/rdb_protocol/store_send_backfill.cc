@@ -3,6 +3,8 @@
 #include "btree/backfill.hpp"
 #include "btree/reql_specific.hpp"
 #include "btree/operations.hpp"
+#include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/vector_stream.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
 #include "rdb_protocol/btree.hpp"
 #include "rdb_protocol/lazy_btree_val.hpp"
@@ -150,9 +152,11 @@ public:
     limiting_btree_backfill_item_consumer_t(
             store_view_t::backfill_item_consumer_t *_inner,
             key_range_t::right_bound_t *_threshold_ptr,
-            const region_map_t<binary_blob_t> *_metainfo_ptr) :
+            const region_map_t<binary_blob_t> *_metainfo_ptr,
+            const field_dictionary_manager_t *_field_dictionary) :
         remaining(MAX_BACKFILL_ITEMS_PER_TXN), inner(_inner),
-        threshold_ptr(_threshold_ptr), metainfo_ptr(_metainfo_ptr) { }
+        threshold_ptr(_threshold_ptr), metainfo_ptr(_metainfo_ptr),
+        field_dictionary(_field_dictionary) { }
     continue_bool_t on_item(backfill_item_t &&item) {
         rassert(remaining > 0);
         --remaining;
@@ -196,6 +200,27 @@ public:
             offset += b.size;
         }
         guarantee(offset == value_out->size());
+
+        /* The receiving server has a field dictionary of its own, so rows that refer
+        to ours have to be sent with their field names spelled out. */
+        if (ql::datum_uses_field_dictionary(*value_out)) {
+            ql::datum_t row;
+            {
+                buffer_read_stream_t read_stream(value_out->data(), value_out->size());
+                archive_result_t res = ql::datum_deserialize(
+                    &read_stream, field_dictionary->get().get(), &row);
+                guarantee_deserialization(res, "rdb value");
+            }
+            write_message_t wm;
+            ql::serialization_result_t res = ql::datum_serialize(
+                &wm, row, ql::check_datum_serialization_errors_t::NO);
+            guarantee(!bad(res));
+            vector_stream_t stream;
+            stream.reserve(wm.size());
+            DEBUG_VAR int write_res = send_write_message(&stream, &wm);
+            rassert(write_res == 0);
+            *value_out = stream.vector();
+        }
     }
     int64_t size_value(
             buf_parent_t parent,
@@ -217,6 +242,8 @@ private:
     Note that it can't be changed. This is OK because `limiting_..._consumer_t` never
     exists across multiple B-tree transactions, so the metainfo is constant. */
     const region_map_t<binary_blob_t> *const metainfo_ptr;
+
+    const field_dictionary_manager_t *const field_dictionary;
 };
 
 continue_bool_t store_t::send_backfill(
@@ -261,7 +288,7 @@ continue_bool_t store_t::send_backfill(
             region_map_t<binary_blob_t> metainfo_copy =
                 metainfo->get(sb.get(), region_t(pair.first));
             limiting_btree_backfill_item_consumer_t limiter(
-                item_consumer, &threshold, &metainfo_copy);
+                item_consumer, &threshold, &metainfo_copy, &field_dictionary);
 
             rdb_value_sizer_t sizer(cache->max_block_size());
             key_range_t to_do = pair.first;
@@ -235,6 +235,16 @@ global_optargs_t term_storage_t::global_optargs() {
     unreachable();
 }
 
+bool term_storage_t::match_point_get(UNUSED point_get_query_t *out) const {
+    return false;
+}
+
+bool term_storage_t::query_shape(
+        UNUSED std::string *key_out,
+        UNUSED std::vector<const rapidjson::Value *> *slots_out) const {
+    return false;
+}
+
 const backtrace_registry_t &term_storage_t::backtrace_registry() const {
     return bt_reg;
 }
@@ -322,6 +332,262 @@ bool json_term_storage_t::static_optarg_as_bool(const std::string &key,
 
 }
 
+// Returns the arguments of `term` if it is a term of the given type without optargs.
+const rapidjson::Value *term_args_without_optargs(const rapidjson::Value &term,
+                                                  Term::TermType type) {
+    if (!term.IsArray() || term.Size() != 2 ||
+        !term[0].IsInt() || term[0].GetInt() != static_cast<int>(type) ||
+        !term[1].IsArray()) {
+        return nullptr;
+    }
+    return &term[1];
+}
+
+// Matches `r.db(<string>)` and stores the name in `name_out`.
+bool match_literal_db_term(const rapidjson::Value &term, std::string *name_out) {
+    const rapidjson::Value *args = term_args_without_optargs(term, Term::DB);
+    if (args == nullptr || args->Size() != 1 || !(*args)[0].IsString()) {
+        return false;
+    }
+    name_out->assign((*args)[0].GetString(), (*args)[0].GetStringLength());
+    return true;
+}
+
+bool json_term_storage_t::match_point_get(point_get_query_t *out) const {
+    if (query_type() != Query::START || query_json.Size() < 2) {
+        return false;
+    }
+
+    // This is the same default as in `global_optargs()`.
+    std::string db_name("test");
+    if (query_json.Size() >= 3) {
+        const rapidjson::Value &optargs = query_json[2];
+        for (auto it = optargs.MemberBegin(); it != optargs.MemberEnd(); ++it) {
+            const std::string key(it->name.GetString(), it->name.GetStringLength());
+            if (key == "noreply" && it->value.IsBool()) {
+                continue;
+            } else if (key == "db" && match_literal_db_term(it->value, &db_name)) {
+                continue;
+            }
+            return false;
+        }
+    }
+
+    const rapidjson::Value *get_args =
+        term_args_without_optargs(query_json[1], Term::GET);
+    if (get_args == nullptr || get_args->Size() != 2) {
+        return false;
+    }
+    // Arrays and objects are terms in the JSON protocol, so only accept scalars.
+    const rapidjson::Value &key = (*get_args)[1];
+    if (!key.IsString() && !key.IsNumber()) {
+        return false;
+    }
+
+    const rapidjson::Value *table_args =
+        term_args_without_optargs((*get_args)[0], Term::TABLE);
+    if (table_args == nullptr) {
+        return false;
+    }
+    const rapidjson::Value *table_name;
+    if (table_args->Size() == 1) {
+        table_name = &(*table_args)[0];
+    } else if (table_args->Size() == 2
+               && match_literal_db_term((*table_args)[0], &db_name)) {
+        table_name = &(*table_args)[1];
+    } else {
+        return false;
+    }
+    if (!table_name->IsString()) {
+        return false;
+    }
+
+    out->db_name = std::move(db_name);
+    out->table_name.assign(table_name->GetString(), table_name->GetStringLength());
+    out->key = &key;
+    return true;
+}
+
+// Queries that are nested deeper than this or whose shape key is longer than this are
+// not worth caching. The depth limit also keeps `query_shape()` and the term walker
+// well within the stack of the coroutine that calls them.
+const size_t MAX_QUERY_SHAPE_DEPTH = 64;
+const size_t MAX_QUERY_SHAPE_KEY_SIZE = 16 * KILOBYTE;
+
+// Terms that do nothing with their positional arguments but evaluate them.
+bool term_takes_literal_slots(Term::TermType type) {
+    switch (type) {
+    case Term::MAKE_ARRAY:
+    case Term::DB:
+    case Term::TABLE:
+    case Term::GET:
+    case Term::GET_ALL:
+    case Term::BETWEEN:
+    case Term::EQ:
+    case Term::NE:
+    case Term::LT:
+    case Term::LE:
+    case Term::GT:
+    case Term::GE:
+    case Term::ADD:
+    case Term::SUB:
+    case Term::MUL:
+    case Term::DIV:
+    case Term::LIMIT:
+    case Term::SKIP:
+    case Term::NTH:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Appends an unambiguous encoding of a JSON value to `key_out`.
+bool write_shape_datum(const rapidjson::Value &value,
+                       size_t depth,
+                       std::string *key_out) {
+    if (depth > MAX_QUERY_SHAPE_DEPTH) {
+        return false;
+    }
+    switch (value.GetType()) {
+    case rapidjson::kNullType:
+        key_out->push_back('n');
+        break;
+    case rapidjson::kFalseType:
+        key_out->push_back('f');
+        break;
+    case rapidjson::kTrueType:
+        key_out->push_back('t');
+        break;
+    case rapidjson::kNumberType:
+        if (value.IsInt64()) {
+            key_out->append(strprintf("i%" PRIi64 ";", value.GetInt64()));
+        } else if (value.IsUint64()) {
+            key_out->append(strprintf("u%" PRIu64 ";", value.GetUint64()));
+        } else {
+            key_out->append(strprintf("d%a;", value.GetDouble()));
+        }
+        break;
+    case rapidjson::kStringType:
+        key_out->append(strprintf("s%u:", value.GetStringLength()));
+        key_out->append(value.GetString(), value.GetStringLength());
+        break;
+    case rapidjson::kArrayType:
+        key_out->push_back('[');
+        for (size_t i = 0; i < value.Size(); ++i) {
+            if (!write_shape_datum(value[i], depth + 1, key_out)) {
+                return false;
+            }
+        }
+        key_out->push_back(']');
+        break;
+    case rapidjson::kObjectType:
+        key_out->push_back('{');
+        for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+            if (!write_shape_datum(it->name, depth + 1, key_out) ||
+                !write_shape_datum(it->value, depth + 1, key_out)) {
+                return false;
+            }
+        }
+        key_out->push_back('}');
+        break;
+    default: unreachable();
+    }
+    return true;
+}
+
+// Appends the shape of a raw (not yet preprocessed) term to `key_out`. Scalars become
+// slots if `slots_ok` is set, which is the case if all terms above them take literal
+// slots.
+bool write_shape_term(const rapidjson::Value &term,
+                      bool slots_ok,
+                      size_t depth,
+                      std::string *key_out,
+                      std::vector<const rapidjson::Value *> *slots_out) {
+    if (depth > MAX_QUERY_SHAPE_DEPTH) {
+        return false;
+    }
+    if (term.IsObject()) {
+        // This is a `MAKE_OBJ` term.
+        key_out->push_back('{');
+        for (auto it = term.MemberBegin(); it != term.MemberEnd(); ++it) {
+            if (!write_shape_datum(it->name, depth + 1, key_out) ||
+                !write_shape_term(it->value, false, depth + 1, key_out, slots_out)) {
+                return false;
+            }
+        }
+        key_out->push_back('}');
+        return true;
+    } else if (!term.IsArray()) {
+        if (slots_ok) {
+            key_out->push_back('?');
+            slots_out->push_back(&term);
+            return true;
+        }
+        return write_shape_datum(term, depth, key_out);
+    }
+
+    // Leave malformed terms to the term walker, which reports them properly.
+    if (term.Size() == 0 || !term[0].IsInt()) {
+        return false;
+    }
+    Term::TermType type = static_cast<Term::TermType>(term[0].GetInt());
+    if (type == Term::NOW) {
+        // `r.now()` is replaced by the current time when the query is preprocessed.
+        return false;
+    } else if (type == Term::DATUM) {
+        return write_shape_datum(term, depth, key_out);
+    }
+
+    const bool arg_slots_ok = slots_ok && term_takes_literal_slots(type);
+    key_out->append(strprintf("[%d;", static_cast<int>(type)));
+    for (size_t i = 1; i < term.Size(); ++i) {
+        const rapidjson::Value &item = term[i];
+        if (item.IsArray()) {
+            key_out->push_back('(');
+            for (size_t j = 0; j < item.Size(); ++j) {
+                if (!write_shape_term(item[j], arg_slots_ok, depth + 1,
+                                      key_out, slots_out)) {
+                    return false;
+                }
+            }
+            key_out->push_back(')');
+        } else if (item.IsObject()) {
+            // Optargs never contain slots, since some terms compile them into
+            // functions from their raw terms (see `lazy_literal_optarg()`).
+            if (!write_shape_term(item, false, depth + 1, key_out, slots_out)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    key_out->push_back(']');
+    return true;
+}
+
+bool json_term_storage_t::query_shape(
+        std::string *key_out,
+        std::vector<const rapidjson::Value *> *slots_out) const {
+    if (query_type() != Query::START || query_json.Size() < 2 ||
+        !query_json[1].IsArray()) {
+        return false;
+    }
+
+    key_out->clear();
+    slots_out->clear();
+    if (!write_shape_term(query_json[1], true, 0, key_out, slots_out)) {
+        return false;
+    }
+    if (query_json.Size() >= 3) {
+        key_out->push_back('|');
+        if (!write_shape_term(query_json[2], false, 0, key_out, slots_out)) {
+            return false;
+        }
+    }
+    return key_out->size() <= MAX_QUERY_SHAPE_KEY_SIZE;
+}
+
 global_optargs_t json_term_storage_t::global_optargs() {
     auto &allocator = query_json.GetAllocator();
     rapidjson::Value *src;
@@ -118,6 +118,19 @@ private:
     }
 };
 
+// The parts of a `r.table(...).get(<literal>)` query that are needed to run it without
+// compiling it first. See `term_storage_t::match_point_get()`.
+struct point_get_query_t {
+    point_get_query_t() : key(nullptr) { }
+    std::string db_name;
+    std::string table_name;
+    const rapidjson::Value *key;
+};
+
+// Maps the literal arguments that `term_storage_t::query_shape()` extracted as slots
+// to their slot indexes.
+typedef std::map<const rapidjson::Value *, size_t> literal_slots_t;
+
 class term_storage_t {
 public:
     virtual ~term_storage_t() { }
@@ -134,6 +147,25 @@ public:
     virtual void preprocess();
     virtual global_optargs_t global_optargs();
 
+    // Returns `true` and fills in `out` if this is a `START` query of the form
+    // `r.table(t).get(k)` or `r.db(d).table(t).get(k)`, where all arguments are
+    // literals, no term has optargs, and the only global optargs are `db` and
+    // `noreply`. Must be called before `preprocess()`. The default implementation
+    // never matches.
+    virtual bool match_point_get(point_get_query_t *out) const;
+
+    // Returns `true` if this is a `START` query that may be compiled once and rerun
+    // from the query shape cache. `key_out` is set to an encoding of the query and its
+    // global optargs in which some literal arguments are replaced by slots, and those
+    // literals are appended to `slots_out` in order. Queries that have the same key
+    // compile to the same term tree except for the values of the slots. A literal only
+    // becomes a slot if all terms above it just evaluate their arguments (see
+    // `term_takes_literal_slots()`), because many other terms look at the raw terms of
+    // their arguments. Must be called before `preprocess()`. The default
+    // implementation never succeeds.
+    virtual bool query_shape(std::string *key_out,
+                             std::vector<const rapidjson::Value *> *slots_out) const;
+
 protected:
     backtrace_registry_t bt_reg;
 };
@@ -148,6 +180,9 @@ public:
     void preprocess();
     raw_term_t root_term() const;
     global_optargs_t global_optargs();
+    bool match_point_get(point_get_query_t *out) const;
+    bool query_shape(std::string *key_out,
+                     std::vector<const rapidjson::Value *> *slots_out) const;
 private:
     scoped_array_t<char> original_data;
     rapidjson::Document query_json;
@@ -2,6 +2,7 @@
 #include "rdb_protocol/terms/terms.hpp"
 
 #include <string>
+#include <vector>
 
 #include "rdb_protocol/op.hpp"
 
@@ -9,9 +10,12 @@ namespace ql {
 
 class datum_term_t : public term_t {
 public:
-    explicit datum_term_t(const raw_term_t &term)
+    static const size_t NO_SLOT = static_cast<size_t>(-1);
+
+    datum_term_t(const raw_term_t &term, size_t _slot)
             : term_t(term),
-              datum(term.datum(configured_limits_t::unlimited, reql_version_t::LATEST)) {
+              datum(term.datum(configured_limits_t::unlimited, reql_version_t::LATEST)),
+              slot(_slot) {
         r_sanity_check(datum.has());
     }
 
@@ -25,11 +29,21 @@ public:
 private:
     virtual void accumulate_captures(var_captures_t *) const { /* do nothing */ }
     virtual deterministic_t is_deterministic() const { return deterministic_t::always; }
-    virtual scoped_ptr_t<val_t> term_eval(scope_env_t *, eval_flags_t) const {
+    virtual scoped_ptr_t<val_t> term_eval(scope_env_t *env, eval_flags_t) const {
+        if (slot != NO_SLOT) {
+            const std::vector<datum_t> *literal_slots = env->env->literal_slots();
+            if (literal_slots != nullptr) {
+                r_sanity_check(slot < literal_slots->size());
+                return new_val((*literal_slots)[slot]);
+            }
+        }
         return new_val(datum);
     }
     virtual const char *name() const { return "datum"; }
     const datum_t datum;
+    // The literal slot this term was compiled for, if it is part of a cached query
+    // shape. See `term_storage_t::query_shape()`.
+    const size_t slot;
 };
 
 class constant_term_t : public op_term_t {
@@ -145,8 +159,19 @@ private:
 };
 
 counted_t<term_t> make_datum_term(
-        const raw_term_t &term) {
-    return make_counted<datum_term_t>(term);
+        compile_env_t *env, const raw_term_t &term) {
+    size_t slot = datum_term_t::NO_SLOT;
+    if (env->literal_slots != nullptr) {
+        term_variant_t src = term.get_src();
+        const rapidjson::Value **json = boost::get<const rapidjson::Value *>(&src);
+        if (json != nullptr) {
+            auto it = env->literal_slots->find(*json);
+            if (it != env->literal_slots->end()) {
+                slot = it->second;
+            }
+        }
+    }
+    return make_counted<datum_term_t>(term, slot);
 }
 counted_t<term_t> make_constant_term(
         compile_env_t *env, const raw_term_t &term,
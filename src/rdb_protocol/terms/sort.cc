@@ -107,6 +107,9 @@ private:
             rcheck(!comparisons.empty(), base_exc_t::LOGIC,
                    "Must specify something to order by.");
             std::vector<datum_t> to_sort;
+            // Rows that don't fit into an array get sorted on disk, if possible.
+            counted_t<external_sort_datum_stream_t> external_sort;
+            const size_t array_size_limit = env->env->limits().array_size_limit();
             batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
             for (;;) {
                 std::vector<datum_t> data
@@ -115,14 +118,29 @@ private:
                     break;
                 }
                 std::move(data.begin(), data.end(), std::back_inserter(to_sort));
+                if (to_sort.size() > array_size_limit
+                    && external_sort_datum_stream_t::can_spill(env->env)) {
+                    if (!external_sort.has()) {
+                        external_sort = make_counted<external_sort_datum_stream_t>(
+                            env->env, lt_cmp, backtrace());
+                    }
+                    external_sort->add_run(env->env, &to_sort);
+                }
                 rcheck_array_size(to_sort, env->env->limits());
             }
-            profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
-            auto fn = boost::bind(lt_cmp, env->env, &sampler, _1, _2);
-            std::stable_sort(to_sort.begin(), to_sort.end(), fn);
-            seq = make_counted<array_datum_stream_t>(
-                datum_t(std::move(to_sort), env->env->limits()),
-                backtrace());
+            if (external_sort.has()) {
+                if (!to_sort.empty()) {
+                    external_sort->add_run(env->env, &to_sort);
+                }
+                seq = external_sort;
+            } else {
+                profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
+                auto fn = boost::bind(lt_cmp, env->env, &sampler, _1, _2);
+                std::stable_sort(to_sort.begin(), to_sort.end(), fn);
+                seq = make_counted<array_datum_stream_t>(
+                    datum_t(std::move(to_sort), env->env->limits()),
+                    backtrace());
+            }
         }
         return tbl_slice.has()
             ? new_val(make_counted<selection_t>(tbl_slice->get_tbl(), seq))
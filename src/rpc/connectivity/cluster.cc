@@ -31,6 +31,13 @@
 // Number of messages after which the message handling loop yields
 #define MESSAGE_HANDLER_MAX_BATCH_SIZE           16
 
+// Messages at least this large go into the bulk lane if their handler allows it
+#define CLUSTER_BULK_MESSAGE_SIZE                (16 * KILOBYTE)
+
+// How many bytes of bulk messages a connection starts to write at a time. Messages are
+// never split, so a write can go over this by up to one message.
+#define CLUSTER_BULK_WRITE_SIZE                  (256 * KILOBYTE)
+
 // The cluster communication protocol version.
 static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_3_ext_is_latest,
               "We need to update CLUSTER_VERSION_STRING when we add a new cluster "
@@ -139,22 +146,23 @@ connectivity_cluster_t::connection_t::connection_t(
         const peer_address_t &_peer_address) THROWS_NOTHING :
     conn(_conn),
     peer_address(_peer_address),
+    control_batch_messages(0),
     flusher([&](signal_t *) {
         guarantee(this->conn != nullptr);
-        // We need to acquire the send_mutex because flushing the buffer
-        // must not interleave with other writes (restriction of linux_tcp_conn_t).
-        mutex_t::acq_t acq(&this->send_mutex);
-        // We ignore the return value of flush_buffer(). Closed connections
-        // must be handled elsewhere.
-        this->conn->flush_buffer();
+        this->write_lanes();
     }, 1),
     pm_collection(),
     pm_bytes_sent(secs_to_ticks(1), true),
+    pm_batch_messages(secs_to_ticks(1), false),
+    pm_batch_bytes(secs_to_ticks(1), false),
     pm_collection_membership(
         &_parent->parent->connectivity_collection,
         &pm_collection,
         uuid_to_str(_peer_id.get_uuid())),
     pm_bytes_sent_membership(&pm_collection, &pm_bytes_sent, "bytes_sent"),
+    pm_batch_messages_membership(
+        &pm_collection, &pm_batch_messages, "messages_per_write"),
+    pm_batch_bytes_membership(&pm_collection, &pm_batch_bytes, "bytes_per_write"),
     parent(_parent),
     peer_id(_peer_id),
     server_id(_server_id),
@@ -175,9 +183,66 @@ connectivity_cluster_t::connection_t::~connection_t() THROWS_NOTHING {
         parent->parent->connections.get()->delete_key(peer_id);
         drainers.get()->drain();
     });
+}
+
+void connectivity_cluster_t::connection_t::write_lanes() {
+    /* Let the senders that are ready to run add their messages first. This bounds
+    the delay that batching adds to a single pass over this thread's ready
+    coroutines, so an idle connection still sends each message right away. */
+    coro_t::yield();
+
+    std::vector<char> batch;
+    size_t messages;
+    std::vector<cond_t *> bulk_done;
+    {
+        ASSERT_NO_CORO_WAITING;
+        control_batch.swap(&batch);
+        messages = control_batch_messages;
+        control_batch_messages = 0;
+        /* Everybody who called `flusher.notify()` so far has their control message
+        in `batch`. Bulk messages are tracked by their `done` conds instead. */
+        flusher.include_latest_notifications();
+
+        /* We check the limit before adding a message rather than after, so every
+        write makes progress on the bulk lane. This is intentional: a single message
+        that is larger than `CLUSTER_BULK_WRITE_SIZE` is written in one piece, since
+        the receiver can't handle parts of a message. Control messages then wait for
+        that one write. */
+        size_t bulk_size = 0;
+        while (!bulk_queue.empty() && bulk_size < CLUSTER_BULK_WRITE_SIZE) {
+            const std::vector<char> &data = bulk_queue.front().data;
+            batch.insert(batch.end(), data.begin(), data.end());
+            bulk_size += data.size();
+            bulk_done.push_back(bulk_queue.front().done);
+            bulk_queue.pop_front();
+            ++messages;
+        }
+        if (!bulk_queue.empty()) {
+            /* Come back for the rest, but give the control lane a chance first. */
+            flusher.notify();
+        }
+    }
+    if (batch.empty()) {
+        return;
+    }
+    pm_batch_messages.record(messages);
+    pm_batch_bytes.record(batch.size());
 
-    /* The drainers have been destroyed, so nothing can be holding the `send_mutex`. */
-    guarantee(!send_mutex.is_locked());
+    /* Only one instance of `flusher` runs at a time, so writes can't interleave.
+    Closed connections are handled by `send_message()`. */
+    int64_t res = conn->write(batch.data(), batch.size());
+    if (res == -1) {
+        /* Close the other half of the connection to make sure that
+        `connectivity_cluster_t::run_t::handle()` notices that something is up */
+        if (conn->is_read_open()) {
+            conn->shutdown_read();
+        }
+    } else {
+        guarantee(res == static_cast<int64_t>(batch.size()));
+    }
+    for (cond_t *done : bulk_done) {
+        done->pulse();
+    }
 }
 
 // Helper function for the `run_t` constructor's initialization list
@@ -1434,7 +1499,7 @@ void connectivity_cluster_t::send_message(connection_t *connection,
     // We could be on _any_ thread.
 
     /* If the connection is being closed, just drop the message now. It's not going
-    to actually get sent anyway. That way we avoid getting in line for the send_mutex. */
+    to actually get sent anyway. That way we avoid adding it to the next write. */
     if (connection_keepalive.get_drain_signal()->is_pulsed()) {
         return;
     }
@@ -1492,54 +1557,52 @@ void connectivity_cluster_t::send_message(connection_t *connection,
     } else {
         on_thread_t threader(connection->conn->home_thread());
 
-        /* Acquire the send-mutex so we don't collide with other things trying
-        to send on the same connection. */
-        {
-            /* The `true` is for eager waiting, which is a significant performance
-            optimization in this case. */
-            mutex_t::acq_t acq(&connection->send_mutex, true);
-
-            /* Write the tag to the network */
+        // All cluster versions use a uint8_t tag here.
+        write_message_t wm;
+        static_assert(std::is_same<message_tag_t, uint8_t>::value,
+                      "We expect to be serializing a uint8_t -- if this has "
+                      "changed, the cluster communication format has changed and "
+                      "you need to ask yourself whether live cluster upgrades work."
+                      );
+        serialize_universal(&wm, tag);
+
+        bool bulk = buffer.vector().size() >= CLUSTER_BULK_MESSAGE_SIZE
+            && message_handlers[tag] != nullptr
+            && message_handlers[tag]->allows_reordering();
+        if (bulk) {
+            /* Queue the tag and the message in the bulk lane. */
+            cond_t done;
             {
-                // All cluster versions use a uint8_t tag here.
-                write_message_t wm;
-                static_assert(std::is_same<message_tag_t, uint8_t>::value,
-                              "We expect to be serializing a uint8_t -- if this has "
-                              "changed, the cluster communication format has changed and "
-                              "you need to ask yourself whether live cluster upgrades work."
-                              );
-                serialize_universal(&wm, tag);
-                make_buffered_tcp_conn_stream_wrapper_t buffered_conn(connection->conn);
-                int res = send_write_message(&buffered_conn, &wm);
-                if (res == -1) {
-                    /* Close the other half of the connection to make sure that
-                       `connectivity_cluster_t::run_t::handle()` notices that something is
-                       up */
-                    if (connection->conn->is_read_open()) {
-                        connection->conn->shutdown_read();
-                    }
-                    return;
-                }
+                ASSERT_NO_CORO_WAITING;
+                vector_stream_t message;
+                message.reserve(sizeof(message_tag_t) + buffer.vector().size());
+                DEBUG_VAR int res = send_write_message(&message, &wm);
+                rassert(res == 0);
+                DEBUG_VAR int64_t written = message.write(
+                    buffer.vector().data(), buffer.vector().size());
+                rassert(written == static_cast<int64_t>(buffer.vector().size()));
+                connection->bulk_queue.push_back(
+                    connection_t::bulk_message_t{std::vector<char>(), &done});
+                message.swap(&connection->bulk_queue.back().data);
             }
-
-            /* Write the message itself to the network */
+            connection->flusher.notify();
+            done.wait_lazily_unordered();
+        } else {
+            /* Add the tag and the message to the connection's next write. */
             {
-                int64_t res = connection->conn->write_buffered(buffer.vector().data(),
-                                                               buffer.vector().size());
-                if (res == -1) {
-                    if (connection->conn->is_read_open()) {
-                        connection->conn->shutdown_read();
-                    }
-                    return;
-                } else {
-                    guarantee(res == static_cast<int64_t>(buffer.vector().size()));
-                }
+                ASSERT_NO_CORO_WAITING;
+                DEBUG_VAR int res =
+                    send_write_message(&connection->control_batch, &wm);
+                rassert(res == 0);
+                DEBUG_VAR int64_t written = connection->control_batch.write(
+                    buffer.vector().data(), buffer.vector().size());
+                rassert(written == static_cast<int64_t>(buffer.vector().size()));
+                connection->control_batch_messages += 1;
             }
-        } /* Releases the send_mutex */
-
-        connection->flusher.notify();
-        cond_t dummy_interruptor;
-        connection->flusher.flush(&dummy_interruptor);
+            connection->flusher.notify();
+            cond_t dummy_interruptor;
+            connection->flusher.flush(&dummy_interruptor);
+        }
         if (!connection->conn->is_write_open()) {
             if (connection->conn->is_read_open()) {
                 connection->conn->shutdown_read();
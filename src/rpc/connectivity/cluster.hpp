@@ -4,6 +4,7 @@
 
 #include <openssl/ssl.h>
 
+#include <deque>
 #include <map>
 #include <set>
 #include <string>
@@ -16,6 +17,7 @@
 #include "concurrency/one_per_thread.hpp"
 #include "concurrency/watchable_map.hpp"
 #include "containers/archive/tcp_conn_stream.hpp"
+#include "containers/archive/vector_stream.hpp"
 #include "containers/map_sentries.hpp"
 #include "concurrency/pump_coro.hpp"
 #include "perfmon/perfmon.hpp"
@@ -149,6 +151,9 @@ public:
             const peer_address_t &peer_address) THROWS_NOTHING;
         ~connection_t() THROWS_NOTHING;
 
+        /* The callback of `flusher`. */
+        void write_lanes();
+
         /* NULL for the loopback connection (i.e. our "connection" to ourself) */
         keepalive_tcp_conn_stream_t *conn;
 
@@ -157,16 +162,34 @@ public:
         cross-thread to access the routing table. */
         peer_address_t peer_address;
 
-        /* Unused for our connection to ourself */
-        mutex_t send_mutex;
+        /* Unused for our connection to ourself. Outgoing messages are serialized
+        along with their tags into one of two lanes, which are only accessed on
+        `conn`'s home thread:
+          - `control_batch` gets most messages. `flusher` writes everything that
+            accumulated there with a single write, so a burst of small messages from
+            many coroutines costs one system call instead of one per message.
+          - `bulk_queue` gets large messages of handlers that don't need their
+            messages to arrive in order, such as backfill chunks. `flusher` only
+            writes a bounded amount of them at a time, after the control messages,
+            so that large transfers don't hold up heartbeats, Raft traffic and
+            queries behind them. */
+        vector_stream_t control_batch;
+        size_t control_batch_messages;
+        struct bulk_message_t {
+            std::vector<char> data;
+            cond_t *done;
+        };
+        std::deque<bulk_message_t> bulk_queue;
 
-        /* Calls `conn->flush_buffer()`. Can be used for making sure that a
-        buffered write makes it to the TCP stack. */
+        /* Writes out the lanes. `send_message()` waits for it to make sure that its
+        message makes it to the TCP stack. */
         pump_coro_t flusher;
 
         perfmon_collection_t pm_collection;
         perfmon_sampler_t pm_bytes_sent;
+        perfmon_sampler_t pm_batch_messages, pm_batch_bytes;
         perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership;
+        perfmon_membership_t pm_batch_messages_membership, pm_batch_bytes_membership;
 
         /* We only hold this information so we can deregister ourself */
         run_t *parent;
@@ -409,6 +432,10 @@ protected:
                               connectivity_cluster_t::message_tag_t tag);
     virtual ~cluster_message_handler_t();
 
+    /* Whether the handler's messages may arrive in a different order than they were
+    sent in. If so, large messages are sent in the bulk lane of the connection. */
+    virtual bool allows_reordering() const { return false; }
+
     /* This can be called on any thread. */
     virtual void on_message(connectivity_cluster_t::connection_t *conn,
                             auto_drainer_t::lock_t keepalive,
@@ -7,6 +7,7 @@
 
 #include "debug.hpp"
 #include "containers/archive/archive.hpp"
+#include "containers/archive/shared_buf_stream.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/archive/versioned.hpp"
 #include "concurrency/pmap.hpp"
@@ -225,22 +226,22 @@ void mailbox_manager_t::on_message(
     read_mailbox_header(stream, &mbox_header);
 
     // Read the data from the read stream, so it can be deallocated before we continue
-    // in a coroutine
-    std::vector<char> stream_data;
-    stream_data.resize(mbox_header.data_length);
-    int64_t bytes_read = force_read(stream, stream_data.data(), mbox_header.data_length);
+    // in a coroutine. It goes into a shared buffer so that deserializers can refer to
+    // parts of it instead of copying them out again (see `datum_deserialize()`).
+    counted_t<shared_buf_t> stream_data = shared_buf_t::create(mbox_header.data_length);
+    int64_t bytes_read =
+        force_read(stream, stream_data->data(), mbox_header.data_length);
     if (bytes_read != static_cast<int64_t>(mbox_header.data_length)) {
         throw fake_archive_exc_t();
     }
 
-    // We use `spawn_now_dangerously()` to avoid having to heap-allocate `stream_data`.
-    // Instead we pass in a pointer to our local automatically allocated object
-    // and `mailbox_read_coroutine()` moves the data out of it before it yields.
+    counted_t<const shared_buf_t> shared_data(std::move(stream_data));
     coro_t::spawn_now_dangerously(
-        [this, mbox_header, &stream_data]() {
-            mailbox_read_coroutine(
+        [this, mbox_header, shared_data]() mutable {
+            shared_buf_read_stream_t data_stream(std::move(shared_data));
+            deliver_message(
                 threadnum_t(mbox_header.dest_thread), mbox_header.dest_mailbox_id,
-                &stream_data, 0, MAYBE_YIELD);
+                &data_stream, MAYBE_YIELD);
         });
 }
 
@@ -256,6 +257,14 @@ void mailbox_manager_t::mailbox_read_coroutine(
     stream_data = nullptr; // <- It is not safe to use `stream_data` anymore once we
                         //    switch the thread
 
+    deliver_message(dest_thread, dest_mailbox_id, &stream, force_yield);
+}
+
+void mailbox_manager_t::deliver_message(
+        threadnum_t dest_thread,
+        raw_mailbox_t::id_t dest_mailbox_id,
+        read_stream_t *stream,
+        force_yield_t force_yield) {
     {
         on_thread_t rethreader(dest_thread);
         if (force_yield == FORCE_YIELD && rethreader.home_thread() == get_thread_id()) {
@@ -269,7 +278,7 @@ void mailbox_manager_t::mailbox_read_coroutine(
             if (mbox != nullptr) {
                 try {
                     auto_drainer_t::lock_t keepalive(&mbox->drainer);
-                    mbox->callback->read(&stream, keepalive.get_drain_signal());
+                    mbox->callback->read(stream, keepalive.get_drain_signal());
                 } catch (const interrupted_exc_t &) {
                     /* Do nothing. It's no longer safe to access `mbox` (because the
                     destructor is running) but otherwise we don't need to take any
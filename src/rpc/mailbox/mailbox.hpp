@@ -170,6 +170,10 @@ private:
                                       raw_mailbox_t::id_t dest_mailbox_id,
                                       mailbox_write_callback_t *callback);
 
+    /* Mailbox messages are not necessarily delivered in order anyway (see
+    `send_write()`). */
+    bool allows_reordering() const { return true; }
+
     void on_message(connectivity_cluster_t::connection_t *connection,
                     auto_drainer_t::lock_t connection_keeepalive,
                     read_stream_t *stream);
@@ -183,6 +187,10 @@ private:
                                 std::vector<char> *stream_data,
                                 int64_t stream_data_offset,
                                 force_yield_t force_yield);
+    void deliver_message(threadnum_t dest_thread,
+                         raw_mailbox_t::id_t dest_mailbox_id,
+                         read_stream_t *stream,
+                         force_yield_t force_yield);
 };
 
 /* Note: disconnect_watcher_t keeps the connection alive for as long as it
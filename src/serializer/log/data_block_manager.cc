@@ -10,6 +10,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "concurrency/mutex.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "containers/lz4_block.hpp"
 #include "errors.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
@@ -59,7 +60,10 @@ class gc_entry_t : public intrusive_list_node_t<gc_entry_t> {
 private:
     struct block_info_t {
         uint32_t relative_offset;
+        // The size of the block, and the space it takes up in the extent.  The two
+        // only differ for compressed blocks.
         block_size_t block_size;
+        block_size_t disk_block_size;
         bool token_referenced;
         bool index_referenced;
     };
@@ -125,17 +129,24 @@ public:
         return block_infos.empty()
             ? 0
             : block_infos.back().relative_offset
-            + aligned_value(block_infos.back().block_size);
+            + aligned_value(block_infos.back().disk_block_size);
     }
 
-    // Returns the ostensible size of the block_index'th block.  Note that
-    // block_boundaries[i] + block_size(i) <= block_boundaries[i + 1].
+    // Returns the ostensible size of the block_index'th block.
     block_size_t block_size(unsigned int block_index) const {
         guarantee(state != state_reconstructing);
         guarantee(block_index < block_infos.size());
         return block_infos[block_index].block_size;
     }
 
+    // Returns the on-disk size of the block_index'th block.  Note that
+    // block_boundaries[i] + disk_block_size(i) <= block_boundaries[i + 1].
+    block_size_t disk_block_size(unsigned int block_index) const {
+        guarantee(state != state_reconstructing);
+        guarantee(block_index < block_infos.size());
+        return block_infos[block_index].disk_block_size;
+    }
+
     // Returns block_boundaries()[block_index].
     uint32_t relative_offset(unsigned int block_index) const {
         guarantee(state != state_reconstructing);
@@ -155,22 +166,25 @@ public:
     }
 
     bool new_offset(block_size_t block_size,
+                    block_size_t disk_block_size,
                     uint32_t *relative_offset_out,
                     unsigned int *block_index_out) {
         // Returns true if there's enough room at the end of the extent for the new
         // block.
         guarantee(state == state_active);
-        guarantee(block_size.ser_value() <= parent->static_config->extent_size());
+        guarantee(disk_block_size.ser_value() <= parent->static_config->extent_size());
 
         uint32_t offset = back_relative_offset();
         guarantee(offset <= parent->static_config->extent_size());
 
-        if (offset > parent->static_config->extent_size() - block_size.ser_value()) {
+        if (offset > parent->static_config->extent_size()
+                     - disk_block_size.ser_value()) {
             return false;
         } else {
             *relative_offset_out = offset;
             *block_index_out = block_infos.size();
-            block_infos.push_back(block_info_t{offset, block_size, false, false});
+            block_infos.push_back(
+                block_info_t{offset, block_size, disk_block_size, false, false});
             update_stats(nullptr, &block_infos.back());
             return true;
         }
@@ -221,7 +235,7 @@ public:
         uint32_t b = 0;
         for (auto it = block_infos.begin(); it < block_infos.end(); ++it) {
             if (it->token_referenced) {
-                b += aligned_value(it->block_size);
+                b += aligned_value(it->disk_block_size);
             }
         }
         return b;
@@ -235,22 +249,27 @@ public:
         return std::lower_bound(block_infos.begin(), block_infos.end(), relative_offset, &gc_entry_t::info_less);
     }
 
-    void mark_live_indexwise_with_offset(int64_t offset, block_size_t block_size) {
+    void mark_live_indexwise_with_offset(int64_t offset, block_size_t block_size,
+                                         block_size_t disk_block_size) {
         guarantee(offset >= extent_ref.offset() && offset < extent_ref.offset() + UINT32_MAX);
 
         uint32_t relative_offset = offset - extent_ref.offset();
 
         auto it = find_lower_bound_iter(relative_offset);
         if (it == block_infos.end()) {
-            block_infos.push_back(block_info_t{relative_offset, block_size, false, true});
+            block_infos.push_back(block_info_t{relative_offset, block_size,
+                                               disk_block_size, false, true});
             update_stats(nullptr, &block_infos.back());
         } else if (it->relative_offset > relative_offset) {
-            guarantee(it->relative_offset >= relative_offset + aligned_value(block_size));
-            auto new_block = block_infos.insert(it, block_info_t{relative_offset, block_size, false, true});
+            guarantee(it->relative_offset
+                      >= relative_offset + aligned_value(disk_block_size));
+            auto new_block = block_infos.insert(it, block_info_t{relative_offset, block_size,
+                                                                 disk_block_size, false, true});
             update_stats(nullptr, &*new_block);
         } else {
             guarantee(it->relative_offset == relative_offset);
             guarantee(it->block_size == block_size);
+            guarantee(it->disk_block_size == disk_block_size);
             const block_info_t old_info = *it;
             it->index_referenced = true;
             update_stats(&old_info, &*it);
@@ -274,7 +293,7 @@ public:
         uint32_t b = 0;
         for (auto it = block_infos.begin(); it < block_infos.end(); ++it) {
             if (it->index_referenced) {
-                b += aligned_value(it->block_size);
+                b += aligned_value(it->disk_block_size);
             }
         }
         return b;
@@ -291,7 +310,7 @@ public:
         for (auto it = block_infos.begin(); it != block_infos.end(); ++it) {
             ret += strprintf("%s[%" PRIi64 "..+%" PRIu32 ") %c%c",
                              it == block_infos.begin() ? "" : separator,
-                             offset + it->relative_offset, it->block_size.ser_value(),
+                             offset + it->relative_offset, it->disk_block_size.ser_value(),
                              it->token_referenced ? 'T' : ' ',
                              it->index_referenced ? 'I' : ' ');
         }
@@ -313,14 +332,14 @@ private:
             if (old_block->token_referenced || old_block->index_referenced) {
                 // Block is live
                 num_live_blocks_stat -= 1;
-                garbage_bytes_stat += aligned_value(old_block->block_size);
+                garbage_bytes_stat += aligned_value(old_block->disk_block_size);
             }
         }
         // Apply new_block
         if (new_block->token_referenced || new_block->index_referenced) {
             // Block is live
             num_live_blocks_stat += 1;
-            garbage_bytes_stat -= aligned_value(new_block->block_size);
+            garbage_bytes_stat -= aligned_value(new_block->disk_block_size);
         }
     }
 
@@ -412,7 +431,8 @@ void data_block_manager_t::start_reconstruct() {
 // gc_entry_t in the entries table.  (This is used when we start up, when
 // everything is presumed to be garbage, until we mark it as
 // non-garbage.)
-void data_block_manager_t::mark_live(int64_t offset, block_size_t ser_block_size) {
+void data_block_manager_t::mark_live(int64_t offset, block_size_t block_size,
+                                     block_size_t disk_block_size) {
     uint64_t extent_id = static_config->extent_index(offset);
 
     if (entries.get(extent_id) == nullptr) {
@@ -423,7 +443,7 @@ void data_block_manager_t::mark_live(int64_t offset, block_size_t ser_block_size
     }
 
     gc_entry_t *entry = entries.get(extent_id);
-    entry->mark_live_indexwise_with_offset(offset, ser_block_size);
+    entry->mark_live_indexwise_with_offset(offset, block_size, disk_block_size);
 }
 
 void data_block_manager_t::end_reconstruct() {
@@ -566,6 +586,22 @@ void read_ahead_offset_and_size(int64_t off_in,
     *size_out = end_offset - offset;
 }
 
+// Turns a compressed block, as it's stored on disk, back into the block that the
+// cache wrote.
+buf_ptr_t decompress_block(const ser_buffer_t *disk_buf,
+                           block_size_t disk_block_size,
+                           block_size_t block_size) {
+    rassert(disk_block_size.ser_value() < block_size.ser_value());
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+    ret.ser_buffer()->ser_header = disk_buf->ser_header;
+    const bool ok = lz4_decompress_block(disk_buf->cache_data, disk_block_size.value(),
+                                         ret.cache_data(), block_size.value());
+    guarantee(ok, "Compressed block %" PRIu64 " is corrupted.",
+              disk_buf->ser_header.block_id);
+    ret.fill_padding_zero();
+    return ret;
+}
+
 class dbm_read_ahead_t {
 public:
     static std::vector<uint32_t> get_boundaries(data_block_manager_t *parent,
@@ -643,15 +679,26 @@ public:
                     continue;
                 }
 
-                const block_size_t block_size = block_size_t::unsafe_make(info.ser_block_size);
-                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
-                memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
-                buf.fill_padding_zero();
                 guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
+                const block_size_t disk_block_size
+                    = block_size_t::unsafe_make(info.ser_block_size);
+                const block_size_t block_size
+                    = block_size_t::unsafe_make(info.logical_ser_block_size());
+                buf_ptr_t buf;
+                if (block_size == disk_block_size) {
+                    buf = buf_ptr_t::alloc_uninitialized(block_size);
+                    memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
+                    buf.fill_padding_zero();
+                } else {
+                    buf = decompress_block(
+                        reinterpret_cast<const ser_buffer_t *>(current_buf),
+                        disk_block_size, block_size);
+                }
 
                 counted_t<ls_block_token_pointee_t> ls_token
                     = parent->serializer->generate_block_token(current_offset,
-                                                               block_size);
+                                                               block_size,
+                                                               disk_block_size);
 
                 counted_t<standard_block_token_t> token
                     = to_standard_block_token(block_id, std::move(ls_token));
@@ -679,8 +726,18 @@ bool data_block_manager_t::should_perform_read_ahead(int64_t offset) {
 }
 
 buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
-                                   file_account_t *io_account) {
+                                     block_size_t disk_block_size,
+                                     file_account_t *io_account) {
     guarantee(state == state_ready);
+    buf_ptr_t ret = read_disk_block(off_in, disk_block_size, io_account);
+    if (block_size != disk_block_size) {
+        ret = decompress_block(ret.ser_buffer(), disk_block_size, block_size);
+    }
+    return ret;
+}
+
+buf_ptr_t data_block_manager_t::read_disk_block(int64_t off_in, block_size_t block_size,
+                                                file_account_t *io_account) {
     if (should_perform_read_ahead(off_in)) {
         buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
         dbm_read_ahead_t::perform_read_ahead(this, off_in, block_size.ser_value(),
@@ -718,20 +775,72 @@ buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
     }
 }
 
+data_block_manager_t::encoded_write_t
+data_block_manager_t::encode_block(const buf_write_info_t &write,
+                                   buf_ptr_t *storage_out) {
+    write.buf->ser_header.block_id = write.block_id;
+    encoded_write_t ret{write.buf, write.block_size, write.block_size};
+    if (write.compression == block_compression_t::NONE) {
+        return ret;
+    }
+
+    // Blocks take up whole device blocks on disk, so compression only pays off if
+    // it saves at least one of them.  We don't let the compressor produce more
+    // than that, which also makes it bail out early on incompressible data.
+    const uint32_t aligned_size = gc_entry_t::aligned_value(write.block_size);
+    if (aligned_size > DEVICE_BLOCK_SIZE) {
+        const block_size_t max_disk_block_size
+            = block_size_t::unsafe_make(aligned_size - DEVICE_BLOCK_SIZE);
+        buf_ptr_t compressed = buf_ptr_t::alloc_uninitialized(max_disk_block_size);
+        const size_t compressed_size
+            = lz4_compress_block(write.buf->cache_data, write.block_size.value(),
+                                 compressed.cache_data(), max_disk_block_size.value());
+        if (compressed_size != 0) {
+            compressed.ser_buffer()->ser_header = write.buf->ser_header;
+            compressed.resize_fill_zero(block_size_t::make_from_cache(compressed_size));
+            compressed.fill_padding_zero();
+            ret.buf = compressed.ser_buffer();
+            ret.disk_block_size = compressed.block_size();
+            *storage_out = std::move(compressed);
+        }
+    }
+
+    stats->block_compressed(ret.block_size.ser_value(),
+                            ret.disk_block_size.ser_value());
+    return ret;
+}
+
 std::vector<counted_t<ls_block_token_pointee_t> >
 data_block_manager_t::many_writes(const buf_write_info_t *writes,
                                   size_t writes_count,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
+    std::vector<encoded_write_t> encoded_writes;
+    encoded_writes.reserve(writes_count);
+    std::vector<buf_ptr_t> storage;
+    for (size_t i = 0; i < writes_count; ++i) {
+        buf_ptr_t compressed;
+        encoded_writes.push_back(encode_block(writes[i], &compressed));
+        if (compressed.has()) {
+            storage.push_back(std::move(compressed));
+        }
+    }
+
+    return write_encoded_blocks(encoded_writes.data(), encoded_writes.size(),
+                                std::move(storage), io_account, cb);
+}
+
+std::vector<counted_t<ls_block_token_pointee_t> >
+data_block_manager_t::write_encoded_blocks(const encoded_write_t *writes,
+                                           size_t writes_count,
+                                           std::vector<buf_ptr_t> &&storage,
+                                           file_account_t *io_account,
+                                           iocallback_t *cb) {
     // These tokens are grouped by extent.  You can do a contiguous write in each
     // extent.
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > token_groups
         = gimme_some_new_offsets(writes, writes_count);
 
-    for (size_t i = 0; i < writes_count; ++i) {
-        writes[i].buf->ser_header.block_id = writes[i].block_id;
-    }
-
     struct intermediate_cb_t : public iocallback_t {
         virtual void on_io_complete() {
             --ops_remaining;
@@ -744,6 +853,9 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
 
         size_t ops_remaining;
         iocallback_t *cb;
+        // Compressed copies of the blocks, which we have to keep around until
+        // the writes are done.
+        std::vector<buf_ptr_t> storage;
     };
 
     intermediate_cb_t *const intermediate_cb = new intermediate_cb_t;
@@ -751,13 +863,14 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
     // intermediate_cb->on_io_complete later.
     intermediate_cb->ops_remaining = token_groups.size() + 1;
     intermediate_cb->cb = cb;
+    intermediate_cb->storage = std::move(storage);
 
     size_t write_number = 0;
     for (size_t i = 0; i < token_groups.size(); ++i) {
 
         const int64_t front_offset = token_groups[i].front()->offset();
         const int64_t back_offset = token_groups[i].back()->offset()
-            + gc_entry_t::aligned_value(token_groups[i].back()->block_size());
+            + gc_entry_t::aligned_value(token_groups[i].back()->disk_block_size());
 
         guarantee(divides(DEVICE_BLOCK_SIZE, front_offset));
 
@@ -770,14 +883,15 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
 
         for (size_t j = 0; j < token_groups[i].size(); ++j) {
             const int64_t j_offset = token_groups[i][j]->offset();
-            const block_size_t j_block_size = token_groups[i][j]->block_size();
+            const block_size_t j_disk_block_size
+                = token_groups[i][j]->disk_block_size();
             guarantee(j_offset == last_written_offset);
-            const size_t j_aligned_size = gc_entry_t::aligned_value(j_block_size);
+            const size_t j_aligned_size = gc_entry_t::aligned_value(j_disk_block_size);
             total_aligned_size += j_aligned_size;
 
             // The behavior of gimme_some_new_offsets is supposed to retain order, so
             // we expect writes[write_number] to have the currently-relevant write.
-            guarantee(writes[write_number].block_size == j_block_size);
+            guarantee(writes[write_number].disk_block_size == j_disk_block_size);
 
             iovecs[j].iov_base = writes[write_number].buf;
             iovecs[j].iov_len = j_aligned_size;
@@ -938,7 +1052,7 @@ void data_block_manager_t::mark_garbage(int64_t offset, extent_transaction_t *tx
     // Add to old garbage count if necessary (works because of the
     // !entry->block_is_garbage(block_index) assertion above).
     if (entry->state == gc_entry_t::state_old && entry->block_is_garbage(block_index)) {
-        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->block_size(block_index));
+        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->disk_block_size(block_index));
     }
 
     check_and_handle_empty_extent(extent_id);
@@ -968,7 +1082,7 @@ void data_block_manager_t::mark_garbage_tokenwise_with_offset(int64_t offset) {
     // Add to old garbage count if necessary (works because of the
     // !entry->block_is_garbage(block_index) assertion above).
     if (entry->state == gc_entry_t::state_old && entry->block_is_garbage(block_index)) {
-        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->block_size(block_index));
+        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->disk_block_size(block_index));
     }
 
     check_and_handle_empty_extent(extent_id);
@@ -1096,7 +1210,8 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
 
                 const uint32_t end
                     = gc_state->current_entry->relative_offset(i)
-                    + gc_entry_t::aligned_value(gc_state->current_entry->block_size(i));
+                    + gc_entry_t::aligned_value(
+                        gc_state->current_entry->disk_block_size(i));
 
                 if (beg <= current_interval_end) {
                     current_interval_end = end;
@@ -1172,7 +1287,8 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
                     + gc_state->current_entry->relative_offset(i);
 
                 gc_writes.push_back(gc_write_t(block, block_offset,
-                    gc_state->current_entry->block_size(i)));
+                    gc_state->current_entry->block_size(i),
+                    gc_state->current_entry->disk_block_size(i)));
             }
             guarantee(gc_writes.size() == num_writes);
         }
@@ -1229,20 +1345,23 @@ void data_block_manager_t::write_gcs(
         // Step 1: Write buffers to disk and assemble index operations
         ASSERT_NO_CORO_WAITING;
 
-        std::vector<buf_write_info_t> the_writes;
+        // The blocks are copied as they are on disk, compressed or not.
+        std::vector<encoded_write_t> the_writes;
         the_writes.reserve(writes.size());
         for (size_t i = 0; i < writes.size(); ++i) {
             old_block_tokens.push_back(serializer->generate_block_token(writes[i].old_offset,
-                                                                        writes[i].block_size));
+                                                                        writes[i].block_size,
+                                                                        writes[i].disk_block_size));
 
-            the_writes.push_back(buf_write_info_t(writes[i].buf,
-                                                  writes[i].block_size,
-                                                  writes[i].buf->ser_header.block_id));
+            the_writes.push_back(encoded_write_t{writes[i].buf,
+                                                 writes[i].block_size,
+                                                 writes[i].disk_block_size});
         }
 
-        new_block_tokens = many_writes(the_writes.data(), the_writes.size(),
-                                       choose_gc_io_account(),
-                                       &block_write_cond);
+        new_block_tokens = write_encoded_blocks(the_writes.data(), the_writes.size(),
+                                                std::vector<buf_ptr_t>(),
+                                                choose_gc_io_account(),
+                                                &block_write_cond);
 
         guarantee(new_block_tokens.size() == writes.size());
     }
@@ -1414,7 +1533,7 @@ void data_block_manager_t::actually_shutdown() {
 }
 
 std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
+data_block_manager_t::gimme_some_new_offsets(const encoded_write_t *writes,
                                              size_t writes_count) {
     ASSERT_NO_CORO_WAITING;
 
@@ -1431,10 +1550,11 @@ data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
 
     std::vector<counted_t<ls_block_token_pointee_t> > tokens;
     for (size_t i = 0; i < writes_count; ++i) {
-        block_size_t block_size = writes[i].block_size;
+        const block_size_t block_size = writes[i].block_size;
+        const block_size_t disk_block_size = writes[i].disk_block_size;
         uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
         unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
-        if (!active_extent->new_offset(block_size,
+        if (!active_extent->new_offset(block_size, disk_block_size,
                                        &relative_offset, &block_index)) {
             // Move the active_extent gc_entry_t to the young extent queue (if it's
             // not already empty), and make a new gc_entry_t.
@@ -1451,6 +1571,7 @@ data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
 
             ++stats->pm_serializer_data_extents_allocated;
             const bool succeeded = active_extent->new_offset(block_size,
+                                                             disk_block_size,
                                                              &relative_offset,
                                                              &block_index);
             guarantee(succeeded);
@@ -1466,7 +1587,8 @@ data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
         active_extent->was_written = true;
         active_extent->mark_live_tokenwise(block_index);
 
-        tokens.push_back(serializer->generate_block_token(offset, block_size));
+        tokens.push_back(serializer->generate_block_token(offset, block_size,
+                                                          disk_block_size));
     }
 
     if (!tokens.empty()) {
@@ -47,8 +47,10 @@ public:
     static void prepare_initial_metablock(data_block_manager::metablock_mixin_t *mb);
     void start_existing(file_t *dbfile, data_block_manager::metablock_mixin_t *last_metablock);
 
+    // Reads `disk_block_size` bytes at `off_in` and decompresses them into a
+    // block of `block_size` bytes, if the two sizes differ.
     buf_ptr_t read(int64_t off_in, block_size_t block_size,
-                 file_account_t *io_account);
+                   block_size_t disk_block_size, file_account_t *io_account);
 
     /* exposed gc api */
     /* mark a buffer as garbage */
@@ -56,7 +58,8 @@ public:
 
     /* r{start,end}_reconstruct functions for safety */
     void start_reconstruct();
-    void mark_live(int64_t offset, block_size_t block_size);
+    void mark_live(int64_t offset, block_size_t block_size,
+                   block_size_t disk_block_size);
     void end_reconstruct();
 
     /* We must make sure that blocks which have tokens pointing to them don't
@@ -87,14 +90,38 @@ public:
                 file_account_t *io_account,
                 iocallback_t *cb);
 
-    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-    gimme_some_new_offsets(const buf_write_info_t *writes, size_t writes_count);
-
     bool is_gc_active() const;
 
 private:
     void actually_shutdown();
 
+    // A block the way it goes to disk: `buf` holds `disk_block_size` bytes, which
+    // decompress to `block_size` bytes unless the two sizes are equal.
+    struct encoded_write_t {
+        ser_buffer_t *buf;
+        block_size_t block_size;
+        block_size_t disk_block_size;
+    };
+
+    // Compresses `write` if it asks for it and it's worth it.  If the block got
+    // compressed, `*storage_out` holds the compressed copy.
+    encoded_write_t encode_block(const buf_write_info_t &write, buf_ptr_t *storage_out);
+
+    buf_ptr_t read_disk_block(int64_t off_in, block_size_t disk_block_size,
+                              file_account_t *io_account);
+
+    // `storage` holds buffers that `writes` point into, which have to stay alive
+    // until the writes are complete.
+    std::vector<counted_t<ls_block_token_pointee_t> >
+    write_encoded_blocks(const encoded_write_t *writes,
+                         size_t writes_count,
+                         std::vector<buf_ptr_t> &&storage,
+                         file_account_t *io_account,
+                         iocallback_t *cb);
+
+    std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
+    gimme_some_new_offsets(const encoded_write_t *writes, size_t writes_count);
+
     struct gc_state_t : public intrusive_list_node_t<gc_state_t>{
     public:
         // The entry we're currently GCing.
@@ -107,14 +134,17 @@ private:
             : current_entry(nullptr) { }
     };
 
+    // GC copies blocks without decompressing them, so `buf` holds
+    // `disk_block_size` bytes.
     struct gc_write_t {
         ser_buffer_t *buf;
         int64_t old_offset;
         block_size_t block_size;
+        block_size_t disk_block_size;
         gc_write_t(ser_buffer_t *b, int64_t _old_offset,
-                   block_size_t _block_size)
+                   block_size_t _block_size, block_size_t _disk_block_size)
             : buf(b), old_offset(_old_offset),
-              block_size(_block_size) { }
+              block_size(_block_size), disk_block_size(_disk_block_size) { }
     };
 
     /* Runs in a coroutine and keeps calling `gc_one_extent()` for as long as
@@ -1,6 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "serializer/log/lba/disk_extent.hpp"
 
+#include <limits>
+
 #include "arch/arch.hpp"
 #include "math.hpp"
 
@@ -64,8 +66,11 @@ void lba_disk_extent_t::read_step_2(read_info_t *info, in_memory_index_t *index)
             // We've never actually used them, and we now use 16 bit block sizes
             // for the in-memory index to save a few bytes.
             guarantee(e->ser_block_size <= std::numeric_limits<uint16_t>::max());
+            guarantee(e->uncompressed_ser_block_size
+                      <= std::numeric_limits<uint16_t>::max());
             index->set_block_info(e->block_id, e->recency, e->offset,
-                                  static_cast<uint16_t>(e->ser_block_size));
+                                  static_cast<uint16_t>(e->ser_block_size),
+                                  static_cast<uint16_t>(e->uncompressed_ser_block_size));
         }
     }
 
@@ -21,14 +21,16 @@ index_block_info_t in_memory_index_t::get_block_info(block_id_t id) {
         index_aux_block_info_t aux_info = aux_infos_.get(make_aux_block_id_relative(id));
         return index_block_info_t(aux_info.offset,
                                   repli_timestamp_t::invalid,
-                                  aux_info.ser_block_size);
+                                  aux_info.ser_block_size,
+                                  aux_info.uncompressed_ser_block_size);
     } else {
         return infos_.get(id);
     }
 }
 
 void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
-                                       flagged_off64_t offset, uint16_t ser_block_size) {
+                                       flagged_off64_t offset, uint16_t ser_block_size,
+                                       uint16_t uncompressed_ser_block_size) {
     if (is_aux_block_id(id)) {
         if (id >= end_aux_block_id_) {
             end_aux_block_id_ = id + 1;
@@ -37,13 +39,15 @@ void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
         // other than `invalid`, you might be doing something wrong. It will be
         // discarded anyway.
         rassert(recency == repli_timestamp_t::invalid);
-        index_aux_block_info_t info(offset, ser_block_size);
+        index_aux_block_info_t info(offset, ser_block_size,
+                                    uncompressed_ser_block_size);
         aux_infos_.set(make_aux_block_id_relative(id), info);
     } else {
         if (id >= end_block_id_) {
             end_block_id_ = id + 1;
         }
-        index_block_info_t info(offset, recency, ser_block_size);
+        index_block_info_t info(offset, recency, ser_block_size,
+                                uncompressed_ser_block_size);
         infos_.set(id, info);
     }
 }
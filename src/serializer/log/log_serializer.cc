@@ -124,6 +124,9 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
       pm_serializer_lba_gcs(),
+      pm_serializer_block_compression_ratio(secs_to_ticks(1), false),
+      pm_serializer_compressed_block_bytes_in(),
+      pm_serializer_compressed_block_bytes_out(),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
           &pm_serializer_block_reads, "serializer_block_reads",
@@ -143,7 +146,12 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
-          &pm_serializer_lba_gcs, "serializer_lba_gcs")
+          &pm_serializer_lba_gcs, "serializer_lba_gcs",
+          &pm_serializer_block_compression_ratio, "serializer_block_compression_ratio",
+          &pm_serializer_compressed_block_bytes_in,
+          "serializer_compressed_block_bytes_in",
+          &pm_serializer_compressed_block_bytes_out,
+          "serializer_compressed_block_bytes_out")
 { }
 
 void log_serializer_stats_t::bytes_read(size_t count) {
@@ -156,13 +164,26 @@ void log_serializer_stats_t::bytes_written(size_t count) {
     pm_serializer_written_bytes_total += count;
 }
 
+void log_serializer_stats_t::block_compressed(uint32_t ser_block_size,
+                                              uint32_t disk_block_size) {
+    // The ratio of stored to uncompressed size, so 1.0 means that compression
+    // didn't help and the block was stored as is.
+    pm_serializer_block_compression_ratio.record(
+        static_cast<double>(disk_block_size) / ser_block_size);
+    pm_serializer_compressed_block_bytes_in += ser_block_size;
+    pm_serializer_compressed_block_bytes_out += disk_block_size;
+}
+
 void log_serializer_t::create(serializer_file_opener_t *file_opener, static_config_t static_config) {
     log_serializer_on_disk_static_config_t *on_disk_config = &static_config;
 
     scoped_ptr_t<file_t> file;
     file_opener->open_serializer_file_create_temporary(&file);
 
-    co_static_header_write(file.get(), on_disk_config, sizeof(*on_disk_config));
+    // New files start out with the oldest version that can describe them (see
+    // `log_serializer_t::static_header_version`).
+    co_static_header_write(file.get(), serializer_version_t::v2_2,
+                           on_disk_config, sizeof(*on_disk_config));
 
     metablock_t metablock;
     memset(&metablock, 0, sizeof(metablock));
@@ -222,7 +243,7 @@ struct ls_start_existing_fsm_t :
             static_header_read(ser->dbfile,
                 &ser->static_config,
                 sizeof(log_serializer_on_disk_static_config_t),
-                &ser->static_header_needs_migration,
+                &ser->static_header_version,
                 this);
             start_existing_state = state_waiting_for_static_header;
             // STATE B above implies STATE C here
@@ -301,6 +322,7 @@ struct ls_start_existing_fsm_t :
                     ser->lba_index->get_block_offset(next_block_to_reconstruct);
                 if (offset.has_value()) {
                     ser->data_block_manager->mark_live(offset.get_value(),
+                        ser->lba_index->get_logical_block_size(next_block_to_reconstruct),
                         ser->lba_index->get_block_size(next_block_to_reconstruct));
                 }
 
@@ -400,7 +422,8 @@ log_serializer_t::log_serializer_t(dynamic_config_t _dynamic_config, serializer_
       shutdown_callback(nullptr),
       shutdown_state(shutdown_not_started),
       state(state_unstarted),
-      static_header_needs_migration(false),
+      static_header_version(serializer_version_t::v2_2),
+      current_format_required(false),
       dbfile(nullptr),
       extent_manager(nullptr),
       metablock_manager(nullptr),
@@ -442,7 +465,7 @@ buf_ptr_t log_serializer_t::block_read(const counted_t<ls_block_token_pointee_t>
     stats->pm_serializer_block_reads.begin(&pm_time);
 
     buf_ptr_t ret = data_block_manager->read(token->offset_, token->block_size(),
-                                           io_account);
+                                             token->disk_block_size(), io_account);
 
     stats->pm_serializer_block_reads.end(&pm_time);
     return ret;
@@ -477,6 +500,11 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
     extent_transaction_t txn;
     index_write_prepare(&txn);
 
+    // The oldest serializer version that can describe the file after this write.
+    serializer_version_t required_version = current_format_required.load()
+        ? serializer_version_t::v2_4
+        : serializer_version_t::v2_2;
+
     {
         // The in-memory index updates, at least due to the needs of
         // data_block_manager_t garbage collection, need to be
@@ -487,8 +515,10 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
              write_op_it != write_ops.end();
              ++write_op_it) {
             const index_write_op_t &op = *write_op_it;
-            flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
-            uint32_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            const index_block_info_t old_info = lba_index->get_block_info(op.block_id);
+            flagged_off64_t offset = old_info.offset;
+            uint32_t ser_block_size = old_info.ser_block_size;
+            uint32_t uncompressed_ser_block_size = old_info.uncompressed_ser_block_size;
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -503,21 +533,31 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 // Write new token to index, or remove from index as appropriate.
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
-                    ser_block_size = token->block_size().ser_value();
+                    ser_block_size = token->disk_block_size().ser_value();
+                    uncompressed_ser_block_size
+                        = token->block_size() == token->disk_block_size()
+                        ? 0
+                        : token->block_size().ser_value();
+                    if (uncompressed_ser_block_size != 0) {
+                        required_version = serializer_version_t::v2_4;
+                    }
 
                     /* mark the life */
-                    data_block_manager->mark_live(offset.get_value(), token->block_size());
+                    data_block_manager->mark_live(offset.get_value(), token->block_size(),
+                                                  token->disk_block_size());
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    uncompressed_ser_block_size = 0;
                 }
             }
 
             repli_timestamp_t recency = op.recency ? op.recency.get()
-                : lba_index->get_block_recency(op.block_id);
+                : old_info.recency;
 
             lba_index->set_block_info(op.block_id, recency,
                                       offset, ser_block_size,
+                                      uncompressed_ser_block_size,
                                       index_writes_io_account.get(), &txn);
         }
     }
@@ -528,13 +568,18 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
     // Before we fully commit the write to disk, we must migrate the static header
     // if necessary.
     // Note that this is early enough for upgrading from the 1.13 serializer
-    // version to 2.2, since only the format of the LBA changed.
+    // version to 2.2, since only the format of the LBA changed. It's also early
+    // enough for upgrading from 2.2 to 2.4, since the first compressed block only
+    // becomes reachable once this index write commits, and the same goes for the
+    // first field dictionary (see `require_current_format()`). Files that never get
+    // either stay at 2.2, so previous versions can still open them.
     // Future serializer format changes might require this step to happen earlier.
     {
         new_mutex_acq_t acq(&static_header_migration_mutex);
-        if (static_header_needs_migration) {
-            static_header_needs_migration = false;
-            migrate_static_header(dbfile, sizeof(log_serializer_on_disk_static_config_t));
+        if (static_header_version < required_version) {
+            migrate_static_header(dbfile, required_version,
+                                  sizeof(log_serializer_on_disk_static_config_t));
+            static_header_version = required_version;
         }
     }
 
@@ -645,9 +690,11 @@ void log_serializer_t::write_metablock_sans_pipelining(const signal_t *safe_to_w
 }
 
 counted_t<ls_block_token_pointee_t>
-log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       block_size_t disk_block_size) {
     assert_thread();
-    counted_t<ls_block_token_pointee_t> ret(new ls_block_token_pointee_t(this, offset, block_size));
+    counted_t<ls_block_token_pointee_t> ret(
+        new ls_block_token_pointee_t(this, offset, block_size, disk_block_size));
     return ret;
 }
 
@@ -767,6 +814,12 @@ bool log_serializer_t::is_gc_active() const {
     return data_block_manager->is_gc_active() || lba_index->is_any_gc_active();
 }
 
+void log_serializer_t::require_current_format() {
+    // The next `index_write()` migrates the static header. The blocks that need the
+    // current format can only be part of index writes that start after this.
+    current_format_required.store(true);
+}
+
 block_id_t log_serializer_t::end_block_id() {
     assert_thread();
     rassert(state == state_ready);
@@ -794,7 +847,10 @@ counted_t<ls_block_token_pointee_t> log_serializer_t::index_read(block_id_t bloc
 
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
-        return generate_block_token(info.offset.get_value(), block_size_t::unsafe_make(info.ser_block_size));
+        return generate_block_token(
+            info.offset.get_value(),
+            block_size_t::unsafe_make(info.logical_ser_block_size()),
+            block_size_t::unsafe_make(info.ser_block_size));
     } else {
         return counted_t<ls_block_token_pointee_t>();
     }
@@ -979,9 +1035,11 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 ls_block_token_pointee_t::ls_block_token_pointee_t(log_serializer_t *serializer,
                                                    int64_t initial_offset,
-                                                   block_size_t initial_block_size)
+                                                   block_size_t initial_block_size,
+                                                   block_size_t initial_disk_block_size)
     : serializer_(serializer), ref_count_(0),
-      block_size_(initial_block_size), offset_(initial_offset) {
+      block_size_(initial_block_size), disk_block_size_(initial_disk_block_size),
+      offset_(initial_offset) {
     serializer_->assert_thread();
     serializer_->register_block_token(this, initial_offset);
 }
@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <atomic>
 
 #include "arch/compiler.hpp"
 #include "arch/types.hpp"
@@ -167,13 +168,16 @@ public:
 
     virtual bool is_gc_active() const;
 
+    void require_current_format();
+
 private:
     void register_block_token(ls_block_token_pointee_t *token, int64_t offset);
     bool tokens_exist_for_offset(int64_t off);
     void unregister_block_token(ls_block_token_pointee_t *token);
     void remap_block_to_new_offset(int64_t current_offset, int64_t new_offset);
     counted_t<ls_block_token_pointee_t> generate_block_token(int64_t offset,
-                                                             block_size_t block_size);
+                                                             block_size_t block_size,
+                                                             block_size_t disk_block_size);
 
     void offer_buf_to_read_ahead_callbacks(
             block_id_t block_id,
@@ -254,10 +258,14 @@ private:
         state_shut_down
     } state;
 
-    /* Set to true during startup if the static file header needs to be migrated.
-    We delay migration until we perform the first index_write. That way if some other
-    migration step fails, users can still downgrade to the previous release. */
-    bool static_header_needs_migration;
+    /* The version in the static file header, as read during startup. Files older than
+    2.2 get migrated on the first index_write, and 2.2 files get migrated to 2.4 on the
+    first index_write that makes a compressed block reachable. We delay migration
+    until then, so that users can still downgrade to the previous release if some
+    other migration step fails, or if the file never uses the newer format. */
+    serializer_version_t static_header_version;
+    // Set by `require_current_format()`, possibly from another thread.
+    std::atomic<bool> current_format_required;
     new_mutex_t static_header_migration_mutex;
 
     file_t *dbfile;
@@ -14,7 +14,19 @@
 // The CURRENT_SERIALIZER_VERSION_STRING might remain unchanged for a while --
 // individual metablocks have a disk_format_version field that can be incremented
 // for on-the-fly version updating.
-#define CURRENT_SERIALIZER_VERSION_STRING "2.2"
+#define CURRENT_SERIALIZER_VERSION_STRING "2.4"
+
+// Since 2.4, LBA entries can describe LZ4-compressed blocks, rows can refer to a
+// field-name dictionary that's stored in the superblock metainfo (see
+// `DICT_BUF_R_OBJECT` and `store_metainfo_manager_t`), and internal B-tree nodes can
+// strip a shared prefix off their keys (see `internal_node_t::expected_magic`). Files
+// only get this version once they contain any of these, so that files that don't can
+// still be opened by previous versions of RethinkDB, which can't read 2.4+ files.
+#define V2_4_SERIALIZER_VERSION_STRING CURRENT_SERIALIZER_VERSION_STRING
+
+// Since 2.2, we changed the LBA format. New files are still created with this
+// version.
+#define V2_2_SERIALIZER_VERSION_STRING "2.2"
 
 // Since 1.13, we added the aux block ID space. We can still read 1.13 serializer
 // files, but previous versions of RethinkDB cannot read 2.2+ files.
@@ -22,6 +34,15 @@
 
 // See also CLUSTER_VERSION_STRING and cluster_version_t.
 
+const char *serializer_version_string(serializer_version_t version) {
+    switch (version) {
+    case serializer_version_t::v1_13: return V1_13_SERIALIZER_VERSION_STRING;
+    case serializer_version_t::v2_2: return V2_2_SERIALIZER_VERSION_STRING;
+    case serializer_version_t::v2_4: return V2_4_SERIALIZER_VERSION_STRING;
+    default: unreachable();
+    }
+}
+
 bool static_header_check(file_t *file) {
     if (file->get_file_size() < DEVICE_BLOCK_SIZE) {
         return false;
@@ -33,7 +54,8 @@ bool static_header_check(file_t *file) {
     }
 }
 
-void co_static_header_write(file_t *file, void *data, size_t data_size) {
+void co_static_header_write(file_t *file, serializer_version_t version,
+                            void *data, size_t data_size) {
     scoped_device_block_aligned_ptr_t<static_header_t> buffer(DEVICE_BLOCK_SIZE);
     rassert(sizeof(static_header_t) + data_size < DEVICE_BLOCK_SIZE);
 
@@ -44,9 +66,11 @@ void co_static_header_write(file_t *file, void *data, size_t data_size) {
     rassert(sizeof(SOFTWARE_NAME_STRING) < 16);
     memcpy(buffer->software_name, SOFTWARE_NAME_STRING, sizeof(SOFTWARE_NAME_STRING));
 
-    rassert(sizeof(CURRENT_SERIALIZER_VERSION_STRING) < 16);
-    memcpy(buffer->version, CURRENT_SERIALIZER_VERSION_STRING,
-           sizeof(CURRENT_SERIALIZER_VERSION_STRING));
+    // We never write 1.13 headers, since we don't write the 1.13 LBA format.
+    rassert(version != serializer_version_t::v1_13);
+    const char *version_string = serializer_version_string(version);
+    rassert(strlen(version_string) < 16);
+    memcpy(buffer->version, version_string, strlen(version_string) + 1);
 
     memcpy(buffer->data, data, data_size);
 
@@ -55,13 +79,13 @@ void co_static_header_write(file_t *file, void *data, size_t data_size) {
     co_write(file, 0, DEVICE_BLOCK_SIZE, buffer.get(), DEFAULT_DISK_ACCOUNT, file_t::WRAP_IN_DATASYNCS);
 }
 
-void co_static_header_write_helper(file_t *file, static_header_write_callback_t *cb, void *data, size_t data_size) {
-    co_static_header_write(file, data, data_size);
+void co_static_header_write_helper(file_t *file, serializer_version_t version, static_header_write_callback_t *cb, void *data, size_t data_size) {
+    co_static_header_write(file, version, data, data_size);
     cb->on_static_header_write();
 }
 
-bool static_header_write(file_t *file, void *data, size_t data_size, static_header_write_callback_t *cb) {
-    coro_t::spawn_later_ordered(std::bind(co_static_header_write_helper, file, cb, data, data_size));
+bool static_header_write(file_t *file, serializer_version_t version, void *data, size_t data_size, static_header_write_callback_t *cb) {
+    coro_t::spawn_later_ordered(std::bind(co_static_header_write_helper, file, version, cb, data, data_size));
     return false;
 }
 
@@ -70,7 +94,7 @@ void co_static_header_read(
         static_header_read_callback_t *callback,
         void *data_out,
         size_t data_size,
-        bool *needs_migration_out) {
+        serializer_version_t *version_out) {
     rassert(sizeof(static_header_t) + data_size < DEVICE_BLOCK_SIZE);
     scoped_device_block_aligned_ptr_t<static_header_t> buffer(DEVICE_BLOCK_SIZE);
     co_read(file, 0, DEVICE_BLOCK_SIZE, buffer.get(), DEFAULT_DISK_ACCOUNT);
@@ -80,10 +104,13 @@ void co_static_header_read(
 
     if (memcmp(buffer->version, V1_13_SERIALIZER_VERSION_STRING,
                sizeof(V1_13_SERIALIZER_VERSION_STRING)) == 0) {
-        *needs_migration_out = true;
-    } else if (memcmp(buffer->version, CURRENT_SERIALIZER_VERSION_STRING,
-               sizeof(CURRENT_SERIALIZER_VERSION_STRING)) == 0) {
-        *needs_migration_out = false;
+        *version_out = serializer_version_t::v1_13;
+    } else if (memcmp(buffer->version, V2_2_SERIALIZER_VERSION_STRING,
+               sizeof(V2_2_SERIALIZER_VERSION_STRING)) == 0) {
+        *version_out = serializer_version_t::v2_2;
+    } else if (memcmp(buffer->version, V2_4_SERIALIZER_VERSION_STRING,
+               sizeof(V2_4_SERIALIZER_VERSION_STRING)) == 0) {
+        *version_out = serializer_version_t::v2_4;
     } else {
         fail_due_to_user_error("File version is incorrect. This file was created with "
                                "RethinkDB's serializer version %s, but you are trying "
@@ -100,33 +127,33 @@ void static_header_read(
         file_t *file,
         void *data_out,
         size_t data_size,
-        bool *needs_migration_out,
+        serializer_version_t *version_out,
         static_header_read_callback_t *cb) {
     coro_t::spawn_later_ordered(std::bind(co_static_header_read,
         file,
         cb,
         data_out,
         data_size,
-        needs_migration_out));
+        version_out));
 }
 
-void migrate_static_header(file_t *file, size_t data_size) {
+void migrate_static_header(file_t *file, serializer_version_t version, size_t data_size) {
     // Migrate the static header by rewriting it
     logNTC("Migrating file to serializer version %s.",
-           CURRENT_SERIALIZER_VERSION_STRING);
+           serializer_version_string(version));
 
     std::vector<char> data(data_size);
 
     struct noop_cb_t : public static_header_read_callback_t {
         void on_static_header_read() { }
     } noop_cb;
-    bool needs_migration;
+    serializer_version_t old_version;
     co_static_header_read(file,
         &noop_cb,
         data.data(),
         data_size,
-        &needs_migration);
-    guarantee(needs_migration);
+        &old_version);
+    guarantee(old_version < version);
 
-    co_static_header_write(file, data.data(), data_size);
+    co_static_header_write(file, version, data.data(), data_size);
 }
@@ -11,6 +11,18 @@ struct static_header_t {
     char data[0];
 };
 
+/* The serializer versions that a file's static header can name. Files are written
+with the oldest version that can describe their contents, and only move to a newer
+one once they use a feature that previous releases can't read. */
+enum class serializer_version_t {
+    v1_13,
+    // The LBA format changed. This is the oldest version we write.
+    v2_2,
+    // LBA entries can describe LZ4-compressed blocks, and blocks can hold rows that
+    // refer to a field-name dictionary.
+    v2_4,
+};
+
 bool static_header_check(file_t *file);
 
 struct static_header_write_callback_t {
@@ -18,10 +30,12 @@ struct static_header_write_callback_t {
     virtual ~static_header_write_callback_t() {}
 };
 
-void co_static_header_write(file_t *file, void *data, size_t data_size);
+void co_static_header_write(file_t *file, serializer_version_t version,
+                            void *data, size_t data_size);
 
 bool static_header_write(
     file_t *file,
+    serializer_version_t version,
     void *data,
     size_t data_size,
     static_header_write_callback_t *cb);
@@ -35,10 +49,11 @@ void static_header_read(
     file_t *file,
     void *data_out,
     size_t data_size,
-    bool *needs_migration_out,
+    serializer_version_t *version_out,
     static_header_read_callback_t *cb);
 
-// Blocks, must be run in a coroutine
-void migrate_static_header(file_t *file, size_t data_size);
+// Blocks, must be run in a coroutine. Rewrites the header of a file whose version is
+// older than `version`.
+void migrate_static_header(file_t *file, serializer_version_t version, size_t data_size);
 
 #endif /* SERIALIZER_LOG_STATIC_HEADER_HPP_ */
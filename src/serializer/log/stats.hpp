@@ -10,6 +10,8 @@ struct log_serializer_stats_t {
 
     void bytes_read(size_t count);
     void bytes_written(size_t count);
+    // Records a block that the write path tried to compress.
+    void block_compressed(uint32_t ser_block_size, uint32_t disk_block_size);
 
     perfmon_duration_sampler_t pm_serializer_block_reads;
     perfmon_counter_t pm_serializer_index_reads;
@@ -39,6 +41,12 @@ struct log_serializer_stats_t {
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
 
+    /* used in serializer/log/data_block_manager.cc, for blocks written with
+    block_compression_t::LZ4 */
+    perfmon_sampler_t pm_serializer_block_compression_ratio;
+    perfmon_counter_t pm_serializer_compressed_block_bytes_in;
+    perfmon_counter_t pm_serializer_compressed_block_bytes_out;
+
     perfmon_membership_t parent_collection_membership;
     perfmon_multi_membership_t stats_membership;
 };
@@ -116,6 +116,8 @@ public:
         return inner->is_gc_active();
     }
 
+    void require_current_format() { inner->require_current_format(); }
+
 private:
     // Adds `op` to `outstanding_index_write_ops`, using `merge_index_write_op()` if
     // necessary
@@ -126,6 +126,12 @@ public:
     /* Return true if the garbage collector is active */
     virtual bool is_gc_active() const = 0;
 
+    /* Makes sure that the file is marked with the current format version before the
+    next index write commits. This is for blocks whose contents previous versions can't
+    read, such as field-name dictionaries. Unlike the other methods, this can be called
+    from any thread. */
+    virtual void require_current_format() = 0;
+
 private:
     DISABLE_COPYING(serializer_t);
 };
@@ -257,7 +257,8 @@ translator_serializer_t::block_writes(const buf_write_info_t *write_infos,
         const buf_write_info_t *info = &write_infos[i];
         guarantee(info->block_id != NULL_BLOCK_ID);
         tmp.push_back(buf_write_info_t(info->buf, info->block_size,
-                                       translate_block_id(info->block_id)));
+                                       translate_block_id(info->block_id),
+                                       info->compression));
     }
 
     return inner->block_writes(tmp.data(), tmp.size(), io_account, cb);
@@ -285,6 +286,10 @@ bool translator_serializer_t::is_gc_active() const {
     return inner->is_gc_active();
 }
 
+void translator_serializer_t::require_current_format() {
+    inner->require_current_format();
+}
+
 // A helper function for `end_block_id` and `end_aux_block_id`
 // `first_block_id` is the lowest block ID in the range, either 0 for regular block
 // IDs or FIRST_AUX_BLOCK_ID for aux blocks.
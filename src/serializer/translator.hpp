@@ -127,6 +127,8 @@ public:
 
     bool is_gc_active() const;
 
+    void require_current_format();
+
     block_id_t end_block_id();
     block_id_t end_aux_block_id();
 
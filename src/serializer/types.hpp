@@ -136,6 +136,8 @@ class ls_block_token_pointee_t {
 public:
     int64_t offset() const { return offset_; }
     block_size_t block_size() const { return block_size_; }
+    // Smaller than block_size() if the block is stored compressed.
+    block_size_t disk_block_size() const { return disk_block_size_; }
 
 private:
     friend class log_serializer_t;
@@ -146,7 +148,8 @@ private:
 
     ls_block_token_pointee_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_ser_block_size);
+                             block_size_t initial_ser_block_size,
+                             block_size_t initial_disk_block_size);
 
     log_serializer_t *serializer_;
     std::atomic<intptr_t> ref_count_;
@@ -154,6 +157,9 @@ private:
     // The block's size.
     block_size_t block_size_;
 
+    // The number of bytes that the block takes up on disk.
+    block_size_t disk_block_size_;
+
     // The block's offset on disk.
     int64_t offset_;
 
@@ -225,13 +231,22 @@ public:
                                       const counted_t<standard_block_token_t> &token) = 0;
 };
 
+// How the serializer encodes a block on disk.  With `LZ4`, the serializer
+// compresses the block's cache data if that saves at least one device block, and
+// stores it uncompressed otherwise.  The `ls_buf_data_t` header is never
+// compressed.
+enum class block_compression_t { NONE, LZ4 };
+
 struct buf_write_info_t {
     buf_write_info_t(ser_buffer_t *_buf, block_size_t _block_size,
-                     block_id_t _block_id)
-        : buf(_buf), block_size(_block_size), block_id(_block_id) { }
+                     block_id_t _block_id,
+                     block_compression_t _compression = block_compression_t::NONE)
+        : buf(_buf), block_size(_block_size), block_id(_block_id),
+          compression(_compression) { }
     ser_buffer_t *buf;
     block_size_t block_size;
     block_id_t block_id;
+    block_compression_t compression;
 };
 
 void debug_print(printf_buffer_t *buf, const buf_write_info_t &info);
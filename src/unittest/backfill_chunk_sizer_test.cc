@@ -0,0 +1,76 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <map>
+
+#include "clustering/immediate_consistency/backfill_chunk_sizer.hpp"
+#include "config/args.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+const size_t QUEUE_SIZE = 4 * MEGABYTE;
+const size_t INITIAL_CHUNK_SIZE = 100 * KILOBYTE;
+const size_t ITEM_SIZE = 10 * KILOBYTE;
+
+/* Simulates a backfill over a link with the given round trip time and throughput.
+Like the backfiller, it keeps up to `QUEUE_SIZE` bytes of items in flight, and the
+backfillee acknowledges every item once it has arrived. Returns the chunk size that
+the sizer settles on. */
+size_t simulate_link(double round_trip_secs, double bytes_per_sec) {
+    backfill_chunk_sizer_t sizer(INITIAL_CHUNK_SIZE, QUEUE_SIZE);
+    const ticks_t one_way = round_trip_secs / 2 * secs_to_ticks(1);
+
+    // The acknowledgements on their way back, with their mem sizes.
+    std::multimap<ticks_t, size_t> acks;
+    ticks_t now = secs_to_ticks(1);
+    ticks_t link_free = now;
+    size_t in_flight = 0;
+    uint64_t total_acked = 0;
+    while (total_acked < 100 * MEGABYTE) {
+        while (in_flight + sizer.get_chunk_size() <= QUEUE_SIZE) {
+            const size_t chunk_size = sizer.get_chunk_size();
+            sizer.on_chunk_sent(chunk_size, now);
+            in_flight += chunk_size;
+            for (size_t sent = 0; sent < chunk_size; sent += ITEM_SIZE) {
+                const size_t item_size = std::min(ITEM_SIZE, chunk_size - sent);
+                link_free = std::max(link_free, now + one_way)
+                    + static_cast<ticks_t>(item_size / bytes_per_sec * secs_to_ticks(1));
+                acks.insert(std::make_pair(link_free + one_way, item_size));
+            }
+        }
+        auto ack = acks.begin();
+        now = ack->first;
+        sizer.on_items_acked(ack->second, now);
+        in_flight -= ack->second;
+        total_acked += ack->second;
+        acks.erase(ack);
+    }
+    return sizer.get_chunk_size();
+}
+
+TEST(BackfillChunkSizerTest, InitialSize) {
+    backfill_chunk_sizer_t sizer(INITIAL_CHUNK_SIZE, QUEUE_SIZE);
+    EXPECT_EQ(INITIAL_CHUNK_SIZE, sizer.get_chunk_size());
+}
+
+/* The backfiller keeps the queue full, so most chunks spend far longer queued than on
+the link. The chunk size has to follow the link anyway, rather than the queue size. */
+TEST(BackfillChunkSizerTest, FollowsRoundTripTime) {
+    const double bytes_per_sec = 10 * MEGABYTE;
+    const size_t short_link = simulate_link(0.05, bytes_per_sec);
+    const size_t long_link = simulate_link(0.2, bytes_per_sec);
+
+    // About a quarter of the bandwidth-delay product.
+    EXPECT_NEAR(bytes_per_sec * 0.05 / 4, short_link, 0.1 * short_link);
+    EXPECT_NEAR(bytes_per_sec * 0.2 / 4, long_link, 0.1 * long_link);
+    EXPECT_LT(long_link, QUEUE_SIZE / 4);
+}
+
+TEST(BackfillChunkSizerTest, StaysWithinBounds) {
+    // A fast local link would call for tiny chunks.
+    EXPECT_EQ(INITIAL_CHUNK_SIZE / 4, simulate_link(0.0005, 100 * MEGABYTE));
+    // A fast long-distance link would call for chunks bigger than the queue.
+    EXPECT_EQ(QUEUE_SIZE / 4, simulate_link(1, 100 * MEGABYTE));
+}
+
+}  // namespace unittest
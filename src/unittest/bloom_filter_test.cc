@@ -0,0 +1,41 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string>
+
+#include "unittest/gtest.hpp"
+
+#include "containers/bloom_filter.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+TEST(BloomFilterTest, NoFalseNegatives) {
+    bloom_filter_t filter(1000, 10);
+    for (int i = 0; i < 1000; ++i) {
+        std::string value = strprintf("key%d", i);
+        filter.insert(value.data(), value.size());
+    }
+    EXPECT_EQ(1000u, filter.num_inserted());
+    for (int i = 0; i < 1000; ++i) {
+        std::string value = strprintf("key%d", i);
+        EXPECT_TRUE(filter.may_contain(value.data(), value.size()));
+    }
+}
+
+TEST(BloomFilterTest, FalsePositiveRate) {
+    bloom_filter_t filter(10000, 10);
+    for (int i = 0; i < 10000; ++i) {
+        std::string value = strprintf("key%d", i);
+        filter.insert(value.data(), value.size());
+    }
+    int false_positives = 0;
+    for (int i = 10000; i < 20000; ++i) {
+        std::string value = strprintf("key%d", i);
+        if (filter.may_contain(value.data(), value.size())) {
+            ++false_positives;
+        }
+    }
+    // The expected rate is about 1%.
+    EXPECT_LT(false_positives, 300);
+}
+
+}  // namespace unittest
@@ -0,0 +1,62 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "buffer_cache/cache_balancer.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+uint64_t sum(const std::vector<uint64_t> &sizes) {
+    uint64_t res = 0;
+    for (uint64_t size : sizes) {
+        res += size;
+    }
+    return res;
+}
+
+TEST(CacheBalancerTest, NoQuotas) {
+    std::vector<uint64_t> sizes = {100, 300, 600};
+    fit_cache_sizes_to_quotas(1000, std::vector<cache_quota_t>(3), &sizes);
+    ASSERT_EQ((std::vector<uint64_t>{100, 300, 600}), sizes);
+}
+
+TEST(CacheBalancerTest, Reservation) {
+    // The noisy third cache gives up memory to the first one's reservation.
+    std::vector<uint64_t> sizes = {100, 300, 600};
+    std::vector<cache_quota_t> quotas(3);
+    quotas[0].min_bytes = 250;
+    fit_cache_sizes_to_quotas(1000, quotas, &sizes);
+    ASSERT_EQ(250u, sizes[0]);
+    ASSERT_EQ(1000u, sum(sizes));
+    ASSERT_GT(sizes[2], sizes[1]);
+}
+
+TEST(CacheBalancerTest, Cap) {
+    std::vector<uint64_t> sizes = {100, 300, 600};
+    std::vector<cache_quota_t> quotas(3);
+    quotas[2].max_bytes = 200;
+    quotas[1].max_bytes = 450;
+    fit_cache_sizes_to_quotas(1000, quotas, &sizes);
+    ASSERT_EQ(200u, sizes[2]);
+    ASSERT_EQ(450u, sizes[1]);
+    ASSERT_EQ(350u, sizes[0]);
+}
+
+TEST(CacheBalancerTest, AllCapped) {
+    // Memory that no cache may take stays unused.
+    std::vector<uint64_t> sizes = {500, 500};
+    std::vector<cache_quota_t> quotas(2, cache_quota_t(0, 300));
+    fit_cache_sizes_to_quotas(1000, quotas, &sizes);
+    ASSERT_EQ((std::vector<uint64_t>{300, 300}), sizes);
+}
+
+TEST(CacheBalancerTest, OvercommittedReservations) {
+    std::vector<uint64_t> sizes = {0, 0, 1000};
+    std::vector<cache_quota_t> quotas(3);
+    quotas[0].min_bytes = 1000;
+    quotas[1].min_bytes = 1000;
+    fit_cache_sizes_to_quotas(1000, quotas, &sizes);
+    ASSERT_EQ((std::vector<uint64_t>{500, 500, 0}), sizes);
+}
+
+}  // namespace unittest
@@ -2,6 +2,8 @@
 #include "clustering/immediate_consistency/backfiller.hpp"
 #include "clustering/immediate_consistency/backfillee.hpp"
 #include "clustering/table_manager/backfill_progress_tracker.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "containers/archive/versioned.hpp"
 #include "containers/uuid.hpp"
 #include "rpc/semilattice/view/field.hpp"
 #include "unittest/branch_history_manager.hpp"
@@ -121,6 +123,11 @@ TPTEST(ClusteringBackfill, BackfillTest) {
             &callback,
             key_range_t::right_bound_t(backfillee_store.get_region().inner.left),
             &non_interruptor);
+
+        /* Chunks are only sent compressed if that makes them smaller */
+        EXPECT_GT(progress_tracker->bytes_uncompressed, 0u);
+        EXPECT_LE(progress_tracker->bytes_transferred,
+                  progress_tracker->bytes_uncompressed);
     }
 
     /* Make sure everything got transferred properly */
@@ -153,4 +160,50 @@ TPTEST(ClusteringBackfill, BackfillTest) {
     //EXPECT_EQ(timestamp, backfillee_metadata[0].second.timestamp);
 }
 
+/* Backfillees running previous versions send an `intro_1_t` without the item chunks
+mailbox and `compress_items`. The backfiller must fall back to plain item sequences for
+them instead of failing to deserialize the message. */
+TEST(ClusteringBackfill, IntroFromPreviousVersion) {
+    backfiller_bcard_t::intro_1_t intro;
+    intro.config.compress_items = true;
+
+    {
+        write_message_t wm;
+        serialize<cluster_version_t::CLUSTER>(&wm, intro);
+        vector_stream_t stream;
+        ASSERT_EQ(0, send_write_message(&stream, &wm));
+        std::vector<char> data;
+        stream.swap(&data);
+        vector_read_stream_t read_stream(std::move(data));
+        backfiller_bcard_t::intro_1_t result;
+        result.config.compress_items = false;
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  deserialize<cluster_version_t::CLUSTER>(&read_stream, &result));
+        EXPECT_TRUE(result.config.compress_items);
+    }
+
+    {
+        /* This is the format of previous versions. */
+        write_message_t wm;
+        serialize<cluster_version_t::CLUSTER>(&wm, intro.config);
+        serialize<cluster_version_t::CLUSTER>(&wm, intro.initial_version);
+        serialize<cluster_version_t::CLUSTER>(&wm, intro.initial_version_history);
+        serialize<cluster_version_t::CLUSTER>(&wm, intro.intro_mailbox);
+        serialize<cluster_version_t::CLUSTER>(&wm, intro.items_mailbox);
+        serialize<cluster_version_t::CLUSTER>(&wm, intro.ack_end_session_mailbox);
+        serialize<cluster_version_t::CLUSTER>(&wm, intro.ack_pre_items_mailbox);
+        vector_stream_t stream;
+        ASSERT_EQ(0, send_write_message(&stream, &wm));
+        std::vector<char> data;
+        stream.swap(&data);
+        vector_read_stream_t read_stream(std::move(data));
+        backfiller_bcard_t::intro_1_t result;
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  deserialize<cluster_version_t::CLUSTER>(&read_stream, &result));
+        EXPECT_TRUE(result.item_chunks_mailbox.is_nil());
+        EXPECT_FALSE(result.config.compress_items);
+    }
+}
+
+
 }   /* namespace unittest */
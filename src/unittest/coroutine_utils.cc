@@ -95,6 +95,50 @@ TEST(CoroutineUtilsTest, WithEnoughStackException) {
     EXPECT_TRUE(got_exception);
 }
 
+TEST(CoroutineUtilsTest, SmallStackTier) {
+    run_in_coro([&]() {
+        cond_t done;
+        coro_t::spawn_sometime([&]() {
+            EXPECT_EQ(coro_stack_tier_t::SMALL, coro_t::self()->get_stack_tier());
+            EXPECT_TRUE(has_n_bytes_free_stack_space(SMALL_COROUTINE_STACK_SIZE / 2));
+            EXPECT_FALSE(has_n_bytes_free_stack_space(SMALL_COROUTINE_STACK_SIZE));
+            // Anything that needs more room than that still gets a normal stack.
+            int res = call_with_enough_stack<int>([] () {
+                EXPECT_EQ(coro_stack_tier_t::NORMAL,
+                          coro_t::self()->get_stack_tier());
+                return 5;
+            }, SMALL_COROUTINE_STACK_SIZE);
+            EXPECT_EQ(5, res);
+            done.pulse();
+        }, coro_stack_tier_t::SMALL);
+        done.wait();
+    });
+}
+
+TEST(CoroutineUtilsTest, StackTiersAreReusedSeparately) {
+    run_in_coro([&]() {
+        // Spawn a bunch of coroutines of both tiers alternately, so the free lists
+        // get exercised. Each coroutine checks that it got a stack of the right size.
+        const int NUM_COROS = 1000;
+        int num_done = 0;
+        cond_t done;
+        for (int i = 0; i < NUM_COROS; ++i) {
+            coro_stack_tier_t tier =
+                i % 2 == 0 ? coro_stack_tier_t::SMALL : coro_stack_tier_t::NORMAL;
+            coro_t::spawn_sometime([&, tier]() {
+                EXPECT_EQ(tier, coro_t::self()->get_stack_tier());
+                EXPECT_EQ(tier == coro_stack_tier_t::NORMAL,
+                          has_n_bytes_free_stack_space(SMALL_COROUTINE_STACK_SIZE));
+                coro_t::yield();
+                if (++num_done == NUM_COROS) {
+                    done.pulse();
+                }
+            }, tier);
+        }
+        done.wait();
+    });
+}
+
 // This is not really a unit test, but a micro benchmark to test the overhead
 // of call_with_enough_stack. No need to run this in debug mode.
 #ifdef NDEBUG
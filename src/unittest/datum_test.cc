@@ -1,9 +1,14 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 
+#include "clustering/administration/tables/table_metadata.hpp"
+#include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/shared_buf_stream.hpp"
 #include "containers/archive/string_stream.hpp"
+#include "containers/archive/vector_stream.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/field_dictionary.hpp"
 #include "unittest/gtest.hpp"
 
 
@@ -205,4 +210,166 @@ TEST(DatumTest, OffsetScaling) {
     }
 }
 
+std::vector<char> serialize_with_dictionary(
+        const ql::datum_t &datum,
+        const ql::datum_field_dictionary_t *dictionary,
+        std::set<datum_string_t> *missing_fields_out) {
+    write_message_t wm;
+    ql::serialization_result_t res =
+        ql::datum_serialize(&wm, datum, ql::check_datum_serialization_errors_t::YES,
+                            dictionary, missing_fields_out);
+    EXPECT_FALSE(bad(res));
+    vector_stream_t stream;
+    int write_res = send_write_message(&stream, &wm);
+    EXPECT_EQ(0, write_res);
+    return stream.vector();
+}
+
+TEST(DatumTest, FieldDictionarySerialization) {
+    ql::datum_t nested(std::map<datum_string_t, ql::datum_t>
+        {std::make_pair(datum_string_t("first_name"), ql::datum_t(1.0)),
+         std::make_pair(datum_string_t("other"), ql::datum_t::null())});
+    ql::datum_t row(std::map<datum_string_t, ql::datum_t>
+        {std::make_pair(datum_string_t("first_name"), ql::datum_t(2.0)),
+         std::make_pair(datum_string_t("last_name"), ql::datum_t(3.0)),
+         std::make_pair(datum_string_t("nested"), nested)});
+
+    auto dictionary = make_counted<const ql::datum_field_dictionary_t>(
+        std::vector<datum_string_t>{datum_string_t("nested"),
+                                    datum_string_t("first_name")});
+
+    std::set<datum_string_t> missing_fields;
+    std::vector<char> serialized =
+        serialize_with_dictionary(row, dictionary.get(), &missing_fields);
+    ASSERT_TRUE(ql::datum_uses_field_dictionary(serialized));
+    ASSERT_EQ((std::set<datum_string_t>{datum_string_t("last_name"),
+                                        datum_string_t("other")}),
+              missing_fields);
+
+    // The row stays readable with later versions of the dictionary.
+    auto grown_dictionary = dictionary->with_names_added(missing_fields);
+    ASSERT_EQ(4u, grown_dictionary->size());
+    for (const ql::datum_field_dictionary_t *d :
+             {dictionary.get(), grown_dictionary.get()}) {
+        buffer_read_stream_t read_stream(serialized.data(), serialized.size());
+        ql::datum_t deserialized;
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  ql::datum_deserialize(&read_stream, d, &deserialized));
+        ASSERT_EQ(row, deserialized);
+        ASSERT_EQ(ql::datum_t(2.0), deserialized.get_field("first_name"));
+        ASSERT_EQ(nested, deserialized.get_field("nested"));
+        ASSERT_FALSE(deserialized.get_field("missing", ql::NOTHROW).has());
+
+        // Serializing the deserialized row without a dictionary spells the names out.
+        std::vector<char> plain = serialize_with_dictionary(deserialized, NULL, NULL);
+        ASSERT_FALSE(ql::datum_uses_field_dictionary(plain));
+        buffer_read_stream_t plain_stream(plain.data(), plain.size());
+        ql::datum_t redeserialized;
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  ql::datum_deserialize(&plain_stream, &redeserialized));
+        ASSERT_EQ(row, redeserialized);
+    }
+
+    {
+        buffer_read_stream_t read_stream(serialized.data(), serialized.size());
+        ql::datum_t deserialized;
+        ASSERT_NE(archive_result_t::SUCCESS,
+                  ql::datum_deserialize(&read_stream, &deserialized));
+    }
+
+    // The dictionary itself round-trips.
+    auto reloaded = ql::datum_field_dictionary_t::deserialize(
+        grown_dictionary->get_serialized());
+    ASSERT_EQ(grown_dictionary->get_serialized(), reloaded->get_serialized());
+}
+
+counted_t<const shared_buf_t> serialize_to_shared_buf(
+        const std::vector<ql::datum_t> &datums) {
+    write_message_t wm;
+    for (const ql::datum_t &datum : datums) {
+        serialize<cluster_version_t::CLUSTER>(&wm, datum);
+    }
+    vector_stream_t write_stream;
+    EXPECT_EQ(0, send_write_message(&write_stream, &wm));
+    counted_t<shared_buf_t> buf = shared_buf_t::create(write_stream.vector().size());
+    memcpy(buf->data(), write_stream.vector().data(), buf->size());
+    return counted_t<const shared_buf_t>(std::move(buf));
+}
+
+TEST(DatumTest, SharedBufDeserialization) {
+    // Big enough that they get sliced rather than copied.
+    const std::string long_string(2 * KILOBYTE, 'x');
+    ql::datum_t row(std::map<datum_string_t, ql::datum_t>
+        {std::make_pair(datum_string_t("id"), ql::datum_t(1.0)),
+         std::make_pair(datum_string_t("tags"), ql::datum_t(
+             std::vector<ql::datum_t>{ql::datum_t("a"),
+                                      ql::datum_t(datum_string_t(long_string))},
+             ql::configured_limits_t::unlimited))});
+    ql::datum_t str(datum_string_t("a string that follows the row: " + long_string));
+    counted_t<const shared_buf_t> const_buf = serialize_to_shared_buf({row, str});
+
+    shared_buf_read_stream_t read_stream((counted_t<const shared_buf_t>(const_buf)));
+    ql::datum_t deserialized_row, deserialized_str;
+    ASSERT_EQ(archive_result_t::SUCCESS,
+              deserialize<cluster_version_t::CLUSTER>(&read_stream, &deserialized_row));
+    ASSERT_EQ(archive_result_t::SUCCESS,
+              deserialize<cluster_version_t::CLUSTER>(&read_stream, &deserialized_str));
+    ASSERT_EQ(const_buf->size(), read_stream.tell());
+    ASSERT_EQ(row, deserialized_row);
+    ASSERT_EQ(str, deserialized_str);
+
+    // Both datums refer into the buffer instead of copying out of it.
+    ASSERT_EQ(4, counted_use_count(const_buf.get()));
+
+    // A truncated buffer fails to deserialize.
+    counted_t<shared_buf_t> truncated_buf = shared_buf_t::create(const_buf->size() - 1);
+    memcpy(truncated_buf->data(), const_buf->data(), truncated_buf->size());
+    shared_buf_read_stream_t truncated_stream(std::move(truncated_buf));
+    ql::datum_t truncated;
+    ASSERT_EQ(archive_result_t::SUCCESS,
+              deserialize<cluster_version_t::CLUSTER>(&truncated_stream, &truncated));
+    ASSERT_EQ(archive_result_t::SOCK_EOF,
+              deserialize<cluster_version_t::CLUSTER>(&truncated_stream, &truncated));
+}
+
+TEST(DatumTest, SharedBufCopies) {
+    const std::string long_string(2 * KILOBYTE, 'x');
+    ql::datum_t small_row(std::map<datum_string_t, ql::datum_t>
+        {std::make_pair(datum_string_t("id"), ql::datum_t(1.0)),
+         std::make_pair(datum_string_t("name"), ql::datum_t("small"))});
+    ql::datum_t big_str((datum_string_t(long_string)));
+    counted_t<const shared_buf_t> const_buf =
+        serialize_to_shared_buf({small_row, big_str, big_str, big_str});
+
+    shared_buf_read_stream_t read_stream((counted_t<const shared_buf_t>(const_buf)));
+    ql::datum_t deserialized;
+
+    // Small datums are copied, so that they don't keep the whole buffer alive.
+    ASSERT_EQ(archive_result_t::SUCCESS,
+              deserialize<cluster_version_t::CLUSTER>(&read_stream, &deserialized));
+    ASSERT_EQ(small_row, deserialized);
+    ASSERT_EQ(2, counted_use_count(const_buf.get()));
+
+    // So are big ones while a `no_slices_t` exists.
+    {
+        shared_buf_read_stream_t::no_slices_t no_slices(&read_stream);
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  deserialize<cluster_version_t::CLUSTER>(&read_stream, &deserialized));
+        ASSERT_EQ(big_str, deserialized);
+        ASSERT_EQ(2, counted_use_count(const_buf.get()));
+    }
+    ASSERT_EQ(archive_result_t::SUCCESS,
+              deserialize<cluster_version_t::CLUSTER>(&read_stream, &deserialized));
+    ASSERT_EQ(big_str, deserialized);
+    ASSERT_EQ(3, counted_use_count(const_buf.get()));
+    deserialized.reset();
+
+    // The user value of a table is kept in its metadata, so it always gets copied.
+    user_value_t user_value;
+    ASSERT_EQ(archive_result_t::SUCCESS,
+              deserialize<cluster_version_t::CLUSTER>(&read_stream, &user_value));
+    ASSERT_EQ(big_str, user_value.datum);
+    ASSERT_EQ(2, counted_use_count(const_buf.get()));
+}
+
 }  // namespace unittest
@@ -74,6 +74,36 @@ TEST(DiskBackedQueue, BigVals) {
     unittest::run_in_thread_pool(&run_big_values_test, 2);
 }
 
+void run_batched_push_test() {
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    const serializer_filepath_t serializer_path = dbq_serializer_path();
+
+    disk_backed_queue_t<int> queue(&io_backender, serializer_path, &get_global_perfmon_collection());
+
+    for (int batch = 0; batch < 10; ++batch) {
+        std::vector<int> values;
+        for (int i = 0; i < 100; ++i) {
+            values.push_back(batch * 100 + i);
+        }
+        queue.push(values);
+    }
+    queue.push(std::vector<int>());
+    EXPECT_EQ(1000, queue.size());
+
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_FALSE(queue.empty());
+        int x;
+        queue.pop(&x);
+        EXPECT_EQ(i, x);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(DiskBackedQueue, BatchedPush) {
+    unittest::run_in_thread_pool(&run_batched_push_test, 2);
+}
+
 static void randomly_delay(int, signal_t *) {
     nap(randint(100));
 }
@@ -0,0 +1,85 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk/uring.hpp"
+
+#if USE_IO_URING
+
+#include <fcntl.h>
+#include <string.h>
+
+#include <vector>
+
+#include "arch/runtime/thread_pool.hpp"
+#include "concurrency/cond_var.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TPTEST(DiskUringTest, WriteThenRead) {
+    if (!uring_diskmgr_t::is_supported()) {
+        return;
+    }
+
+    temp_file_t temp_file;
+    scoped_fd_t fd(::open(temp_file.name().permanent_path().c_str(),
+                          O_RDWR | O_CREAT | O_TRUNC, 0644));
+    ASSERT_NE(INVALID_FD, fd.get());
+
+    const int num_blocks = 300;
+    const size_t block_size = 4096;
+
+    unlimited_fifo_queue_t<pool_diskmgr_action_t *> source;
+    uring_diskmgr_t diskmgr(&linux_thread_pool_t::get_thread()->queue, &source, 4);
+
+    std::vector<scoped_ptr_t<pool_diskmgr_action_t> > actions;
+    int num_done = 0;
+    int num_failed = 0;
+    cond_t all_done;
+    int num_expected = 0;
+    diskmgr.done_fun = [&](pool_diskmgr_action_t *a) {
+        if (!a->get_succeeded()) {
+            ++num_failed;
+        }
+        if (++num_done == num_expected) {
+            all_done.pulse();
+        }
+    };
+
+    // The resize goes through the blocking fallback pool, the writes through
+    // the ring. More writes than the queue depth are submitted at once.
+    std::vector<std::vector<char> > bufs(num_blocks, std::vector<char>(block_size));
+    actions.push_back(make_scoped<pool_diskmgr_action_t>());
+    actions.back()->make_resize(fd.get(), 0, num_blocks * block_size, true);
+    source.push(actions.back().get());
+    for (int i = 0; i < num_blocks; ++i) {
+        memset(bufs[i].data(), 'a' + i % 26, block_size);
+        actions.push_back(make_scoped<pool_diskmgr_action_t>());
+        actions.back()->make_write(fd.get(), bufs[i].data(), block_size,
+                                   i * block_size, false);
+        source.push(actions.back().get());
+    }
+    num_expected = num_blocks + 1;
+    all_done.wait();
+    ASSERT_EQ(0, num_failed);
+
+    std::vector<std::vector<char> > read_bufs(num_blocks,
+                                              std::vector<char>(block_size));
+    all_done.reset();
+    num_done = 0;
+    num_expected = num_blocks;
+    for (int i = 0; i < num_blocks; ++i) {
+        actions.push_back(make_scoped<pool_diskmgr_action_t>());
+        actions.back()->make_read(fd.get(), read_bufs[i].data(), block_size,
+                                  i * block_size);
+        source.push(actions.back().get());
+    }
+    all_done.wait();
+    ASSERT_EQ(0, num_failed);
+    for (int i = 0; i < num_blocks; ++i) {
+        ASSERT_EQ(bufs[i], read_bufs[i]);
+    }
+}
+
+}  // namespace unittest
+
+#endif  // USE_IO_URING
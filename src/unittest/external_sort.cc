@@ -0,0 +1,113 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/external_sort.hpp"
+#include "unittest/unittest_utils.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+const char *const EXTERNAL_SORT_TEST_PATH = "test_external_sort";
+
+void run_external_sort_test() {
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    typedef std::pair<int, int> value_t;
+    int next_run = 0;
+    external_sorter_t<value_t> sorter([&]() {
+        std::string path = strprintf("%s_%d", EXTERNAL_SORT_TEST_PATH, next_run++);
+        return make_scoped<disk_backed_queue_t<value_t> >(
+            &io_backender,
+            manual_serializer_filepath(path, path + ".create"),
+            &get_global_perfmon_collection());
+    });
+
+    // Values are sorted by their first element. The second one records the order in
+    // which they were added, to check that the sort is stable.
+    auto less = [](const value_t &l, const value_t &r) { return l.first < r.first; };
+    const int NUM_RUNS = 40;
+    const int RUN_SIZE = 50;
+    int added = 0;
+    for (int run = 0; run < NUM_RUNS; ++run) {
+        std::vector<value_t> values;
+        for (int i = 0; i < RUN_SIZE; ++i) {
+            values.push_back(std::make_pair(randint(100), added++));
+        }
+        sorter.add_run(&values, less);
+        EXPECT_TRUE(values.empty());
+    }
+    // Two merges of 16 runs each, and 8 runs that haven't been merged.
+    EXPECT_EQ(10u, sorter.num_runs());
+
+    value_t prev(-1, -1);
+    value_t value;
+    int read = 0;
+    while (sorter.next(&value, less)) {
+        EXPECT_TRUE(prev.first < value.first
+                    || (prev.first == value.first && prev.second < value.second));
+        prev = value;
+        ++read;
+    }
+    EXPECT_EQ(NUM_RUNS * RUN_SIZE, read);
+    EXPECT_TRUE(sorter.is_exhausted());
+}
+
+TEST(ExternalSort, StableMerge) {
+    unittest::run_in_thread_pool(&run_external_sort_test, 2);
+}
+
+void run_merge_levels_test() {
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    int next_run = 0;
+    external_sorter_t<int> sorter([&]() {
+        std::string path = strprintf("%s_%d", EXTERNAL_SORT_TEST_PATH, next_run++);
+        return make_scoped<disk_backed_queue_t<int> >(
+            &io_backender,
+            manual_serializer_filepath(path, path + ".create"),
+            &get_global_perfmon_collection());
+    });
+    auto less = [](int l, int r) { return l < r; };
+
+    // Reading a sorter without any runs returns nothing.
+    {
+        external_sorter_t<int> empty([]() -> scoped_ptr_t<disk_backed_queue_t<int> > {
+            unreachable();
+        });
+        int value;
+        EXPECT_FALSE(empty.next(&value, less));
+        EXPECT_TRUE(empty.is_exhausted());
+    }
+
+    // 16 * 16 runs add up to a single run of the second level, after writing every
+    // value twice more.
+    const int NUM_RUNS = 16 * 16;
+    for (int run = 0; run < NUM_RUNS; ++run) {
+        std::vector<int> values;
+        values.push_back(NUM_RUNS - run);
+        values.push_back(run);
+        sorter.add_run(&values, less);
+        EXPECT_GE(32u, sorter.num_runs());
+    }
+    EXPECT_EQ(1u, sorter.num_runs());
+    EXPECT_EQ(NUM_RUNS + 16 + 1, next_run);
+
+    std::vector<int> read;
+    int value;
+    while (sorter.next(&value, less)) {
+        read.push_back(value);
+    }
+    ASSERT_EQ(static_cast<size_t>(2 * NUM_RUNS), read.size());
+    EXPECT_TRUE(std::is_sorted(read.begin(), read.end()));
+}
+
+TEST(ExternalSort, MergeLevels) {
+    unittest::run_in_thread_pool(&run_merge_levels_test, 2);
+}
+
+}  // namespace unittest
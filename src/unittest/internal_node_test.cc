@@ -1,16 +1,19 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include <algorithm>
+#include <string>
 #include <vector>
 
 #include "unittest/gtest.hpp"
 
 #include "btree/internal_node.hpp"
 #include "btree/node.hpp"
+#include "containers/scoped.hpp"
+#include "utils.hpp"
 
 namespace unittest {
 
 void verify(block_size_t block_size, const internal_node_t *buf) {
-    EXPECT_TRUE(buf->magic == internal_node_t::expected_magic);
+    EXPECT_TRUE(node::is_internal(reinterpret_cast<const node_t *>(buf)));
 
     // Internal nodes must have at least one pair.
     ASSERT_LE(1, buf->npairs);
@@ -45,7 +48,8 @@ void verify(block_size_t block_size, const internal_node_t *buf) {
         last_key = next_key;
     }
 
-    EXPECT_EQ(0, internal_node::get_pair(buf, last_pair_offset)->key.size);
+    EXPECT_EQ(internal_node::get_prefix(buf)->size,
+              internal_node::get_pair(buf, last_pair_offset)->key.size);
 }
 
 TEST(InternalNodeTest, Offsets) {
@@ -61,6 +65,174 @@ TEST(InternalNodeTest, Offsets) {
     EXPECT_EQ(9u, sizeof(btree_internal_pair));
 }
 
+// Builds an internal node whose children are numbered in key order.
+void make_node(block_size_t block_size, const std::vector<std::string> &keys,
+               block_id_t first_child, internal_node_t *node) {
+    internal_node::init(block_size, node);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        store_key_t key(keys[i]);
+        ASSERT_TRUE(internal_node::insert(node, key.btree_key(),
+                                          first_child + i, first_child + i + 1));
+    }
+}
+
+// Checks that `node` contains exactly `keys` and routes lookups accordingly.
+void check_node(block_size_t block_size, const internal_node_t *node,
+                const std::vector<std::string> &keys, block_id_t first_child) {
+    verify(block_size, node);
+    ASSERT_EQ(keys.size() + 1, node->npairs);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        store_key_t key;
+        internal_node::get_key_by_index(node, i, &key);
+        ASSERT_EQ(store_key_t(keys[i]), key);
+        ASSERT_EQ(first_child + i, internal_node::lookup(node, key.btree_key()));
+        key.increment();
+        ASSERT_EQ(first_child + i + 1, internal_node::lookup(node, key.btree_key()));
+    }
+    ASSERT_EQ(first_child, internal_node::lookup(node, store_key_t::min().btree_key()));
+    ASSERT_EQ(first_child + keys.size(),
+              internal_node::lookup(node, store_key_t::max().btree_key()));
+}
+
+std::vector<std::string> prefixed_keys(const std::string &prefix, int begin, int end) {
+    std::vector<std::string> keys;
+    for (int i = begin; i < end; ++i) {
+        keys.push_back(prefix + strprintf("%05d", i));
+    }
+    return keys;
+}
+
+TEST(InternalNodeTest, PrefixCompression) {
+    block_size_t block_size = block_size_t::unsafe_make(4096);
+    scoped_malloc_t<internal_node_t> node(block_size.value());
+
+    const std::string prefix(100, 'p');
+    std::vector<std::string> keys = prefixed_keys(prefix, 0, 20);
+    make_node(block_size, keys, 1, node.get());
+    check_node(block_size, node.get(), keys, 1);
+    EXPECT_EQ(0, internal_node::get_prefix(node.get())->size);
+    const uint16_t uncompressed_frontmost = node->frontmost_offset;
+
+    // The node can only store a prefix that its parent guarantees for its range.
+    store_key_t node_prefix(prefix);
+    internal_node::extend_prefix(block_size, node.get(), node_prefix.btree_key());
+    EXPECT_TRUE(node->magic == internal_node_t::expected_magic);
+    EXPECT_EQ(store_key_t(internal_node::get_prefix(node.get())), node_prefix);
+    EXPECT_EQ(uncompressed_frontmost + 19 * 100, node->frontmost_offset);
+    check_node(block_size, node.get(), keys, 1);
+
+    // New keys in the range go in without their prefix.
+    store_key_t key(prefix + "00019a");
+    ASSERT_TRUE(internal_node::insert(node.get(), key.btree_key(), 100, 101));
+    EXPECT_EQ(100u, internal_node::lookup(node.get(), key.btree_key()));
+    key.increment();
+    EXPECT_EQ(101u, internal_node::lookup(node.get(), key.btree_key()));
+
+    ASSERT_TRUE(internal_node::remove(block_size, node.get(), key.btree_key()));
+    verify(block_size, node.get());
+}
+
+TEST(InternalNodeTest, UnprefixedNodes) {
+    block_size_t block_size = block_size_t::unsafe_make(4096);
+    scoped_malloc_t<internal_node_t> node(block_size.value());
+
+    std::vector<std::string> keys = prefixed_keys("key", 0, 30);
+    make_node(block_size, keys, 1, node.get());
+    // Nodes written by older versions have a different magic but the same layout.
+    node->magic = internal_node_t::unprefixed_magic;
+    EXPECT_TRUE(node::is_internal(reinterpret_cast<const node_t *>(node.get())));
+    check_node(block_size, node.get(), keys, 1);
+
+    store_key_t key("key00005a");
+    ASSERT_TRUE(internal_node::insert(node.get(), key.btree_key(), 100, 101));
+    EXPECT_EQ(100u, internal_node::lookup(node.get(), key.btree_key()));
+}
+
+TEST(InternalNodeTest, SplitMergeLevel) {
+    block_size_t block_size = block_size_t::unsafe_make(4096);
+    scoped_malloc_t<internal_node_t> parent(block_size.value());
+    scoped_malloc_t<internal_node_t> left(block_size.value());
+    scoped_malloc_t<internal_node_t> right(block_size.value());
+
+    // Fill a node with long keys until it has to be split.
+    const std::string prefix(150, 's');
+    internal_node::init(block_size, left.get());
+    std::vector<std::string> keys;
+    for (int i = 0; !internal_node::is_full(left.get()); ++i) {
+        keys.push_back(prefix + strprintf("%05d", i));
+        store_key_t key(keys.back());
+        ASSERT_TRUE(internal_node::insert(left.get(), key.btree_key(), i + 1, i + 2));
+    }
+
+    store_key_t median;
+    internal_node::split(block_size, left.get(), right.get(), median.btree_key());
+    const size_t num_left = left->npairs - 1;
+    ASSERT_EQ(store_key_t(keys[num_left]), median);
+    check_node(block_size, left.get(), std::vector<std::string>(
+                   keys.begin(), keys.begin() + num_left), 1);
+    check_node(block_size, right.get(), std::vector<std::string>(
+                   keys.begin() + num_left + 1, keys.end()), num_left + 2);
+
+    // A parent that bounds both halves lets them store the shared prefix.
+    internal_node::init(block_size, parent.get());
+    store_key_t parent_key(prefix + "x");
+    ASSERT_TRUE(internal_node::insert(parent.get(), median.btree_key(), 1000, 1001));
+    ASSERT_TRUE(internal_node::insert(parent.get(), parent_key.btree_key(), 1001, 1002));
+    store_key_t lower_key("a");
+    ASSERT_TRUE(internal_node::insert(parent.get(), lower_key.btree_key(), 999, 1000));
+    store_key_t child_prefix;
+    internal_node::get_child_prefix(parent.get(), 2, &child_prefix);
+    ASSERT_EQ(store_key_t(prefix), child_prefix);
+    internal_node::extend_prefix(block_size, right.get(), child_prefix.btree_key());
+    EXPECT_EQ(150, internal_node::get_prefix(right.get())->size);
+    check_node(block_size, right.get(), std::vector<std::string>(
+                   keys.begin() + num_left + 1, keys.end()), num_left + 2);
+
+    // Leveling and merging have to agree on the keys, whatever the prefixes.
+    EXPECT_FALSE(internal_node::is_mergable(block_size, left.get(), right.get(), parent.get()));
+    store_key_t replacement;
+    std::vector<block_id_t> moved;
+    for (size_t i = 0; i < num_left - 3; ++i) {
+        ASSERT_TRUE(internal_node::remove(block_size, left.get(), store_key_t(keys[i]).btree_key()));
+    }
+    ASSERT_TRUE(internal_node::level(block_size, left.get(), right.get(),
+                                     replacement.btree_key(), parent.get(), &moved));
+    ASSERT_FALSE(moved.empty());
+    EXPECT_EQ(num_left + 2, moved.front());
+    verify(block_size, left.get());
+    verify(block_size, right.get());
+    internal_node::update_key(parent.get(), median.btree_key(), replacement.btree_key());
+
+    std::vector<std::string> all_keys(keys.begin() + num_left - 3, keys.end());
+    const size_t new_num_left = left->npairs - 1;
+    EXPECT_EQ(store_key_t(all_keys[new_num_left]), replacement);
+    check_node(block_size, left.get(), std::vector<std::string>(
+                   all_keys.begin(), all_keys.begin() + new_num_left), num_left - 2);
+    check_node(block_size, right.get(), std::vector<std::string>(
+                   all_keys.begin() + new_num_left + 1, all_keys.end()),
+               num_left - 2 + new_num_left + 1);
+
+    // Empty out the right node so that the two fit into one.
+    while (right->npairs > 2) {
+        store_key_t key;
+        internal_node::get_key_by_index(right.get(), 0, &key);
+        ASSERT_TRUE(internal_node::remove(block_size, right.get(), key.btree_key()));
+    }
+    ASSERT_TRUE(internal_node::is_mergable(block_size, left.get(), right.get(), parent.get()));
+    store_key_t last_right_key;
+    internal_node::get_key_by_index(right.get(), 0, &last_right_key);
+    internal_node::merge(block_size, left.get(), right.get(), parent.get());
+    std::vector<std::string> merged_keys(all_keys.begin(), all_keys.begin() + new_num_left + 1);
+    merged_keys.push_back(key_to_unescaped_str(last_right_key));
+    verify(block_size, right.get());
+    ASSERT_EQ(merged_keys.size() + 1, right->npairs);
+    for (size_t i = 0; i < merged_keys.size(); ++i) {
+        store_key_t key;
+        internal_node::get_key_by_index(right.get(), i, &key);
+        ASSERT_EQ(store_key_t(merged_keys[i]), key);
+    }
+}
+
 
 }  // namespace unittest
 
@@ -0,0 +1,87 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "unittest/gtest.hpp"
+
+#include "containers/interval_index.hpp"
+#include "random.hpp"
+
+namespace unittest {
+
+// Bounds are a value and whether they're closed.
+struct int_bounds_t {
+    typedef int point_t;
+    typedef std::pair<int, bool> left_t;
+    typedef std::pair<int, bool> right_t;
+    static bool left_before(const left_t &a, const left_t &b) {
+        return a.first < b.first || (a.first == b.first && a.second && !b.second);
+    }
+    static bool right_before(const right_t &a, const right_t &b) {
+        return a.first < b.first || (a.first == b.first && !a.second && b.second);
+    }
+    static bool left_admits(const left_t &l, int p) {
+        return l.first < p || (l.first == p && l.second);
+    }
+    static bool right_admits(const right_t &r, int p) {
+        return r.first > p || (r.first == p && r.second);
+    }
+};
+
+typedef interval_index_t<int_bounds_t, int> int_index_t;
+
+std::multiset<int> containing(const int_index_t &index, int point) {
+    std::multiset<int> res;
+    index.visit_containing(point, [&res](int value) { res.insert(value); });
+    return res;
+}
+
+TEST(IntervalIndexTest, Empty) {
+    int_index_t index;
+    EXPECT_TRUE(containing(index, 0).empty());
+    int_index_t built((std::vector<int_index_t::interval_t>()));
+    EXPECT_TRUE(built.empty());
+    EXPECT_TRUE(containing(built, 0).empty());
+}
+
+TEST(IntervalIndexTest, Bounds) {
+    std::vector<int_index_t::interval_t> intervals;
+    intervals.push_back({{0, true}, {10, false}, 1});
+    intervals.push_back({{0, false}, {10, true}, 2});
+    intervals.push_back({{5, true}, {5, true}, 3});
+    intervals.push_back({{5, true}, {5, true}, 4});
+    int_index_t index(std::move(intervals));
+    EXPECT_EQ(4u, index.size());
+    EXPECT_EQ(std::multiset<int>({1}), containing(index, 0));
+    EXPECT_EQ(std::multiset<int>({1, 2, 3, 4}), containing(index, 5));
+    EXPECT_EQ(std::multiset<int>({2}), containing(index, 10));
+    EXPECT_TRUE(containing(index, -1).empty());
+    EXPECT_TRUE(containing(index, 11).empty());
+}
+
+TEST(IntervalIndexTest, MatchesBruteForce) {
+    for (int round = 0; round < 50; ++round) {
+        std::vector<int_index_t::interval_t> intervals;
+        int n = randint(200);
+        for (int i = 0; i < n; ++i) {
+            int l = randint(100);
+            int r = l + randint(30);
+            intervals.push_back({{l, randint(2) == 0}, {r, randint(2) == 0}, i});
+        }
+        std::vector<int_index_t::interval_t> copy = intervals;
+        int_index_t index(std::move(copy));
+        for (int point = -1; point <= 131; ++point) {
+            std::multiset<int> expected;
+            for (const auto &i : intervals) {
+                if (int_bounds_t::left_admits(i.left, point)
+                    && int_bounds_t::right_admits(i.right, point)) {
+                    expected.insert(i.value);
+                }
+            }
+            ASSERT_EQ(expected, containing(index, point));
+        }
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,236 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <functional>
+
+#include "arch/io/disk.hpp"
+#include "arch/timing.hpp"
+#include "btree/reql_specific.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "config/args.hpp"
+#include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/key_filter.hpp"
+#include "rdb_protocol/store.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// None of the tests write rows with ids from here on.
+const int KEY_FILTER_TEST_MISSING_ID = 1000000;
+const int KEY_FILTER_TEST_NUM_MISSING = 1000;
+
+store_key_t key_filter_test_key(int id) {
+    return store_key_t(ql::datum_t(static_cast<double>(id)).print_primary());
+}
+
+void key_filter_test_write(store_t *store, int id) {
+    cond_t non_interruptor;
+    write_token_t token;
+    store->new_write_token(&token);
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    store->acquire_superblock_for_write(
+        1, write_durability_t::SOFT, &token, &txn, &superblock, &non_interruptor);
+
+    ql::datum_object_builder_t builder;
+    builder.overwrite("id", ql::datum_t(static_cast<double>(id)));
+    point_write_response_t response;
+    rdb_modification_info_t mod_info;
+    rdb_live_deletion_context_t deletion_context;
+    rdb_set(key_filter_test_key(id), std::move(builder).to_datum(), true,
+            store->btree.get(), repli_timestamp_t::distant_past, superblock.get(),
+            &deletion_context, &response, &mod_info,
+            static_cast<profile::trace_t *>(nullptr));
+}
+
+void key_filter_test_write_range(store_t *store, int start, int finish) {
+    for (int id = start; id < finish; ++id) {
+        key_filter_test_write(store, id);
+    }
+}
+
+// Reads the row with `id` the way point reads do, which may skip the B-tree.
+ql::datum_t key_filter_test_read(store_t *store, int id) {
+    cond_t non_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    store->acquire_superblock_for_read(&token, &txn, &superblock, &non_interruptor,
+                                       false /* use snapshot */);
+    point_read_response_t response;
+    rdb_get(key_filter_test_key(id), store->btree.get(), superblock.get(), &response,
+            static_cast<profile::trace_t *>(nullptr));
+    return response.data;
+}
+
+// The number of ids from `start` to `finish` that the filter rules out.
+int count_definitely_absent(store_t *store, int start, int finish) {
+    int count = 0;
+    for (int id = start; id < finish; ++id) {
+        if (store->key_filter.definitely_absent(key_filter_test_key(id))) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int count_missing_definitely_absent(store_t *store) {
+    return count_definitely_absent(
+        store,
+        KEY_FILTER_TEST_MISSING_ID,
+        KEY_FILTER_TEST_MISSING_ID + KEY_FILTER_TEST_NUM_MISSING);
+}
+
+// A filter that is ready rules out nearly all of the missing ids, and one that isn't
+// rules out none of them.
+void wait_for_key_filter(store_t *store) {
+    while (count_missing_definitely_absent(store) == 0) {
+        nap(10);
+    }
+}
+
+// Checks that the rows from `start` to `finish` exist, and that the filter knows it.
+void check_key_filter_rows(store_t *store, int start, int finish) {
+    EXPECT_EQ(0, count_definitely_absent(store, start, finish));
+    for (int id = start; id < finish; ++id) {
+        ql::datum_t row = key_filter_test_read(store, id);
+        ASSERT_EQ(ql::datum_t::R_OBJECT, row.get_type()) << "id " << id;
+        EXPECT_EQ(id, row.get_field("id").as_int());
+    }
+}
+
+void check_key_filter_missing_rows(store_t *store) {
+    for (int id = KEY_FILTER_TEST_MISSING_ID;
+         id < KEY_FILTER_TEST_MISSING_ID + KEY_FILTER_TEST_NUM_MISSING;
+         ++id) {
+        EXPECT_EQ(ql::datum_t::R_NULL, key_filter_test_read(store, id).get_type());
+    }
+}
+
+void run_key_filter_test(const std::function<void(store_t *)> &fun) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE,
+            which_cpu_shard_t{0, 1});
+
+    fun(&store);
+}
+
+TPTEST(KeyFilterTest, Disabled) {
+    run_key_filter_test([](store_t *store) {
+        key_filter_test_write_range(store, 0, 100);
+        EXPECT_EQ(0u, store->key_filter.capacity());
+        EXPECT_EQ(0, count_missing_definitely_absent(store));
+        check_key_filter_rows(store, 0, 100);
+        check_key_filter_missing_rows(store);
+    });
+}
+
+TPTEST(KeyFilterTest, BuildAndLookup) {
+    run_key_filter_test([](store_t *store) {
+        key_filter_test_write_range(store, 0, 1000);
+
+        // The filter answers nothing until it has all the keys.
+        store->configure_key_filter(true);
+        EXPECT_EQ(0, count_missing_definitely_absent(store));
+        EXPECT_EQ(0, count_definitely_absent(store, 0, 1000));
+
+        wait_for_key_filter(store);
+        EXPECT_EQ(2u * KEY_FILTER_MIN_CAPACITY, store->key_filter.capacity());
+        check_key_filter_rows(store, 0, 1000);
+        // About 1% false positives at capacity, and the filter is far from full.
+        EXPECT_LT(KEY_FILTER_TEST_NUM_MISSING * 9 / 10,
+                  count_missing_definitely_absent(store));
+        check_key_filter_missing_rows(store);
+
+        // Rows written after the filter was built get added to it.
+        key_filter_test_write_range(store, 1000, 2000);
+        check_key_filter_rows(store, 0, 2000);
+        check_key_filter_missing_rows(store);
+    });
+}
+
+TPTEST(KeyFilterTest, RebuildWhenFull) {
+    run_key_filter_test([](store_t *store) {
+        store->configure_key_filter(true);
+        wait_for_key_filter(store);
+        const int capacity = 2 * KEY_FILTER_MIN_CAPACITY;
+        ASSERT_EQ(static_cast<size_t>(capacity), store->key_filter.capacity());
+
+        // The write that goes over the capacity drops the filter and starts a
+        // rebuild. Keys that were false positives don't count, so it may take a few
+        // more writes than the capacity.
+        int num_rows = 0;
+        while (store->key_filter.capacity() == static_cast<size_t>(capacity)) {
+            ASSERT_LT(num_rows, 2 * capacity);
+            key_filter_test_write(store, num_rows);
+            ++num_rows;
+        }
+        EXPECT_LT(capacity, num_rows);
+
+        // The new filter is sized for at least twice as many keys as the old one had.
+        wait_for_key_filter(store);
+        EXPECT_LE(2u * (capacity + 1), store->key_filter.capacity());
+        check_key_filter_rows(store, 0, num_rows);
+        EXPECT_LT(KEY_FILTER_TEST_NUM_MISSING * 9 / 10,
+                  count_missing_definitely_absent(store));
+        check_key_filter_missing_rows(store);
+    });
+}
+
+TPTEST(KeyFilterTest, DisableAndEnable) {
+    run_key_filter_test([](store_t *store) {
+        key_filter_test_write_range(store, 0, 500);
+        store->configure_key_filter(true);
+        wait_for_key_filter(store);
+
+        // A disabled filter is freed and rules out nothing.
+        store->configure_key_filter(false);
+        EXPECT_EQ(0u, store->key_filter.capacity());
+        EXPECT_EQ(0, count_missing_definitely_absent(store));
+        key_filter_test_write_range(store, 500, 1000);
+        check_key_filter_rows(store, 0, 1000);
+        check_key_filter_missing_rows(store);
+
+        // Disabling the filter again stops its rebuild.
+        store->configure_key_filter(true);
+        store->configure_key_filter(false);
+        nap(100);
+        EXPECT_EQ(0u, store->key_filter.capacity());
+        EXPECT_EQ(0, count_missing_definitely_absent(store));
+
+        // The rebuild finds the rows that were written while the filter was disabled.
+        store->configure_key_filter(true);
+        wait_for_key_filter(store);
+        check_key_filter_rows(store, 0, 1000);
+        check_key_filter_missing_rows(store);
+    });
+}
+
+}  // namespace unittest
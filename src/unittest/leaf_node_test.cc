@@ -1,10 +1,13 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include <map>
+#include <string>
+#include <vector>
 
 #include "btree/leaf_node.hpp"
 #include "btree/node.hpp"
 #include "containers/scoped.hpp"
 #include "repli_timestamp.hpp"
+#include "time.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
 #include "utils.hpp"
@@ -714,4 +717,92 @@ TEST(LeafNodeTest, Fullness) {
     ASSERT_TRUE(node.IsFull(store_key_t(strprintf("a%d", i)), strprintf("A%d", i)));
 }
 
+// The plain binary search that `leaf::find_key` used to be.
+bool reference_find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
+    int beg = 0;
+    int end = node->num_pairs;
+    while (beg < end) {
+        int test_point = beg + (end - beg) / 2;
+        int res = btree_key_cmp(key, (*leaf::iterator(node, test_point)).first);
+        if (res < 0) {
+            end = test_point;
+        } else if (res > 0) {
+            beg = test_point + 1;
+        } else {
+            *index_out = test_point;
+            return true;
+        }
+    }
+    *index_out = beg;
+    return false;
+}
+
+// Secondary index keys share long prefixes, so this exercises skipping the common
+// prefix in `leaf::find_key`. Fills `node` with such keys, and returns them along with
+// keys between and around them to search for.
+void fill_with_shared_prefixes(LeafNodeTracker *node, std::vector<store_key_t> *probes_out) {
+    const std::string prefix(100, 'p');
+    for (int i = 0; ; i += 2) {
+        store_key_t key(prefix + strprintf("%05d", i));
+        if (!node->Insert(key, "v")) {
+            break;
+        }
+        probes_out->push_back(key);
+        probes_out->push_back(store_key_t(prefix + strprintf("%05d", i + 1)));
+    }
+    probes_out->push_back(store_key_t(""));
+    probes_out->push_back(store_key_t(prefix));
+    probes_out->push_back(store_key_t(prefix + "~"));
+    probes_out->push_back(store_key_t(std::string(100, 'o')));
+    probes_out->push_back(store_key_t(std::string(120, 'q')));
+}
+
+TEST(LeafNodeTest, FindKeyWithSharedPrefixes) {
+    LeafNodeTracker node;
+    std::vector<store_key_t> probes;
+    fill_with_shared_prefixes(&node, &probes);
+    ASSERT_GT(node.node()->num_pairs, 10);
+
+    for (const store_key_t &probe : probes) {
+        int expected_index;
+        bool expected_found = reference_find_key(node.node(), probe.btree_key(),
+                                                 &expected_index);
+        int index;
+        ASSERT_EQ(expected_found, leaf::find_key(node.node(), probe.btree_key(), &index));
+        ASSERT_EQ(expected_index, index);
+    }
+}
+
+#ifdef NDEBUG
+TEST(LeafNodeTest, FindKeyWithSharedPrefixesBenchmark) {
+    LeafNodeTracker node;
+    std::vector<store_key_t> probes;
+    fill_with_shared_prefixes(&node, &probes);
+
+    const int rounds = 2000;
+    int sink = 0;
+    ticks_t start = get_ticks();
+    for (int r = 0; r < rounds; ++r) {
+        for (const store_key_t &probe : probes) {
+            int index;
+            reference_find_key(node.node(), probe.btree_key(), &index);
+            sink += index;
+        }
+    }
+    ticks_t middle = get_ticks();
+    for (int r = 0; r < rounds; ++r) {
+        for (const store_key_t &probe : probes) {
+            int index;
+            leaf::find_key(node.node(), probe.btree_key(), &index);
+            sink -= index;
+        }
+    }
+    ticks_t finish = get_ticks();
+    ASSERT_EQ(0, sink);
+    printf("find_key over %d keys: plain %.3f ms, prefix-skipping %.3f ms\n",
+           node.node()->num_pairs,
+           ticks_to_secs(middle - start) * 1000, ticks_to_secs(finish - middle) * 1000);
+}
+#endif  // NDEBUG
+
 }  // namespace unittest
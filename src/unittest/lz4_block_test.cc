@@ -0,0 +1,95 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string>
+#include <vector>
+
+#include "containers/lz4_block.hpp"
+#include "random.hpp"
+#include "unittest/gtest.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+void lz4_round_trip(const std::string &input) {
+    std::vector<char> compressed(lz4_max_compressed_size(input.size()));
+    const size_t compressed_size = lz4_compress_block(
+        input.data(), input.size(), compressed.data(), compressed.size());
+    ASSERT_NE(0u, compressed_size);
+    ASSERT_LE(compressed_size, compressed.size());
+
+    std::string output(input.size(), '\0');
+    ASSERT_TRUE(lz4_decompress_block(compressed.data(), compressed_size,
+                                     &output[0], output.size()));
+    ASSERT_EQ(input, output);
+
+    // The output size has to match exactly.
+    std::string too_big(input.size() + 1, '\0');
+    ASSERT_FALSE(lz4_decompress_block(compressed.data(), compressed_size,
+                                      &too_big[0], too_big.size()));
+}
+
+TEST(LZ4BlockTest, RoundTrip) {
+    lz4_round_trip("");
+    lz4_round_trip("a");
+    lz4_round_trip("abcdefghijklm");
+    lz4_round_trip(std::string(4096, 'x'));
+    lz4_round_trip(std::string(100000, '\0'));
+
+    std::string repetitive;
+    while (repetitive.size() < 4000) {
+        repetitive += strprintf("{\"id\": %zu, \"name\": \"row\"}", repetitive.size());
+    }
+    lz4_round_trip(repetitive);
+
+    rng_t rng(1234);
+    std::string noise;
+    for (int i = 0; i < 70000; ++i) {
+        noise += static_cast<char>(rng.randint(256));
+    }
+    lz4_round_trip(noise);
+}
+
+TEST(LZ4BlockTest, Compresses) {
+    const std::string input(4096, 'x');
+    std::vector<char> compressed(input.size());
+    const size_t compressed_size = lz4_compress_block(
+        input.data(), input.size(), compressed.data(), compressed.size());
+    ASSERT_NE(0u, compressed_size);
+    ASSERT_LT(compressed_size, 64u);
+}
+
+TEST(LZ4BlockTest, GivesUpWhenFull) {
+    rng_t rng(4321);
+    std::string noise;
+    for (int i = 0; i < 4096; ++i) {
+        noise += static_cast<char>(rng.randint(256));
+    }
+    std::vector<char> compressed(noise.size() / 2);
+    ASSERT_EQ(0u, lz4_compress_block(noise.data(), noise.size(),
+                                     compressed.data(), compressed.size()));
+}
+
+TEST(LZ4BlockTest, RejectsCorruption) {
+    std::string input;
+    for (int i = 0; i < 1000; ++i) {
+        input += strprintf("%d,", i % 37);
+    }
+    std::vector<char> compressed(lz4_max_compressed_size(input.size()));
+    const size_t compressed_size = lz4_compress_block(
+        input.data(), input.size(), compressed.data(), compressed.size());
+    ASSERT_NE(0u, compressed_size);
+
+    // Every truncation and every single-byte corruption has to be rejected or
+    // decode to something, but must never touch memory out of bounds.
+    std::string output(input.size(), '\0');
+    for (size_t i = 0; i < compressed_size; ++i) {
+        ASSERT_FALSE(lz4_decompress_block(compressed.data(), i,
+                                          &output[0], output.size()));
+        std::vector<char> corrupt(compressed.begin(),
+                                  compressed.begin() + compressed_size);
+        corrupt[i] ^= 0x5a;
+        UNUSED bool res = lz4_decompress_block(corrupt.data(), corrupt.size(),
+                                               &output[0], output.size());
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,141 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <pthread.h>
+
+#include <vector>
+
+#include "unittest/gtest.hpp"
+
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/mpsc_queue.hpp"
+#include "containers/scoped.hpp"
+#include "random.hpp"
+#include "time.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+struct test_elem_t
+    : public intrusive_list_node_t<test_elem_t>,
+      public mpsc_queue_node_t<test_elem_t> {
+    int producer;
+    int seq;
+};
+
+struct test_producer_t {
+    mpsc_queue_t<test_elem_t> *queue;
+    int number;
+    scoped_array_t<test_elem_t> elems;
+    int pushes_onto_empty;
+};
+
+static const int NUM_PRODUCERS = 4;
+static const int ELEMS_PER_PRODUCER = 100000;
+
+void *run_producer(void *v_producer) {
+    test_producer_t *producer = static_cast<test_producer_t *>(v_producer);
+    intrusive_list_t<test_elem_t> batch;
+    int i = 0;
+    while (i < ELEMS_PER_PRODUCER) {
+        for (int n = 1 + randint(8); n > 0 && i < ELEMS_PER_PRODUCER; --n, ++i) {
+            producer->elems[i].producer = producer->number;
+            producer->elems[i].seq = i;
+            batch.push_back(&producer->elems[i]);
+        }
+        if (producer->queue->push_all(&batch)) {
+            ++producer->pushes_onto_empty;
+        }
+        EXPECT_TRUE(batch.empty());
+    }
+    return nullptr;
+}
+
+TEST(MpscQueueTest, ManyProducers) {
+    mpsc_queue_t<test_elem_t> queue;
+    std::vector<test_producer_t> producers(NUM_PRODUCERS);
+    std::vector<pthread_t> threads(NUM_PRODUCERS);
+    for (int p = 0; p < NUM_PRODUCERS; ++p) {
+        producers[p].queue = &queue;
+        producers[p].number = p;
+        producers[p].elems.init(ELEMS_PER_PRODUCER);
+        producers[p].pushes_onto_empty = 0;
+        int res = pthread_create(&threads[p], nullptr, run_producer, &producers[p]);
+        guarantee_xerr(res == 0, res, "pthread_create failed");
+    }
+
+    // Elements of each producer come out in the order in which they were pushed.
+    std::vector<int> next_seq(NUM_PRODUCERS, 0);
+    int received = 0;
+    int pops = 0;
+    while (received < NUM_PRODUCERS * ELEMS_PER_PRODUCER) {
+        intrusive_list_t<test_elem_t> popped;
+        queue.pop_all(&popped);
+        if (!popped.empty()) {
+            ++pops;
+        }
+        while (test_elem_t *e = popped.head()) {
+            popped.remove(e);
+            ASSERT_EQ(next_seq[e->producer], e->seq);
+            ++next_seq[e->producer];
+            ++received;
+        }
+    }
+    EXPECT_TRUE(queue.empty());
+
+    int pushes_onto_empty = 0;
+    for (int p = 0; p < NUM_PRODUCERS; ++p) {
+        int res = pthread_join(threads[p], nullptr);
+        guarantee_xerr(res == 0, res, "pthread_join failed");
+        pushes_onto_empty += producers[p].pushes_onto_empty;
+    }
+    // Every pop that got something was preceded by exactly one push onto the empty
+    // queue.
+    EXPECT_EQ(pops, pushes_onto_empty);
+}
+
+TEST(MpscQueueTest, Empty) {
+    mpsc_queue_t<test_elem_t> queue;
+    intrusive_list_t<test_elem_t> list;
+    EXPECT_FALSE(queue.push_all(&list));
+    EXPECT_TRUE(queue.empty());
+    queue.pop_all(&list);
+    EXPECT_TRUE(list.empty());
+}
+
+// This is not really a unit test, but a micro benchmark for the latency and throughput
+// of thread switches, which go through the message hubs' queues. No need to run this
+// in debug mode.
+#ifdef NDEBUG
+TEST(MpscQueueTest, ThreadHopBenchmark) {
+    const int NUM_HOPS = 100000;
+    const int COROS_PER_THREAD = 16;
+    for (int num_threads : {2, 4, 8, 16, 32}) {
+        run_in_thread_pool([&]() {
+            // A single coroutine that hops back and forth between two threads
+            ticks_t start_ticks = get_ticks();
+            for (int i = 0; i < NUM_HOPS / 2; ++i) {
+                on_thread_t rethreader((threadnum_t(1)));
+            }
+            double latency = ticks_to_secs(get_ticks() - start_ticks) / NUM_HOPS;
+
+            // Many coroutines on every thread that hop to all other threads
+            start_ticks = get_ticks();
+            pmap(num_threads * COROS_PER_THREAD, [&](int c) {
+                int home = c % num_threads;
+                on_thread_t rethreader((threadnum_t(home)));
+                for (int i = 0; i < NUM_HOPS / COROS_PER_THREAD / 2; ++i) {
+                    int dest = (home + 1 + i % (num_threads - 1)) % num_threads;
+                    on_thread_t hop((threadnum_t(dest)));
+                }
+            });
+            double duration = ticks_to_secs(get_ticks() - start_ticks);
+            double hops = static_cast<double>(num_threads) * NUM_HOPS;
+
+            printf("%d threads: %.2f us per hop, %.0f hops per second\n",
+                   num_threads, latency * 1000000, hops / duration);
+        }, num_threads);
+    }
+}
+#endif  // NDEBUG
+
+}  // namespace unittest
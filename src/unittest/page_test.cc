@@ -1,4 +1,6 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <vector>
+
 #include "arch/runtime/coroutines.hpp"
 #include "arch/timing.hpp"
 #include "buffer_cache/page_cache.hpp"
@@ -1175,4 +1177,186 @@ TPTEST(PageTest, BiggerTestNoMemory, 4) {
     test.run();
 }
 
+void read_blocks(test_cache_t *cache, const std::vector<block_id_t> &block_ids,
+                 page_reuse_t reuse) {
+    auto txn = make_scoped<test_txn_t>(cache);
+    for (block_id_t block_id : block_ids) {
+        current_test_acq_t acq(txn.get(), block_id, access_t::read);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(), cache);
+        page_acq.get_buf_read(reuse);
+    }
+    cache->flush(std::move(txn));
+}
+
+// Reads a hot set of blocks twice, scans over a lot of other blocks, and returns
+// how many bytes had to be loaded to read the hot set again.
+int64_t bytes_reloaded_after_scan(eviction_policy_t policy) {
+    const size_t num_hot = 10;
+    const size_t num_blocks = 200;
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids;
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&cache);
+        for (size_t i = 0; i < num_blocks; ++i) {
+            current_test_acq_t acq(txn.get(), alt_create_t::create);
+            block_ids.push_back(acq.block_id());
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &cache);
+            page_acq.get_buf_write();
+        }
+        cache.flush(std::move(txn));
+    }
+
+    const std::vector<block_id_t> hot(block_ids.begin(), block_ids.begin() + num_hot);
+    const std::vector<block_id_t> cold(block_ids.begin() + num_hot, block_ids.end());
+
+    // Room for about 40 blocks.
+    dummy_cache_balancer_t balancer(40 * (mock.ser->max_block_size().ser_value() + 512));
+    test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
+    cache.evicter().set_eviction_policy(policy);
+
+    read_blocks(&cache, hot, page_reuse_t::NORMAL);
+    read_blocks(&cache, hot, page_reuse_t::NORMAL);
+    read_blocks(&cache, cold, page_reuse_t::LOW);
+
+    const int64_t bytes_loaded = cache.evicter().get_bytes_loaded();
+    read_blocks(&cache, hot, page_reuse_t::NORMAL);
+    return cache.evicter().get_bytes_loaded() - bytes_loaded;
+}
+
+TPTEST(PageTest, ScanResistantEviction, 4) {
+    // The scan pushes the hot set out of the sampled LRU...
+    ASSERT_GT(bytes_reloaded_after_scan(eviction_policy_t::SAMPLED_LRU), 0);
+    // ... but only cycles through the probationary bag with TWO_QUEUE.
+    ASSERT_EQ(0, bytes_reloaded_after_scan(eviction_policy_t::TWO_QUEUE));
+}
+
+// Like `dummy_cache_balancer_t`, but lets the cache read ahead from the start.
+class read_ahead_cache_balancer_t final : public cache_balancer_t {
+public:
+    explicit read_ahead_cache_balancer_t(uint64_t _base_mem_per_store)
+        : base_mem_per_store_(_base_mem_per_store),
+          notify_activity_boolean_(false) { }
+
+    uint64_t base_mem_per_store() const final {
+        return base_mem_per_store_;
+    }
+
+    bool read_ahead_ok_at_start() const final {
+        return true;
+    }
+
+    bool *notify_activity_boolean(threadnum_t) final {
+        return &notify_activity_boolean_;
+    }
+
+    void wake_up_activity_happened() final { }
+
+private:
+    void add_evicter(alt::evicter_t *) { }
+    void remove_evicter(alt::evicter_t *) { }
+
+    uint64_t base_mem_per_store_;
+
+    bool notify_activity_boolean_;
+
+    DISABLE_COPYING(read_ahead_cache_balancer_t);
+};
+
+TPTEST(PageTest, TwoQueueReadAhead, 4) {
+    const size_t num_blocks = 200;
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids;
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&cache);
+        for (size_t i = 0; i < num_blocks; ++i) {
+            current_test_acq_t acq(txn.get(), alt_create_t::create);
+            block_ids.push_back(acq.block_id());
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &cache);
+            page_acq.get_buf_write();
+        }
+        cache.flush(std::move(txn));
+    }
+
+    // Room for about 40 blocks.
+    const uint64_t block_size = mock.ser->max_block_size().ser_value();
+    read_ahead_cache_balancer_t balancer(40 * (block_size + 512));
+    test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
+    cache.evicter().set_eviction_policy(eviction_policy_t::TWO_QUEUE);
+
+    // Reading one block makes the serializer offer its neighbors to the cache, which
+    // puts them on probation.
+    read_blocks(&cache, std::vector<block_id_t>(1, block_ids[0]), page_reuse_t::NORMAL);
+    for (int i = 0; i < 100; ++i) {
+        if (cache.evicter().evictable_disk_backed_size() > block_size) {
+            break;
+        }
+        nap(10);
+    }
+    ASSERT_LT(block_size, cache.evicter().evictable_disk_backed_size());
+
+    // Acquiring the read-ahead pages moves them between bags, and reading everything
+    // twice evicts them and the pages that replace them.
+    read_blocks(&cache, block_ids, page_reuse_t::NORMAL);
+    read_blocks(&cache, block_ids, page_reuse_t::LOW);
+    ASSERT_EQ(0u, cache.evicter().unevictable_size());
+    ASSERT_GE(cache.evicter().memory_limit(), cache.evicter().in_memory_size());
+}
+
+TPTEST(PageTest, WarmUp, 4) {
+    const size_t num_blocks = 100;
+    mock_ser_t mock;
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    std::vector<block_id_t> block_ids;
+    {
+        test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&cache);
+        for (size_t i = 0; i < num_blocks; ++i) {
+            current_test_acq_t acq(txn.get(), alt_create_t::create);
+            block_ids.push_back(acq.block_id());
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &cache);
+            page_acq.get_buf_write();
+        }
+        cache.flush(std::move(txn));
+    }
+
+    std::vector<block_id_t> hot;
+    {
+        test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
+        ASSERT_TRUE(cache.hot_block_ids(num_blocks).empty());
+        read_blocks(&cache, std::vector<block_id_t>(block_ids.begin() + 10,
+                                                    block_ids.begin() + 20),
+                    page_reuse_t::NORMAL);
+        // The most recently read blocks come first.
+        hot = cache.hot_block_ids(5);
+        ASSERT_EQ(std::vector<block_id_t>(block_ids.rbegin() + num_blocks - 20,
+                                          block_ids.rbegin() + num_blocks - 15),
+                  hot);
+    }
+
+    test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
+    cache_account_t account = cache.create_cache_account(CACHE_WARMUP_CACHE_PRIORITY);
+    cond_t non_interruptor;
+    for (block_id_t block_id : hot) {
+        cache.warm_up_block(block_id, &account, &non_interruptor);
+    }
+    const int64_t bytes_loaded = cache.evicter().get_bytes_loaded();
+    ASSERT_GT(bytes_loaded, 0);
+    read_blocks(&cache, hot, page_reuse_t::NORMAL);
+    ASSERT_EQ(bytes_loaded, cache.evicter().get_bytes_loaded());
+
+    // Warming up blocks that are already there doesn't load anything.
+    for (block_id_t block_id : hot) {
+        cache.warm_up_block(block_id, &account, &non_interruptor);
+    }
+    ASSERT_EQ(bytes_loaded, cache.evicter().get_bytes_loaded());
+}
+
 }  // namespace unittest
@@ -1,4 +1,5 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <algorithm>
 #include <functional>
 
 #include "arch/io/disk.hpp"
@@ -7,6 +8,7 @@
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "config/args.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/uuid.hpp"
@@ -20,6 +22,7 @@
 #include "rdb_protocol/sym.hpp"
 #include "stl_utils.hpp"
 #include "serializer/log/log_serializer.hpp"
+#include "time.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
 
@@ -443,4 +446,150 @@ TPTEST(RDBBtree, SindexInterruptionViaStoreDelete) {
     store.reset();
 }
 
+std::vector<key_range_t> split_range_of_store(
+        store_t *store, const key_range_t &range, size_t max_slices) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    store->acquire_superblock_for_read(
+            &token, &txn, &superblock,
+            &dummy_interruptor, false);
+    int64_t rows_in_range;
+    std::vector<key_range_t> slices = split_construction_range(
+        superblock.get(), range, max_slices, &rows_in_range);
+    EXPECT_LE(0, rows_in_range);
+
+    // The slices must be non-empty, contiguous, and cover all of `range`.
+    EXPECT_LE(1u, slices.size());
+    EXPECT_GE(max_slices, slices.size());
+    if (!slices.empty()) {
+        EXPECT_EQ(range.left, slices.front().left);
+        EXPECT_TRUE(range.right == slices.back().right);
+        for (size_t i = 0; i < slices.size(); ++i) {
+            EXPECT_FALSE(slices[i].is_empty());
+            if (i + 1 < slices.size()) {
+                EXPECT_TRUE(slices[i].right
+                            == key_range_t::right_bound_t(slices[i + 1].left));
+            }
+        }
+    }
+    return slices;
+}
+
+TPTEST(RDBBtree, SplitConstructionRange) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE,
+            which_cpu_shard_t{0, 1});
+
+    // An empty tree has nothing to split at.
+    EXPECT_EQ(1u, split_range_of_store(&store, key_range_t::universe(), 4).size());
+
+    insert_rows(0, TOTAL_KEYS_TO_INSERT, &store);
+
+    std::vector<store_key_t> keys;
+    for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+        keys.push_back(
+            store_key_t(ql::datum_t(static_cast<double>(i)).print_primary()));
+    }
+    std::sort(keys.begin(), keys.end());
+
+    EXPECT_EQ(4u, split_range_of_store(&store, key_range_t::universe(), 4).size());
+    EXPECT_EQ(1u, split_range_of_store(&store, key_range_t::universe(), 1).size());
+    split_range_of_store(&store, key_range_t(
+        key_range_t::closed, keys[100], key_range_t::open, keys[900]), 4);
+    split_range_of_store(&store, key_range_t(
+        key_range_t::open, keys[100], key_range_t::none, store_key_t()), 3);
+
+    // A range that only contains a single row, at its left end.
+    EXPECT_EQ(1u, split_range_of_store(&store, key_range_t(
+        key_range_t::closed, keys[500], key_range_t::open, keys[501]), 4).size());
+    // A range with no rows in it.
+    EXPECT_EQ(1u, split_range_of_store(&store, key_range_t(
+        key_range_t::open, keys.back(), key_range_t::none, store_key_t()), 4).size());
+}
+
+TPTEST(RDBBtree, SindexRowsPerSecond) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE,
+            which_cpu_shard_t{0, 1});
+
+    uuid_u running_id = generate_uuid();
+    uuid_u starting_id = generate_uuid();
+
+    sindex_construction_progress_t running;
+    running.start_time = current_microtime() - 2 * MILLION;
+    running.rows_done = 1000;
+    sindex_construction_progress_t starting;
+    starting.start_time = current_microtime() + MILLION;
+    starting.rows_done = 1000;
+
+    store.get_sindex_context_map()->insert(std::make_pair(running_id, &running));
+    store.get_sindex_context_map()->insert(std::make_pair(starting_id, &starting));
+
+    double rows_per_second = store.get_sindex_rows_per_second(running_id);
+    EXPECT_LT(400.0, rows_per_second);
+    EXPECT_GE(500.0, rows_per_second);
+    // No time has passed yet.
+    EXPECT_EQ(0.0, store.get_sindex_rows_per_second(starting_id));
+    // An index that isn't being constructed.
+    EXPECT_EQ(0.0, store.get_sindex_rows_per_second(generate_uuid()));
+
+    store.get_sindex_context_map()->erase(running_id);
+    store.get_sindex_context_map()->erase(starting_id);
+}
+
 } //namespace unittest
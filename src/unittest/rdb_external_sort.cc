@@ -0,0 +1,111 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <utility>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "clustering/administration/metadata.hpp"
+#include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/order_util.hpp"
+#include "stl_utils.hpp"
+#include "unittest/dummy_metadata_controller.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+ql::datum_t make_sort_row(double key, double added) {
+    ql::datum_object_builder_t builder;
+    UNUSED bool dup = builder.add("key", ql::datum_t(key));
+    dup = builder.add("added", ql::datum_t(added));
+    return std::move(builder).to_datum();
+}
+
+/* Adds `num_runs` runs of `run_size` rows to an `external_sort_datum_stream_t` that
+orders them by `key`, and checks that reading the stream in batches returns every row
+in order, with rows of equal keys in the order they were added in. */
+void run_external_sort_stream_test(ql::order_direction_t direction,
+                                   int num_runs,
+                                   int run_size) {
+    recreate_temporary_directory(base_path_t("."));
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t> auth_manager;
+    rdb_context_t ctx(nullptr, nullptr, nullptr, auth_manager.get_view(),
+                      &get_global_perfmon_collection(), std::string(),
+                      &io_backender, base_path_t("."));
+    cond_t interruptor;
+    ql::env_t env(&ctx,
+                  ql::return_empty_normal_batches_t::NO,
+                  &interruptor,
+                  ql::global_optargs_t(),
+                  auth::user_context_t(auth::permissions_t(false, false, false, false)),
+                  nullptr);
+    ASSERT_TRUE(ql::external_sort_datum_stream_t::can_spill(&env));
+
+    ql::sym_t x(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    counted_t<const ql::func_t> key_fn =
+        ql::wire_func_t(r.var(x)["key"].root_term(), make_vector(x))
+            .compile_wire_func();
+    ql::lt_cmp_t lt_cmp(make_vector(std::make_pair(direction, key_fn)));
+
+    counted_t<ql::external_sort_datum_stream_t> stream =
+        make_counted<ql::external_sort_datum_stream_t>(
+            &env, lt_cmp, ql::backtrace_id_t::empty());
+    int added = 0;
+    for (int run = 0; run < num_runs; ++run) {
+        std::vector<ql::datum_t> rows;
+        for (int i = 0; i < run_size; ++i) {
+            rows.push_back(make_sort_row(randint(100), added++));
+        }
+        stream->add_run(&env, &rows);
+        EXPECT_TRUE(rows.empty());
+    }
+
+    const double sign = direction == ql::ASC ? 1.0 : -1.0;
+    double prev_key = 0.0;
+    double prev_added = -1.0;
+    int read = 0;
+    size_t batches = 0;
+    for (;;) {
+        std::vector<ql::datum_t> batch = stream->next_batch(
+            &env,
+            ql::batchspec_t::default_for(ql::batch_type_t::NORMAL).with_at_most(100));
+        if (batch.empty()) {
+            break;
+        }
+        ++batches;
+        for (const ql::datum_t &row : batch) {
+            const double key = sign * row.get_field("key").as_num();
+            const double row_added = row.get_field("added").as_num();
+            if (read > 0) {
+                EXPECT_TRUE(prev_key < key
+                            || (prev_key == key && prev_added < row_added))
+                    << "row " << read;
+            }
+            prev_key = key;
+            prev_added = row_added;
+            ++read;
+        }
+    }
+    EXPECT_EQ(num_runs * run_size, read);
+    EXPECT_LT(1u, batches);
+    EXPECT_TRUE(stream->is_exhausted());
+}
+
+TPTEST(RDBExternalSort, Ascending) {
+    // Enough runs to merge some of them twice before the stream gets read.
+    run_external_sort_stream_test(ql::ASC, 300, 20);
+}
+
+TPTEST(RDBExternalSort, Descending) {
+    run_external_sort_stream_test(ql::DESC, 40, 100);
+}
+
+TPTEST(RDBExternalSort, SingleRun) {
+    run_external_sort_stream_test(ql::ASC, 1, 1000);
+}
+
+}  // namespace unittest
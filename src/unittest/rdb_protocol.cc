@@ -8,11 +8,15 @@
 #include <boost/shared_ptr.hpp>
 
 #include "arch/io/disk.hpp"
+#include "btree/operations.hpp"
+#include "btree/reql_specific.hpp"
 #include "buffer_cache/cache_balancer.hpp"
 #include "clustering/administration/metadata.hpp"
+#include "concurrency/pmap.hpp"
 #include "extproc/extproc_pool.hpp"
 #include "extproc/extproc_spawner.hpp"
 #include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/func.hpp"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/store.hpp"
@@ -677,6 +681,150 @@ TEST(RDBProtocol, SindexRepeatedRename) {
         10);
 }
 
+/* The ids of the rows start with letters from all over the alphabet, so that the
+rows of a batch go to both shards of `run_with_namespace_interface()`. */
+ql::datum_t make_sid_doc(int id, int sid) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("id", ql::datum_t(datum_string_t(
+        strprintf("%c%d", static_cast<char>('a' + id % 26), id))));
+    builder.overwrite("sid", ql::datum_t(static_cast<double>(sid)));
+    return std::move(builder).to_datum();
+}
+
+/* Inserts `num_rows` rows with ids from `first_id` on and a `sid` of `sid`, followed by
+another copy of the first `num_duplicates` of them with a `sid` of `sid + 1`, and another
+copy of the first `num_duplicates / 2` with a `sid` of `sid + 2`. They're all inserted in
+one batch. */
+void insert_batch_with_duplicates(
+        namespace_interface_t *nsi,
+        order_source_t *osource,
+        int first_id,
+        int num_rows,
+        int num_duplicates,
+        int sid,
+        conflict_behavior_t conflict_behavior,
+        const boost::optional<ql::wire_func_t> &conflict_func) {
+    std::vector<ql::datum_t> docs;
+    for (int i = 0; i < num_rows; ++i) {
+        docs.push_back(make_sid_doc(first_id + i, sid));
+    }
+    for (int i = 0; i < num_duplicates; ++i) {
+        docs.push_back(make_sid_doc(first_id + i, sid + 1));
+    }
+    for (int i = 0; i < num_duplicates / 2; ++i) {
+        docs.push_back(make_sid_doc(first_id + i, sid + 2));
+    }
+
+    ql::configured_limits_t limits;
+    auth::user_context_t user_context(auth::permissions_t(true, true, false, false));
+    batched_insert_t insert(std::move(docs), "id", conflict_behavior, boost::none,
+                            limits, user_context, return_changes_t::NO);
+    insert.conflict_func = conflict_func;
+    write_t write(std::move(insert), DURABILITY_REQUIREMENT_SOFT,
+                  profile_bool_t::PROFILE, limits);
+    write_response_t response;
+
+    cond_t interruptor;
+    nsi->write(
+        user_context,
+        write,
+        &response,
+        osource->check_in("unittest::insert_batch_with_duplicates(rdb_protocol.cc-A"),
+        &interruptor);
+
+    if (!boost::get<batched_replace_response_t>(&response.response)) {
+        ADD_FAILURE() << "got wrong type of result back";
+    }
+}
+
+/* The number of batches that the stores inserted in key order with
+`rdb_batched_insert_into_empty_range()`. */
+int64_t count_sorted_inserts(const std::vector<scoped_ptr_t<store_t> > *stores) {
+    int64_t total = 0;
+    for (const auto &store : *stores) {
+        perfmon_t *counter = &store->btree->stats.pm_total_sorted_inserts;
+        void *data = counter->begin_stats();
+        pmap(get_num_threads(), [&](int thread) {
+            on_thread_t thread_switcher((threadnum_t(thread)));
+            counter->visit_stats(data);
+        });
+        total += counter->end_stats(data).as_int();
+    }
+    return total;
+}
+
+void run_sindex_batched_insert_test(
+        namespace_interface_t *nsi,
+        order_source_t *osource,
+        const std::vector<scoped_ptr_t<store_t> > *stores) {
+    std::string id = create_sindex(stores);
+    wait_for_sindex(stores, id);
+
+    // Each shard gets half of the rows, which must be well above the 32 keys that
+    // `rdb_batched_insert_into_empty_range()` needs.
+    const int num_rows = 256;
+    const int num_duplicates = 64;
+    // Every batch is split between the two shards of the namespace interface, and
+    // both halves go into empty key ranges.
+    const int64_t sorted_inserts_per_batch = 2;
+    int64_t sorted_inserts = count_sorted_inserts(stores);
+
+    // The duplicates replace the rows, and the last copy replaces them again.
+    insert_batch_with_duplicates(nsi, osource, 1000, num_rows, num_duplicates, 10,
+                                 conflict_behavior_t::REPLACE, boost::none);
+    sorted_inserts += sorted_inserts_per_batch;
+    EXPECT_EQ(sorted_inserts, count_sorted_inserts(stores));
+    read_sindex(nsi, osource, 10.0, id, num_rows - num_duplicates);
+    read_sindex(nsi, osource, 11.0, id, num_duplicates / 2);
+    read_sindex(nsi, osource, 12.0, id, num_duplicates / 2);
+
+    // Same for updates, since `sid` is the only other field.
+    insert_batch_with_duplicates(nsi, osource, 2000, num_rows, num_duplicates, 20,
+                                 conflict_behavior_t::UPDATE, boost::none);
+    sorted_inserts += sorted_inserts_per_batch;
+    EXPECT_EQ(sorted_inserts, count_sorted_inserts(stores));
+    read_sindex(nsi, osource, 20.0, id, num_rows - num_duplicates);
+    read_sindex(nsi, osource, 21.0, id, num_duplicates / 2);
+    read_sindex(nsi, osource, 22.0, id, num_duplicates / 2);
+
+    // The duplicates fail, and the rows keep their first values.
+    insert_batch_with_duplicates(nsi, osource, 3000, num_rows, num_duplicates, 30,
+                                 conflict_behavior_t::ERROR, boost::none);
+    sorted_inserts += sorted_inserts_per_batch;
+    EXPECT_EQ(sorted_inserts, count_sorted_inserts(stores));
+    read_sindex(nsi, osource, 30.0, id, num_rows);
+
+    // A conflict function that returns `null` deletes the rows, and the last copy is
+    // inserted again as a new row.
+    const ql::sym_t key_arg(1), old_arg(2), new_arg(3);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    ql::wire_func_t delete_func(r.null().root_term(),
+                                make_vector(key_arg, old_arg, new_arg));
+    insert_batch_with_duplicates(nsi, osource, 4000, num_rows, num_duplicates, 40,
+                                 conflict_behavior_t::FUNCTION, delete_func);
+    sorted_inserts += sorted_inserts_per_batch;
+    EXPECT_EQ(sorted_inserts, count_sorted_inserts(stores));
+    read_sindex(nsi, osource, 40.0, id, num_rows - num_duplicates);
+    read_sindex(nsi, osource, 42.0, id, num_duplicates / 2);
+
+    // The ids of this batch overlap the rows of the first one, so it can't take the
+    // fast path and gets replaced one row at a time instead.
+    insert_batch_with_duplicates(nsi, osource, 1000, num_rows, num_duplicates, 50,
+                                 conflict_behavior_t::REPLACE, boost::none);
+    EXPECT_EQ(sorted_inserts, count_sorted_inserts(stores));
+    read_sindex(nsi, osource, 50.0, id, num_rows - num_duplicates);
+
+    drop_sindex(stores, id);
+}
+
+TEST(RDBProtocol, SindexBatchedInsert) {
+    run_in_thread_pool_with_namespace_interface(&run_sindex_batched_insert_test, false);
+}
+
+TEST(RDBProtocol, OvershardedSindexBatchedInsert) {
+    run_in_thread_pool_with_namespace_interface(&run_sindex_batched_insert_test, true);
+}
+
 void check_sindexes(
         const std::vector<scoped_ptr_t<store_t> > *stores,
         const std::set<std::string> &expect) {
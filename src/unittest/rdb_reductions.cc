@@ -0,0 +1,242 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <math.h>
+
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/shards.hpp"
+#include "rdb_protocol/sym.hpp"
+#include "rdb_protocol/val.hpp"
+#include "stl_utils.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// More than the terminals put into one batch, so that batches fill up and get
+// flushed in the middle of a group.
+const size_t ROWS_PER_GROUP = 1000;
+
+double sum_in_order(const std::vector<double> &numbers) {
+    double sum = 0.0;
+    for (double n : numbers) {
+        sum += n;
+    }
+    return sum;
+}
+
+TEST(RDBReductions, SumNumbersTails) {
+    // Covers every length of the scalar tail behind the four-wide loop.
+    for (size_t count = 0; count < 24; ++count) {
+        std::vector<double> numbers;
+        for (size_t i = 0; i < count; ++i) {
+            // Halves add up exactly in any order.
+            numbers.push_back(static_cast<double>(i) * 0.5 - 3.0);
+        }
+        EXPECT_EQ(sum_in_order(numbers), ql::sum_numbers(numbers.data(), count))
+            << "count " << count;
+    }
+}
+
+TEST(RDBReductions, SumNumbersNonFinite) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    // Put the special values into each of the lanes and into the tail.
+    for (size_t count = 1; count < 12; ++count) {
+        for (size_t pos = 0; pos < count; ++pos) {
+            std::vector<double> numbers(count, 1.0);
+
+            numbers[pos] = nan;
+            EXPECT_TRUE(isnan(ql::sum_numbers(numbers.data(), count)));
+
+            numbers[pos] = inf;
+            EXPECT_EQ(inf, ql::sum_numbers(numbers.data(), count));
+
+            numbers[pos] = -inf;
+            EXPECT_EQ(-inf, ql::sum_numbers(numbers.data(), count));
+
+            if (count > 1) {
+                numbers[(pos + 1) % count] = inf;
+                EXPECT_TRUE(isnan(ql::sum_numbers(numbers.data(), count)));
+            }
+        }
+    }
+
+    // Finite numbers can still add up to infinity.
+    std::vector<double> big(9, std::numeric_limits<double>::max());
+    EXPECT_EQ(inf, ql::sum_numbers(big.data(), big.size()));
+}
+
+bool is_field_getter(const ql::raw_term_t &body,
+                     std::vector<ql::sym_t> args,
+                     datum_string_t *field_out) {
+    counted_t<const ql::func_t> f =
+        ql::wire_func_t(body, std::move(args)).compile_wire_func();
+    return f->is_field_getter(field_out);
+}
+
+TPTEST(RDBReductions, FieldGetter) {
+    ql::sym_t x(1), y(2);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+
+    datum_string_t field;
+    EXPECT_TRUE(is_field_getter(r.var(x)["a"].root_term(), make_vector(x), &field));
+    EXPECT_EQ(datum_string_t("a"), field);
+    EXPECT_TRUE(is_field_getter(
+        r.var(x).bracket("b").root_term(), make_vector(x), &field));
+    EXPECT_EQ(datum_string_t("b"), field);
+
+    // A field of a field.
+    EXPECT_FALSE(is_field_getter(
+        r.var(x)["a"]["b"].root_term(), make_vector(x), &field));
+    // The field with a default.
+    EXPECT_FALSE(is_field_getter(
+        r.var(x)["a"].default_(0.0).root_term(), make_vector(x), &field));
+    // A number rather than a field name.
+    EXPECT_FALSE(is_field_getter(
+        r.var(x).bracket(0.0).root_term(), make_vector(x), &field));
+    // A field of something other than the argument.
+    EXPECT_FALSE(is_field_getter(
+        r.expr(ql::datum_t::empty_object())["a"].root_term(), make_vector(x), &field));
+    // A field of one of several arguments.
+    EXPECT_FALSE(is_field_getter(
+        r.var(y)["a"].root_term(), make_vector(x, y), &field));
+}
+
+ql::datum_t make_row(double number) {
+    ql::datum_object_builder_t builder;
+    UNUSED bool dup = builder.add("a", ql::datum_t(number));
+    return std::move(builder).to_datum();
+}
+
+/* Feeds the same rows through `terminal` in several rounds. The groups are
+interleaved, and the rounds are uneven, so batches get cut off by switching between
+groups and by `add_res` as well as by filling up. Returns the result of
+`finish_eager`, and the sum and count of every group. */
+scoped_ptr_t<ql::val_t> run_grouped_terminal(
+        ql::env_t *env,
+        const ql::terminal_variant_t &terminal,
+        bool with_add_res,
+        std::map<std::string, std::pair<double, uint64_t> > *expected_out) {
+    scoped_ptr_t<ql::eager_acc_t> acc = ql::make_eager_terminal(terminal);
+    const char *group_names[] = { "a", "b", "c" };
+    size_t rows_in_round[] = { 3, ROWS_PER_GROUP, 1, ROWS_PER_GROUP / 3 + 7 };
+    size_t next = 0;
+    for (size_t round = 0; round < 4; ++round) {
+        ql::groups_t groups;
+        for (size_t g = 0; g < 3; ++g) {
+            // Group "c" sits out a round, so its rows come in fewer, bigger pieces.
+            if (g == 2 && round == 1) {
+                continue;
+            }
+            ql::datums_t *rows = &groups[ql::datum_t(group_names[g])];
+            for (size_t i = 0; i < rows_in_round[round]; ++i, ++next) {
+                double number = static_cast<double>(next % 97) * 0.25;
+                rows->push_back(make_row(number));
+                (*expected_out)[group_names[g]].first += number;
+                (*expected_out)[group_names[g]].second += 1;
+            }
+            // Rows without the field get skipped.
+            rows->push_back(ql::datum_t::empty_object());
+        }
+        (*acc)(env, &groups);
+
+        if (with_add_res && round == 2) {
+            // The result of another shard, with a group we have and one we don't.
+            ql::result_t res;
+            if (boost::get<ql::sum_wire_func_t>(&terminal) != nullptr) {
+                ql::grouped_t<double> shard;
+                shard[ql::datum_t("a")] = 1000.0;
+                shard[ql::datum_t("d")] = 5.5;
+                res = shard;
+            } else {
+                ql::grouped_t<std::pair<double, uint64_t> > shard;
+                shard[ql::datum_t("a")] = std::make_pair(1000.0, 8);
+                shard[ql::datum_t("d")] = std::make_pair(5.5, 2);
+                res = shard;
+            }
+            acc->add_res(env, &res, sorting_t::UNORDERED);
+            (*expected_out)["a"].first += 1000.0;
+            (*expected_out)["a"].second += 8;
+            (*expected_out)["d"].first += 5.5;
+            (*expected_out)["d"].second += 2;
+        }
+    }
+    return acc->finish_eager(
+        ql::backtrace_id_t::empty(), true, ql::configured_limits_t());
+}
+
+void run_grouped_sum_avg_test(bool with_add_res) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    ql::sym_t x(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    ql::wire_func_t getter(r.var(x)["a"].root_term(), make_vector(x));
+
+    {
+        std::map<std::string, std::pair<double, uint64_t> > expected;
+        scoped_ptr_t<ql::val_t> res = run_grouped_terminal(
+            &env,
+            ql::sum_wire_func_t(ql::backtrace_id_t::empty(), getter),
+            with_add_res,
+            &expected);
+        counted_t<ql::grouped_data_t> groups = res->as_grouped_data();
+        ASSERT_EQ(expected.size(), groups->size());
+        for (const auto &pair : expected) {
+            EXPECT_EQ(pair.second.first,
+                      (*groups)[ql::datum_t(pair.first.c_str())].as_num())
+                << "group " << pair.first;
+        }
+    }
+
+    {
+        std::map<std::string, std::pair<double, uint64_t> > expected;
+        scoped_ptr_t<ql::val_t> res = run_grouped_terminal(
+            &env,
+            ql::avg_wire_func_t(ql::backtrace_id_t::empty(), getter),
+            with_add_res,
+            &expected);
+        counted_t<ql::grouped_data_t> groups = res->as_grouped_data();
+        ASSERT_EQ(expected.size(), groups->size());
+        for (const auto &pair : expected) {
+            EXPECT_EQ(pair.second.first / pair.second.second,
+                      (*groups)[ql::datum_t(pair.first.c_str())].as_num())
+                << "group " << pair.first;
+        }
+    }
+}
+
+TPTEST(RDBReductions, GroupedSumAvg) {
+    run_grouped_sum_avg_test(false);
+}
+
+TPTEST(RDBReductions, GroupedSumAvgWithShardResults) {
+    run_grouped_sum_avg_test(true);
+}
+
+TPTEST(RDBReductions, SumOverflow) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    scoped_ptr_t<ql::eager_acc_t> acc = ql::make_eager_terminal(
+        ql::sum_wire_func_t(ql::backtrace_id_t::empty()));
+
+    ql::groups_t groups;
+    groups[ql::datum_t()].push_back(ql::datum_t(1e308));
+    groups[ql::datum_t()].push_back(ql::datum_t(1e308));
+    (*acc)(&env, &groups);
+    EXPECT_THROW(
+        acc->finish_eager(ql::backtrace_id_t::empty(), false, ql::configured_limits_t()),
+        ql::base_exc_t);
+}
+
+}  // namespace unittest
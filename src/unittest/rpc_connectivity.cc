@@ -6,9 +6,12 @@
 #else
 
 #include <functional>
+#include <map>
+#include <string>
 
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/timing.hpp"
+#include "concurrency/pmap.hpp"
 #include "containers/scoped.hpp"
 #include "containers/archive/socket_stream.hpp"
 #include "unittest/clustering_utils.hpp"
@@ -452,6 +455,96 @@ TPTEST_MULTITHREAD(RPCConnectivityTest, BinaryData, 3) {
     EXPECT_TRUE(a2.got_spectrum);
 }
 
+/* `bulk_test_application_t` sends strings of a single repeated character. It allows
+reordering, so strings of at least 16KB go through the connection's bulk lane. */
+
+class bulk_test_application_t :
+    public home_thread_mixin_t,
+    public cluster_message_handler_t
+{
+public:
+    explicit bulk_test_application_t(connectivity_cluster_t *cm) :
+        cluster_message_handler_t(cm, 'L')
+        { }
+    void send(char fill, size_t size, peer_id_t peer) {
+        class writer_t : public cluster_send_message_write_callback_t {
+        public:
+            writer_t(char fill, size_t size) : data(size, fill) { }
+            virtual ~writer_t() { }
+            void write(write_stream_t *stream) {
+                write_message_t wm;
+                serialize<cluster_version_t::CLUSTER>(&wm, data);
+                int res = send_write_message(stream, &wm);
+                if (res) { throw fake_archive_exc_t(); }
+            }
+#ifdef ENABLE_MESSAGE_PROFILER
+            const char *message_profiler_tag() const {
+                return "unittest";
+            }
+#endif
+            std::string data;
+        } writer(fill, size);
+        auto_drainer_t::lock_t connection_keepalive;
+        connectivity_cluster_t::connection_t *connection =
+            get_connectivity_cluster()->get_connection(peer, &connection_keepalive);
+        ASSERT_TRUE(connection != nullptr);
+        get_connectivity_cluster()->send_message(connection, connection_keepalive,
+                                                 get_message_tag(), &writer);
+    }
+    void expect(char fill, size_t size) {
+        assert_thread();
+        auto it = received.find(fill);
+        ASSERT_TRUE(it != received.end()) << "'" << fill << "'";
+        EXPECT_EQ(size, it->second) << "'" << fill << "'";
+    }
+
+private:
+    bool allows_reordering() const { return true; }
+
+    void on_message(connectivity_cluster_t::connection_t *,
+                    auto_drainer_t::lock_t,
+                    read_stream_t *stream) {
+        std::string data;
+        archive_result_t res = deserialize<cluster_version_t::CLUSTER>(stream, &data);
+        if (bad(res) || data.empty()) { throw fake_archive_exc_t(); }
+        EXPECT_EQ(std::string::npos, data.find_first_not_of(data[0]));
+        on_thread_t th(home_thread());
+        EXPECT_EQ(0u, received.count(data[0]));
+        received[data[0]] = data.size();
+    }
+
+    std::map<char, size_t> received;
+};
+
+/* `OversizedBulkMessage` checks that bulk messages larger than a whole bulk write
+(256KB) arrive in one piece, and so do the messages sent alongside them. */
+TPTEST_MULTITHREAD(RPCConnectivityTest, OversizedBulkMessage, 3) {
+    connectivity_cluster_t c1, c2;
+    bulk_test_application_t a1(&c1), a2(&c2);
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    std::vector<std::pair<char, size_t> > messages = {
+        {'a', 4 * MEGABYTE},
+        {'b', 20 * KILOBYTE},
+        {'c', 300 * KILOBYTE},
+        {'d', 100},
+        {'e', 1 * MEGABYTE},
+        {'f', 40 * KILOBYTE}};
+    pmap(messages.size(), [&](size_t i) {
+        a1.send(messages[i].first, messages[i].second, c2.get_me());
+    });
+
+    let_stuff_happen();
+
+    for (const auto &message : messages) {
+        a2.expect(message.first, message.second);
+    }
+}
+
 /* `PeerIDSemantics` makes sure that `peer_id_t::is_nil()` works as expected. */
 TPTEST_MULTITHREAD(RPCConnectivityTest, PeerIDSemantics, 3) {
     peer_id_t nil_peer;
@@ -1,9 +1,12 @@
 #include <functional>
 
+#include "arch/arch.hpp"
 #include "arch/runtime/starter.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "random.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/log/log_serializer.hpp"
+#include "serializer/log/static_header.hpp"
 #include "unittest/mock_file.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -90,5 +93,148 @@ TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
     run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
 }
 
+TPTEST(SerializerTest, CompressedBlocks) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    // Block 0 compresses well, block 1 doesn't compress at all.
+    std::vector<buf_ptr_t> bufs;
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        rng_t rng(12345);
+        bufs.push_back(buf_ptr_t::alloc_zeroed(ser.max_block_size()));
+        memset(bufs[0].cache_data(), 'x', bufs[0].block_size().value() / 2);
+        bufs.push_back(buf_ptr_t::alloc_zeroed(ser.max_block_size()));
+        char *noise = static_cast<char *>(bufs[1].cache_data());
+        for (uint32_t i = 0; i < bufs[1].block_size().value(); ++i) {
+            noise[i] = rng.randint(256);
+        }
+
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        std::vector<buf_write_info_t> infos;
+        for (size_t i = 0; i < bufs.size(); ++i) {
+            infos.push_back(buf_write_info_t(bufs[i].ser_buffer(), bufs[i].block_size(),
+                                             i, block_compression_t::LZ4));
+        }
+
+        struct : public iocallback_t, public cond_t {
+            void on_io_complete() {
+                pulse();
+            }
+        } cb;
+        std::vector<counted_t<standard_block_token_t> > tokens
+            = ser.block_writes(infos.data(), infos.size(), account.get(), &cb);
+        cb.wait();
+
+        ASSERT_EQ(bufs[0].block_size(), tokens[0]->block_size());
+        ASSERT_LT(tokens[0]->disk_block_size().ser_value(),
+                  bufs[0].block_size().ser_value() / 4);
+        ASSERT_EQ(bufs[1].block_size(), tokens[1]->block_size());
+        ASSERT_EQ(bufs[1].block_size(), tokens[1]->disk_block_size());
+
+        std::vector<index_write_op_t> write_ops;
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            write_ops.push_back(index_write_op_t(i, tokens[i],
+                                                 repli_timestamp_t::distant_past));
+        }
+        new_mutex_in_line_t dummy_acq;
+        ser.index_write(&dummy_acq, []{ }, write_ops);
+    }
+
+    // The sizes have to survive a restart, which reads them back from the LBA.
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        counted_t<standard_block_token_t> token = ser.index_read(i);
+        ASSERT_TRUE(token.has());
+        ASSERT_EQ(bufs[i].block_size(), token->block_size());
+        buf_ptr_t read = ser.block_read(token, account.get());
+        ASSERT_EQ(bufs[i].block_size(), read.block_size());
+        ASSERT_EQ(0, memcmp(bufs[i].ser_buffer(), read.ser_buffer(),
+                            bufs[i].block_size().ser_value()));
+    }
+}
+
+std::string read_serializer_version(mock_file_opener_t *file_opener) {
+    scoped_ptr_t<file_t> file;
+    file_opener->open_serializer_file_existing(&file);
+    scoped_device_block_aligned_ptr_t<static_header_t> header(DEVICE_BLOCK_SIZE);
+    co_read(file.get(), 0, DEVICE_BLOCK_SIZE, header.get(), DEFAULT_DISK_ACCOUNT);
+    return std::string(header->version);
+}
+
+void write_one_block(log_serializer_t *ser, block_id_t block_id,
+                     const buf_ptr_t &buf, block_compression_t compression) {
+    scoped_ptr_t<file_account_t> account(ser->make_io_account(1));
+    buf_write_info_t info(buf.ser_buffer(), buf.block_size(), block_id, compression);
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<standard_block_token_t> > tokens
+        = ser->block_writes(&info, 1, account.get(), &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    write_ops.push_back(index_write_op_t(block_id, tokens[0],
+                                         repli_timestamp_t::distant_past));
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+// Files only move to serializer version 2.4 once they contain a compressed block, so
+// that previous versions can still open the others.
+TPTEST(SerializerTest, VersionOnlyBumpedByCompressedBlocks) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    EXPECT_EQ("2.2", read_serializer_version(&file_opener));
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+        memset(buf.cache_data(), 'x', buf.block_size().value() / 2);
+
+        write_one_block(&ser, 0, buf, block_compression_t::NONE);
+        EXPECT_EQ("2.2", read_serializer_version(&file_opener));
+
+        write_one_block(&ser, 1, buf, block_compression_t::LZ4);
+        EXPECT_EQ("2.4", read_serializer_version(&file_opener));
+    }
+
+    // The migration is one-way. Files with compressed blocks keep their version,
+    // even after a restart and writes that don't compress anything.
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    write_one_block(&ser, 2, buf, block_compression_t::NONE);
+    EXPECT_EQ("2.4", read_serializer_version(&file_opener));
+}
+
+// Field dictionaries are stored in regular blocks, so their writers have to ask for the
+// current format explicitly.
+TPTEST(SerializerTest, VersionBumpedOnRequest) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    write_one_block(&ser, 0, buf, block_compression_t::NONE);
+    EXPECT_EQ("2.2", read_serializer_version(&file_opener));
+
+    ser.require_current_format();
+    EXPECT_EQ("2.2", read_serializer_version(&file_opener));
+    write_one_block(&ser, 1, buf, block_compression_t::NONE);
+    EXPECT_EQ("2.4", read_serializer_version(&file_opener));
+}
+
 
 }  // namespace unittest
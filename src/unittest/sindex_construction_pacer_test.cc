@@ -0,0 +1,115 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <vector>
+
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rdb_protocol/sindex_construction_pacer.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+const double SLOW_WRITE_MS = 2 * SINDEX_CONSTRUCTION_TARGET_WRITE_LATENCY_MS;
+
+TPTEST(SindexConstructionPacerTest, DoublesUpToMaximum) {
+    perfmon_collection_t collection;
+    write_latency_monitor_t monitor(&collection);
+    sindex_construction_pacer_t pacer(&monitor);
+
+    // Without any writes, there's no reason to pause.
+    EXPECT_EQ(0, pacer.update_pause_ms());
+
+    int64_t expected = 1;
+    for (int i = 0; i < 20; ++i) {
+        monitor.record_write(SLOW_WRITE_MS);
+        EXPECT_EQ(expected, pacer.update_pause_ms());
+        expected = std::min<int64_t>(2 * expected, SINDEX_CONSTRUCTION_MAX_PAUSE_MS);
+    }
+    // A chunk without any writes.
+    EXPECT_EQ(SINDEX_CONSTRUCTION_MAX_PAUSE_MS / 2, pacer.update_pause_ms());
+}
+
+TPTEST(SindexConstructionPacerTest, HalvesWithoutSlowWrites) {
+    perfmon_collection_t collection;
+    write_latency_monitor_t monitor(&collection);
+    sindex_construction_pacer_t pacer(&monitor);
+
+    for (int i = 0; i < 20; ++i) {
+        monitor.record_write(SLOW_WRITE_MS);
+        pacer.update_pause_ms();
+    }
+
+    // Chunks during which there were no writes.
+    int64_t expected = SINDEX_CONSTRUCTION_MAX_PAUSE_MS;
+    for (int i = 0; i < 3; ++i) {
+        expected /= 2;
+        EXPECT_EQ(expected, pacer.update_pause_ms());
+    }
+
+    // Chunks during which the writes were slow, but less so on average than the
+    // target.
+    while (monitor.average_latency_ms() > SINDEX_CONSTRUCTION_TARGET_WRITE_LATENCY_MS) {
+        monitor.record_write(0);
+    }
+    while (expected > 0) {
+        expected /= 2;
+        monitor.record_write(SLOW_WRITE_MS / 4);
+        EXPECT_EQ(expected, pacer.update_pause_ms());
+    }
+    EXPECT_EQ(0, pacer.update_pause_ms());
+}
+
+TPTEST(SindexConstructionPacerTest, ConcurrentSlices) {
+    perfmon_collection_t collection;
+    write_latency_monitor_t monitor(&collection);
+
+    // Index construction traverses several slices of a table at once, each with its
+    // own pacer. Every pacer has to notice the writes since its own last update, not
+    // just the ones since any slice last paused.
+    const int NUM_SLICES = 4;
+    std::vector<scoped_ptr_t<sindex_construction_pacer_t> > pacers;
+    for (int i = 0; i < NUM_SLICES; ++i) {
+        pacers.push_back(make_scoped<sindex_construction_pacer_t>(&monitor));
+    }
+
+    int64_t expected = 1;
+    for (int chunk = 0; chunk < 5; ++chunk) {
+        monitor.record_write(SLOW_WRITE_MS);
+        for (int i = 0; i < NUM_SLICES; ++i) {
+            EXPECT_EQ(expected, pacers[i]->update_pause_ms()) << "slice " << i;
+        }
+        expected *= 2;
+    }
+
+    // Every slice sees the same write, and backs off on its own once there are none.
+    monitor.record_write(SLOW_WRITE_MS);
+    for (int i = 0; i < NUM_SLICES; ++i) {
+        EXPECT_EQ(32, pacers[i]->update_pause_ms()) << "slice " << i;
+    }
+    for (int i = 0; i < NUM_SLICES; ++i) {
+        EXPECT_EQ(16, pacers[i]->update_pause_ms()) << "slice " << i;
+    }
+}
+
+TPTEST(SindexConstructionPacerTest, MovingAverage) {
+    perfmon_collection_t collection;
+    write_latency_monitor_t monitor(&collection);
+    EXPECT_EQ(0u, monitor.num_writes());
+
+    // The first write sets the average, and later ones move it gradually.
+    monitor.record_write(10);
+    EXPECT_EQ(10, monitor.average_latency_ms());
+    monitor.record_write(110);
+    EXPECT_LT(10, monitor.average_latency_ms());
+    EXPECT_GT(60, monitor.average_latency_ms());
+    EXPECT_EQ(2u, monitor.num_writes());
+
+    {
+        write_latency_monitor_t::sentry_t sentry(&monitor);
+    }
+    EXPECT_EQ(3u, monitor.num_writes());
+}
+
+}  // namespace unittest
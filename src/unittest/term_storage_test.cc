@@ -0,0 +1,146 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "unittest/gtest.hpp"
+
+#include "rapidjson/document.h"
+#include "rdb_protocol/term_storage.hpp"
+
+namespace unittest {
+
+bool match_query(const char *json, ql::point_get_query_t *out) {
+    size_t size = strlen(json);
+    scoped_array_t<char> data(size + 1);
+    memcpy(data.data(), json, size + 1);
+    rapidjson::Document doc;
+    doc.ParseInsitu(data.data());
+    EXPECT_FALSE(doc.HasParseError());
+    ql::json_term_storage_t storage(std::move(data), std::move(doc));
+    bool res = storage.match_point_get(out);
+    // `out->key` points into `storage`, so copy what we need.
+    if (res) {
+        EXPECT_TRUE(out->key != nullptr);
+        out->key = nullptr;
+    }
+    return res;
+}
+
+TEST(TermStorageTest, MatchPointGet) {
+    ql::point_get_query_t q;
+
+    // r.table("t").get("k")
+    ASSERT_TRUE(match_query("[1,[16,[[15,[\"t\"]],\"k\"]]]", &q));
+    EXPECT_EQ("test", q.db_name);
+    EXPECT_EQ("t", q.table_name);
+
+    // r.db("d").table("t").get(5)
+    ASSERT_TRUE(match_query("[1,[16,[[15,[[14,[\"d\"]],\"t\"]],5]]]", &q));
+    EXPECT_EQ("d", q.db_name);
+    EXPECT_EQ("t", q.table_name);
+
+    // r.table("t").get("k") with the `db` and `noreply` global optargs
+    ASSERT_TRUE(match_query(
+        "[1,[16,[[15,[\"t\"]],\"k\"]],{\"db\":[14,[\"g\"]],\"noreply\":true}]", &q));
+    EXPECT_EQ("g", q.db_name);
+
+    // An explicit database wins over the `db` global optarg.
+    ASSERT_TRUE(match_query(
+        "[1,[16,[[15,[[14,[\"d\"]],\"t\"]],\"k\"]],{\"db\":[14,[\"g\"]]}]", &q));
+    EXPECT_EQ("d", q.db_name);
+}
+
+TEST(TermStorageTest, NoMatchPointGet) {
+    ql::point_get_query_t q;
+
+    // Not a START query
+    EXPECT_FALSE(match_query("[2]", &q));
+    // r.table("t")
+    EXPECT_FALSE(match_query("[1,[15,[\"t\"]]]", &q));
+    // r.table("t", read_mode="outdated").get("k")
+    EXPECT_FALSE(match_query(
+        "[1,[16,[[15,[\"t\"],{\"read_mode\":\"outdated\"}],\"k\"]]]", &q));
+    // r.table("t").get([1, 2]) uses a MAKE_ARRAY term for the key.
+    EXPECT_FALSE(match_query("[1,[16,[[15,[\"t\"]],[2,[1,2]]]]]", &q));
+    // r.table(r.expr("t")).get("k")
+    EXPECT_FALSE(match_query("[1,[16,[[15,[[1,\"t\"]]],\"k\"]]]", &q));
+    // Other global optargs
+    EXPECT_FALSE(match_query(
+        "[1,[16,[[15,[\"t\"]],\"k\"]],{\"profile\":true}]", &q));
+    EXPECT_FALSE(match_query(
+        "[1,[16,[[15,[\"t\"]],\"k\"]],{\"db\":[14,[[1,\"g\"]]]}]", &q));
+}
+
+bool query_shape(const char *json, std::string *key_out, size_t *num_slots_out) {
+    size_t size = strlen(json);
+    scoped_array_t<char> data(size + 1);
+    memcpy(data.data(), json, size + 1);
+    rapidjson::Document doc;
+    doc.ParseInsitu(data.data());
+    EXPECT_FALSE(doc.HasParseError());
+    ql::json_term_storage_t storage(std::move(data), std::move(doc));
+    std::vector<const rapidjson::Value *> slots;
+    bool res = storage.query_shape(key_out, &slots);
+    *num_slots_out = slots.size();
+    return res;
+}
+
+TEST(TermStorageTest, QueryShape) {
+    std::string key1, key2;
+    size_t slots1, slots2;
+
+    // r.table("t").get("k") and r.table("u").get(5) have the same shape.
+    ASSERT_TRUE(query_shape("[1,[16,[[15,[\"t\"]],\"k\"]]]", &key1, &slots1));
+    ASSERT_TRUE(query_shape("[1,[16,[[15,[\"u\"]],5]]]", &key2, &slots2));
+    EXPECT_EQ(key1, key2);
+    EXPECT_EQ(2u, slots1);
+    EXPECT_EQ(2u, slots2);
+
+    // r.table("t").get_all("a", "b", index="i") has a different shape, and the
+    // value of its optarg isn't a slot.
+    ASSERT_TRUE(query_shape(
+        "[1,[78,[[15,[\"t\"]],\"a\",\"b\"],{\"index\":\"i\"}]]", &key2, &slots2));
+    EXPECT_NE(key1, key2);
+    EXPECT_EQ(3u, slots2);
+    ASSERT_TRUE(query_shape(
+        "[1,[78,[[15,[\"t\"]],\"a\",\"b\"],{\"index\":\"j\"}]]", &key1, &slots1));
+    EXPECT_NE(key1, key2);
+
+    // Global optargs are part of the shape.
+    ASSERT_TRUE(query_shape("[1,[16,[[15,[\"t\"]],\"k\"]]]", &key1, &slots1));
+    ASSERT_TRUE(query_shape(
+        "[1,[16,[[15,[\"t\"]],\"k\"]],{\"noreply\":true}]", &key2, &slots2));
+    EXPECT_NE(key1, key2);
+
+    // Literals under other terms, like the field name in
+    // r.table("t").get("k")("f"), stay in the shape.
+    ASSERT_TRUE(query_shape(
+        "[1,[170,[[16,[[15,[\"t\"]],\"k\"]],\"f\"]]]", &key1, &slots1));
+    ASSERT_TRUE(query_shape(
+        "[1,[170,[[16,[[15,[\"t\"]],\"k\"]],\"g\"]]]", &key2, &slots2));
+    EXPECT_NE(key1, key2);
+    EXPECT_EQ(0u, slots1);
+
+    // The encoding of a string can't be confused with a slot or another term.
+    ASSERT_TRUE(query_shape("[1,[170,[[2,[]],\"?\"]]]", &key1, &slots1));
+    ASSERT_TRUE(query_shape("[1,[170,[[2,[]],\"s1:?\"]]]", &key2, &slots2));
+    EXPECT_NE(key1, key2);
+}
+
+TEST(TermStorageTest, NoQueryShape) {
+    std::string key;
+    size_t slots;
+
+    // Not a START query
+    EXPECT_FALSE(query_shape("[2]", &key, &slots));
+    // r.expr(5)
+    EXPECT_FALSE(query_shape("[1,5]", &key, &slots));
+    // r.table("t").get(r.now()) is rewritten when it is preprocessed.
+    EXPECT_FALSE(query_shape("[1,[16,[[15,[\"t\"]],[103,[]]]]]", &key, &slots));
+    // Malformed terms are left to the term walker.
+    EXPECT_FALSE(query_shape("[1,[\"get\",[]]]", &key, &slots));
+}
+
+}  // namespace unittest
@@ -0,0 +1,47 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <atomic>
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/interruptor.hpp"
+#include "concurrency/work_stealing.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TPTEST(WorkStealingTest, RunsEveryTaskOnce, 4) {
+    const size_t num_tasks = 1000;
+    std::vector<std::atomic<int> > runs(num_tasks);
+    std::vector<std::atomic<int> > threads(get_num_threads());
+    for (auto &r : runs) { r.store(0); }
+    for (auto &t : threads) { t.store(0); }
+    cond_t non_interruptor;
+    work_stealing_pmap(num_tasks, [&](size_t task) {
+        ++runs[task];
+        ++threads[get_thread_id().threadnum];
+        // Give the other threads a chance to take some of the tasks.
+        nap(1);
+    }, &non_interruptor);
+    for (size_t i = 0; i < num_tasks; ++i) {
+        ASSERT_EQ(1, runs[i].load());
+    }
+    int threads_used = 0;
+    for (const auto &t : threads) {
+        threads_used += t.load() > 0 ? 1 : 0;
+    }
+    EXPECT_LT(1, threads_used);
+}
+
+TPTEST(WorkStealingTest, Interrupted, 4) {
+    std::atomic<int> runs(0);
+    cond_t interruptor;
+    interruptor.pulse();
+    EXPECT_THROW(work_stealing_pmap(100, [&](size_t) { ++runs; }, &interruptor),
+                 interrupted_exc_t);
+    EXPECT_EQ(0, runs.load());
+}
+
+}  // namespace unittest